@@ -0,0 +1,507 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include <ircd/asio.h>
+#include "bench.h"
+
+namespace bench
+{
+	struct result;
+
+	static bool match(const test &);
+	static nanoseconds time(const test::op &, const size_t &iterations);
+	static size_t calibrate(const test::op &);
+	static result measure(const test::op &, const size_t &iterations);
+	static void run(json::stack::array &, const test &);
+	static void main() noexcept;
+
+	milliseconds duration {500};
+	size_t iterations {0};
+	bool verbose;
+	const char *output;
+	std::vector<string_view> filters;
+	std::string results;
+	int status {EXIT_SUCCESS};
+}
+
+/// Totals for all iterations of one test; reported divided by iterations.
+struct bench::result
+{
+	size_t iterations {0};
+	nanoseconds elapsed {0};
+	uint64_t cycles {0};
+	uint64_t instructions {0};
+	uint64_t cache_misses {0};
+	allocator::profile alloc;
+	bool counters {false};
+};
+
+std::vector<bench::test *> &
+bench::tests()
+{
+	static std::vector<test *> tests;
+	return tests;
+}
+
+int
+main(int argc, char *const *argv)
+noexcept try
+{
+	using namespace ircd;
+
+	for(int i(1); i < argc; ++i)
+	{
+		const string_view arg
+		{
+			argv[i]
+		};
+
+		if(arg == "-verbose")
+			bench::verbose = true;
+		else if(arg == "-duration" && i + 1 < argc)
+			bench::duration = milliseconds(lex_cast<long>(string_view{argv[++i]}));
+		else if(arg == "-iterations" && i + 1 < argc)
+			bench::iterations = lex_cast<size_t>(string_view{argv[++i]});
+		else if(arg == "-o" && i + 1 < argc)
+			bench::output = argv[++i];
+		else if(startswith(arg, '-'))
+			throw user_error
+			{
+				"usage: %s [-verbose] [-duration ms] [-iterations n] [-o file] [prefix...]",
+				argv[0],
+			};
+		else
+			bench::filters.emplace_back(arg);
+	}
+
+	// The log would interleave with the results on stdout.
+	if(!bench::verbose)
+		log::console_disable();
+
+	// The benchmarks run on an ircd::ctx after libircd reaches runlevel RUN,
+	// then the run loop is made to exit.
+	const run::changed runner
+	{
+		[](const auto &level)
+		{
+			if(level != run::level::RUN)
+				return;
+
+			ircd::context
+			{
+				"bench", 1_MiB, context::POST | context::DETACH, bench::main
+			};
+		}
+	};
+
+	boost::asio::io_context ios;
+	ircd::init(ios.get_executor());
+	ios.run();
+
+	if(bench::output)
+		std::ofstream(bench::output, std::ios::trunc) << bench::results << std::endl;
+	else
+		std::cout << bench::results << std::endl;
+
+	return bench::status;
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "%s\n", e.what());
+	return EXIT_FAILURE;
+}
+
+void
+bench::main()
+noexcept try
+{
+	const unwind quit{[]
+	{
+		ircd::post {[] { ircd::quit(); }};
+	}};
+
+	// The selected tests run in name order so the output is comparable
+	// between runs.
+	std::vector<test *> selected;
+	std::copy_if(begin(tests()), end(tests()), std::back_inserter(selected), []
+	(const test *const &test)
+	{
+		return match(*test);
+	});
+
+	std::sort(begin(selected), end(selected), []
+	(const test *const &a, const test *const &b)
+	{
+		return a->name < b->name;
+	});
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		256_KiB
+	};
+
+	json::stack out
+	{
+		buf
+	};
+
+	{
+		json::stack::object top
+		{
+			out
+		};
+
+		json::stack::member
+		{
+			top, "version", json::value(info::version)
+		};
+
+		json::stack::member
+		{
+			top, "duration", json::value(int64_t(duration.count()))
+		};
+
+		json::stack::array array
+		{
+			top, "tests"
+		};
+
+		for(const auto *const test : selected)
+			run(array, *test);
+	}
+
+	results = out.completed();
+}
+catch(const std::exception &e)
+{
+	status = EXIT_FAILURE;
+	fprintf(stderr, "%s\n", e.what());
+}
+
+void
+bench::run(json::stack::array &out,
+           const test &test)
+{
+	const auto op
+	{
+		test.init()
+	};
+
+	const size_t count
+	{
+		iterations?: calibrate(op)
+	};
+
+	const auto res
+	{
+		measure(op, count)
+	};
+
+	const auto per{[&res](const auto &value)
+	{
+		return json::value(double(value) / double(res.iterations));
+	}};
+
+	json::stack::object object
+	{
+		out
+	};
+
+	json::stack::member
+	{
+		object, "name", json::value(test.name)
+	};
+
+	json::stack::member
+	{
+		object, "iterations", json::value(int64_t(res.iterations))
+	};
+
+	json::stack::member
+	{
+		object, "ns", per(res.elapsed.count())
+	};
+
+	json::stack::member
+	{
+		object, "cycles", per(res.cycles)
+	};
+
+	// Hardware counters are unavailable on some platforms and when prohibited
+	// by perf_event_paranoid; the cycles above are then the TSC.
+	json::stack::member
+	{
+		object, "instructions", res.counters?
+			per(res.instructions):
+			json::value{}
+	};
+
+	json::stack::member
+	{
+		object, "cache_misses", res.counters?
+			per(res.cache_misses):
+			json::value{}
+	};
+
+	// Allocations are counted only when libircd is built with RB_PROF_ALLOC.
+	json::stack::member
+	{
+		object, "allocs", per(res.alloc.alloc_count)
+	};
+
+	json::stack::member
+	{
+		object, "alloc_bytes", per(res.alloc.alloc_bytes)
+	};
+}
+
+/// Doubles the iterations until a trial takes a tenth of the duration, then
+/// scales that to the full duration.
+size_t
+bench::calibrate(const test::op &op)
+{
+	const nanoseconds trial
+	{
+		duration / 10
+	};
+
+	size_t count(1);
+	nanoseconds elapsed {0};
+	while(count < (1UL << 30) && (elapsed = time(op, count)) < trial)
+		count *= 2;
+
+	const auto scale
+	{
+		double(nanoseconds(duration).count()) / std::max(elapsed.count(), 1L)
+	};
+
+	return std::max(size_t(count * scale), 1UL);
+}
+
+bench::result
+bench::measure(const test::op &op,
+               const size_t &iterations)
+{
+	result ret;
+	ret.iterations = iterations;
+
+	std::unique_ptr<prof::counters> counters; try
+	{
+		counters = std::make_unique<prof::counters>();
+		ret.counters = true;
+	}
+	catch(const std::exception &e)
+	{
+		counters.reset();
+	}
+
+	const auto counters_begin
+	{
+		counters?
+			counters->sample():
+			prof::counters::sample_type{0}
+	};
+
+	const auto alloc_begin
+	{
+		allocator::profile::this_thread
+	};
+
+	const auto cycles_begin
+	{
+		prof::cycles()
+	};
+
+	const auto started
+	{
+		now<steady_point>()
+	};
+
+	for(size_t i(0); i < iterations; ++i)
+		op();
+
+	const auto stopped
+	{
+		now<steady_point>()
+	};
+
+	const auto cycles_end
+	{
+		prof::cycles()
+	};
+
+	const auto alloc_end
+	{
+		allocator::profile::this_thread
+	};
+
+	const auto counters_end
+	{
+		counters?
+			counters->sample():
+			prof::counters::sample_type{0}
+	};
+
+	ret.elapsed = stopped - started;
+	ret.alloc = alloc_end - alloc_begin;
+	ret.cycles = counters?
+		counters_end[prof::counters::CYCLES] - counters_begin[prof::counters::CYCLES]:
+		cycles_end - cycles_begin;
+
+	ret.instructions = counters_end[prof::counters::INSTRUCTIONS] - counters_begin[prof::counters::INSTRUCTIONS];
+	ret.cache_misses = counters_end[prof::counters::CACHE_MISSES] - counters_begin[prof::counters::CACHE_MISSES];
+	return ret;
+}
+
+ircd::nanoseconds
+bench::time(const test::op &op,
+            const size_t &iterations)
+{
+	const auto started
+	{
+		now<steady_point>()
+	};
+
+	for(size_t i(0); i < iterations; ++i)
+		op();
+
+	return now<steady_point>() - started;
+}
+
+bool
+bench::match(const test &test)
+{
+	return filters.empty() || std::any_of(begin(filters), end(filters), [&test]
+	(const string_view &filter)
+	{
+		return startswith(test.name, filter);
+	});
+}
+
+//
+// corpus
+//
+
+/// Each test seeds its own generator from its name so its corpus does not
+/// depend on which other tests were selected.
+std::mt19937_64
+bench::prng(const string_view &name)
+{
+	return std::mt19937_64
+	{
+		ircd::hash(name)
+	};
+}
+
+std::string
+bench::text(std::mt19937_64 &prng,
+            const size_t &min,
+            const size_t &max)
+{
+	static const string_view dict
+	{
+		"abcdefghijklmnopqrstuvwxyz      "
+	};
+
+	std::uniform_int_distribution<size_t> len(min, max);
+	std::uniform_int_distribution<size_t> chr(0, dict.size() - 1);
+
+	std::string ret(len(prng), ' ');
+	for(auto &c : ret)
+		c = dict[chr(prng)];
+
+	return ret;
+}
+
+/// Synthetic corpus of room version 1 m.room.message events with a fixed
+/// seed; they are well-formed but unsigned.
+const std::vector<std::string> &
+bench::events()
+{
+	static std::vector<std::string> ret; if(!ret.empty())
+		return ret;
+
+	auto prng
+	{
+		bench::prng("events")
+	};
+
+	std::uniform_int_distribution<int> sender(0, 255), prevs(1, 3);
+	ret.reserve(1024);
+	for(size_t i(0); i < 1024; ++i)
+	{
+		char sender_buf[64], event_id_buf[64], prev_buf[64];
+		const string_view sender_id
+		{
+			fmt::sprintf{sender_buf, "@user%d:bench.example", sender(prng)}
+		};
+
+		const string_view event_id
+		{
+			fmt::sprintf{event_id_buf, "$%zu:bench.example", i + 1}
+		};
+
+		// Room version 1 references: [["$id", {"sha256": "..."}], ...]
+		std::string prev_events("[");
+		const size_t prev_count(i? std::min(size_t(prevs(prng)), i): 0UL);
+		for(size_t j(0); j < prev_count; ++j)
+			prev_events += fmt::sprintf
+			{
+				prev_buf, "%s[\"$%zu:bench.example\",{}]", j? ",": "", i - j
+			};
+
+		prev_events += "]";
+
+		const json::members content
+		{
+			{ "body",     text(prng, 16, 256) },
+			{ "msgtype",  "m.text"            },
+		};
+
+		ret.emplace_back(json::strung
+		{
+			json::members
+			{
+				{ "auth_events",       json::array{json::empty_array}            },
+				{ "content",           content                                   },
+				{ "depth",             int64_t(i + 1)                            },
+				{ "event_id",          event_id                                  },
+				{ "origin",            "bench.example"                           },
+				{ "origin_server_ts",  int64_t(1577836800000L + i * 1000)        },
+				{ "prev_events",       json::array{prev_events}                  },
+				{ "room_id",           "!bench:bench.example"                    },
+				{ "sender",            sender_id                                 },
+				{ "type",              "m.room.message"                          },
+			}
+		});
+	}
+
+	return ret;
+}
+
+//
+// test
+//
+
+bench::test::test(const string_view &name,
+                  setup init)
+:name{name}
+,init{std::move(init)}
+{
+	tests().emplace_back(this);
+}
+
+bench::test::~test()
+noexcept
+{
+	auto &tests(bench::tests());
+	tests.erase(std::remove(begin(tests), end(tests), this), end(tests));
+}
@@ -0,0 +1,40 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace bench
+{
+	using namespace ircd;
+
+	struct test;
+
+	std::vector<test *> &tests();
+
+	std::mt19937_64 prng(const string_view &name);
+	std::string text(std::mt19937_64 &, const size_t &min, const size_t &max);
+	const std::vector<std::string> &events();
+}
+
+/// A registered benchmark. Instances are defined at static scope in each
+/// unit. The setup closure is run once outside of the measurement on an
+/// ircd::ctx; it prepares its corpus and returns the operation to measure.
+/// Any state the operation requires must be captured by the operation.
+struct bench::test
+{
+	using op = std::function<void ()>;
+	using setup = std::function<op ()>;
+
+	string_view name;
+	setup init;
+
+	test(const string_view &name, setup);
+	test(test &&) = delete;
+	test(const test &) = delete;
+	~test() noexcept;
+};
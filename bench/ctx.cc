@@ -0,0 +1,82 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include "bench.h"
+
+namespace bench::ctx_
+{
+	extern const ctx::pool::opts pool_opts;
+
+	extern test yield;
+	extern test pool;
+}
+
+decltype(bench::ctx_::pool_opts)
+bench::ctx_::pool_opts
+{
+	256_KiB,   // stack_size
+	1,         // initial_ctxs
+};
+
+/// One operation is a yield to a second context which yields straight back;
+/// two context switches and a trip through the event loop.
+decltype(bench::ctx_::yield)
+bench::ctx_::yield
+{
+	"ctx.yield", []
+	{
+		auto partner
+		{
+			std::make_shared<context>("bench.partner", 64_KiB, []
+			{
+				while(1)
+				{
+					ctx::interruption_point();
+					ctx::yield();
+				}
+			})
+		};
+
+		return [partner]
+		{
+			ctx::yield();
+		};
+	}
+};
+
+/// Submission of a job to a pool and waiting for it to complete; the round
+/// trip of dispatching work to a context which is waiting for it.
+decltype(bench::ctx_::pool)
+bench::ctx_::pool
+{
+	"ctx.pool.dispatch", []
+	{
+		auto pool
+		{
+			std::make_shared<ctx::pool>("bench", pool_opts)
+		};
+
+		return [pool]
+		{
+			ctx::latch latch
+			{
+				1
+			};
+
+			(*pool)([&latch]
+			{
+				latch.count_down();
+			});
+
+			latch.wait();
+		};
+	}
+};
@@ -0,0 +1,197 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include "bench.h"
+
+namespace bench::db_
+{
+	using database_ptr = std::shared_ptr<db::database>;
+
+	static string_view make_key(const mutable_buffer &, const size_t &);
+	static database_ptr open();
+
+	extern const db::description description;
+	extern const size_t keys;
+
+	extern test get;
+	extern test get_miss;
+	extern test seek;
+}
+
+/// Number of keys in the corpus. The values are 64 to 512 bytes; with the
+/// block cache below the corpus is served entirely from memory after the
+/// first pass, so these measure the read path rather than the device.
+decltype(bench::db_::keys)
+bench::db_::keys
+{
+	64 * 1024
+};
+
+decltype(bench::db_::description)
+bench::db_::description
+{
+	{
+		"default",
+		"Unused default column.",
+		{ typeid(string_view), typeid(string_view) },
+	},
+	{
+		"bench",
+		"Benchmark corpus.",
+		{ typeid(string_view), typeid(string_view) },
+		{},            // options
+		{},            // cmp
+		{},            // prefix
+		false,         // drop
+		64_MiB,        // cache_size
+		0,             // cache_size_comp
+	},
+};
+
+/// Random point reads of keys which exist.
+decltype(bench::db_::get)
+bench::db_::get
+{
+	"db.column.get", []
+	{
+		auto database(open());
+		db::column column
+		{
+			*database, "bench"
+		};
+
+		auto prng(bench::prng("db.column.get"));
+		return [database, column, prng]() mutable
+		{
+			char buf[32];
+			const auto key
+			{
+				make_key(buf, prng() % keys)
+			};
+
+			column(key, [](const string_view &value)
+			{
+				asm volatile ("" :: "r"(value.data()));
+			});
+		};
+	}
+};
+
+/// Random point reads of keys which do not exist; the bloom filter path.
+decltype(bench::db_::get_miss)
+bench::db_::get_miss
+{
+	"db.column.get.miss", []
+	{
+		auto database(open());
+		db::column column
+		{
+			*database, "bench"
+		};
+
+		auto prng(bench::prng("db.column.get.miss"));
+		return [database, column, prng]() mutable
+		{
+			char buf[32];
+			const auto key
+			{
+				make_key(buf, keys + prng() % keys)
+			};
+
+			const bool found
+			{
+				column(key, std::nothrow, [](const string_view &value)
+				{
+					asm volatile ("" :: "r"(value.data()));
+				})
+			};
+
+			asm volatile ("" :: "r"(found));
+		};
+	}
+};
+
+/// Seek to a random key and iterate the sixteen following it.
+decltype(bench::db_::seek)
+bench::db_::seek
+{
+	"db.column.seek", []
+	{
+		auto database(open());
+		db::column column
+		{
+			*database, "bench"
+		};
+
+		auto prng(bench::prng("db.column.seek"));
+		return [database, column, prng]() mutable
+		{
+			char buf[32];
+			const auto key
+			{
+				make_key(buf, prng() % keys)
+			};
+
+			size_t i(0);
+			auto it(column.lower_bound(key));
+			for(; it && i < 16; ++it, ++i)
+				asm volatile ("" :: "r"(it->second.data()));
+		};
+	}
+};
+
+/// Opens the database "bench" in the database directory, populating it on
+/// first use. The contents are the same on every run, so the populated
+/// database is left in place between runs.
+bench::db_::database_ptr
+bench::db_::open()
+{
+	auto ret
+	{
+		std::make_shared<db::database>("bench", std::string{}, description)
+	};
+
+	db::column column
+	{
+		*ret, "bench"
+	};
+
+	char buf[32];
+	if(db::has(column, make_key(buf, keys - 1)))
+		return ret;
+
+	auto prng(bench::prng("db"));
+	for(size_t i(0); i < keys; ++i)
+	{
+		const auto value
+		{
+			text(prng, 64, 512)
+		};
+
+		db::write(column, make_key(buf, i), const_buffer{value});
+	}
+
+	db::sort(*ret, true, true);
+	db::compact(*ret);
+	return ret;
+}
+
+/// Keys are hex of a scrambled index so that insertion order is not the key
+/// order; the same index always yields the same key.
+ircd::string_view
+bench::db_::make_key(const mutable_buffer &buf,
+                     const size_t &i)
+{
+	return fmt::sprintf
+	{
+		buf, "%016lx", (i * 0x9E3779B97F4A7C15UL) ^ 0xBEEFUL
+	};
+}
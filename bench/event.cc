@@ -0,0 +1,151 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include "bench.h"
+
+namespace bench::event
+{
+	struct keys;
+
+	static std::shared_ptr<std::vector<m::event>> corpus();
+
+	extern test tuple;
+	extern test hash;
+	extern test sign;
+	extern test verify;
+}
+
+/// Keypair generated from a seed out of the prng so signatures are the same
+/// on every run.
+struct bench::event::keys
+{
+	ed25519::pk pk;
+	ed25519::sk sk;
+
+	keys()
+	:sk{[this]
+	{
+		auto prng(bench::prng("event.keys"));
+		std::array<uint64_t, ed25519::SEED_SZ / 8> seed;
+		std::generate(begin(seed), end(seed), std::ref(prng));
+		return ed25519::sk
+		{
+			&pk, const_buffer{reinterpret_cast<const char *>(seed.data()), ed25519::SEED_SZ}
+		};
+	}()}
+	{}
+};
+
+/// Parse of the JSON into the m::event tuple, which every event received
+/// over the network or read from the database undergoes.
+decltype(bench::event::tuple)
+bench::event::tuple
+{
+	"m.event.tuple", []
+	{
+		return [i(0UL)]() mutable
+		{
+			const m::event event
+			{
+				json::object{events()[i++ % events().size()]}
+			};
+
+			asm volatile ("" :: "r"(json::get<"depth"_>(event)));
+		};
+	}
+};
+
+/// Content hash; canonical JSON preimage and sha256.
+decltype(bench::event::hash)
+bench::event::hash
+{
+	"m.event.hash", []
+	{
+		return [corpus(corpus()), i(0UL)]() mutable
+		{
+			const auto hash
+			{
+				m::hash(corpus->at(i++ % corpus->size()))
+			};
+
+			asm volatile ("" :: "r"(hash.data()));
+		};
+	}
+};
+
+decltype(bench::event::sign)
+bench::event::sign
+{
+	"m.event.sign", []
+	{
+		return [corpus(corpus()), key(std::make_shared<keys>()), i(0UL)]() mutable
+		{
+			const auto sig
+			{
+				m::sign(corpus->at(i++ % corpus->size()), key->sk)
+			};
+
+			asm volatile ("" :: "r"(sig.data()));
+		};
+	}
+};
+
+decltype(bench::event::verify)
+bench::event::verify
+{
+	"m.event.verify", []
+	{
+		const auto keys
+		{
+			std::make_shared<struct keys>()
+		};
+
+		const auto corpus
+		{
+			event::corpus()
+		};
+
+		auto sigs
+		{
+			std::make_shared<std::vector<ed25519::sig>>()
+		};
+
+		for(const auto &event : *corpus)
+			sigs->emplace_back(m::sign(event, keys->sk));
+
+		return [corpus, keys, sigs, i(0UL)]() mutable
+		{
+			const auto j(i++ % corpus->size());
+			const bool ok
+			{
+				m::verify(corpus->at(j), keys->pk, sigs->at(j))
+			};
+
+			assert(ok);
+			asm volatile ("" :: "r"(ok));
+		};
+	}
+};
+
+std::shared_ptr<std::vector<ircd::m::event>>
+bench::event::corpus()
+{
+	auto ret
+	{
+		std::make_shared<std::vector<m::event>>()
+	};
+
+	ret->reserve(events().size());
+	for(const auto &event : events())
+		ret->emplace_back(json::object{event});
+
+	return ret;
+}
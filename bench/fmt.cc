@@ -0,0 +1,76 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include "bench.h"
+
+namespace bench::fmt_
+{
+	extern test sprintf;
+	extern test sprintf_log;
+}
+
+/// A short format with an integer, as made for keys and identifiers.
+decltype(bench::fmt_::sprintf)
+bench::fmt_::sprintf
+{
+	"fmt.sprintf", []
+	{
+		return [i(0UL)]() mutable
+		{
+			char buf[64];
+			const string_view out
+			{
+				fmt::sprintf
+				{
+					buf, "$%zu:%s", i++, "bench.example"
+				}
+			};
+
+			asm volatile ("" :: "r"(out.data()));
+		};
+	}
+};
+
+/// A format typical of a log line: several strings and integers.
+decltype(bench::fmt_::sprintf_log)
+bench::fmt_::sprintf_log
+{
+	"fmt.sprintf.log", []
+	{
+		return [i(0UL)]() mutable
+		{
+			const auto &event
+			{
+				events()[i % events().size()]
+			};
+
+			char buf[512];
+			const string_view out
+			{
+				fmt::sprintf
+				{
+					buf, "%s %s %ld:%lu %s in %s from '%s' %zu bytes",
+					"Received",
+					"m.room.message",
+					int64_t(i),
+					i * 7,
+					string_view{event}.substr(0, 32),
+					"!bench:bench.example",
+					"bench.example",
+					size(event),
+				}
+			};
+
+			++i;
+			asm volatile ("" :: "r"(out.data()));
+		};
+	}
+};
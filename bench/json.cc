@@ -0,0 +1,112 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include "bench.h"
+
+namespace bench::json_
+{
+	extern test parse;
+	extern test get;
+	extern test print;
+	extern test valid;
+}
+
+/// Visits every member of every event, descending into content.
+decltype(bench::json_::parse)
+bench::json_::parse
+{
+	"json.parse", []
+	{
+		return [i(0UL)]() mutable
+		{
+			const json::object event
+			{
+				events()[i++ % events().size()]
+			};
+
+			size_t count(0);
+			for(const auto &[key, val] : event)
+				if(key == "content")
+					for(const auto &member : json::object{val})
+						count += size(member.second);
+
+			asm volatile ("" :: "r"(count));
+		};
+	}
+};
+
+/// Point lookup of one member by key, as done by json::tuple property access.
+decltype(bench::json_::get)
+bench::json_::get
+{
+	"json.get", []
+	{
+		return [i(0UL)]() mutable
+		{
+			const json::object event
+			{
+				events()[i++ % events().size()]
+			};
+
+			const json::string type
+			{
+				event.get("type")
+			};
+
+			asm volatile ("" :: "r"(type.data()));
+		};
+	}
+};
+
+/// Prints an m::event tuple back to canonical JSON.
+decltype(bench::json_::print)
+bench::json_::print
+{
+	"json.print", []
+	{
+		auto corpus
+		{
+			std::make_shared<std::vector<m::event>>()
+		};
+
+		for(const auto &event : events())
+			corpus->emplace_back(json::object{event});
+
+		return [corpus, i(0UL)]() mutable
+		{
+			thread_local char buf[4_KiB];
+			const string_view out
+			{
+				json::stringify(buf, corpus->at(i++ % corpus->size()))
+			};
+
+			asm volatile ("" :: "r"(out.data()));
+		};
+	}
+};
+
+/// Full validation of the grammar of an event.
+decltype(bench::json_::valid)
+bench::json_::valid
+{
+	"json.valid", []
+	{
+		return [i(0UL)]() mutable
+		{
+			const bool ret
+			{
+				json::valid(events()[i++ % events().size()], std::nothrow)
+			};
+
+			asm volatile ("" :: "r"(ret));
+		};
+	}
+};
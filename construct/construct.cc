@@ -35,6 +35,7 @@ bool yes6;
 bool norun;
 bool read_only;
 bool write_avoid;
+bool secondary;
 bool soft_assert;
 bool nomatrix;
 bool matrix {true}; // matrix server by default.
@@ -64,6 +65,7 @@ lgetopt opts[]
 	{ "norun",      &norun,         lgetopt::BOOL,    "[debug & testing only] Initialize but never run the event loop." },
 	{ "ro",         &read_only,     lgetopt::BOOL,    "Read-only mode. No writes to database allowed." },
 	{ "wa",         &write_avoid,   lgetopt::BOOL,    "Like read-only mode, but writes permitted if triggered." },
+	{ "secondary",  &secondary,     lgetopt::BOOL,    "Read-only mode tailing the databases of a primary instance." },
 	{ "smoketest",  &smoketest[0],  lgetopt::BOOL,    "Starts and stops the daemon to return success."},
 	{ "sassert",    &soft_assert,   lgetopt::BOOL,    "Softens assertion effects in debug mode."},
 	{ "nomatrix",   &nomatrix,      lgetopt::BOOL,    "Prevent loading the matrix application module."},
@@ -455,6 +457,13 @@ applyargs()
 		cmdline = true;
 	}
 
+	// secondary implies read_only.
+	if(secondary)
+		read_only = true;
+
+	if(secondary)
+		ircd::db::open_secondary.set("true");
+
 	if(read_only)
 		ircd::read_only.set("true");
 
@@ -27,6 +27,7 @@ namespace ircd::allocator
 	template<class T = char, size_t = 512> struct fixed;
 	template<class T = char, size_t L0_SIZE = 512> struct twolevel;
 	template<class T> struct node;
+	struct arena;
 
 	std::unique_ptr<char, decltype(&std::free)>
 	aligned_alloc(const size_t &align, const size_t &size);
@@ -762,3 +763,135 @@ allocator()
 {
 	return ircd::allocator::twolevel<T, L0_SIZE>::allocator(*this);
 }
+
+/// The arena allocator serves allocations which all share one lifetime, such
+/// as everything made while handling a request. Memory is carved in order out
+/// of chunks obtained from malloc; individual deallocations are ignored and
+/// everything is returned at once by reset() or destruction. The first chunk
+/// is retained by reset() so an arena reused for the next request does not
+/// go back to malloc at all.
+///
+/// Nothing allocated from an arena may outlive it. Users wanting the arena
+/// for the work being conducted on their context should see ctx::scope_arena.
+///
+struct ircd::allocator::arena
+{
+	struct chunk;
+	template<class T = char> struct allocator;
+
+	static const size_t chunk_size_default;
+
+	size_t chunk_size;                // size of chunks after the first
+	chunk *head {nullptr};            // chunk being carved; first chunk is last
+	chunk *large {nullptr};           // chunks dedicated to one allocation
+	char *pos {nullptr};              // next byte of head to carve
+	char *stop {nullptr};             // end of head
+	size_t served {0};                // bytes carved since reset
+	size_t obtained {0};              // bytes malloc'ed since reset
+
+	void *grow(const size_t &size, const size_t &align);
+
+  public:
+	template<class T> allocator<T> operator()();
+
+	void *
+	__attribute__((malloc, returns_nonnull, warn_unused_result))
+	allocate(const size_t &size, const size_t &align = alignof(std::max_align_t));
+
+	void reset() noexcept;
+
+	arena(const size_t &chunk_size = chunk_size_default) noexcept;
+	arena(arena &&) = delete;
+	arena(const arena &) = delete;
+	~arena() noexcept;
+};
+
+/// The actual template passed to containers for using the arena.
+///
+/// See the notes for ircd::allocator::fixed::allocator for details.
+///
+template<class T>
+struct ircd::allocator::arena::allocator
+{
+	using value_type         = T;
+	using pointer            = T *;
+	using const_pointer      = const T *;
+	using reference          = T &;
+	using const_reference    = const T &;
+	using size_type          = std::size_t;
+	using difference_type    = std::ptrdiff_t;
+
+	arena *s;
+
+  public:
+	template<class U> struct rebind
+	{
+		using other = typename arena::allocator<U>;
+	};
+
+	size_type max_size() const                   { return std::numeric_limits<size_t>::max();      }
+	auto address(reference x) const              { return &x;                                      }
+	auto address(const_reference x) const        { return &x;                                      }
+
+	pointer
+	__attribute__((malloc, returns_nonnull, warn_unused_result))
+	allocate(const size_type &n, const const_pointer &hint = nullptr)
+	{
+		assert(s);
+		return reinterpret_cast<pointer>(s->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(const pointer &p, const size_type &n)
+	{
+		assert(s);
+	}
+
+	template<class U>
+	allocator(const arena::allocator<U> &s) noexcept
+	:s{s.s}
+	{}
+
+	allocator(arena &s) noexcept
+	:s{&s}
+	{}
+
+	allocator(allocator &&) = default;
+	allocator(const allocator &) = default;
+
+	friend bool operator==(const allocator &a, const allocator &b)
+	{
+		return a.s == b.s;
+	}
+
+	friend bool operator!=(const allocator &a, const allocator &b)
+	{
+		return a.s != b.s;
+	}
+};
+
+template<class T>
+typename ircd::allocator::arena::allocator<T>
+ircd::allocator::arena::operator()()
+{
+	return ircd::allocator::arena::allocator<T>(*this);
+}
+
+/// Carves size bytes at the alignment out of the head chunk, obtaining a new
+/// chunk when it has insufficient space remaining.
+inline void *
+ircd::allocator::arena::allocate(const size_t &size,
+                                 const size_t &align)
+{
+	assert(align && (align & (align - 1)) == 0);
+	const auto addr
+	{
+		(uintptr_t(pos) + (align - 1)) & ~uintptr_t(align - 1)
+	};
+
+	if(unlikely(!pos || addr + size > uintptr_t(stop)))
+		return grow(size, align);
+
+	pos = reinterpret_cast<char *>(addr + size);
+	served += size;
+	return reinterpret_cast<void *>(addr);
+}
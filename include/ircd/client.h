@@ -62,6 +62,7 @@ struct ircd::client
 	size_t head_length {0};
 	size_t content_consumed {0};
 	resource::request request;
+	allocator::arena arena;
 
 	string_view loghead() const;
 	size_t write_all(const const_buffer &);
@@ -0,0 +1,70 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_COMPRESS_H
+
+/// Content compression for HTTP content-coding. Each coding is available
+/// when its library was found by ./configure (zlib for gzip, libzstd for
+/// zstd); identity is always available.
+namespace ircd::compress
+{
+	IRCD_EXCEPTION(ircd::error, error)
+
+	enum class type :uint8_t;
+	struct deflate;
+
+	extern const info::versions zlib_version_api, zlib_version_abi;
+	extern const info::versions zstd_version_api, zstd_version_abi;
+
+	string_view reflect(const type &) noexcept;
+	type parse(const string_view &content_coding) noexcept;
+	bool available(const type &) noexcept;
+	size_t bound(const type &, const size_t &) noexcept;
+
+	// Choose the coding for a response from a request's Accept-Encoding.
+	type negotiate(const string_view &accept_encoding) noexcept;
+
+	// Value for an Accept-Encoding header listing the available codings.
+	string_view accept() noexcept;
+
+	// Decodes the whole input into buf, which is (re)allocated to fit up to
+	// max bytes; returns the view of the decoded content in buf.
+	const_buffer inflate(unique_buffer<mutable_buffer> &buf, const type &, const const_buffer &, const size_t &max);
+}
+
+enum class ircd::compress::type
+:uint8_t
+{
+	IDENTITY,
+	GZIP,
+	ZSTD,
+};
+
+/// Streaming encoder. Each call encodes all of the input and flushes it so
+/// that the receiver is able to decode everything given so far; this suits
+/// chunked responses where each chunk goes out as it is produced. The final
+/// call sets finish to write the end of the stream. The output buffer must
+/// be at least bound() of the input.
+struct ircd::compress::deflate
+{
+	struct state;
+
+	type coding;
+	std::unique_ptr<state> s;
+
+  public:
+	const_buffer operator()(const mutable_buffer &out, const const_buffer &in, const bool &finish = false);
+
+	deflate(const type &);
+	deflate(deflate &&) = delete;
+	deflate(const deflate &) = delete;
+	~deflate() noexcept;
+};
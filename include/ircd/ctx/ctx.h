@@ -53,6 +53,7 @@ namespace ircd::ctx
 	const int8_t &ionice(const ctx &) noexcept;     // IO priority nice-value
 	const int8_t &nice(const ctx &) noexcept;       // Scheduling priority nice-value
 	bool interruptible(const ctx &) noexcept;       // Context can throw at interruption point
+	allocator::arena *arena(const ctx &) noexcept;  // Arena for the context's work (or null)
 	bool interruption(const ctx &) noexcept;        // Context was marked for interruption
 	bool termination(const ctx &) noexcept;         // Context was marked for termination
 	bool finished(const ctx &) noexcept;            // Context function returned (or exception).
@@ -64,6 +65,7 @@ namespace ircd::ctx
 	int8_t ionice(ctx &, const int8_t &);           // IO priority nice-value
 	int8_t nice(ctx &, const int8_t &);             // Scheduling priority nice-value
 	void interruptible(ctx &, const bool &);        // False for interrupt suppression.
+	allocator::arena *arena(ctx &, allocator::arena *) noexcept; // Returns previous
 	void interrupt(ctx &);                          // Interrupt the context.
 	void terminate(ctx &);                          // Interrupt for termination.
 	void signal(ctx &, std::function<void ()>);     // Post function to context strand
@@ -87,6 +89,7 @@ namespace ircd::ctx
 #include "critical_indicator.h"
 #include "exception_handler.h"
 #include "uninterruptible.h"
+#include "scope_arena.h"
 #include "list.h"
 #include "dock.h"
 #include "latch.h"
@@ -17,11 +17,19 @@
 /// worker thread for execution. The context on the main IRCd thread yields until the offload
 /// function has returned (or thrown).
 ///
+/// Each worker thread has its own deque; submissions are spread across them
+/// and an idle worker steals from the others, so a batch of functions given
+/// to one offload runs on as many cores as there are threads. The offloading
+/// context is woken once, by whichever task of its batch finishes last.
+///
 namespace ircd::ctx::ole
 {
 	struct init;
 	struct opts;
 	struct offload;
+	struct tally;
+
+	extern std::map<std::string, tally, std::less<>> tallies;
 }
 
 namespace ircd::ctx
@@ -33,13 +41,15 @@ struct ircd::ctx::ole::offload
 {
 	using function = std::function<void ()>;
 
+	offload(const opts &, const vector_view<const function> &);
 	offload(const opts &, const function &);
 	offload(const function &);
 };
 
 struct ircd::ctx::ole::opts
 {
-	/// Optionally give this offload task a name for any tasklist.
+	/// Optionally give this offload task a name for any tasklist. Offloads
+	/// with the same name are accounted together in ole::tallies.
 	string_view name;
 
 	/// The function will be executed on each thread.
@@ -49,6 +59,18 @@ struct ircd::ctx::ole::opts
 	int8_t prio {0};
 };
 
+/// Accounting for a class of offload tasks sharing the same opts.name. These
+/// are only updated on the main thread when an offload completes.
+struct ircd::ctx::ole::tally
+{
+	uint64_t batches {0};               // Number of offload() calls
+	uint64_t tasks {0};                 // Number of functions executed
+	uint64_t errors {0};                // Number of functions which threw
+	uint64_t steals {0};                // Functions run by a thread they weren't queued to
+	nanoseconds queued {0};             // Total time functions waited to start
+	nanoseconds busy {0};               // Total time functions spent executing
+};
+
 struct ircd::ctx::ole::init
 {
 	init();
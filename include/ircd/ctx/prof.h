@@ -30,10 +30,14 @@
 namespace ircd::ctx::prof
 {
 	enum class event :uint8_t;
+	enum class counter :uint8_t;
 	struct ticker;
+	struct node;
+	struct scope;
 
 	ulong cycles() noexcept;
 	string_view reflect(const event &);
+	string_view reflect(const counter &);
 
 	// totals
 	const ticker &get() noexcept;
@@ -42,6 +46,7 @@ namespace ircd::ctx::prof
 	// specific context
 	const ticker &get(const ctx &c) noexcept;
 	const uint64_t &get(const ctx &c, const event &);
+	size_t stack_committed(const ctx &c);
 
 	// current slice state
 	const ulong &cur_slice_start() noexcept;
@@ -53,6 +58,9 @@ namespace ircd::ctx::prof
 	bool slice_exceeded_interrupt(const ulong &cycles) noexcept;
 	bool stack_exceeded_warning(const size_t &size) noexcept;
 	bool stack_exceeded_assertion(const size_t &size) noexcept;
+
+	// node tree
+	string_view path(const mutable_buffer &, const node &, const char &sep = ';');
 }
 
 namespace ircd::ctx::prof::settings
@@ -63,6 +71,8 @@ namespace ircd::ctx::prof::settings
 	extern conf::item<ulong> slice_warning;     // Warn when the yield-to-yield cycles exceeds
 	extern conf::item<ulong> slice_interrupt;   // Interrupt exception when exceeded (not a signal)
 	extern conf::item<ulong> slice_assertion;   // abort() when exceeded (not a signal, must yield)
+
+	extern conf::item<bool> counters_enable;    // Charge hardware counters to the node tree
 }
 
 /// Profiling events for marking. These are currently used internally at the
@@ -85,11 +95,66 @@ enum class ircd::ctx::prof::event
 	_NUM_
 };
 
+/// Counters charged to each prof::node.
+enum class ircd::ctx::prof::counter
+:uint8_t
+{
+	SLICES,        // Number of execution slices (or parts thereof)
+	TSC,           // Reference cycles (rdtsc)
+	CYCLES,        // Core cycles (hardware counter)
+	INSTRUCTIONS,  // Instructions retired (hardware counter)
+	CACHE_MISSES,  // Cache misses (hardware counter)
+
+	_NUM_
+};
+
 /// structure aggregating any profiling related state for a ctx
 struct ircd::ctx::prof::ticker
 {
 	// monotonic counters for events
 	std::array<uint64_t, num_of<prof::event>()> event {{0}};
+
+	// node currently charged for this context's execution
+	prof::node *node {nullptr};
+};
+
+/// Tree of everything which has been charged for execution time. The first
+/// level is keyed by context name; deeper levels are opened by prof::scope
+/// for the operations done by the context (e.g. resource methods and
+/// database columns). Each path from the root is a folded stack.
+struct ircd::ctx::prof::node
+{
+	using counters = std::array<uint64_t, num_of<counter>()>;
+	using closure_bool = std::function<bool (const node &)>;
+
+	static node root;
+
+	std::string name;
+	node *parent {nullptr};
+	std::map<std::string, std::unique_ptr<node>, std::less<>> children;
+	counters count {{0}};
+
+  public:
+	bool for_each(const closure_bool &) const; // depth-first descendants
+	node &child(const string_view &name);
+
+	node(std::string name = {}, node *parent = nullptr);
+	node(node &&) = delete;
+	node(const node &) = delete;
+};
+
+/// Charge the current context's execution to a named child of its current
+/// node until this object goes out of scope. This is a no-op outside of a
+/// context or when not enabled by the caller.
+struct ircd::ctx::prof::scope
+{
+	node *theirs {nullptr};
+
+  public:
+	scope(const string_view &name, const bool &enable = true);
+	scope(scope &&) = delete;
+	scope(const scope &) = delete;
+	~scope() noexcept;
 };
 
 /// Calculate the current reference cycle count (TSC) for the current
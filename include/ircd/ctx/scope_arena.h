@@ -0,0 +1,61 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_CTX_SCOPE_ARENA_H
+
+namespace ircd::ctx {
+inline namespace this_ctx
+{
+	struct scope_arena;
+
+	allocator::arena *arena() noexcept;
+}}
+
+/// Binds an arena to the current context for the scope. Subsystems which
+/// opt in take their short-lived allocations from the arena bound to their
+/// context (see this_ctx::arena()) rather than the global allocator; the
+/// owner of the arena releases them all at once at the end of its unit of
+/// work, such as a request. The previous binding is restored after the scope.
+///
+struct ircd::ctx::this_ctx::scope_arena
+{
+	allocator::arena *theirs;
+
+	scope_arena(allocator::arena &) noexcept;
+	scope_arena(scope_arena &&) = delete;
+	scope_arena(const scope_arena &) = delete;
+	~scope_arena() noexcept;
+};
+
+/// Arena bound to the current context, or null if none or not on a context.
+inline ircd::allocator::arena *
+ircd::ctx::this_ctx::arena()
+noexcept
+{
+	return current? arena(cur()) : nullptr;
+}
+
+inline
+ircd::ctx::this_ctx::scope_arena::scope_arena(allocator::arena &arena)
+noexcept
+:theirs
+{
+	ircd::ctx::arena(cur(), &arena)
+}
+{
+}
+
+inline
+ircd::ctx::this_ctx::scope_arena::~scope_arena()
+noexcept
+{
+	ircd::ctx::arena(cur(), theirs);
+}
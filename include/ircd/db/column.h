@@ -43,6 +43,7 @@ namespace ircd::db
 	bool has(column &, const string_view &key, const gopts & = {});
 	bool cached(column &, const string_view &key, const gopts & = {});
 	bool prefetch(column &, const string_view &key, const gopts & = {});
+	bool prefetch(column &, const std::pair<string_view, string_view> &range, const gopts & = {});
 
 	// [GET] Query space usage
 	size_t bytes(column &, const std::pair<string_view, string_view> &range, const gopts & = {});
@@ -19,6 +19,8 @@ namespace ircd::db
 	extern conf::item<bool> open_check;
 	extern conf::item<std::string> open_recover;
 	extern conf::item<bool> open_repair;
+	extern conf::item<bool> open_secondary;
+	extern conf::item<std::string> open_secondary_id;
 
 	// General information
 	const std::string &name(const database &);
@@ -60,6 +62,8 @@ namespace ircd::db
 	void sort(database &, const bool &blocking = true, const bool &now = true);
 	void flush(database &, const bool &sync = false);
 	void sync(database &);
+	bool refresh(database &);
+	void ingest(database &, const vector_view<const std::pair<string_view, string_view>> &); // column, path
 }
 
 /// Database instance
@@ -103,7 +107,7 @@ struct ircd::db::database
 	uint64_t checkpoint;
 	std::string path;
 	std::string optstr;
-	bool fsck, read_only;
+	bool fsck, read_only, secondary;
 	std::shared_ptr<struct env> env;
 	std::shared_ptr<struct stats> stats;
 	std::shared_ptr<struct logger> logger;
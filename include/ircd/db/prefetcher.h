@@ -29,6 +29,7 @@ struct ircd::db::prefetcher
 	size_t request_workers {0};
 
 	size_t wait_pending();
+	void request_handle_range(request &, column &);
 	void request_handle(request &);
 	size_t request_cleanup() noexcept;
 	void request_worker();
@@ -40,6 +41,7 @@ struct ircd::db::prefetcher
 	size_t cancel(database &);         // Cancel all for db
 	size_t cancel(column &);           // Cancel all for column
 
+	bool operator()(column &, const std::pair<string_view, string_view> &range, const gopts &);
 	bool operator()(column &, const string_view &key, const gopts &);
 
 	prefetcher();
@@ -52,14 +54,17 @@ struct ircd::db::prefetcher::request
 
 	database *d {nullptr};             // database instance
 	uint32_t cid {0};                  // column ID
-	uint32_t len {0};                  // length of key
+	uint16_t len {0};                  // length of key
+	uint16_t end_len {0};              // length of range end key after key
 	steady_point snd;                  // submitted by user
 	steady_point req;                  // request sent to database
 	steady_point fin;                  // result from database
 	key_buf key alignas(16);           // key buffer
 
+	explicit operator std::pair<string_view, string_view>() const noexcept;
 	explicit operator string_view() const noexcept;
 
+	request(database &d, const column &c, const std::pair<string_view, string_view> &range) noexcept;
 	request(database &d, const column &c, const string_view &key) noexcept;
 	request() = default;
 };
@@ -82,10 +87,12 @@ struct ircd::db::prefetcher::ticker
 	size_t fetches {0};       ///< Incremented before actual database operation
 	size_t fetched {0};       ///< Incremented after actual database operation
 	size_t cancels {0};       ///< Count of canceled operations
+	size_t ranges {0};        ///< Range requests added to the queue
 
 	// throughput totals
 	size_t fetched_bytes_key {0};      ///< Total bytes of key data received
 	size_t fetched_bytes_val {0};      ///< Total bytes of value data received
+	size_t fetched_bytes_range {0};    ///< Total bytes of range data received
 
 	// from last operation only
 	microseconds last_snd_req {0us};   ///< duration request was queued here
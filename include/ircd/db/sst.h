@@ -15,6 +15,7 @@ struct ircd::db::database::sst
 {
 	struct info;
 	struct dump;
+	struct writer;
 
 	static void tool(const vector_view<const string_view> &args);
 };
@@ -84,3 +85,28 @@ struct ircd::db::database::sst::dump
 	dump(dump &&) = delete;
 	dump(const dump &) = delete;
 };
+
+/// Generate an external SST file for a column outside of the write path.
+/// Updates are buffered and may arrive in any order; they are sorted by the
+/// column's comparator when finished. Later updates to the same key replace
+/// earlier ones just like within a txn. The resulting file can be ingested
+/// with db::ingest().
+struct ircd::db::database::sst::writer
+{
+	using update = std::tuple<std::string, std::string, op>;
+
+	database::column *column {nullptr};
+	std::string path;
+	std::vector<update> buf;
+
+  public:
+	size_t size() const                { return buf.size();                  }
+
+	void operator()(const op &, const string_view &key, const string_view &val = {});
+	sst::info finish();
+
+	writer(db::column, const string_view &path);
+	writer(writer &&) = default;
+	writer(const writer &) = delete;
+	~writer() noexcept;
+};
@@ -14,6 +14,7 @@
 namespace ircd::fs
 {
 	struct read_opts extern const read_opts_default;
+	struct read_op;
 
 	// Yields ircd::ctx for read into buffers; returns bytes read
 	size_t read(const fd &, const mutable_buffers &, const read_opts & = read_opts_default);
@@ -27,6 +28,9 @@ namespace ircd::fs
 	std::string read(const fd &, const read_opts & = read_opts_default);
 	std::string read(const string_view &path, const read_opts & = read_opts_default);
 
+	// Yields ircd::ctx once for a batch of reads; returns count of successes.
+	size_t read(const vector_view<read_op> &);
+
 	// Test whether bytes in the specified range are cached and should not block
 	bool fincore(const fd &, const size_t &, const read_opts & = read_opts_default);
 
@@ -56,6 +60,20 @@ struct ircd::fs::read_opts
 	read_opts(const off_t & = 0);
 };
 
+/// Single operation within a batch of reads. The ops are submitted together
+/// and the ctx yields once for the whole batch; each op's result is reported
+/// in its ret or eptr rather than throwing from the batch read() itself.
+struct ircd::fs::read_op
+{
+	const fs::fd *fd {nullptr};
+	read_opts opts;
+	mutable_buffer buf;
+
+	/// Result: bytes read into buf; or the error if eptr is set.
+	size_t ret {0};
+	std::exception_ptr eptr;
+};
+
 inline
 ircd::fs::read_opts::read_opts(const off_t &offset)
 :opts{offset, op::READ}
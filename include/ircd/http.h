@@ -238,6 +238,7 @@ struct ircd::http::request::head
 	string_view upgrade;
 	string_view range;
 	string_view if_range;
+	string_view accept_encoding;
 	size_t content_length {0};
 
 	string_view uri;       // full view of (path, query, fragmet)
@@ -279,6 +280,7 @@ struct ircd::http::response::head
 	string_view content_range;
 	string_view accept_range;
 	string_view transfer_encoding;
+	string_view content_encoding;
 	string_view server;
 	string_view location;
 
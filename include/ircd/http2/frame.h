@@ -21,8 +21,15 @@ struct ircd::http2::frame
 	struct header;
 	struct settings;
 	enum type :uint8_t;
+	enum flag :uint8_t;
+
+	static constexpr size_t header_size {9};
 
 	static string_view reflect(const type &);
+
+	// The header struct has host byte order; these convert the wire format.
+	static header read(const const_buffer &);
+	static const_buffer write(const mutable_buffer &, const type &, const uint8_t &flags, const uint32_t &stream_id, const const_buffer &payload = {});
 };
 
 struct ircd::http2::frame::header
@@ -49,3 +56,13 @@ enum ircd::http2::frame::type
 	WINDOW_UPDATE  = 0x8,
 	CONTINUATION   = 0x9,
 };
+
+enum ircd::http2::frame::flag
+:uint8_t
+{
+	END_STREAM     = 0x01,   // DATA, HEADERS
+	ACK            = 0x01,   // SETTINGS, PING
+	END_HEADERS    = 0x04,   // HEADERS, CONTINUATION
+	PADDED         = 0x08,   // DATA, HEADERS
+	PRIO           = 0x20,   // HEADERS (priority fields)
+};
@@ -0,0 +1,47 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_HTTP2_HPACK_H
+
+/// RFC 7541 header compression. The encoder only emits literals which are
+/// never added to the remote's table and are not Huffman coded; this costs
+/// some bytes on the wire but the encoder keeps no state. The decoder is
+/// complete and must see every header block of the connection in order.
+namespace ircd::http2::hpack
+{
+	struct decoder;
+
+	// Append a header field; the name is lower-cased as HTTP/2 requires.
+	void write(window_buffer &, const http::header &);
+
+	// Decode a Huffman coded string into buf; returns the view in buf.
+	string_view huffman(const mutable_buffer &buf, const const_buffer &in);
+}
+
+struct ircd::http2::hpack::decoder
+{
+	using closure = std::function<void (const string_view &name, const string_view &value)>;
+	using entry = std::pair<std::string, std::string>;
+
+	std::deque<entry> table;                     ///< dynamic table; newest first
+	size_t table_size {0};                       ///< RFC 7541 4.1 accounting
+	size_t table_max {4096};                     ///< current size from updates
+	size_t table_limit {4096};                   ///< our SETTINGS_HEADER_TABLE_SIZE
+
+	void evict(const size_t &max);
+	void insert(entry &&);
+	std::pair<string_view, string_view> get(const size_t &index) const;
+
+  public:
+	void operator()(const const_buffer &block, const closure &);
+
+	decoder(const size_t &table_limit = 4096);
+};
@@ -21,3 +21,4 @@ namespace ircd::http2
 #include "frame.h"
 #include "settings.h"
 #include "stream.h"
+#include "hpack.h"
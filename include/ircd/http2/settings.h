@@ -62,5 +62,24 @@ struct ircd::http2::settings
 	using code = frame::settings::code;
 	using array_type = std::array<uint32_t, num_of<code>()>;
 
+	uint32_t operator[](const code &) const;
+	uint32_t &operator[](const code &);
+
 	settings();
 };
+
+/// The array starts at the first code (1) rather than 0.
+inline uint32_t &
+ircd::http2::settings::operator[](const code &code)
+{
+	assert(code > 0 && code < code::_NUM_);
+	return array_type::operator[](code - 1);
+}
+
+inline uint32_t
+ircd::http2::settings::operator[](const code &code)
+const
+{
+	assert(code > 0 && code < code::_NUM_);
+	return array_type::operator[](code - 1);
+}
@@ -80,6 +80,7 @@
 #include "fmt.h"
 #include "http.h"
 #include "http2/http2.h"
+#include "compress.h"
 #include "magics.h"
 #include "conf.h"
 #include "stats.h"
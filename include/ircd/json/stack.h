@@ -115,6 +115,7 @@ struct ircd::json::stack::member
   public:
 	template<class... T> void append(const json::tuple<T...> &);
 	void append(const json::value &);
+	void splice(const string_view &strung);
 
 	member(object &po, const string_view &name);
 	member(stack &s, const string_view &name);
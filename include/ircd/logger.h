@@ -48,6 +48,10 @@ namespace ircd::log
 	void file_unmask(const vector_view<const string_view> & = {});
 	void file_mask(const vector_view<const string_view> & = {});
 
+	// Loggers in this list are written to the binary log file in a compact
+	// record format rather than as text to the per-level files.
+	void file_binary(const vector_view<const string_view> & = {});
+
 	// This suite adjusts the output for an entire level.
 	bool console_enabled(const level &);
 	void console_disable(const level &);
@@ -95,6 +99,7 @@ struct ircd::log::log
 	char snote;                        // snomask character
 	bool cmasked;                      // currently in the console mask (enabled)
 	bool fmasked;                      // currently in the file mask (enabled)
+	bool fbinary;                      // file output uses binary records
 
   public:
 	template<class... args> void operator()(const level &, const string_view &fmt, args&&...);
@@ -57,6 +57,8 @@ namespace ircd::m::dbs::appendix
 #include "room_state_space.h"       // room_id | type, state_key, depth, event_idx
 #include "room_joined.h"            // room_id | origin, member => event_idx
 #include "room_head.h"              // room_id | event_id => event_idx
+#include "user_mitsein.h"           // user_id | other_user_id, room_id
+#include "user_unread.h"            // user_id room_id => counts
 
 /// Options that affect the dbs::write() of an event to the transaction.
 struct ircd::m::dbs::write_opts
@@ -184,6 +186,9 @@ enum ircd::m::dbs::appendix::index
 	/// Involves room_joined table.
 	ROOM_JOINED,
 
+	/// Involves user_mitsein table; follows ROOM_JOINED.
+	USER_MITSEIN,
+
 	/// Take branch to handle room redaction events.
 	ROOM_REDACT,
 };
@@ -0,0 +1,43 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_MITSEIN_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t USER_MITSEIN_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 2 + id::MAX_SIZE + 1 + id::MAX_SIZE
+	};
+
+	// other is a user_id, or an origin when it has no '@' sigil.
+	string_view user_mitsein_key(const mutable_buffer &out, const id::user &, const string_view &other, const id::room & = {});
+	std::tuple<string_view, string_view> user_mitsein_key(const string_view &amalgam);
+
+	bool user_mitsein_built(const id::user &);
+	void _index_user_mitsein(db::txn &, const event &, const write_opts &);
+
+	// user_id | other_user_id, room_id
+	// user_id | "\0" origin, room_id
+	// user_id | "\0" (built)
+	extern db::domain user_mitsein;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<size_t> user_mitsein__block__size;
+	extern conf::item<size_t> user_mitsein__meta_block__size;
+	extern conf::item<size_t> user_mitsein__cache__size;
+	extern conf::item<size_t> user_mitsein__cache_comp__size;
+	extern conf::item<size_t> user_mitsein__bloom__bits;
+	extern const db::prefix_transform user_mitsein__pfx;
+	extern const db::descriptor user_mitsein;
+}
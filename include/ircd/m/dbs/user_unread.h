@@ -0,0 +1,35 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_UNREAD_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t USER_UNREAD_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE * 2
+	};
+
+	string_view user_unread_key(const mutable_buffer &out, const id::user &, const id::room &);
+
+	// user_id room_id => notification_count, highlight_count
+	extern db::column user_unread;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<size_t> user_unread__block__size;
+	extern conf::item<size_t> user_unread__meta_block__size;
+	extern conf::item<size_t> user_unread__cache__size;
+	extern conf::item<size_t> user_unread__cache_comp__size;
+	extern conf::item<size_t> user_unread__bloom__bits;
+	extern const db::descriptor user_unread;
+}
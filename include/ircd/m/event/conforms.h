@@ -37,9 +37,14 @@ struct ircd::m::event::conforms
 	void del(const code &code);
 	void operator|=(const code &) &;
 
+  private:
+	conforms(const event &, const preimage *const &);
+
+  public:
 	conforms() = default;
 	conforms(const event &);
 	conforms(const event &, const uint64_t &skip);
+	conforms(const event &, const preimage &, const uint64_t &skip = 0);
 
 	static code reflect(const string_view &);
 };
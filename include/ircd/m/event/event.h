@@ -100,6 +100,7 @@ struct ircd::m::event
 	struct fetch;
 	struct conforms;
 	struct append;
+	struct preimage;
 
 	using keys = json::keys<event>;
 	using id = m::id::event;
@@ -159,6 +160,7 @@ struct ircd::m::event
 #include "fetch.h"
 #include "cached.h"
 #include "prefetch.h"
+#include "preimage.h"
 #include "conforms.h"
 #include "pretty.h"
 #include "append.h"
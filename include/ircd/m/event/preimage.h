@@ -0,0 +1,45 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_EVENT_PREIMAGE_H
+
+namespace ircd::m
+{
+	bool check_id(const event &, const event::preimage &) noexcept;
+
+	bool verify(const event::preimage &, const ed25519::pk &, const ed25519::sig &sig);
+	bool verify(const event &, const event::preimage &, const string_view &origin); // io/yield
+	bool verify(const event &, const event::preimage &); // io/yield
+}
+
+/// Canonical preimage of an event. Checking an event's id and its signatures
+/// each require the event to be reduced and canonically stringified, and the
+/// reference preimage is identical for the v3+ event_id and for the ed25519
+/// signature. This device does that work once so the result can be shared by
+/// every check made on the same event during an evaluation rather than being
+/// recomputed by each of them.
+///
+/// The user supplies the buffer, which must remain valid for the lifetime
+/// of this object; buffer_size() provides a sufficient size for the event.
+///
+struct ircd::m::event::preimage
+{
+	/// Essential (redacted) event without signatures. This is the input to
+	/// signing, to verification and to the reference hash (event_id v3+).
+	json::object reference;
+
+	sha256::buf reference_hash;
+
+	static size_t buffer_size(const event &);
+
+	preimage(const mutable_buffer &, const event &);
+	preimage() = default;
+};
@@ -37,6 +37,12 @@
 /// conducting a parallel request to every server in a room; this conducts a
 /// serial request to every server in a room (and stopping when satisfied).
 ///
+/// Servers are chosen at random weighted by the success ratio and response
+/// time ircd::server has observed for each. When the server being attempted
+/// has not responded within a delay derived from its response time history,
+/// a second (hedge) request is made to another server; the first satisfying
+/// response of the two is the result.
+///
 namespace ircd::m::fetch
 {
 	struct init;
@@ -166,6 +172,23 @@ struct ircd::m::fetch::request
 	/// Our future for the server::request. Since we make
 	std::unique_ptr<server::request> future;
 
+	/// Time after which a hedge request is made if the current attempt has
+	/// not responded. Zero when no hedge is to be made.
+	system_point hedge_at;
+
+	/// Time the hedge request was started.
+	system_point hedged;
+
+	/// Server of the hedge request; also placed in the attempted set.
+	string_view hedge_origin;
+
+	/// HTTP heads and scratch buffer for the hedge request.
+	unique_buffer<mutable_buffer> hedge_buf;
+
+	/// The hedge request running concurrently with the current attempt. If
+	/// it responds satisfactorily first it becomes the current attempt.
+	std::unique_ptr<server::request> hedge;
+
 	/// Promise for our user's future of this request.
 	ctx::promise<result> promise;
 
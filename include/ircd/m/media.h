@@ -19,10 +19,17 @@ namespace ircd::m::media
 namespace ircd::m::media::file
 {
 	using closure = std::function<void (const const_buffer &)>;
+	using range = std::pair<size_t, size_t>; // [start, stop) byte offsets
+
+	constexpr const size_t block_size_max
+	{
+		32_KiB
+	};
 
 	room::id room_id(room::id::buf &out, const mxc &);
 	room::id::buf room_id(const mxc &);
 
+	size_t read(const room &, const range &, const closure &);
 	size_t read(const room &, const closure &);
 	size_t write(const room &, const user::id &, const const_buffer &content, const string_view &content_type);
 
@@ -40,8 +40,14 @@
 /// with the creator's room_id. This may be essential functionality when no
 /// power_levels event exists.
 ///
+/// Decoded tables of power_levels events are cached by event::idx and shared
+/// by all instances; user and event level queries are then hashed lookups
+/// rather than scans of the content.
+///
 struct ircd::m::room::power
 {
+	struct table;
+
 	using closure = std::function<void (const string_view &, const int64_t &)>;
 	using closure_bool = std::function<bool (const string_view &, const int64_t &)>;
 
@@ -54,6 +60,7 @@ struct ircd::m::room::power
 	event::idx power_event_idx {0};
 	json::object power_event_content;
 	m::id::user room_creator_id;
+	std::shared_ptr<const table> cache;
 
 	bool view(const std::function<void (const json::object &)> &) const;
 
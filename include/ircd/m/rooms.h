@@ -18,7 +18,11 @@ namespace ircd::m::rooms
 {
 	struct opts extern const opts_default;
 
+	// Also supplies the origin of the directory entry when opts.summary.
+	using origin_closure_bool = std::function<bool (const room::id &, const string_view &origin)>;
+
 	// Iterate the rooms
+	bool for_each(const opts &, const origin_closure_bool &);
 	bool for_each(const opts &, const room::id::closure_bool &);
 	bool for_each(const room::id::closure_bool &);
 
@@ -80,6 +84,10 @@ struct ircd::m::rooms::opts
 	/// Spec search term
 	string_view search_term;
 
+	/// Directory cursor from summary::index::cursor(); only valid with
+	/// summary. The iteration resumes after that position.
+	string_view since;
+
 	/// Specify prefetching to increase iteration performance.
 	size_t prefetch {0};
 
@@ -36,6 +36,21 @@ namespace ircd::m::rooms::summary
 	void del(const room &);
 }
 
+/// Directory index over every summary in the public rooms room. It is built
+/// on first use and then maintained by hooks on the summary set and delist
+/// events. Iteration is ordered by num_joined_members descending; a cursor
+/// resumes an iteration after the position it names, even if the index has
+/// changed in the meantime. Search terms are matched as prefixes of the
+/// words in the name, topic and aliases.
+namespace ircd::m::rooms::summary::index
+{
+	using closure = std::function<bool (const room::id &, const string_view &origin)>;
+
+	string_view cursor(const mutable_buffer &, const room::id &, const string_view &origin = {});
+	bool for_each(const rooms::opts &, const closure &);
+	size_t count(const string_view &origin = {});
+}
+
 struct ircd::m::rooms::summary::fetch
 {
 	// conf
@@ -122,6 +122,9 @@ struct ircd::m::sync::data
 	     const sync::args *const &args = nullptr,
 	     const device::id &device_id = {});
 
+	// For a part of the sync composed to its own json::stack.
+	data(const data &, json::stack &out);
+
 	data(data &&) = delete;
 	data(const data &) = delete;
 	~data() noexcept;
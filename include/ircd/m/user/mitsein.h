@@ -11,9 +11,14 @@
 #pragma once
 #define HAVE_IRCD_M_USER_MITSEIN_H
 
-/// Interface to the other users visible to a user from common rooms.
+/// Interface to the other users visible to a user from common rooms. For our
+/// own users and the "join" membership these are served by the user_mitsein
+/// index once it's built for the user; otherwise the rooms and their members
+/// are iterated.
 struct ircd::m::user::mitsein
 {
+	struct rebuild;
+
 	m::user user;
 
   public:
@@ -36,3 +41,9 @@ struct ircd::m::user::mitsein
 	:user{user}
 	{}
 };
+
+/// Rewrite the user_mitsein entries of one of our users from their rooms.
+struct ircd::m::user::mitsein::rebuild
+{
+	rebuild(const m::user &);
+};
@@ -30,6 +30,12 @@ struct ircd::m::user::notifications
 	size_t count(const opts &) const;
 	bool empty(const opts &) const;
 
+	// Notification and highlight counts in a room since the user's last
+	// read receipt there. These are kept in the _user_unread column; push
+	// evaluation increments them and the receipt resets them.
+	std::pair<long, long> unread(const room::id &) const;
+	void notified(const room::id &, const bool &highlight) const;
+
 	notifications(const m::user &user) noexcept;
 };
 
@@ -86,9 +86,11 @@ struct ircd::m::vm::eval
 	string_view room_id;
 	event::id::buf event_id;
 	event::conforms report;
+	const event::preimage *preimage {nullptr};
 	string_view room_version;
 	const hook::base::site *phase {nullptr};
 	bool room_internal {false};
+	allocator::arena arena;
 
 	static bool for_each_pdu(const std::function<bool (const event &)> &);
 	static const event *find_pdu(const eval &, const event::id &);
@@ -16,6 +16,12 @@ namespace ircd::net::dns::cache
 	extern conf::item<seconds> min_ttl;
 	extern conf::item<seconds> error_ttl;
 	extern conf::item<seconds> nxdomain_ttl;
+	extern conf::item<seconds> stale_ttl;
+	extern conf::item<size_t> prefetch_hits;
+	extern conf::item<size_t> prefetch_pct;
+	extern conf::item<size_t> mem_max;
+	extern conf::item<milliseconds> persist_interval;
+	extern conf::item<size_t> persist_batch;
 
 	string_view make_type(const mutable_buffer &out, const string_view &);
 	string_view make_type(const mutable_buffer &out, const uint16_t &);
@@ -113,6 +113,11 @@ struct ircd::net::open_opts
 
 	/// Option to allow expired certificates.
 	bool allow_expired { default_allow_expired };
+
+	/// Application protocols to offer in the ClientHello, in order of
+	/// preference. The selection is available from openssl::alpn() once
+	/// open; none is offered when empty.
+	vector_view<const string_view> alpn;
 };
 
 /// Constructor intended to provide implicit conversions (no-brackets required)
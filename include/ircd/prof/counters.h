@@ -0,0 +1,45 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_PROF_COUNTERS_H
+
+namespace ircd::prof
+{
+	struct counters;
+}
+
+/// Group of userspace hardware counters which are read directly with rdpmc
+/// rather than a syscall; cheap enough to sample at every context switch.
+/// Construction throws if the platform or the perf_event_paranoid setting
+/// does not permit this.
+struct ircd::prof::counters
+{
+	enum counter :uint8_t;
+	using sample_type = std::array<uint64_t, 3>;
+
+	prof::group group;
+
+  public:
+	sample_type sample() const;
+
+	counters();
+	counters(counters &&) = delete;
+	counters(const counters &) = delete;
+	~counters() noexcept;
+};
+
+enum ircd::prof::counters::counter
+:uint8_t
+{
+	CYCLES,
+	INSTRUCTIONS,
+	CACHE_MISSES,
+};
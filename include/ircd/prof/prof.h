@@ -41,6 +41,7 @@ namespace ircd::prof
 #include "syscall_timer.h"
 #include "syscall_usage_warning.h"
 #include "instructions.h"
+#include "counters.h"
 #include "resource.h"
 #include "times.h"
 #include "system.h"
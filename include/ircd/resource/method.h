@@ -16,9 +16,12 @@ struct ircd::resource::method
 	enum flag :uint;
 	struct opts;
 	struct stats;
+	struct tap;
 	using handler = std::function<response (client &, request &)>;
 
 	static ctx::dock idle_dock;
+	static conf::item<std::string> forward_remote;
+	static conf::item<seconds> forward_timeout;
 
 	struct resource *resource;
 	string_view name;
@@ -28,6 +31,7 @@ struct ircd::resource::method
 	unique_const_iterator<decltype(resource::methods)> methods_it;
 
 	void handle_timeout(client &) const;
+	response forward(client &, request &);
 	response call_handler(client &, request &);
 
   public:
@@ -63,6 +67,25 @@ struct ircd::resource::method::opts
 	std::pair<string_view, string_view> mime;
 };
 
+/// Observes every request dispatched to any method once its content has
+/// been received and before it is handled or forwarded. The closure is
+/// called for the lifetime of the instance; it must not yield.
+struct ircd::resource::method::tap
+:instance_list<ircd::resource::method::tap>
+{
+	using closure = std::function<void (const method &, const client &, const request &)>;
+
+	closure function;
+
+	tap(closure function) noexcept
+	:function{std::move(function)}
+	{}
+
+	tap(tap &&) = delete;
+	tap(const tap &) = delete;
+	~tap() noexcept;
+};
+
 struct ircd::resource::method::stats
 {
 	uint64_t pending {0};             // Clients currently inside the method
@@ -38,6 +38,12 @@ struct ircd::resource::response
 
 	static const size_t HEAD_BUF_SZ;
 	static conf::item<std::string> access_control_allow_origin;
+	static conf::item<bool> compress_enable;
+	static conf::item<size_t> compress_min_size;
+	static conf::item<size_t> compress_offload_size;
+
+	static compress::type coding(const client &, const http::code &, const string_view &content_type, const string_view &headers, const size_t &content_length);
+	static string_view coding_headers(const mutable_buffer &, const string_view &headers, const compress::type &);
 
 	response(client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {});
 	response(client &, const string_view &str, const string_view &content_type, const http::code &, const vector_view<const http::header> &);
@@ -81,6 +87,10 @@ struct ircd::resource::response
 /// encoding with some other content has the option of setting a zero buffer
 /// size on construction.
 ///
+/// When the request's Accept-Encoding allows it, the chunks are compressed as
+/// one stream; each write() flushes the compressor so the client can decode
+/// everything it has received so far.
+///
 struct ircd::resource::response::chunked
 :resource::response
 {
@@ -88,17 +98,23 @@ struct ircd::resource::response::chunked
 
 	client *c {nullptr};
 	unique_buffer<mutable_buffer> buf;
+	std::unique_ptr<compress::deflate> deflate;
+	unique_buffer<mutable_buffer> zbuf;
 	size_t flushed {0};
 	size_t wrote {0};
 	uint count {0};
 	bool finished {false};
 
+	size_t write_chunk(const const_buffer &chunk);
+
+  public:
 	size_t write(const const_buffer &chunk, const bool &ignore_empty = true);
 	const_buffer flush(const const_buffer &);
 	bool finish();
 
 	std::function<const_buffer (const const_buffer &)> flusher();
 
+	chunked(client &, const http::code &, const string_view &content_type, const string_view &headers, const size_t &buffer_size, const compress::type &);
 	chunked(client &, const http::code &, const string_view &content_type, const string_view &headers = {}, const size_t &buffer_size = default_buffer_size);
 	chunked(client &, const http::code &, const string_view &content_type, const vector_view<const http::header> &, const size_t &buffer_size = default_buffer_size);
 	chunked(client &, const http::code &, const vector_view<const http::header> &, const size_t &buffer_size = default_buffer_size);
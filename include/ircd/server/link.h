@@ -19,16 +19,28 @@ namespace ircd::server
 
 /// A single connection to a remote peer.
 ///
+/// When the remote selects h2 by ALPN the link multiplexes its tags as
+/// HTTP/2 streams rather than pipelining them; responses complete in any
+/// order and a canceled tag is reset without closing the link.
+///
 struct ircd::server::link
 {
+	struct h2;
+
 	static conf::item<size_t> tag_max_default;
 	static conf::item<size_t> tag_commit_max_default;
+	static conf::item<bool> http2_enable;
+	static conf::item<size_t> http2_streams_max;
+	static conf::item<size_t> http2_stream_window;
+	static conf::item<size_t> http2_conn_window;
+	static const string_view alpn[2];
 	static uint64_t ids;
 
 	uint64_t id {++ids};                         ///< unique identifier of link.
 	server::peer *peer;                          ///< backreference to peer
 	std::shared_ptr<net::socket> socket;         ///< link's socket
 	std::list<tag> queue;                        ///< link's work queue
+	std::unique_ptr<struct h2> h2;               ///< HTTP/2 session if negotiated
 	time_t synack_ts {0L};                       ///< time socket was estab
 	time_t read_ts {0L};                         ///< time of last read
 	time_t write_ts {0L};                        ///< time of last write
@@ -55,6 +67,9 @@ struct ircd::server::link
 	void handle_writable(const error_code &) noexcept;
 	void wait_writable();
 
+	void handle_readable_h2();
+	void handle_writable_h2();
+
 	void handle_close(std::exception_ptr);
 	void handle_open(std::exception_ptr);
 	void cleanup_canceled();
@@ -38,6 +38,10 @@ struct ircd::server::peer
 	std::string server_version;
 	size_t write_bytes {0};
 	size_t read_bytes {0};
+	size_t tag_done {0};               // responses with a success status
+	size_t tag_fail {0};               // error status or failed link
+	nanoseconds rtt {0};               // smoothed tag response time
+	nanoseconds rtt_var {0};           // smoothed mean deviation of rtt
 	bool op_resolve {false};
 	bool op_fini {false};
 
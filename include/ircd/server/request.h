@@ -91,6 +91,11 @@ struct ircd::server::in
 	/// An option can be set in request::opts to skip the last step.
 	std::vector<unique_buffer<mutable_buffer>> chunks;
 
+	/// Content-coding of content received into dynamic. The content is left
+	/// as it was received until request::get() decodes it on the context
+	/// which is waiting for the response rather than on the main stack.
+	compress::type coding {compress::type::IDENTITY};
+
 	/// Call server::in::gethead(request) to extract the details of the HTTP
 	/// response being received by the request. This may not always be
 	/// available if it has not been received or was discarded etc.
@@ -129,6 +134,11 @@ struct ircd::server::request
 	        server::in &&,
 	        const opts *const & = nullptr);
 
+	// Results as ctx::future; any content-coding is decoded by the caller.
+	http::code get();
+	template<class duration> http::code get(const duration &);
+	template<class time_point> http::code get_until(const time_point &);
+
 	request() = default;
 	request(request &&) noexcept;
 	request(const request &) = delete;
@@ -151,6 +161,11 @@ struct ircd::server::request::opts
 	/// is the same as if specifying an in.content buffer of this size.
 	size_t content_length_maxalloc {256_MiB};
 
+	/// Only applies to dynamic content received with a content-coding; this
+	/// limits the size of the content after decoding, which bounds how far
+	/// a small compressed response can expand.
+	size_t content_decode_maxalloc {32_MiB};
+
 	/// Only applies when using dynamic content allocation when the message is
 	/// received with chunked encoding. By default, chunks are saved in
 	/// individual buffers and copied to a final contiguous buffer. We skip
@@ -196,6 +211,22 @@ ircd::server::request::request(const net::hostport &hostport,
 	submit(hostport, *this);
 }
 
+template<class time_point>
+ircd::http::code
+ircd::server::request::get_until(const time_point &tp)
+{
+	this->wait_until(tp);
+	return get();
+}
+
+template<class duration>
+ircd::http::code
+ircd::server::request::get(const duration &d)
+{
+	this->wait(d);
+	return get();
+}
+
 inline
 ircd::server::request::request(request &&o)
 noexcept
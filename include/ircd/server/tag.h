@@ -39,6 +39,9 @@ struct ircd::server::tag
 		size_t chunk_read {0};         // content read after last chunk head
 		size_t chunk_length {0};       // -1 for chunk header mode
 		http::code status {(http::code)0};
+		compress::type coding {compress::type::IDENTITY};
+		uint32_t stream_id {0};        // HTTP/2 stream; 0 on HTTP/1.1 links
+		steady_point started {now<steady_point>()};
 	}
 	state;
 	ctx::promise<http::code> p;
@@ -189,6 +189,151 @@ noexcept
 {
 }
 
+//
+// allocator::arena
+//
+
+namespace ircd::allocator
+{
+	extern stats::item arena_served;
+	extern stats::item arena_obtained;
+	extern stats::item arena_resets;
+}
+
+/// Header of each chunk; the carved space follows it.
+struct ircd::allocator::arena::chunk
+{
+	chunk *next;
+	size_t size;
+};
+
+decltype(ircd::allocator::arena_served)
+ircd::allocator::arena_served
+{
+	{ "name", "ircd.allocator.arena.served" },
+	{ "desc", "Bytes allocated from arenas" },
+};
+
+decltype(ircd::allocator::arena_obtained)
+ircd::allocator::arena_obtained
+{
+	{ "name", "ircd.allocator.arena.obtained" },
+	{ "desc", "Bytes obtained from malloc by arenas to serve those allocations" },
+};
+
+decltype(ircd::allocator::arena_resets)
+ircd::allocator::arena_resets
+{
+	{ "name", "ircd.allocator.arena.resets" },
+	{ "desc", "Number of times an arena released its allocations" },
+};
+
+decltype(ircd::allocator::arena::chunk_size_default)
+ircd::allocator::arena::chunk_size_default
+{
+	8_KiB
+};
+
+ircd::allocator::arena::arena(const size_t &chunk_size)
+noexcept
+:chunk_size{chunk_size}
+{
+}
+
+ircd::allocator::arena::~arena()
+noexcept
+{
+	reset();
+	for(chunk *c(head), *next; c; c = next)
+	{
+		next = c->next;
+		std::free(c);
+	}
+}
+
+/// Releases everything allocated from the arena except the first chunk,
+/// which is retained for reuse.
+void
+ircd::allocator::arena::reset()
+noexcept
+{
+	if(!served && !obtained)
+		return;
+
+	arena_served += served;
+	arena_obtained += obtained;
+	++arena_resets;
+	served = 0;
+	obtained = 0;
+
+	for(chunk *c(large), *next; c; c = next)
+	{
+		next = c->next;
+		std::free(c);
+	}
+
+	large = nullptr;
+	while(head && head->next)
+	{
+		chunk *const next(head->next);
+		std::free(head);
+		head = next;
+	}
+
+	pos = head? reinterpret_cast<char *>(head + 1) : nullptr;
+	stop = head? pos + head->size : nullptr;
+}
+
+/// Slow path of allocate(). Allocations too large to share a chunk are made
+/// in a chunk of their own; otherwise a new head chunk is obtained and the
+/// remainder of the last one is abandoned.
+void *
+ircd::allocator::arena::grow(const size_t &size,
+                             const size_t &align)
+{
+	static_assert(sizeof(chunk) % alignof(std::max_align_t) == 0);
+	const size_t required
+	{
+		size + align
+	};
+
+	const bool dedicated
+	{
+		head && required > chunk_size / 4
+	};
+
+	const size_t chunk_bytes
+	{
+		dedicated? required : std::max(chunk_size, required)
+	};
+
+	auto *const c
+	{
+		reinterpret_cast<chunk *>(std::malloc(sizeof(chunk) + chunk_bytes))
+	};
+
+	if(unlikely(!c))
+		throw std::bad_alloc{};
+
+	c->size = chunk_bytes;
+	obtained += sizeof(chunk) + chunk_bytes;
+	if(dedicated)
+	{
+		c->next = large;
+		large = c;
+		served += size;
+
+		const auto addr(uintptr_t(c + 1));
+		return reinterpret_cast<void *>((addr + (align - 1)) & ~uintptr_t(align - 1));
+	}
+
+	c->next = head;
+	head = c;
+	pos = reinterpret_cast<char *>(c + 1);
+	stop = pos + c->size;
+	return allocate(size, align);
+}
+
 //
 // allocator::profile
 //
@@ -753,6 +753,18 @@ try
 	timer = ircd::timer{};
 	++request_count;
 
+	// Allocations made on behalf of this request by subsystems which opt in
+	// are taken from the client's arena and all released when it's done.
+	const unwind reset_arena{[this]
+	{
+		arena.reset();
+	}};
+
+	const ctx::scope_arena scope_arena
+	{
+		arena
+	};
+
 	// This timeout covers the reception of a complete HTTP head. If the
 	// head was fragmented and has not entirely arrived yet this function
 	// will block this request context below. The timeout limits that.
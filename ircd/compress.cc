@@ -0,0 +1,591 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <RB_INC_ZLIB_H
+#include <RB_INC_ZSTD_H
+
+namespace ircd::compress
+{
+	static void inflate_gzip(unique_buffer<mutable_buffer> &, size_t &, const const_buffer &, const size_t &);
+	static void inflate_zstd(unique_buffer<mutable_buffer> &, size_t &, const const_buffer &, const size_t &);
+	static void grow(unique_buffer<mutable_buffer> &, const size_t &used, const size_t &max);
+
+	extern conf::item<int32_t> gzip_level;
+	extern conf::item<int32_t> zstd_level;
+}
+
+/// Codec state; only the member for the deflate's coding is initialized.
+struct ircd::compress::deflate::state
+{
+	#ifdef HAVE_ZLIB_H
+	z_stream z {};
+	#endif
+
+	#ifdef HAVE_ZSTD_H
+	ZSTD_CCtx *zstd {nullptr};
+	#endif
+};
+
+decltype(ircd::compress::zlib_version_api)
+ircd::compress::zlib_version_api
+{
+	"zlib", info::versions::API, 0,
+	#ifdef HAVE_ZLIB_H
+	{
+		ZLIB_VER_MAJOR,
+		ZLIB_VER_MINOR,
+		ZLIB_VER_REVISION,
+	},
+	ZLIB_VERSION
+	#endif
+};
+
+decltype(ircd::compress::zlib_version_abi)
+ircd::compress::zlib_version_abi
+{
+	"zlib", info::versions::ABI, 0, {0},
+	#ifdef HAVE_ZLIB_H
+	::zlibVersion()
+	#endif
+};
+
+decltype(ircd::compress::zstd_version_api)
+ircd::compress::zstd_version_api
+{
+	"zstd", info::versions::API,
+	#ifdef HAVE_ZSTD_H
+	ZSTD_VERSION_NUMBER,
+	{
+		ZSTD_VERSION_MAJOR,
+		ZSTD_VERSION_MINOR,
+		ZSTD_VERSION_RELEASE,
+	},
+	ZSTD_VERSION_STRING
+	#endif
+};
+
+decltype(ircd::compress::zstd_version_abi)
+ircd::compress::zstd_version_abi
+{
+	"zstd", info::versions::ABI,
+	#ifdef HAVE_ZSTD_H
+	long(::ZSTD_versionNumber()), {0}, ::ZSTD_versionString()
+	#endif
+};
+
+decltype(ircd::compress::gzip_level)
+ircd::compress::gzip_level
+{
+	{ "name",     "ircd.compress.gzip.level" },
+	{ "default",  1L                         },
+	{ "description",
+
+	R"(
+	Compression level for gzip content-coding from 1 to 9. The lowest level
+	still reduces JSON to a fraction of its size for the least cpu.
+	)"}
+};
+
+decltype(ircd::compress::zstd_level)
+ircd::compress::zstd_level
+{
+	{ "name",     "ircd.compress.zstd.level" },
+	{ "default",  3L                         },
+	{ "description",
+
+	R"(
+	Compression level for zstd content-coding from 1 to 19. Levels past the
+	default cost considerably more cpu for a small gain on JSON.
+	)"}
+};
+
+ircd::string_view
+ircd::compress::accept()
+noexcept
+{
+	return
+		available(type::ZSTD) && available(type::GZIP)?
+			"zstd, gzip"_sv:
+		available(type::GZIP)?
+			"gzip"_sv:
+		available(type::ZSTD)?
+			"zstd"_sv:
+			"identity"_sv;
+}
+
+/// Picks the available coding with the highest quality value in the
+/// Accept-Encoding; zstd wins a tie with gzip. A wildcard stands for gzip.
+ircd::compress::type
+ircd::compress::negotiate(const string_view &accept_encoding)
+noexcept
+{
+	type ret {type::IDENTITY};
+	double best {0.0};
+	tokens(accept_encoding, ',', [&ret, &best]
+	(const string_view &token)
+	{
+		const auto &[coding_, params]
+		{
+			split(strip(token), ';')
+		};
+
+		const auto &[q_key, q_val]
+		{
+			split(strip(params), '=')
+		};
+
+		const double q
+		{
+			q_key == "q" && lex_castable<double>(strip(q_val))?
+				lex_cast<double>(strip(q_val)):
+				1.0
+		};
+
+		const string_view coding
+		{
+			strip(coding_)
+		};
+
+		const type t
+		{
+			coding == "*"?
+				type::GZIP:
+				parse(coding)
+		};
+
+		if(t == type::IDENTITY || !available(t) || q <= 0.0)
+			return;
+
+		if(q > best || (q == best && t == type::ZSTD))
+		{
+			ret = t;
+			best = q;
+		}
+	});
+
+	return ret;
+}
+
+/// Upper bound on the output of deflate for an input of size; this includes
+/// the framing of the stream and the flush made by each call.
+size_t
+ircd::compress::bound(const type &type,
+                      const size_t &size)
+noexcept
+{
+	switch(type)
+	{
+		case type::GZIP:
+			return size + (size >> 12) + (size >> 14) + (size >> 25) + 64;
+
+		case type::ZSTD:
+			return size + (size >> 8) + 128;
+
+		case type::IDENTITY:
+		default:
+			return size;
+	}
+}
+
+bool
+ircd::compress::available(const type &type)
+noexcept
+{
+	switch(type)
+	{
+		#ifdef HAVE_ZLIB_H
+		case type::GZIP:
+			return true;
+		#endif
+
+		#ifdef HAVE_ZSTD_H
+		case type::ZSTD:
+			return true;
+		#endif
+
+		case type::IDENTITY:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+ircd::compress::type
+ircd::compress::parse(const string_view &coding)
+noexcept
+{
+	return
+		iequals(coding, "gzip"_sv) || iequals(coding, "x-gzip"_sv)?
+			type::GZIP:
+		iequals(coding, "zstd"_sv)?
+			type::ZSTD:
+			type::IDENTITY;
+}
+
+ircd::string_view
+ircd::compress::reflect(const type &type)
+noexcept
+{
+	switch(type)
+	{
+		case type::IDENTITY:   return "identity";
+		case type::GZIP:       return "gzip";
+		case type::ZSTD:       return "zstd";
+	}
+
+	return "??????";
+}
+
+//
+// inflate
+//
+
+ircd::const_buffer
+ircd::compress::inflate(unique_buffer<mutable_buffer> &buf,
+                        const type &type,
+                        const const_buffer &in,
+                        const size_t &max)
+{
+	// Initial guess at the decoded size; grown by doubling from there.
+	const size_t initial
+	{
+		std::min(max, std::max(size(in) * 4, size_t(64_KiB)))
+	};
+
+	size_t used(0);
+	if(size(buf) < initial)
+		buf = unique_buffer<mutable_buffer>
+		{
+			initial
+		};
+
+	switch(type)
+	{
+		case type::GZIP:
+			inflate_gzip(buf, used, in, max);
+			break;
+
+		case type::ZSTD:
+			inflate_zstd(buf, used, in, max);
+			break;
+
+		case type::IDENTITY:
+			used = copy(buf, in);
+			break;
+	}
+
+	return const_buffer
+	{
+		data(buf), used
+	};
+}
+
+/// Replaces buf with one twice the size (up to max) holding its first used
+/// bytes; throws when buf is already at max.
+void
+ircd::compress::grow(unique_buffer<mutable_buffer> &buf,
+                     const size_t &used,
+                     const size_t &max)
+{
+	if(size(buf) >= max)
+		throw error
+		{
+			"Decoded content exceeds the maximum of %zu bytes", max
+		};
+
+	unique_buffer<mutable_buffer> next
+	{
+		std::min(size(buf) * 2, max)
+	};
+
+	copy(next, const_buffer{data(buf), used});
+	buf = std::move(next);
+}
+
+#ifdef HAVE_ZLIB_H
+void
+ircd::compress::inflate_gzip(unique_buffer<mutable_buffer> &buf,
+                             size_t &used,
+                             const const_buffer &in,
+                             const size_t &max)
+{
+	z_stream z {};
+	if(::inflateInit2(&z, 15 + 32) != Z_OK) // gzip or zlib header detected
+		throw error
+		{
+			"inflateInit2() :%s", z.msg?: "failed"
+		};
+
+	const unwind end{[&z]
+	{
+		::inflateEnd(&z);
+	}};
+
+	z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(in)));
+	z.avail_in = size(in);
+	for(int ret(Z_OK); ret != Z_STREAM_END;)
+	{
+		if(used == size(buf))
+			grow(buf, used, max);
+
+		z.next_out = reinterpret_cast<Bytef *>(data(buf) + used);
+		z.avail_out = size(buf) - used;
+		ret = ::inflate(&z, Z_NO_FLUSH);
+		used = size(buf) - z.avail_out;
+		if(ret == Z_BUF_ERROR && !z.avail_in)
+			throw error
+			{
+				"Truncated gzip content after %zu bytes", size(in)
+			};
+
+		if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+			throw error
+			{
+				"inflate() :%s", z.msg?: "failed"
+			};
+	}
+}
+#else
+void
+ircd::compress::inflate_gzip(unique_buffer<mutable_buffer> &buf,
+                             size_t &used,
+                             const const_buffer &in,
+                             const size_t &max)
+{
+	throw error
+	{
+		"gzip is not available in this build."
+	};
+}
+#endif
+
+#ifdef HAVE_ZSTD_H
+void
+ircd::compress::inflate_zstd(unique_buffer<mutable_buffer> &buf,
+                             size_t &used,
+                             const const_buffer &in,
+                             const size_t &max)
+{
+	const std::unique_ptr<ZSTD_DCtx, decltype(&::ZSTD_freeDCtx)> dctx
+	{
+		::ZSTD_createDCtx(), &::ZSTD_freeDCtx
+	};
+
+	if(!dctx)
+		throw std::bad_alloc{};
+
+	ZSTD_inBuffer zin
+	{
+		data(in), size(in), 0
+	};
+
+	for(size_t ret(1); ret != 0;)
+	{
+		if(used == size(buf))
+			grow(buf, used, max);
+
+		ZSTD_outBuffer zout
+		{
+			data(buf), size(buf), used
+		};
+
+		ret = ::ZSTD_decompressStream(dctx.get(), &zout, &zin);
+		used = zout.pos;
+		if(::ZSTD_isError(ret))
+			throw error
+			{
+				"ZSTD_decompressStream() :%s", ::ZSTD_getErrorName(ret)
+			};
+
+		if(ret != 0 && zin.pos == zin.size && used < size(buf))
+			throw error
+			{
+				"Truncated zstd content after %zu bytes", size(in)
+			};
+	}
+}
+#else
+void
+ircd::compress::inflate_zstd(unique_buffer<mutable_buffer> &buf,
+                             size_t &used,
+                             const const_buffer &in,
+                             const size_t &max)
+{
+	throw error
+	{
+		"zstd is not available in this build."
+	};
+}
+#endif
+
+//
+// deflate
+//
+
+ircd::compress::deflate::deflate(const type &coding)
+:coding{coding}
+,s{std::make_unique<state>()}
+{
+	switch(coding)
+	{
+		#ifdef HAVE_ZLIB_H
+		case type::GZIP:
+		{
+			// Window bits of 15 + 16 selects the gzip header and trailer.
+			const int level(std::clamp(int(gzip_level), 1, 9));
+			if(::deflateInit2(&s->z, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw error
+				{
+					"deflateInit2() :%s", s->z.msg?: "failed"
+				};
+
+			return;
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD_H
+		case type::ZSTD:
+		{
+			s->zstd = ::ZSTD_createCCtx();
+			if(!s->zstd)
+				throw std::bad_alloc{};
+
+			::ZSTD_CCtx_setParameter(s->zstd, ZSTD_c_compressionLevel, int(zstd_level));
+			return;
+		}
+		#endif
+
+		case type::IDENTITY:
+			return;
+
+		default:
+			throw error
+			{
+				"%s is not available in this build.", reflect(coding)
+			};
+	}
+}
+
+ircd::compress::deflate::~deflate()
+noexcept
+{
+	switch(coding)
+	{
+		#ifdef HAVE_ZLIB_H
+		case type::GZIP:
+			::deflateEnd(&s->z);
+			break;
+		#endif
+
+		#ifdef HAVE_ZSTD_H
+		case type::ZSTD:
+			::ZSTD_freeCCtx(s->zstd);
+			break;
+		#endif
+
+		default:
+			break;
+	}
+}
+
+ircd::const_buffer
+ircd::compress::deflate::operator()(const mutable_buffer &out,
+                                    const const_buffer &in,
+                                    const bool &finish)
+{
+	switch(coding)
+	{
+		#ifdef HAVE_ZLIB_H
+		case type::GZIP:
+		{
+			auto &z(s->z);
+			z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(in)));
+			z.avail_in = size(in);
+			z.next_out = reinterpret_cast<Bytef *>(data(out));
+			z.avail_out = size(out);
+			const int ret
+			{
+				::deflate(&z, finish? Z_FINISH : Z_SYNC_FLUSH)
+			};
+
+			if(ret != Z_OK && ret != Z_STREAM_END && !(ret == Z_BUF_ERROR && !z.avail_in))
+				throw error
+				{
+					"deflate() :%s", z.msg?: "failed"
+				};
+
+			if(z.avail_in || !z.avail_out || (finish && ret != Z_STREAM_END))
+				throw error
+				{
+					"deflate() output buffer of %zu bytes too small for %zu bytes",
+					size(out),
+					size(in),
+				};
+
+			return const_buffer
+			{
+				data(out), size(out) - z.avail_out
+			};
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD_H
+		case type::ZSTD:
+		{
+			ZSTD_inBuffer zin
+			{
+				data(in), size(in), 0
+			};
+
+			ZSTD_outBuffer zout
+			{
+				data(out), size(out), 0
+			};
+
+			const size_t ret
+			{
+				::ZSTD_compressStream2(s->zstd, &zout, &zin, finish? ZSTD_e_end : ZSTD_e_flush)
+			};
+
+			if(::ZSTD_isError(ret))
+				throw error
+				{
+					"ZSTD_compressStream2() :%s", ::ZSTD_getErrorName(ret)
+				};
+
+			if(ret != 0 || zin.pos != zin.size)
+				throw error
+				{
+					"ZSTD_compressStream2() output buffer of %zu bytes too small for %zu bytes",
+					size(out),
+					size(in),
+				};
+
+			return const_buffer
+			{
+				data(out), zout.pos
+			};
+		}
+		#endif
+
+		case type::IDENTITY:
+			return const_buffer
+			{
+				data(out), copy(out, in)
+			};
+
+		default:
+			throw error
+			{
+				"%s is not available in this build.", reflect(coding)
+			};
+	}
+}
@@ -21,6 +21,11 @@ ircd::ctx::log
 // ctx::ctx (internal)
 //
 
+namespace ircd::ctx
+{
+	template<class function> static void spawn_coroutine(function&&, const boost::coroutines::attributes &);
+}
+
 /// Allocator instance for the ctx instance_list. This allocator will place
 /// the std::list nodes in the ctx struct itself.
 template<>
@@ -104,7 +109,70 @@ ircd::ctx::ctx::spawn(context::function func)
 	};
 
 	mark(prof::event::SPAWN);
-	boost::asio::spawn(ios::get(), std::move(bound), attrs);
+	spawn_coroutine(std::move(bound), attrs);
+}
+
+/// This is boost::asio::spawn() except the coroutine is given our stack
+/// allocator; asio has no way to pass one through. The rest mirrors asio's
+/// own spawn_helper so the yield_context behaves identically. The internals
+/// this relies on were replaced in boost 1.80; from there asio's spawn() is
+/// used and the stacks are boost's own.
+template<class function>
+void
+ircd::ctx::spawn_coroutine(function&& func,
+                           const boost::coroutines::attributes &attrs)
+{
+	#if BOOST_VERSION < 108000
+	static const auto make_handler{[]
+	{
+		#if BOOST_VERSION >= 107000
+			auto strand(boost::asio::make_strand(ios::get()));
+		#else
+			boost::asio::io_context::strand strand(ios::get());
+		#endif
+
+		return boost::asio::bind_executor(strand, &boost::asio::detail::default_spawn_handler);
+	}};
+
+	using handler_type = decltype(make_handler());
+
+	using function_type = std::decay_t<function>;
+	using data_type = boost::asio::detail::spawn_data<handler_type, function_type>;
+	using entry_type = boost::asio::detail::coro_entry_point<handler_type, function_type>;
+	using callee_type = typename boost::asio::basic_yield_context<handler_type>::callee_type;
+
+	std::shared_ptr<data_type> data
+	{
+		new data_type
+		{
+			make_handler(), true, std::forward<function>(func)
+		}
+	};
+
+	// The coroutine is entered on the handler's strand as asio does.
+	const auto executor
+	{
+		boost::asio::get_associated_executor(data->handler_)
+	};
+
+	boost::asio::dispatch(executor, [data(std::move(data)), attrs]
+	{
+		entry_type entry_point
+		{
+			data
+		};
+
+		std::shared_ptr<callee_type> coro
+		{
+			new callee_type(entry_point, attrs, stack::allocator{})
+		};
+
+		data->coro_ = coro;
+		(*coro)();
+	});
+	#else
+	boost::asio::spawn(ios::get(), std::forward<function>(func), attrs);
+	#endif
 }
 
 /// Base frame for a context.
@@ -387,6 +455,184 @@ const noexcept
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+//
+// ctx::stack::allocator
+//
+
+decltype(ircd::ctx::stack::allocator::cache_max)
+ircd::ctx::stack::allocator::cache_max
+{
+	{ "name",     "ircd.ctx.stack.cache.max" },
+	{ "default",  64L                        },
+	{ "description",
+
+	R"(
+	Maximum number of released stacks kept for reuse in each size class.
+	Stacks released beyond this are unmapped.
+	)"}
+};
+
+decltype(ircd::ctx::stack::allocator::cache_trim)
+ircd::ctx::stack::allocator::cache_trim
+{
+	{ "name",     "ircd.ctx.stack.cache.trim" },
+	{ "default",  true                        },
+	{ "description",
+
+	R"(
+	Give the pages of cached stacks back to the kernel while they are idle.
+	The top page is kept resident because every context touches it.
+	)"}
+};
+
+decltype(ircd::ctx::stack::allocator::mapped_bytes)
+ircd::ctx::stack::allocator::mapped_bytes
+{
+	{ "name", "ircd.ctx.stack.mapped.bytes"                           },
+	{ "desc", "Address space reserved for context stacks (lazily committed)" },
+};
+
+decltype(ircd::ctx::stack::allocator::mapped_count)
+ircd::ctx::stack::allocator::mapped_count
+{
+	{ "name", "ircd.ctx.stack.mapped.count"                 },
+	{ "desc", "Number of context stacks currently mapped"   },
+};
+
+decltype(ircd::ctx::stack::allocator::cached_count)
+ircd::ctx::stack::allocator::cached_count
+{
+	{ "name", "ircd.ctx.stack.cached.count"                      },
+	{ "desc", "Number of idle context stacks held for reuse"     },
+};
+
+decltype(ircd::ctx::stack::allocator::reuse_count)
+ircd::ctx::stack::allocator::reuse_count
+{
+	{ "name", "ircd.ctx.stack.reuse.count"                          },
+	{ "desc", "Number of context stacks served from the free list"  },
+};
+
+decltype(ircd::ctx::stack::allocator::cache)
+ircd::ctx::stack::allocator::cache;
+
+void
+ircd::ctx::stack::allocator::allocate(boost::coroutines::stack_context &sc,
+                                      std::size_t size)
+{
+	const size_t &page_size
+	{
+		info::page_size
+	};
+
+	const size_t &class_size
+	{
+		size_class(size)
+	};
+
+	auto &list
+	{
+		cache[class_size]
+	};
+
+	uintptr_t map;
+	if(!list.empty())
+	{
+		map = list.back();
+		list.pop_back();
+		--cached_count;
+		++reuse_count;
+	}
+	else
+	{
+		static const auto prot
+		{
+			PROT_READ | PROT_WRITE
+		};
+
+		static const auto flags
+		{
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK
+		};
+
+		void *const ptr
+		{
+			::mmap(nullptr, page_size + class_size, prot, flags, -1, 0)
+		};
+
+		if(unlikely(ptr == MAP_FAILED))
+			throw_system_error(errno);
+
+		// Stacks grow down; the guard page is at the lowest address.
+		map = uintptr_t(ptr);
+		syscall(::mprotect, ptr, page_size, PROT_NONE);
+		mapped_bytes += page_size + class_size;
+		++mapped_count;
+	}
+
+	sc.size = class_size;
+	sc.sp = reinterpret_cast<void *>(map + page_size + class_size);
+}
+
+void
+ircd::ctx::stack::allocator::deallocate(boost::coroutines::stack_context &sc)
+noexcept
+{
+	const size_t &page_size
+	{
+		info::page_size
+	};
+
+	const size_t &class_size
+	{
+		sc.size
+	};
+
+	const uintptr_t top
+	{
+		reinterpret_cast<uintptr_t>(sc.sp)
+	};
+
+	const uintptr_t map
+	{
+		top - class_size - page_size
+	};
+
+	auto &list
+	{
+		cache[class_size]
+	};
+
+	if(list.size() < size_t(cache_max))
+	{
+		if(cache_trim && class_size > page_size)
+			::madvise(reinterpret_cast<void *>(map + page_size), class_size - page_size, MADV_DONTNEED);
+
+		list.emplace_back(map);
+		++cached_count;
+		return;
+	}
+
+	::munmap(reinterpret_cast<void *>(map), page_size + class_size);
+	mapped_bytes -= page_size + class_size;
+	--mapped_count;
+}
+
+size_t
+ircd::ctx::stack::allocator::size_class(const size_t &size)
+noexcept
+{
+	size_t ret
+	{
+		info::page_size
+	};
+
+	while(ret < size)
+		ret <<= 1;
+
+	return ret;
+}
+
 //
 // ctx/ctx.h
 //
@@ -522,6 +768,22 @@ ircd::ctx::interruptible(ctx &ctx,
 		ctx.flags |= context::NOINTERRUPT;
 }
 
+/// Binds `arena` to `ctx` for allocations made on behalf of its work by the
+/// subsystems which opt in. Returns the previously bound arena.
+ircd::allocator::arena *
+ircd::ctx::arena(ctx &ctx,
+                 allocator::arena *const arena)
+noexcept
+{
+	allocator::arena *const theirs
+	{
+		ctx.arena
+	};
+
+	ctx.arena = arena;
+	return theirs;
+}
+
 int8_t
 ircd::ctx::nice(ctx &ctx,
                 const int8_t &val)
@@ -637,6 +899,15 @@ noexcept
 	return ctx.nice;
 }
 
+/// Returns the arena bound to `ctx` or null
+[[gnu::hot]]
+ircd::allocator::arena *
+ircd::ctx::arena(const ctx &ctx)
+noexcept
+{
+	return ctx.arena;
+}
+
 /// Returns the yield count for `ctx`
 [[gnu::hot]]
 const uint64_t &
@@ -1591,7 +1862,14 @@ namespace ircd::ctx::prof
 	thread_local ulong _slice_start;     // Current/last time slice started
 	thread_local ulong _slice_stop;      // Last time slice ended
 	thread_local ticker _total;          // Totals kept for all contexts.
-
+	thread_local ulong _charge_start;    // Cycles when the current node was last charged
+	thread_local ircd::prof::counters::sample_type _charge_counters;
+	std::unique_ptr<ircd::prof::counters> _counters;
+	bool _counters_tried;
+
+	static void counters_init() noexcept;
+	static node &cur_node(ctx &) noexcept;
+	static void charge(node &, const bool &slice) noexcept;
 	static void check_stack();
 	static void check_slice();
 	static void slice_enter() noexcept;
@@ -1647,6 +1925,17 @@ ircd::ctx::prof::settings::slice_assertion
 	{ "persist",  false                           },
 };
 
+// hardware counters are opened at the first slice when this is set.
+decltype(ircd::ctx::prof::settings::counters_enable)
+ircd::ctx::prof::settings::counters_enable
+{
+	{ "name",     "ircd.ctx.prof.counters.enable" },
+	{ "default",  true                            },
+};
+
+decltype(ircd::ctx::prof::node::root)
+ircd::ctx::prof::node::root;
+
 [[gnu::hot]]
 void
 ircd::ctx::prof::mark(const event &e)
@@ -1716,7 +2005,15 @@ noexcept
 {
 	assert(ctx::ios_desc.stats);
 	++ctx::ios_desc.stats->calls;
+
+	if(unlikely(!_counters_tried))
+		counters_init();
+
+	if(likely(_counters))
+		_charge_counters = _counters->sample();
+
 	_slice_start = cycles();
+	_charge_start = _slice_start;
 	assert(_slice_start >= _slice_stop);
 }
 
@@ -1748,6 +2045,72 @@ noexcept
 	c.ios_desc.stats->slice_total += last_slice;
 	c.ios_desc.stats->slice_last = last_slice;
 	c.stack.at = stack_at_here();
+	charge(cur_node(c), true);
+}
+
+/// Add everything since the last charge to the node.
+[[gnu::hot]]
+void
+ircd::ctx::prof::charge(node &node,
+                        const bool &slice)
+noexcept
+{
+	const auto now
+	{
+		cycles()
+	};
+
+	static constexpr auto pos
+	{
+		size_t(counter::CYCLES)
+	};
+
+	node.count[size_t(counter::SLICES)] += slice;
+	node.count[size_t(counter::TSC)] += now - _charge_start;
+	_charge_start = now;
+
+	if(!_counters)
+		return;
+
+	const auto sample
+	{
+		_counters->sample()
+	};
+
+	for(size_t i(0); i < sample.size(); ++i)
+		node.count[pos + i] += sample[i] - _charge_counters[i];
+
+	_charge_counters = sample;
+}
+
+[[gnu::hot]]
+ircd::ctx::prof::node &
+ircd::ctx::prof::cur_node(ctx &c)
+noexcept
+{
+	if(unlikely(!c.profile.node))
+		c.profile.node = &node::root.child(c.name);
+
+	return *c.profile.node;
+}
+
+void
+ircd::ctx::prof::counters_init()
+noexcept try
+{
+	_counters_tried = true;
+	if(!settings::counters_enable)
+		return;
+
+	_counters = std::make_unique<ircd::prof::counters>();
+}
+catch(const std::exception &e)
+{
+	log::warning
+	{
+		log, "Hardware counters are not available for context profiling :%s",
+		e.what(),
+	};
 }
 
 #ifndef NDEBUG
@@ -1908,6 +2271,56 @@ noexcept
 	return c.profile;
 }
 
+/// Bytes of the context's stack actually resident in memory, as opposed to
+/// the high-water mark sampled at each sleep (stack_at). This makes a
+/// mincore(2) call over the stack and is not meant for hot paths.
+size_t
+ircd::ctx::prof::stack_committed(const ctx &c)
+{
+	if(!c.stack.base || !c.stack.max)
+		return 0;
+
+	const size_t &page_size
+	{
+		info::page_size
+	};
+
+	const uintptr_t top
+	{
+		(c.stack.base + page_size - 1) & ~(page_size - 1)
+	};
+
+	const uintptr_t bottom
+	{
+		(c.stack.base - c.stack.max) & ~(page_size - 1)
+	};
+
+	const size_t pages
+	{
+		(top - bottom) / page_size
+	};
+
+	thread_local std::array<uint8_t, 1024> tls_vec;
+	std::vector<uint8_t> dynamic_vec(pages > tls_vec.size()? pages: 0UL);
+	uint8_t *const vec
+	{
+		pages > tls_vec.size()? dynamic_vec.data(): tls_vec.data()
+	};
+
+	if(::mincore(reinterpret_cast<void *>(bottom), top - bottom, vec) != 0)
+		return 0;
+
+	const auto resident
+	{
+		std::count_if(vec, vec + pages, [](const uint8_t &b)
+		{
+			return b & 0x01;
+		})
+	};
+
+	return resident * page_size;
+}
+
 [[gnu::hot]]
 const uint64_t &
 ircd::ctx::prof::get(const event &e)
@@ -1923,6 +2336,48 @@ noexcept
 	return _total;
 }
 
+ircd::string_view
+ircd::ctx::prof::path(const mutable_buffer &buf,
+                      const node &node,
+                      const char &sep)
+{
+	size_t i(0);
+	const prof::node *stack[32];
+	for(auto *n(&node); n && n->parent && i < 32; n = n->parent)
+		stack[i++] = n;
+
+	char *pos(data(buf));
+	char *const end(data(buf) + size(buf));
+	while(i--)
+	{
+		if(pos != data(buf) && pos < end)
+			*pos++ = sep;
+
+		pos += copy(mutable_buffer{pos, end}, string_view{stack[i]->name});
+	}
+
+	return string_view
+	{
+		data(buf), pos
+	};
+}
+
+ircd::string_view
+ircd::ctx::prof::reflect(const counter &c)
+{
+	switch(c)
+	{
+		case counter::SLICES:         return "SLICES";
+		case counter::TSC:            return "TSC";
+		case counter::CYCLES:         return "CYCLES";
+		case counter::INSTRUCTIONS:   return "INSTRUCTIONS";
+		case counter::CACHE_MISSES:   return "CACHE_MISSES";
+		case counter::_NUM_:          break;
+	}
+
+	return "?????";
+}
+
 ircd::string_view
 ircd::ctx::prof::reflect(const event &e)
 {
@@ -1944,6 +2399,82 @@ ircd::ctx::prof::reflect(const event &e)
 	return "?????";
 }
 
+//
+// prof::node
+//
+
+ircd::ctx::prof::node::node(std::string name,
+                            node *const parent)
+:name{std::move(name)}
+,parent{parent}
+{
+}
+
+ircd::ctx::prof::node &
+ircd::ctx::prof::node::child(const string_view &name)
+{
+	auto it
+	{
+		children.lower_bound(name)
+	};
+
+	if(it == end(children) || it->first != name)
+		it = children.emplace_hint(it, std::string(name), std::make_unique<node>
+		(
+			std::string(name), this
+		));
+
+	return *it->second;
+}
+
+bool
+ircd::ctx::prof::node::for_each(const closure_bool &closure)
+const
+{
+	for(const auto &[name, child] : children)
+	{
+		if(!closure(*child))
+			return false;
+
+		if(!child->for_each(closure))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// prof::scope
+//
+
+ircd::ctx::prof::scope::scope(const string_view &name,
+                              const bool &enable)
+{
+	if(!current || !enable)
+		return;
+
+	auto &node
+	{
+		cur_node(*current)
+	};
+
+	charge(node, false);
+	theirs = &node;
+	current->profile.node = &node.child(name);
+}
+
+ircd::ctx::prof::scope::~scope()
+noexcept
+{
+	if(!theirs)
+		return;
+
+	assert(current);
+	assert(current->profile.node);
+	charge(*current->profile.node, false);
+	current->profile.node = theirs;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // ctx/promise.h
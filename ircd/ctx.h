@@ -32,6 +32,8 @@ namespace ircd::ctx::prof
 /// Internal structure aggregating any stack related state for the ctx
 struct ircd::ctx::stack
 {
+	struct allocator;
+
 	uintptr_t base {0};                    // assigned when spawned
 	size_t max {0};                        // User given stack size
 	size_t at {0};                         // Updated for profiling at sleep
@@ -41,6 +43,28 @@ struct ircd::ctx::stack
 	{}
 };
 
+/// Allocator given to boost::coroutines for every context stack. Stacks are
+/// mapped in power-of-two size classes with a guard page below each, so an
+/// overflow faults rather than corrupting a neighbor. Pages are committed by
+/// the kernel only as they are touched. Released stacks are kept on a free
+/// list for their class and their pages are given back with MADV_DONTNEED
+/// while they sit idle; stacks in excess of the cache limit are unmapped.
+struct ircd::ctx::stack::allocator
+{
+	static conf::item<size_t> cache_max;
+	static conf::item<bool> cache_trim;
+	static stats::item mapped_bytes;
+	static stats::item mapped_count;
+	static stats::item cached_count;
+	static stats::item reuse_count;
+	static std::map<size_t, std::vector<uintptr_t>> cache;
+
+	static size_t size_class(const size_t &size) noexcept;
+
+	void allocate(boost::coroutines::stack_context &, std::size_t size);
+	void deallocate(boost::coroutines::stack_context &) noexcept;
+};
+
 /// Internal context implementation
 ///
 struct ircd::ctx::ctx
@@ -54,6 +78,7 @@ struct ircd::ctx::ctx
 	context::flags flags;                        // User given flags
 	int8_t nice {0};                             // Scheduling priority nice-value
 	int8_t ionice {0};                           // IO priority nice-value (defaults for fs::opts)
+	allocator::arena *arena {nullptr};           // see: ctx::scope_arena
 	int32_t notes {0};                           // norm: 0 = asleep; 1 = awake; inc by others; dec by self
 	boost::asio::deadline_timer alarm;           // acting semaphore (64B)
 	boost::asio::yield_context *yc {nullptr};    // boost interface
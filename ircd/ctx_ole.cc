@@ -12,45 +12,101 @@
 
 namespace ircd::ctx::ole
 {
+	struct batch;
+	struct task;
+	struct worker;
+
+	static constexpr const size_t &MAX_THREADS {64};
+
 	extern conf::item<size_t> thread_max;
+	static std::atomic<size_t> workers_count;
+	static std::atomic<size_t> pending;
+	static std::mutex mutex;
+	static std::condition_variable cond;
+	static size_t next;
+	static bool termination;
+
+	static bool take(const size_t &id, task &);
+	static void push(std::vector<task> &);
+	static void spawn();
+	static void worker_main(const size_t id) noexcept;
+}
+
+/// The package for one offload() on the offloading context's stack. It
+/// remains there until the last task of the batch has signaled the context.
+struct ircd::ctx::ole::batch
+{
+	ctx *context {current};
+	latch done {1};
+	std::atomic<size_t> remaining {0};
+	std::atomic<uint64_t> errors {0};
+	std::atomic<uint64_t> steals {0};
+	std::atomic<int64_t> queued {0};
+	std::atomic<int64_t> busy {0};
+	std::atomic<bool> faulted {false};
+	std::exception_ptr eptr;
+	steady_point submitted {now<steady_point>()};
+};
+
+/// Queue element; one function of a batch.
+struct ircd::ctx::ole::task
+{
+	const offload::function *func {nullptr};
+	batch *b {nullptr};
+	size_t owner {0};
+
+	void operator()(const size_t &id) noexcept;
+};
+
+/// Each worker thread owns one of these; the deque is only contended when
+/// another worker is stealing from it or the main thread is pushing to it.
+struct ircd::ctx::ole::worker
+{
 	std::mutex mutex;
-	std::condition_variable cond;
-	std::deque<offload::function> queue;
-	std::vector<std::thread> threads;
-	bool termination;
-
-	static offload::function pop();
-	static void push(offload::function &&);
-	static void worker() noexcept;
+	std::deque<task> queue;
+	std::thread thread;
+};
+
+namespace ircd::ctx::ole
+{
+	static std::array<worker, MAX_THREADS> workers;
 }
 
 decltype(ircd::ctx::ole::thread_max)
 ircd::ctx::ole::thread_max
 {
-	{ "name",     "ircd.ctx.ole.thread.max"  },
-	{ "default",  int64_t(1)                 },
+	{ "name",     "ircd.ctx.ole.thread.max"                         },
+	{ "default",  int64_t(std::thread::hardware_concurrency())     },
 };
 
+decltype(ircd::ctx::ole::tallies)
+ircd::ctx::ole::tallies;
+
 ircd::ctx::ole::init::init()
 {
-	assert(threads.empty());
+	assert(!workers_count);
 	termination = false;
 }
 
 ircd::ctx::ole::init::~init()
 noexcept
 {
-	std::unique_lock lock
 	{
-		mutex
-	};
+		const std::lock_guard lock
+		{
+			mutex
+		};
 
-	termination = true;
-	cond.notify_all();
-	cond.wait(lock, []
-	{
-		return threads.empty();
-	});
+		termination = true;
+		cond.notify_all();
+	}
+
+	const size_t count(workers_count);
+	for(size_t i(0); i < count; ++i)
+		if(workers[i].thread.joinable())
+			workers[i].thread.join();
+
+	workers_count = 0;
 }
 
 ircd::ctx::ole::offload::offload(const function &func)
@@ -60,40 +116,38 @@ ircd::ctx::ole::offload::offload(const function &func)
 
 ircd::ctx::ole::offload::offload(const opts &opts,
                                  const function &func)
+:offload
+{
+	opts, vector_view<const function>{&func, 1}
+}
+{
+}
+
+ircd::ctx::ole::offload::offload(const opts &opts,
+                                 const vector_view<const function> &funcs)
 {
 	assert(current);
-	assert(opts.concurrency == 1); // not yet implemented
+	assert(opts.concurrency > 0);
+
+	const size_t count
+	{
+		funcs.size() * std::max(opts.concurrency, 1UL)
+	};
+
+	if(unlikely(!count))
+		return;
 
 	// Prepare the offload package on our stack here. These objects will
 	// remain here for the duration of the offload.
-	latch latch{1};
-	std::exception_ptr eptr;
-	auto *const context(current);
-	auto closure{[&func, &latch, &eptr, &context]
-	() noexcept
-	{
-		try
-		{
-			func();
-		}
-		catch(...)
-		{
-			// Note that the write to eptr is taking place on a different
-			// thread from where we created the eptr.
-			eptr = std::current_exception();
-		}
+	batch batch;
+	batch.remaining = count;
 
-		// The ctx::signal() is a special device which executes the closure
-		// as soon as the target context is not currently running on any
-		// thread. This has the ability to provide the cross-thread
-		// synchronization we need to hit the latch from this thread.
-		assert(context);
-		signal(*context, [&latch]
-		{
-			assert(!latch.is_ready());
-			latch.count_down();
-		});
-	}};
+	std::vector<task> tasks(count);
+	for(size_t i(0); i < count; ++i)
+	{
+		tasks[i].func = &funcs[i % funcs.size()];
+		tasks[i].b = &batch;
+	}
 
 	// interrupt(ctx) is suppressed while this context has offloaded some work
 	// to another thread. This context must stay right here and not disappear
@@ -101,92 +155,221 @@ ircd::ctx::ole::offload::offload(const opts &opts,
 	// capable of throwing an interrupt that was received during this scope.
 	const uninterruptible uninterruptible;
 
-	ole::push(std::move(closure));       // scope address required for clang-7
-	latch.wait();
+	ole::push(tasks);
+	batch.done.wait();
+
+	const string_view &name
+	{
+		opts.name?: "<unnamed>"_sv
+	};
+
+	auto it(tallies.lower_bound(name));
+	if(it == end(tallies) || it->first != name)
+		it = tallies.emplace_hint(it, std::string(name), tally{});
+
+	auto &tally(it->second);
+
+	tally.batches += 1;
+	tally.tasks += count;
+	tally.errors += batch.errors;
+	tally.steals += batch.steals;
+	tally.queued += nanoseconds(batch.queued);
+	tally.busy += nanoseconds(batch.busy);
 
 	// Don't throw any exception if there is a pending interrupt for this ctx.
 	// Two exceptions will be thrown in that case and if there's an interrupt
 	// we don't care about eptr anyway.
 	if(likely(!interruption_requested()))
-		if(unlikely(eptr))
-			std::rethrow_exception(eptr);
+		if(unlikely(batch.eptr))
+			std::rethrow_exception(batch.eptr);
 }
+
 void
-ircd::ctx::ole::push(offload::function &&func)
+ircd::ctx::ole::task::operator()(const size_t &id)
+noexcept
 {
-	if(unlikely(threads.size() < size_t(thread_max)))
-		threads.emplace_back(&worker);
+	assert(func);
+	assert(b);
+	const auto started
+	{
+		now<steady_point>()
+	};
 
-	const std::lock_guard lock
+	try
 	{
-		mutex
+		(*func)();
+	}
+	catch(...)
+	{
+		// Only the first exception of the batch is kept; the write to eptr
+		// is taking place on a different thread from where it was created.
+		if(!b->faulted.exchange(true))
+			b->eptr = std::current_exception();
+
+		b->errors.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const auto stopped
+	{
+		now<steady_point>()
 	};
 
-	queue.emplace_back(std::move(func));
-	cond.notify_all();
+	b->queued.fetch_add((started - b->submitted).count(), std::memory_order_relaxed);
+	b->busy.fetch_add((stopped - started).count(), std::memory_order_relaxed);
+	if(id != owner)
+		b->steals.fetch_add(1, std::memory_order_relaxed);
+
+	// Only the last task of the batch wakes the offloading context.
+	if(b->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	// The ctx::signal() is a special device which executes the closure
+	// as soon as the target context is not currently running on any
+	// thread. This has the ability to provide the cross-thread
+	// synchronization we need to hit the latch from this thread.
+	auto *const b(this->b);
+	assert(b->context);
+	signal(*b->context, [b]
+	{
+		assert(!b->done.is_ready());
+		b->done.count_down();
+	});
 }
 
 void
-ircd::ctx::ole::worker()
-noexcept try
+ircd::ctx::ole::push(std::vector<task> &tasks)
 {
-	while(1)
+	const size_t threads
+	{
+		std::clamp(size_t(thread_max), 1UL, MAX_THREADS)
+	};
+
+	while(unlikely(workers_count < threads))
+		spawn();
+
+	const size_t count
 	{
-		const auto func
+		workers_count
+	};
+
+	// The count is raised before any task becomes visible to the workers;
+	// a worker decrements it only after claiming a task, so it can never
+	// fall below the number of tasks actually queued.
+	pending.fetch_add(tasks.size(), std::memory_order_release);
+
+	// Tasks are dealt round-robin so a batch starts on as many threads as
+	// possible; any imbalance is corrected by stealing.
+	for(auto &task : tasks)
+	{
+		const size_t id(next++ % count);
+		auto &worker(workers.at(id));
+		task.owner = id;
+
+		const std::lock_guard lock
 		{
-			pop()
+			worker.mutex
 		};
 
-		func();
+		worker.queue.emplace_back(task);
 	}
-}
-catch(const interrupted &)
-{
+
 	const std::lock_guard lock
 	{
 		mutex
 	};
 
-	const auto it
+	if(tasks.size() > 1)
+		cond.notify_all();
+	else
+		cond.notify_one();
+}
+
+void
+ircd::ctx::ole::spawn()
+{
+	const size_t id
 	{
-		std::find_if(begin(threads), end(threads), []
-		(const auto &thread)
-		{
-			return thread.get_id() == std::this_thread::get_id();
-		})
+		workers_count
 	};
 
-	assert(it != end(threads));
-	auto &this_thread(*it);
-	this_thread.detach();
-	threads.erase(it);
-	cond.notify_all();
+	assert(id < MAX_THREADS);
+	workers.at(id).thread = std::thread
+	{
+		&worker_main, id
+	};
+
+	++workers_count;
 }
 
-ircd::ctx::ole::offload::function
-ircd::ctx::ole::pop()
+void
+ircd::ctx::ole::worker_main(const size_t id)
+noexcept
 {
-	std::unique_lock lock
+	task task;
+	while(1)
 	{
-		mutex
-	};
+		if(take(id, task))
+		{
+			task(id);
+			continue;
+		}
 
-	cond.wait(lock, []
-	{
-		if(!queue.empty())
-			return true;
+		std::unique_lock lock
+		{
+			mutex
+		};
 
-		if(unlikely(termination))
-			throw interrupted{};
+		cond.wait(lock, []
+		{
+			return pending.load(std::memory_order_acquire) > 0 || termination;
+		});
 
-		return false;
-	});
+		if(unlikely(termination) && !pending)
+			return;
+	}
+}
 
-	auto function
+/// Takes the newest task from this worker's own deque, otherwise steals the
+/// oldest task from another worker's deque.
+bool
+ircd::ctx::ole::take(const size_t &id,
+                     task &ret)
+{
+	const size_t count
 	{
-		std::move(queue.front())
+		workers_count
 	};
 
-	queue.pop_front();
-	return function;
+	for(size_t i(0); i < count; ++i)
+	{
+		const bool own(i == 0);
+		auto &worker
+		{
+			workers[(id + i) % count]
+		};
+
+		const std::lock_guard lock
+		{
+			worker.mutex
+		};
+
+		if(worker.queue.empty())
+			continue;
+
+		if(own)
+		{
+			ret = worker.queue.back();
+			worker.queue.pop_back();
+		}
+		else
+		{
+			ret = worker.queue.front();
+			worker.queue.pop_front();
+		}
+
+		pending.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	return false;
 }
@@ -402,6 +402,73 @@ ircd::db::open_repair
 	{ "persist",  false                  },
 };
 
+/// Conf item determines if databases are opened as a secondary instance of
+/// a primary which is concurrently opened by another process (i.e. another
+/// instance of IRCd on this host). The secondary is read-only; it observes
+/// the primary's writes after each db::refresh(). This allows several
+/// processes to serve reads from the same database.
+decltype(ircd::db::open_secondary)
+ircd::db::open_secondary
+{
+	{ "name",     "ircd.db.open.secondary"  },
+	{ "default",  false                     },
+	{ "persist",  false                     },
+};
+
+/// Identifies this secondary instance among any others on the host. Each
+/// secondary requires its own directory for its info log and MANIFEST
+/// scratch; it is the database path suffixed with ".secondary." and this
+/// value. When empty the process id is used. This is not persisted since
+/// the configuration is shared with the primary and the other secondaries;
+/// set it from the environment to keep a stable directory across restarts.
+decltype(ircd::db::open_secondary_id)
+ircd::db::open_secondary_id
+{
+	{ "name",     "ircd.db.open.secondary.id"  },
+	{ "default",  string_view{}                },
+	{ "persist",  false                        },
+};
+
+/// Catch up a secondary instance with its primary by replaying any new
+/// MANIFEST and WAL records written by the primary since the last call.
+/// This is a no-op returning false for a database which is not a secondary.
+bool
+ircd::db::refresh(database &d)
+{
+	if(!d.secondary)
+		return false;
+
+	#ifdef IRCD_DB_HAS_SECONDARY
+	const auto before
+	{
+		sequence(d)
+	};
+
+	throw_on_error
+	{
+		d.d->TryCatchUpWithPrimary()
+	};
+
+	const auto after
+	{
+		sequence(d)
+	};
+
+	if(after != before)
+		log::debug
+		{
+			log, "[%s] @%lu REFRESH from primary to @%lu",
+			name(d),
+			before,
+			after,
+		};
+
+	return after != before;
+	#else
+	return false;
+	#endif
+}
+
 void
 ircd::db::sync(database &d)
 {
@@ -1121,7 +1188,11 @@ try
 }
 ,read_only
 {
-	ircd::read_only
+	ircd::read_only || db::open_secondary
+}
+,secondary
+{
+	db::open_secondary
 }
 ,env
 {
@@ -1391,7 +1462,7 @@ try
 		columns.size()
 	};
 
-	if(read_only)
+	if(read_only && !secondary)
 		log::warning
 		{
 			log, "Database \"%s\" @ `%s' will be opened in read-only mode.",
@@ -1399,9 +1470,52 @@ try
 			path,
 		};
 
+	// The secondary keeps its own info log and state in a separate directory
+	// from the primary; the primary's directory is not written to.
+	const std::string secondary_path
+	{
+		!secondary?
+			std::string{}:
+		!empty(string_view(open_secondary_id))?
+			path + ".secondary." + std::string(string_view(open_secondary_id)):
+			path + ".secondary." + std::to_string(::getpid())
+	};
+
+	if(secondary)
+		log::notice
+		{
+			log, "Database \"%s\" @ `%s' will be opened as a secondary instance @ `%s'",
+			this->name,
+			path,
+			secondary_path,
+		};
+
+	// Required by RocksDB for a secondary instance; all files remain open
+	// because the primary may delete them at any time.
+	if(secondary)
+		opts->max_open_files = -1;
+
 	// Open DB into ptr
 	rocksdb::DB *ptr;
-	if(read_only)
+	if(secondary)
+	{
+		#ifdef IRCD_DB_HAS_SECONDARY
+		throw_on_error
+		{
+			rocksdb::DB::OpenAsSecondary(*opts, path, secondary_path, columns, &handles, &ptr)
+		};
+		#else
+		throw error
+		{
+			"Database \"%s\" cannot be opened as a secondary with RocksDB %d.%d.%d",
+			this->name,
+			ROCKSDB_MAJOR,
+			ROCKSDB_MINOR,
+			ROCKSDB_PATCH,
+		};
+		#endif
+	}
+	else if(read_only)
 		throw_on_error
 		{
 			rocksdb::DB::OpenForReadOnly(*opts, path, columns, &handles, &ptr)
@@ -3541,6 +3655,126 @@ ircd::db::database::sst::dump::dump(db::column column,
 	this->info.version = info.version;
 }
 
+//
+// sst::writer
+//
+
+ircd::db::database::sst::writer::writer(db::column column,
+                                        const string_view &path)
+:column
+{
+	&static_cast<database::column &>(column)
+}
+,path
+{
+	path
+}
+{
+}
+
+ircd::db::database::sst::writer::~writer()
+noexcept
+{
+}
+
+void
+ircd::db::database::sst::writer::operator()(const op &op,
+                                            const string_view &key,
+                                            const string_view &val)
+{
+	if(unlikely(op != op::SET && op != op::DELETE))
+		throw error
+		{
+			"Unsupported operation '%s' for external SST file", reflect(op)
+		};
+
+	buf.emplace_back(std::string{key}, std::string{val}, op);
+}
+
+ircd::db::database::sst::info
+ircd::db::database::sst::writer::finish()
+{
+	assert(column);
+	database::column &c(*column);
+	const database &d(*c.d);
+	const auto &cmp
+	{
+		c.cmp
+	};
+
+	// Stable so the last update to any key is last among its equals.
+	std::stable_sort(begin(buf), end(buf), [&cmp]
+	(const update &a, const update &b)
+	{
+		return cmp.Compare(slice(std::get<0>(a)), slice(std::get<0>(b))) < 0;
+	});
+
+	// RocksDB cannot create an SST without entries; nothing is created and
+	// the returned info has zero entries and no path.
+	if(buf.empty())
+	{
+		sst::info ret;
+		ret.column = db::name(c);
+		return ret;
+	}
+
+	rocksdb::Options opts(d.d->GetOptions(c));
+	rocksdb::EnvOptions eopts(opts);
+	rocksdb::SstFileWriter writer
+	{
+		eopts, opts, c
+	};
+
+	throw_on_error
+	{
+		writer.Open(path)
+	};
+
+	size_t i(0);
+	for(auto it(begin(buf)); it != end(buf); ++it)
+	{
+		const auto next(std::next(it));
+		const auto &key(std::get<0>(*it));
+		if(next != end(buf) && cmp.Equal(slice(key), slice(std::get<0>(*next))))
+			continue;
+
+		if(std::get<2>(*it) == op::DELETE)
+			throw_on_error
+			{
+				writer.Delete(slice(key))
+			};
+		else
+			throw_on_error
+			{
+				writer.Put(slice(key), slice(std::get<1>(*it)))
+			};
+
+		++i;
+	}
+
+	buf.clear();
+	buf.shrink_to_fit();
+
+	rocksdb::ExternalSstFileInfo info;
+	if(i)
+		throw_on_error
+		{
+			writer.Finish(&info)
+		};
+
+	sst::info ret;
+	ret.column = db::name(c);
+	ret.path = std::move(info.file_path);
+	ret.min_key = std::move(info.smallest_key);
+	ret.max_key = std::move(info.largest_key);
+	ret.min_seq = info.sequence_number;
+	ret.max_seq = info.sequence_number;
+	ret.size = info.file_size;
+	ret.entries = info.num_entries;
+	ret.version = info.version;
+	return ret;
+}
+
 //
 // sst::info::vector
 //
@@ -3932,6 +4166,38 @@ ircd::db::histogram_max
 decltype(ircd::db::prefetcher)
 ircd::db::prefetcher;
 
+namespace ircd::db
+{
+	extern conf::item<size_t> prefetch_range_readahead;
+	extern conf::item<size_t> prefetch_range_max;
+}
+
+decltype(ircd::db::prefetch_range_readahead)
+ircd::db::prefetch_range_readahead
+{
+	{ "name",     "ircd.db.prefetch.range.readahead" },
+	{ "default",  long(512_KiB)                      },
+	{ "description",
+
+	R"(
+	Size of the read-ahead used by the iteration of a range prefetch. The
+	blocks of the range are read in requests of this size and loaded into
+	the cache.
+	)"}
+};
+
+decltype(ircd::db::prefetch_range_max)
+ircd::db::prefetch_range_max
+{
+	{ "name",     "ircd.db.prefetch.range.max" },
+	{ "default",  long(16_MiB)                 },
+	{ "description",
+
+	R"(
+	Upper bound on the bytes of data loaded by a single range prefetch.
+	)"}
+};
+
 //
 // db::prefetcher
 //
@@ -4018,6 +4284,29 @@ ircd::db::prefetcher::operator()(column &c,
 	return true;
 }
 
+bool
+ircd::db::prefetcher::operator()(column &c,
+                                 const std::pair<string_view, string_view> &range,
+                                 const gopts &opts)
+{
+	auto &d
+	{
+		static_cast<database &>(c)
+	};
+
+	assert(ticker);
+	ticker->queries++;
+	queue.emplace_back(d, c, range);
+	queue.back().snd = now<steady_point>();
+	ticker->request++;
+	ticker->ranges++;
+
+	// A range is a long operation so it is always handed to our worker
+	// rather than dispatched directly from the caller's stack.
+	dock.notify_one();
+	return true;
+}
+
 size_t
 ircd::db::prefetcher::cancel(column &c)
 {
@@ -4201,6 +4490,9 @@ try
 		(*request.d)[request.cid]
 	};
 
+	if(request.end_len)
+		return request_handle_range(request, column);
+
 	const string_view key
 	{
 		request
@@ -4263,6 +4555,54 @@ catch(...)
 	throw;
 }
 
+/// Iterate the range with a large read-ahead so its blocks are read in few
+/// large requests and loaded into the cache; the data itself is discarded.
+void
+ircd::db::prefetcher::request_handle_range(request &request,
+                                           column &column)
+{
+	const auto range
+	{
+		static_cast<std::pair<string_view, string_view>>(request)
+	};
+
+	const rocksdb::Slice upper_bound
+	{
+		slice(range.second)
+	};
+
+	gopts opts;
+	opts.upper_bound = &upper_bound;
+	opts.readahead = size_t(prefetch_range_readahead);
+
+	size_t bytes(0);
+	auto it(seek(column, range.first, opts));
+	for(; valid(*it) && bytes < size_t(prefetch_range_max); it->Next())
+		bytes += size(it->key()) + size(it->value());
+
+	const ctx::critical_assertion ca;
+	request.fin = now<steady_point>();
+	ticker->last_req_fin = duration_cast<microseconds>(request.fin - request.req);
+	ticker->accum_req_fin += ticker->last_req_fin;
+	ticker->fetched_bytes_range += bytes;
+
+	#ifdef IRCD_DB_DEBUG_PREFETCH
+	char pbuf[2][32];
+	log::debug
+	{
+		log, "[%s][%s] completed range prefetch len:%zu:%zu bytes:%zu snd-req:%s req-fin:%s queue:%zu",
+		name(*request.d),
+		name(column),
+		size(range.first),
+		size(range.second),
+		bytes,
+		pretty(pbuf[0], request.req - request.snd, 1),
+		pretty(pbuf[1], request.fin - request.req, 1),
+		queue.size(),
+	};
+	#endif
+}
+
 size_t
 ircd::db::prefetcher::wait_pending()
 {
@@ -4303,7 +4643,7 @@ noexcept
 }
 ,len
 {
-	 uint32_t(std::min(size(key), sizeof(this->key)))
+	 uint16_t(std::min(size(key), sizeof(this->key)))
 }
 ,snd
 {
@@ -4326,6 +4666,58 @@ noexcept
 	assert(this->len == len);
 }
 
+/// Keys which don't fit are truncated. A truncated key sorts before the
+/// original, so the range can only be extended from its start and shrunk
+/// from its end, which is acceptable for a prefetch.
+ircd::db::prefetcher::request::request(database &d,
+                                       const column &c,
+                                       const std::pair<string_view, string_view> &range)
+noexcept
+:d
+{
+	std::addressof(d)
+}
+,cid
+{
+	db::id(c)
+}
+,len
+{
+	uint16_t(std::min(size(range.first), sizeof(key) - std::min(size(range.second), sizeof(key) / 2)))
+}
+,end_len
+{
+	uint16_t(std::min(size(range.second), sizeof(key) - len))
+}
+,snd
+{
+	steady_point::min()
+}
+,req
+{
+	steady_point::min()
+}
+,fin
+{
+	steady_point::min()
+}
+{
+	assert(!empty(range.second));
+	buffer::copy(mutable_buffer{key, len}, range.first);
+	buffer::copy(mutable_buffer{key + len, end_len}, range.second);
+}
+
+ircd::db::prefetcher::request::operator
+std::pair<ircd::string_view, ircd::string_view>()
+const noexcept
+{
+	return
+	{
+		string_view{key, len},
+		string_view{key + len, end_len},
+	};
+}
+
 ircd::db::prefetcher::request::operator
 ircd::string_view()
 const noexcept
@@ -6242,6 +6634,45 @@ ircd::db::setopt(column &column,
 	};
 }
 
+/// Ingest external SST files into several columns of a database at once.
+/// The files are moved into the database rather than copied when possible.
+/// With RocksDB 6 or later either all files become visible or none do.
+void
+ircd::db::ingest(database &d,
+                 const vector_view<const std::pair<string_view, string_view>> &files)
+{
+	#ifdef IRCD_DB_HAS_INGEST_FILES
+	std::vector<rocksdb::IngestExternalFileArg> args(files.size());
+	for(size_t i(0); i < files.size(); ++i)
+	{
+		database::column &c(d[files[i].first]);
+		auto &arg(args.at(i));
+		arg.column_family = c;
+		arg.external_files.emplace_back(files[i].second);
+		arg.options.move_files = true;
+		arg.options.allow_global_seqno = true;
+		arg.options.allow_blocking_flush = true;
+	}
+
+	const std::lock_guard lock{write_mutex};
+	const ctx::uninterruptible::nothrow ui;
+	throw_on_error
+	{
+		d.d->IngestExternalFiles(args)
+	};
+	#else
+	for(const auto &[colname, path] : files)
+	{
+		db::column column
+		{
+			d, colname
+		};
+
+		ingest(column, path);
+	}
+	#endif
+}
+
 void
 ircd::db::ingest(column &column,
                  const string_view &path)
@@ -6390,10 +6821,32 @@ ircd::db::bytes(column &column,
 // db::prefetch
 //
 
+namespace ircd::db
+{
+	static struct prefetcher &_prefetcher();
+}
+
 bool
 ircd::db::prefetch(column &column,
                    const string_view &key,
                    const gopts &gopts)
+{
+	return _prefetcher()(column, key, gopts);
+}
+
+/// Prefetch the range [first, second) of the column into the cache. This is
+/// conducted asynchronously; it is useful to callers which know the bounds
+/// of a scan they are about to conduct.
+bool
+ircd::db::prefetch(column &column,
+                   const std::pair<string_view, string_view> &range,
+                   const gopts &gopts)
+{
+	return _prefetcher()(column, range, gopts);
+}
+
+struct ircd::db::prefetcher &
+ircd::db::_prefetcher()
 {
 	static construction instance
 	{
@@ -6401,7 +6854,7 @@ ircd::db::prefetch(column &column,
 	};
 
 	assert(prefetcher);
-	return (*prefetcher)(column, key, gopts);
+	return *prefetcher;
 }
 
 //
@@ -7716,8 +8169,19 @@ namespace ircd::db
 	static rocksdb::Iterator &_seek_upper_(rocksdb::Iterator &, const string_view &);
 	static bool _seek(database::column &, const pos &, const rocksdb::ReadOptions &, rocksdb::Iterator &it);
 	static bool _seek(database::column &, const string_view &, const rocksdb::ReadOptions &, rocksdb::Iterator &it);
+
+	extern conf::item<bool> seek_prof;
 }
 
+/// Charges each seek to a ctx::prof node for the column. This is off by
+/// default because of its cost on such a frequent operation.
+decltype(ircd::db::seek_prof)
+ircd::db::seek_prof
+{
+	{ "name",     "ircd.db.seek.prof" },
+	{ "default",  false               },
+};
+
 std::unique_ptr<rocksdb::Iterator>
 ircd::db::seek(column &column,
                const string_view &key,
@@ -7758,6 +8222,10 @@ ircd::db::_seek(database::column &c,
 try
 {
 	const ctx::uninterruptible ui;
+	const ctx::prof::scope prof_scope
+	{
+		c.name, bool(seek_prof)
+	};
 
 	#ifdef RB_DEBUG_DB_SEEK
 	database &d(*c.d);
@@ -7806,6 +8274,10 @@ ircd::db::_seek(database::column &c,
 try
 {
 	const ctx::stack_usage_assertion sua;
+	const ctx::prof::scope prof_scope
+	{
+		c.name, bool(seek_prof)
+	};
 
 	#ifdef RB_DEBUG_DB_SEEK
 	database &d(*c.d);
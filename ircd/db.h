@@ -52,6 +52,21 @@
 #include <rocksdb/compaction_filter.h>
 #include <rocksdb/wal_filter.h>
 
+/// Secondary instances (rocksdb::DB::OpenAsSecondary) are available from 6.2
+#if ROCKSDB_MAJOR > 6 || (ROCKSDB_MAJOR == 6 && ROCKSDB_MINOR >= 2)
+	#define IRCD_DB_HAS_SECONDARY
+#endif
+
+/// Atomic ingestion across columns (rocksdb::DB::IngestExternalFiles)
+#if ROCKSDB_MAJOR >= 6
+	#define IRCD_DB_HAS_INGEST_FILES
+#endif
+
+/// Vectored reads (rocksdb::RandomAccessFile::MultiRead)
+#if ROCKSDB_MAJOR > 6 || (ROCKSDB_MAJOR == 6 && ROCKSDB_MINOR >= 4)
+	#define IRCD_DB_HAS_ENV_MULTIREAD
+#endif
+
 namespace ircd::db
 {
 	struct throw_on_error;
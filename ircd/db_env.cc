@@ -3223,6 +3223,71 @@ ircd::db::database::env::random_access_file::default_opts{[]
 	return ret;
 }()};
 
+decltype(ircd::db::database::env::random_access_file::readahead_enable)
+ircd::db::database::env::random_access_file::readahead_enable
+{
+	{ "name",     "ircd.db.env.readahead.enable" },
+	{ "default",  true                           },
+	{ "description",
+
+	R"(
+	Read ahead of sequential block reads for files opened with direct-io.
+	)"}
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead_size)
+ircd::db::database::env::random_access_file::readahead_size
+{
+	{ "name",     "ircd.db.env.readahead.size" },
+	{ "default",  long(256_KiB)                },
+	{ "description",
+
+	R"(
+	Size of each read-ahead window. Reads at least half this size are not
+	considered for read-ahead; they are likely already RocksDB's own.
+	)"}
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead_trigger)
+ircd::db::database::env::random_access_file::readahead_trigger
+{
+	{ "name",     "ircd.db.env.readahead.trigger" },
+	{ "default",  2L                              },
+	{ "description",
+
+	R"(
+	Number of sequential reads of a file before read-ahead is started.
+	)"}
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead_max)
+ircd::db::database::env::random_access_file::readahead_max
+{
+	{ "name",     "ircd.db.env.readahead.max" },
+	{ "default",  long(16_MiB)                },
+	{ "description",
+
+	R"(
+	Total size of the read-ahead windows of the files of one database. At
+	this limit the windows of idle readers are freed, and when none are idle
+	no more read-ahead is started.
+	)"}
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead_idle)
+ircd::db::database::env::random_access_file::readahead_idle
+{
+	{ "name",     "ircd.db.env.readahead.idle" },
+	{ "default",  5L                           },
+	{ "description",
+
+	R"(
+	Seconds without a read after which the read-ahead windows of a reader
+	of a file are freed, either for another reader of the file or for
+	another file of the database.
+	)"}
+};
+
 ircd::db::database::env::random_access_file::random_access_file(database *const &d,
                                                                 const std::string &name,
                                                                 const EnvOptions &env_opts)
@@ -3286,6 +3351,26 @@ catch(const std::exception &e)
 ircd::db::database::env::random_access_file::~random_access_file()
 noexcept
 {
+	// A read-ahead worker may still be filling a window of this file.
+	if(ra)
+	{
+		const ctx::uninterruptible::nothrow ui;
+		ra->dock.wait([this]
+		{
+			return std::none_of(begin(ra->win), end(ra->win), []
+			(const auto &win)
+			{
+				return std::any_of(begin(win), end(win), []
+				(const auto &window)
+				{
+					return window.pending;
+				});
+			});
+		});
+
+		readahead_free(true);
+	}
+
 	#ifdef RB_DEBUG_DB_ENV
 	log::debug
 	{
@@ -3375,11 +3460,21 @@ const noexcept try
 	};
 
 	assert(!this->opts.direct || buffer::aligned(buf, _buffer_align));
+	const size_t copied
+	{
+		ra? readahead_read(offset, buf): 0UL
+	};
+
 	const auto read
 	{
-		fs::read(fd, buf, opts)
+		copied?
+			const_buffer{scratch, copied}:
+			fs::read(fd, buf, opts)
 	};
 
+	if(this->opts.direct && readahead_enable)
+		readahead_detect(offset, length);
+
 	*result = slice(read);
 	return Status::OK();
 }
@@ -3416,6 +3511,475 @@ catch(const std::exception &e)
 	return error_to_status{e};
 }
 
+#ifdef IRCD_DB_HAS_ENV_MULTIREAD
+rocksdb::Status
+ircd::db::database::env::random_access_file::MultiRead(rocksdb::ReadRequest *const req,
+                                                       size_t num)
+noexcept try
+{
+	const ctx::uninterruptible::nothrow ui;
+
+	assert(req || !num);
+	#ifdef RB_DEBUG_DB_ENV
+	log::debug
+	{
+		log, "[%s] rfile:%p multiread:%p num:%zu",
+		d.name,
+		this,
+		req,
+		num
+	};
+	#endif
+
+	// Blocks already in a read-ahead window are copied from it; the rest are
+	// submitted as one batch so this ctx yields once rather than once per
+	// block. Each op keeps the index of its request.
+	std::vector<fs::read_op> op;
+	std::vector<size_t> idx;
+	op.reserve(num);
+	idx.reserve(num);
+	for(size_t i(0); i < num; ++i)
+	{
+		assert(req[i].scratch);
+		const mutable_buffer buf
+		{
+			req[i].scratch, req[i].len
+		};
+
+		assert(!this->opts.direct || buffer::aligned(buf, _buffer_align));
+		const size_t copied
+		{
+			ra? readahead_read(req[i].offset, buf): 0UL
+		};
+
+		if(copied)
+		{
+			req[i].result = slice(const_buffer{req[i].scratch, copied});
+			req[i].status = Status::OK();
+			continue;
+		}
+
+		auto &o(op.emplace_back());
+		o.fd = &fd;
+		o.opts.offset = req[i].offset;
+		o.opts.priority = ionice;
+		o.opts.aio = this->aio;
+		o.opts.all = !this->opts.direct;
+		o.buf = buf;
+		idx.emplace_back(i);
+	}
+
+	if(!op.empty())
+		fs::read(op);
+
+	for(size_t j(0); j < op.size(); ++j)
+	{
+		const size_t &i(idx[j]);
+		try
+		{
+			if(op[j].eptr)
+				std::rethrow_exception(op[j].eptr);
+
+			req[i].result = slice(const_buffer{data(op[j].buf), op[j].ret});
+			req[i].status = Status::OK();
+		}
+		catch(const std::system_error &e)
+		{
+			log::error
+			{
+				log, "[%s] rfile:%p multiread:%p #%zu offset:%zu length:%zu :%s",
+				d.name,
+				this,
+				req,
+				i,
+				req[i].offset,
+				req[i].len,
+				e.what()
+			};
+
+			req[i].status = error_to_status{e};
+		}
+		catch(const std::exception &e)
+		{
+			req[i].status = error_to_status{e};
+		}
+	}
+
+	return Status::OK();
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "[%s] rfile:%p multiread:%p num:%zu :%s",
+		d.name,
+		this,
+		req,
+		num,
+		e.what()
+	};
+
+	return error_to_status{e};
+}
+#endif IRCD_DB_HAS_ENV_MULTIREAD
+
+/// Copy the requested range out of a read-ahead window if one has it. This
+/// may yield while a window which will contain the range is loading. Returns
+/// the number of bytes copied; zero if the read must go to the device.
+size_t
+ircd::db::database::env::random_access_file::readahead_read(const uint64_t &offset,
+                                                            const mutable_buffer &buf)
+const
+{
+	assert(ra);
+	for(const auto &win : ra->win)
+		for(const auto &window : win)
+		{
+			const bool within
+			{
+				offset >= window.offset && offset < window.offset + window.want
+			};
+
+			if(!within)
+				continue;
+
+			ra->dock.wait([&window]
+			{
+				return !window.pending;
+			});
+
+			// The window may have been reused for another range while waiting.
+			if(offset < window.offset || offset >= window.offset + window.length)
+				return 0UL;
+
+			// The window only satisfies a read which extends past its end if
+			// the window itself was cut short by the end of the file.
+			const bool eof
+			{
+				window.length < window.want
+			};
+
+			const size_t avail
+			{
+				window.offset + window.length - offset
+			};
+
+			if(avail < size(buf) && !eof)
+				return 0UL;
+
+			const const_buffer src
+			{
+				data(window.buf) + (offset - window.offset), avail
+			};
+
+			return buffer::copy(buf, src);
+		}
+
+	return 0UL;
+}
+
+/// Track sequential access to this file and keep a read-ahead window loading
+/// in front of each reader once enough sequential reads were observed.
+void
+ircd::db::database::env::random_access_file::readahead_detect(const uint64_t &offset,
+                                                              const size_t &length)
+const
+{
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	const auto idle_since
+	{
+		now - seconds(readahead_idle)
+	};
+
+	// With direct-io each read is aligned, so the next block's read can
+	// overlap the last block of the previous read.
+	auto it
+	{
+		std::find_if(begin(seq), end(seq), [&offset]
+		(const auto &stream)
+		{
+			return offset > stream.offset && offset <= stream.end;
+		})
+	};
+
+	// Otherwise this read starts a stream in place of the least recent one
+	// which holds no windows or has gone idle; the windows of an active
+	// stream are never taken. When all are active the read isn't tracked.
+	const bool sequential
+	{
+		it != end(seq)
+	};
+
+	if(!sequential)
+		for(auto cand(begin(seq)); cand != end(seq); ++cand)
+		{
+			const size_t i(std::distance(begin(seq), cand));
+			if(readahead_held(i) && cand->last > idle_since)
+				continue;
+
+			if(it == end(seq) || cand->last < it->last)
+				it = cand;
+		}
+
+	if(it == end(seq))
+		return;
+
+	// Windows left by a previous stream in this place go back to the db.
+	const size_t s(std::distance(begin(seq), it));
+	if(!sequential && readahead_held(s))
+		readahead_free(false);
+
+	auto &stream(*it);
+	stream.count = sequential? stream.count + 1: 0;
+	stream.offset = offset;
+	stream.end = offset + length;
+	stream.last = now;
+
+	const size_t window_size
+	{
+		size_t(readahead_size)
+	};
+
+	if(!length || length >= window_size / 2)
+		return;
+
+	if(stream.count < size_t(readahead_trigger))
+		return;
+
+	if(!ra)
+		ra = std::make_unique<struct readahead>();
+
+	// Find the end of what is already loaded or loading contiguously ahead
+	// of the reader.
+	uint64_t ahead(stream.end);
+	for(bool extended(true); extended;)
+	{
+		extended = false;
+		for(const auto &window : ra->win.at(s))
+			if(window.offset <= ahead && window.offset + window.want > ahead)
+			{
+				ahead = window.offset + window.want;
+				extended = true;
+			}
+	}
+
+	if(ahead - stream.end >= window_size)
+		return;
+
+	// Start the next window where the reader's next read will begin; which
+	// is the aligned block containing the end of this read.
+	const uint64_t start
+	{
+		ahead > stream.end?
+			ahead:
+			stream.end - 1 - (stream.end - 1) % _buffer_align
+	};
+
+	readahead_start(s, start, window_size);
+}
+
+void
+ircd::db::database::env::random_access_file::readahead_start(const size_t &s,
+                                                             const uint64_t &offset,
+                                                             const size_t &length)
+const
+{
+	assert(ra);
+	assert(offset % _buffer_align == 0);
+	const size_t want
+	{
+		length + (_buffer_align - length % _buffer_align) % _buffer_align
+	};
+
+	// A window can be loaded when it is unused, entirely behind the reader
+	// or too far off to be useful; its buffer is reused.
+	const auto &stream(seq.at(s));
+	auto &win(ra->win.at(s));
+	const auto it
+	{
+		std::find_if(begin(win), end(win), [&stream, &want]
+		(const auto &window)
+		{
+			return !window.pending &&
+			(
+				!window.want ||
+				window.offset + window.want <= stream.offset ||
+				window.offset >= stream.end + 2 * want
+			);
+		})
+	};
+
+	if(it == end(win))
+		return;
+
+	// Read-ahead is opportunistic; never wait for a worker here.
+	if(db::request.wouldblock())
+		return;
+
+	auto &window(*it);
+	if(size(window.buf) != want)
+	{
+		auto &env(*d.env);
+		const auto over{[&env, &window, &want]
+		{
+			return env.readahead_bytes - size(window.buf) + want > size_t(readahead_max);
+		}};
+
+		if(over())
+			readahead_reclaim();
+
+		if(over())
+			return;
+
+		env.readahead_bytes -= size(window.buf);
+		window.buf = unique_buffer<mutable_buffer>
+		{
+			want, _buffer_align
+		};
+
+		env.readahead_bytes += size(window.buf);
+		env.readahead_files.emplace(this);
+	}
+
+	window.offset = offset;
+	window.want = want;
+	window.length = 0;
+	window.pending = true;
+	db::request([this, s, i(std::distance(begin(win), it))]
+	{
+		readahead_worker(s, i);
+	});
+}
+
+/// Whether any window of the stream has a buffer.
+bool
+ircd::db::database::env::random_access_file::readahead_held(const size_t &s)
+const noexcept
+{
+	if(!ra)
+		return false;
+
+	const auto &win(ra->win.at(s));
+	return std::any_of(begin(win), end(win), []
+	(const auto &window)
+	{
+		return size(window.buf) > 0;
+	});
+}
+
+/// Free the windows of the streams which haven't been read for
+/// readahead_idle, or of all streams when all; windows still loading are
+/// left. The file leaves the database's accounting with its last window.
+void
+ircd::db::database::env::random_access_file::readahead_free(const bool &all)
+const noexcept
+{
+	if(!ra)
+		return;
+
+	auto &env(*d.env);
+	const auto idle_since
+	{
+		now<steady_point>() - seconds(readahead_idle)
+	};
+
+	for(size_t s(0); s < seq.size(); ++s)
+	{
+		if(!all && seq[s].last > idle_since)
+			continue;
+
+		for(auto &window : ra->win[s])
+		{
+			if(window.pending || !size(window.buf))
+				continue;
+
+			assert(env.readahead_bytes >= size(window.buf));
+			env.readahead_bytes -= size(window.buf);
+			window.buf = {};
+			window.offset = 0;
+			window.want = 0;
+			window.length = 0;
+		}
+	}
+
+	bool held(false);
+	for(size_t s(0); s < seq.size(); ++s)
+		held |= readahead_held(s);
+
+	if(!held)
+		env.readahead_files.erase(this);
+}
+
+/// Free the windows of the streams of any file of the database which
+/// haven't been read for readahead_idle.
+void
+ircd::db::database::env::random_access_file::readahead_reclaim()
+const noexcept
+{
+	auto &env(*d.env);
+	for(auto it(begin(env.readahead_files)); it != end(env.readahead_files);)
+	{
+		// Advanced first; the file is erased when its windows are freed.
+		const auto *const file(*it++);
+		file->readahead_free(false);
+	}
+}
+
+void
+ircd::db::database::env::random_access_file::readahead_worker(const size_t &s,
+                                                              const size_t &i)
+const noexcept try
+{
+	assert(ra);
+	auto &window(ra->win.at(s).at(i));
+	const unwind done{[this, &window]
+	{
+		window.pending = false;
+		ra->dock.notify_all();
+	}};
+
+	#ifdef RB_DEBUG_DB_ENV
+	log::debug
+	{
+		log, "[%s] rfile:%p readahead stream:%zu window:%zu offset:%zu length:%zu",
+		d.name,
+		this,
+		s,
+		i,
+		window.offset,
+		window.want
+	};
+	#endif
+
+	fs::read_opts opts;
+	opts.offset = window.offset;
+	opts.priority = ionice;
+	opts.aio = this->aio;
+	opts.all = false;
+	const mutable_buffer buf
+	{
+		data(window.buf), window.want
+	};
+
+	window.length = size(fs::read(fd, buf, opts));
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "[%s] rfile:%p readahead stream:%zu window:%zu :%s",
+		d.name,
+		this,
+		s,
+		i,
+		e.what()
+	};
+}
+
 rocksdb::Status
 ircd::db::database::env::random_access_file::InvalidateCache(size_t offset,
                                                              size_t length)
@@ -47,6 +47,10 @@ struct ircd::db::database::env final
 
 	std::unique_ptr<struct state> st;
 
+	// Read-ahead windows allocated by the random_access_files of this db.
+	size_t readahead_bytes {0};
+	std::set<const random_access_file *> readahead_files;
+
 	Status NewSequentialFile(const std::string& f, std::unique_ptr<SequentialFile>* r, const EnvOptions& options) noexcept override;
 	Status NewRandomAccessFile(const std::string& f, std::unique_ptr<RandomAccessFile>* r, const EnvOptions& options) noexcept override;
 	Status NewWritableFile(const std::string& f, std::unique_ptr<WritableFile>* r, const EnvOptions& options) noexcept override;
@@ -119,10 +123,18 @@ struct ircd::db::database::env::file_lock final
 struct ircd::db::database::env::random_access_file final
 :rocksdb::RandomAccessFile
 {
+	struct readahead;
+
 	using Status = rocksdb::Status;
 	using Slice = rocksdb::Slice;
 
 	static const fs::fd::opts default_opts;
+	static conf::item<bool> readahead_enable;
+	static conf::item<size_t> readahead_size;
+	static conf::item<size_t> readahead_trigger;
+	static conf::item<size_t> readahead_max;
+	static conf::item<seconds> readahead_idle;
+	static constexpr size_t streams_max {4};
 
 	database &d;
 	fs::fd::opts opts;
@@ -131,18 +143,65 @@ struct ircd::db::database::env::random_access_file final
 	int8_t ionice {0};
 	bool aio;
 
+	// sequential access detection; several iterators may scan the file at
+	// once, so each read continues the stream which ended where it begins.
+	struct stream
+	{
+		uint64_t offset {0};          // start of the last read
+		uint64_t end {0};             // end of the last read
+		size_t count {0};             // sequential reads so far
+		steady_point last;            // time of the last read
+	};
+
+	mutable std::array<stream, streams_max> seq;
+	mutable std::unique_ptr<struct readahead> ra;
+
+	bool readahead_held(const size_t &stream) const noexcept;
+	void readahead_free(const bool &all) const noexcept;
+	void readahead_reclaim() const noexcept;
+	void readahead_worker(const size_t &stream, const size_t &window) const noexcept;
+	void readahead_start(const size_t &stream, const uint64_t &offset, const size_t &length) const;
+	void readahead_detect(const uint64_t &offset, const size_t &length) const;
+	size_t readahead_read(const uint64_t &offset, const mutable_buffer &) const;
+
 	bool use_direct_io() const noexcept override;
 	size_t GetRequiredBufferAlignment() const noexcept override;
 	size_t GetUniqueId(char* id, size_t max_size) const noexcept override;
 	void Hint(AccessPattern pattern) noexcept override;
 	Status InvalidateCache(size_t offset, size_t length) noexcept override;
 	Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const noexcept override;
+	#ifdef IRCD_DB_HAS_ENV_MULTIREAD
+	Status MultiRead(rocksdb::ReadRequest *reqs, size_t num_reqs) noexcept override;
+	#endif
 	Status Prefetch(uint64_t offset, size_t n) noexcept override;
 
 	random_access_file(database *const &d, const std::string &name, const EnvOptions &);
 	~random_access_file() noexcept;
 };
 
+/// Read-ahead for direct-io where there is no page cache and RocksDB never
+/// calls Prefetch(). When sequential reads of small blocks are detected the
+/// next blocks are read asynchronously into one of these windows; subsequent
+/// reads are copied out of a window rather than going to the device. Each
+/// stream has two windows so the next one loads while the reader consumes
+/// the other. A window the reader has passed is reused for the next; the
+/// buffers are freed when their stream goes idle, which also happens to the
+/// windows of other files when the db reaches its cap.
+struct ircd::db::database::env::random_access_file::readahead
+{
+	struct window
+	{
+		unique_buffer<mutable_buffer> buf;
+		uint64_t offset {0};       // file offset of buf
+		size_t want {0};           // bytes requested into buf
+		size_t length {0};         // bytes valid in buf
+		bool pending {false};      // read in progress; buf not valid
+	};
+
+	ctx::dock dock;
+	std::array<std::array<window, 2>, streams_max> win;
+};
+
 struct ircd::db::database::env::random_rw_file final
 :rocksdb::RandomRWFile
 {
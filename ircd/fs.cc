@@ -829,6 +829,69 @@ ircd::fs::read(const string_view &path,
 	return read(fd, bufs, opts);
 }
 
+/// Read a batch of ops; each op reports its own result in read_op::ret or
+/// its error in read_op::eptr. When AIO is available all ops are submitted
+/// together and the ctx yields once for the batch; otherwise they are
+/// conducted in sequence. Returns the number of ops which did not fail.
+size_t
+ircd::fs::read(const vector_view<read_op> &ops)
+{
+	#ifdef IRCD_USE_AIO
+	const bool use_aio
+	{
+		aio::system && std::all_of(begin(ops), end(ops), []
+		(const read_op &op)
+		{
+			return op.opts.aio;
+		})
+	};
+
+	size_t ret
+	{
+		use_aio? aio::read(ops): 0UL
+	};
+	#else
+	const bool use_aio {false};
+	size_t ret {0};
+	#endif
+
+	for(size_t i(0); i < ops.size(); ++i) try
+	{
+		auto &op(ops[i]);
+		assert(op.fd);
+		assert(op.opts.op == op::READ);
+		if(op.eptr)
+			continue;
+
+		// The AIO batch conducts a single operation for each op; when the
+		// user expects the full buffer we finish any partial read here.
+		const bool partial
+		{
+			use_aio && op.opts.all && op.ret && op.ret < size(op.buf)
+		};
+
+		if(use_aio && !partial)
+			continue;
+
+		read_opts opts(op.opts);
+		opts.offset += op.ret;
+		const mutable_buffer buf
+		{
+			op.buf + op.ret
+		};
+
+		op.ret += size(read(*op.fd, buf, opts));
+		ret += !use_aio;
+	}
+	catch(...)
+	{
+		ops[i].eptr = std::current_exception();
+		ret -= use_aio;
+	}
+
+	return ret;
+}
+
 namespace ircd::fs
 {
 	static int flags(const read_opts &opts);
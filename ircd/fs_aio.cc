@@ -246,6 +246,75 @@ ircd::fs::aio::read(const fd &fd,
 	return bytes;
 }
 
+/// Submit a batch of reads together so the ctx yields once for all of
+/// them; the requests are coalesced into the same io_submit() when the
+/// system allows. Errors are reported per-op in read_op::eptr.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstack-usage="
+size_t
+__attribute__((stack_protect))
+ircd::fs::aio::read(const vector_view<read_op> &op)
+{
+	const size_t num(op.size());
+	struct ::iovec iov[num];
+	std::vector<std::optional<aio::request::read>> request(num);
+	for(size_t i(0); i < num; ++i)
+	{
+		assert(op[i].fd);
+		iov[i] = ::iovec
+		{
+			data(op[i].buf), size(op[i].buf)
+		};
+
+		request[i].emplace(*op[i].fd, const_iovec_view{iov + i, 1}, op[i].opts);
+	}
+
+	const scope_count cur_reads{stats.cur_reads};
+	stats.max_reads = std::max(stats.max_reads, stats.cur_reads);
+
+	size_t submitted(0);
+	std::exception_ptr eptr; try
+	{
+		for(; submitted < num; ++submitted)
+			request[submitted]->submit();
+	}
+	catch(...)
+	{
+		eptr = std::current_exception();
+	}
+
+	// Every submitted request must reach completion (or cancellation)
+	// before this frame can be unwound; the first error is rethrown after.
+	for(size_t i(0); i < submitted; ++i) try
+	{
+		while(!request[i]->wait());
+	}
+	catch(...)
+	{
+		if(!eptr)
+			eptr = std::current_exception();
+	}
+
+	if(unlikely(eptr))
+		std::rethrow_exception(eptr);
+
+	size_t ret(0);
+	for(size_t i(0); i < num; ++i) try
+	{
+		op[i].ret = request[i]->complete();
+		stats.bytes_read += op[i].ret;
+		stats.reads++;
+		++ret;
+	}
+	catch(...)
+	{
+		op[i].eptr = std::current_exception();
+	}
+
+	return ret;
+}
+#pragma GCC diagnostic pop
+
 //
 // request::write
 //
@@ -418,6 +487,20 @@ ircd::fs::aio::request::cancel()
 /// result will be available or an exception will be thrown.
 size_t
 ircd::fs::aio::request::operator()()
+{
+	submit();
+
+	// Wait for completion
+	while(!wait());
+
+	return complete();
+}
+
+/// Submit a request to the system without waiting for its completion. The
+/// ctx only yields here if there is no room for another request. The caller
+/// must wait() and then complete() the request.
+void
+ircd::fs::aio::request::submit()
 {
 	assert(system);
 	assert(ctx::current);
@@ -442,11 +525,18 @@ ircd::fs::aio::request::operator()()
 
 	// Submit to system
 	system->submit(*this);
+}
 
-	// Wait for completion
-	while(!wait());
-
+/// Conclude a completed request; returns the result or throws its error.
+size_t
+ircd::fs::aio::request::complete()
+{
 	assert(completed());
+	const size_t submitted_bytes
+	{
+		bytes(iovec())
+	};
+
 	assert(retval <= ssize_t(submitted_bytes));
 
 	// Update stats for completion phase.
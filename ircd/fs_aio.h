@@ -29,6 +29,7 @@ namespace ircd::fs::aio
 
 	size_t write(const fd &, const const_iovec_view &, const write_opts &);
 	size_t read(const fd &, const const_iovec_view &, const read_opts &);
+	size_t read(const vector_view<read_op> &);
 	void fsync(const fd &, const sync_opts &);
 }
 
@@ -133,6 +134,8 @@ struct ircd::fs::aio::request
 	bool queued() const;
 	bool wait();
 
+	void submit();
+	size_t complete();
 	size_t operator()();
 	bool cancel();
 
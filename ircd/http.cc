@@ -401,6 +401,9 @@ ircd::http::assign(request::head &head,
 
 	else if(key == "if-range"_sv)
 		head.if_range = val;
+
+	else if(key == "accept-encoding"_sv)
+		head.accept_encoding = val;
 }
 
 ircd::http::response::response(window_buffer &out,
@@ -577,6 +580,9 @@ ircd::http::assign(response::head &head,
 	else if(key == "transfer-encoding"_sv)
 		head.transfer_encoding = val;
 
+	else if(key == "content-encoding"_sv)
+		head.content_encoding = val;
+
 	else if(key == "server"_sv)
 		head.server = val;
 
@@ -91,6 +91,87 @@ static_assert
     sizeof(ircd::http2::frame::header) == 9
 );
 
+ircd::http2::frame::header
+ircd::http2::frame::read(const const_buffer &buf)
+{
+	if(unlikely(size(buf) < header_size))
+		throw error
+		{
+			error::FRAME_SIZE_ERROR, "frame header truncated to %zu bytes", size(buf)
+		};
+
+	const auto *const b
+	{
+		reinterpret_cast<const uint8_t *>(data(buf))
+	};
+
+	header ret;
+	ret.len = uint32_t(b[0]) << 16 | uint32_t(b[1]) << 8 | uint32_t(b[2]);
+	ret.type = type(b[3]);
+	ret.flags = b[4];
+	ret.stream_id = (uint32_t(b[5]) << 24 | uint32_t(b[6]) << 16 | uint32_t(b[7]) << 8 | uint32_t(b[8])) & 0x7fffffffU;
+	return ret;
+}
+
+ircd::const_buffer
+ircd::http2::frame::write(const mutable_buffer &buf,
+                          const type &type,
+                          const uint8_t &flags,
+                          const uint32_t &stream_id,
+                          const const_buffer &payload)
+{
+	const size_t len
+	{
+		size(payload)
+	};
+
+	if(unlikely(len > 0xffffffUL || size(buf) < header_size + len))
+		throw error
+		{
+			error::INTERNAL_ERROR, "no room for %s frame of %zu bytes", reflect(type), len
+		};
+
+	auto *const b
+	{
+		reinterpret_cast<uint8_t *>(data(buf))
+	};
+
+	b[0] = uint8_t(len >> 16);
+	b[1] = uint8_t(len >> 8);
+	b[2] = uint8_t(len);
+	b[3] = uint8_t(type);
+	b[4] = flags;
+	b[5] = uint8_t(stream_id >> 24) & 0x7f;
+	b[6] = uint8_t(stream_id >> 16);
+	b[7] = uint8_t(stream_id >> 8);
+	b[8] = uint8_t(stream_id);
+	copy(buf + header_size, payload);
+	return const_buffer
+	{
+		data(buf), header_size + len
+	};
+}
+
+ircd::string_view
+ircd::http2::frame::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::DATA:             return "DATA";
+		case type::HEADERS:          return "HEADERS";
+		case type::PRIORITY:         return "PRIORITY";
+		case type::RST_STREAM:       return "RST_STREAM";
+		case type::SETTINGS:         return "SETTINGS";
+		case type::PUSH_PROMISE:     return "PUSH_PROMISE";
+		case type::PING:             return "PING";
+		case type::GOAWAY:           return "GOAWAY";
+		case type::WINDOW_UPDATE:    return "WINDOW_UPDATE";
+		case type::CONTINUATION:     return "CONTINUATION";
+	}
+
+	return "??????";
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -167,3 +248,533 @@ ircd::http2::reflect(const enum error::code &code)
 
 	return "??????";
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// hpack.h
+//
+
+namespace ircd::http2::hpack
+{
+	struct code
+	{
+		uint32_t bits;
+		uint8_t len;
+	};
+
+	static size_t read_int(const_buffer &, const uint8_t &prefix);
+	static void write_int(window_buffer &, const size_t &, const uint8_t &prefix, const uint8_t &flags);
+	static string_view read_str(const_buffer &, const mutable_buffer &);
+	static void write_str(window_buffer &, const string_view &, const bool &lower = false);
+
+	extern const std::array<std::pair<string_view, string_view>, 61> static_table;
+	extern const std::array<code, 257> huffman_codes;
+
+	thread_local char name_buf[8_KiB], value_buf[16_KiB];
+}
+
+/// RFC 7541 Appendix A
+decltype(ircd::http2::hpack::static_table)
+ircd::http2::hpack::static_table
+{{
+	{ ":authority",                    ""               },
+	{ ":method",                       "GET"            },
+	{ ":method",                       "POST"           },
+	{ ":path",                         "/"              },
+	{ ":path",                         "/index.html"    },
+	{ ":scheme",                       "http"           },
+	{ ":scheme",                       "https"          },
+	{ ":status",                       "200"            },
+	{ ":status",                       "204"            },
+	{ ":status",                       "206"            },
+	{ ":status",                       "304"            },
+	{ ":status",                       "400"            },
+	{ ":status",                       "404"            },
+	{ ":status",                       "500"            },
+	{ "accept-charset",                ""               },
+	{ "accept-encoding",               "gzip, deflate"  },
+	{ "accept-language",               ""               },
+	{ "accept-ranges",                 ""               },
+	{ "accept",                        ""               },
+	{ "access-control-allow-origin",   ""               },
+	{ "age",                           ""               },
+	{ "allow",                         ""               },
+	{ "authorization",                 ""               },
+	{ "cache-control",                 ""               },
+	{ "content-disposition",           ""               },
+	{ "content-encoding",              ""               },
+	{ "content-language",              ""               },
+	{ "content-length",                ""               },
+	{ "content-location",              ""               },
+	{ "content-range",                 ""               },
+	{ "content-type",                  ""               },
+	{ "cookie",                        ""               },
+	{ "date",                          ""               },
+	{ "etag",                          ""               },
+	{ "expect",                        ""               },
+	{ "expires",                       ""               },
+	{ "from",                          ""               },
+	{ "host",                          ""               },
+	{ "if-match",                      ""               },
+	{ "if-modified-since",             ""               },
+	{ "if-none-match",                 ""               },
+	{ "if-range",                      ""               },
+	{ "if-unmodified-since",           ""               },
+	{ "last-modified",                 ""               },
+	{ "link",                          ""               },
+	{ "location",                      ""               },
+	{ "max-forwards",                  ""               },
+	{ "proxy-authenticate",            ""               },
+	{ "proxy-authorization",           ""               },
+	{ "range",                         ""               },
+	{ "referer",                       ""               },
+	{ "refresh",                       ""               },
+	{ "retry-after",                   ""               },
+	{ "server",                        ""               },
+	{ "set-cookie",                    ""               },
+	{ "strict-transport-security",     ""               },
+	{ "transfer-encoding",             ""               },
+	{ "user-agent",                    ""               },
+	{ "vary",                          ""               },
+	{ "via",                           ""               },
+	{ "www-authenticate",              ""               },
+}};
+
+/// RFC 7541 Appendix B; code bits are right-aligned, indexed by symbol.
+decltype(ircd::http2::hpack::huffman_codes)
+ircd::http2::hpack::huffman_codes
+{{
+	{0x00001ff8, 13}, {0x007fffd8, 23}, {0x0fffffe2, 28}, {0x0fffffe3, 28},
+	{0x0fffffe4, 28}, {0x0fffffe5, 28}, {0x0fffffe6, 28}, {0x0fffffe7, 28},
+	{0x0fffffe8, 28}, {0x00ffffea, 24}, {0x3ffffffc, 30}, {0x0fffffe9, 28},
+	{0x0fffffea, 28}, {0x3ffffffd, 30}, {0x0fffffeb, 28}, {0x0fffffec, 28},
+	{0x0fffffed, 28}, {0x0fffffee, 28}, {0x0fffffef, 28}, {0x0ffffff0, 28},
+	{0x0ffffff1, 28}, {0x0ffffff2, 28}, {0x3ffffffe, 30}, {0x0ffffff3, 28},
+	{0x0ffffff4, 28}, {0x0ffffff5, 28}, {0x0ffffff6, 28}, {0x0ffffff7, 28},
+	{0x0ffffff8, 28}, {0x0ffffff9, 28}, {0x0ffffffa, 28}, {0x0ffffffb, 28},
+	{0x00000014,  6}, {0x000003f8, 10}, {0x000003f9, 10}, {0x00000ffa, 12},
+	{0x00001ff9, 13}, {0x00000015,  6}, {0x000000f8,  8}, {0x000007fa, 11},
+	{0x000003fa, 10}, {0x000003fb, 10}, {0x000000f9,  8}, {0x000007fb, 11},
+	{0x000000fa,  8}, {0x00000016,  6}, {0x00000017,  6}, {0x00000018,  6},
+	{0x00000000,  5}, {0x00000001,  5}, {0x00000002,  5}, {0x00000019,  6},
+	{0x0000001a,  6}, {0x0000001b,  6}, {0x0000001c,  6}, {0x0000001d,  6},
+	{0x0000001e,  6}, {0x0000001f,  6}, {0x0000005c,  7}, {0x000000fb,  8},
+	{0x00007ffc, 15}, {0x00000020,  6}, {0x00000ffb, 12}, {0x000003fc, 10},
+	{0x00001ffa, 13}, {0x00000021,  6}, {0x0000005d,  7}, {0x0000005e,  7},
+	{0x0000005f,  7}, {0x00000060,  7}, {0x00000061,  7}, {0x00000062,  7},
+	{0x00000063,  7}, {0x00000064,  7}, {0x00000065,  7}, {0x00000066,  7},
+	{0x00000067,  7}, {0x00000068,  7}, {0x00000069,  7}, {0x0000006a,  7},
+	{0x0000006b,  7}, {0x0000006c,  7}, {0x0000006d,  7}, {0x0000006e,  7},
+	{0x0000006f,  7}, {0x00000070,  7}, {0x00000071,  7}, {0x00000072,  7},
+	{0x000000fc,  8}, {0x00000073,  7}, {0x000000fd,  8}, {0x00001ffb, 13},
+	{0x0007fff0, 19}, {0x00001ffc, 13}, {0x00003ffc, 14}, {0x00000022,  6},
+	{0x00007ffd, 15}, {0x00000003,  5}, {0x00000023,  6}, {0x00000004,  5},
+	{0x00000024,  6}, {0x00000005,  5}, {0x00000025,  6}, {0x00000026,  6},
+	{0x00000027,  6}, {0x00000006,  5}, {0x00000074,  7}, {0x00000075,  7},
+	{0x00000028,  6}, {0x00000029,  6}, {0x0000002a,  6}, {0x00000007,  5},
+	{0x0000002b,  6}, {0x00000076,  7}, {0x0000002c,  6}, {0x00000008,  5},
+	{0x00000009,  5}, {0x0000002d,  6}, {0x00000077,  7}, {0x00000078,  7},
+	{0x00000079,  7}, {0x0000007a,  7}, {0x0000007b,  7}, {0x00007ffe, 15},
+	{0x000007fc, 11}, {0x00003ffd, 14}, {0x00001ffd, 13}, {0x0ffffffc, 28},
+	{0x000fffe6, 20}, {0x003fffd2, 22}, {0x000fffe7, 20}, {0x000fffe8, 20},
+	{0x003fffd3, 22}, {0x003fffd4, 22}, {0x003fffd5, 22}, {0x007fffd9, 23},
+	{0x003fffd6, 22}, {0x007fffda, 23}, {0x007fffdb, 23}, {0x007fffdc, 23},
+	{0x007fffdd, 23}, {0x007fffde, 23}, {0x00ffffeb, 24}, {0x007fffdf, 23},
+	{0x00ffffec, 24}, {0x00ffffed, 24}, {0x003fffd7, 22}, {0x007fffe0, 23},
+	{0x00ffffee, 24}, {0x007fffe1, 23}, {0x007fffe2, 23}, {0x007fffe3, 23},
+	{0x007fffe4, 23}, {0x001fffdc, 21}, {0x003fffd8, 22}, {0x007fffe5, 23},
+	{0x003fffd9, 22}, {0x007fffe6, 23}, {0x007fffe7, 23}, {0x00ffffef, 24},
+	{0x003fffda, 22}, {0x001fffdd, 21}, {0x000fffe9, 20}, {0x003fffdb, 22},
+	{0x003fffdc, 22}, {0x007fffe8, 23}, {0x007fffe9, 23}, {0x001fffde, 21},
+	{0x007fffea, 23}, {0x003fffdd, 22}, {0x003fffde, 22}, {0x00fffff0, 24},
+	{0x001fffdf, 21}, {0x003fffdf, 22}, {0x007fffeb, 23}, {0x007fffec, 23},
+	{0x001fffe0, 21}, {0x001fffe1, 21}, {0x003fffe0, 22}, {0x001fffe2, 21},
+	{0x007fffed, 23}, {0x003fffe1, 22}, {0x007fffee, 23}, {0x007fffef, 23},
+	{0x000fffea, 20}, {0x003fffe2, 22}, {0x003fffe3, 22}, {0x003fffe4, 22},
+	{0x007ffff0, 23}, {0x003fffe5, 22}, {0x003fffe6, 22}, {0x007ffff1, 23},
+	{0x03ffffe0, 26}, {0x03ffffe1, 26}, {0x000fffeb, 20}, {0x0007fff1, 19},
+	{0x003fffe7, 22}, {0x007ffff2, 23}, {0x003fffe8, 22}, {0x01ffffec, 25},
+	{0x03ffffe2, 26}, {0x03ffffe3, 26}, {0x03ffffe4, 26}, {0x07ffffde, 27},
+	{0x07ffffdf, 27}, {0x03ffffe5, 26}, {0x00fffff1, 24}, {0x01ffffed, 25},
+	{0x0007fff2, 19}, {0x001fffe3, 21}, {0x03ffffe6, 26}, {0x07ffffe0, 27},
+	{0x07ffffe1, 27}, {0x03ffffe7, 26}, {0x07ffffe2, 27}, {0x00fffff2, 24},
+	{0x001fffe4, 21}, {0x001fffe5, 21}, {0x03ffffe8, 26}, {0x03ffffe9, 26},
+	{0x0ffffffd, 28}, {0x07ffffe3, 27}, {0x07ffffe4, 27}, {0x07ffffe5, 27},
+	{0x000fffec, 20}, {0x00fffff3, 24}, {0x000fffed, 20}, {0x001fffe6, 21},
+	{0x003fffe9, 22}, {0x001fffe7, 21}, {0x001fffe8, 21}, {0x007ffff3, 23},
+	{0x003fffea, 22}, {0x003fffeb, 22}, {0x01ffffee, 25}, {0x01ffffef, 25},
+	{0x00fffff4, 24}, {0x00fffff5, 24}, {0x03ffffea, 26}, {0x007ffff4, 23},
+	{0x03ffffeb, 26}, {0x07ffffe6, 27}, {0x03ffffec, 26}, {0x03ffffed, 26},
+	{0x07ffffe7, 27}, {0x07ffffe8, 27}, {0x07ffffe9, 27}, {0x07ffffea, 27},
+	{0x07ffffeb, 27}, {0x0ffffffe, 28}, {0x07ffffec, 27}, {0x07ffffed, 27},
+	{0x07ffffee, 27}, {0x07ffffef, 27}, {0x07fffff0, 27}, {0x03ffffee, 26},
+	{0x3fffffff, 30},
+}};
+
+//
+// decoder
+//
+
+ircd::http2::hpack::decoder::decoder(const size_t &table_limit)
+:table_max{table_limit}
+,table_limit{table_limit}
+{
+}
+
+void
+ircd::http2::hpack::decoder::operator()(const const_buffer &block,
+                                        const closure &closure)
+{
+	const_buffer in{block};
+	while(!empty(in))
+	{
+		const uint8_t b(*data(in));
+
+		// 6.1 Indexed Header Field
+		if(b & 0x80)
+		{
+			const auto &[name, value]
+			{
+				get(read_int(in, 7))
+			};
+
+			closure(name, value);
+			continue;
+		}
+
+		// 6.3 Dynamic Table Size Update
+		if((b & 0xe0) == 0x20)
+		{
+			const size_t max
+			{
+				read_int(in, 5)
+			};
+
+			if(unlikely(max > table_limit))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "table size update %zu exceeds %zu", max, table_limit
+				};
+
+			table_max = max;
+			evict(table_max);
+			continue;
+		}
+
+		// 6.2.1 Literal with Incremental Indexing; otherwise 6.2.2 and 6.2.3
+		// without indexing or never indexed, which are the same to us.
+		const bool indexing
+		{
+			(b & 0xc0) == 0x40
+		};
+
+		const size_t index
+		{
+			read_int(in, indexing? 6 : 4)
+		};
+
+		const string_view name
+		{
+			index?
+				get(index).first:
+				read_str(in, name_buf)
+		};
+
+		const string_view value
+		{
+			read_str(in, value_buf)
+		};
+
+		if(!indexing)
+		{
+			closure(name, value);
+			continue;
+		}
+
+		// The name might be in the table and evicted by the insertion.
+		insert(entry{name, value});
+		closure(table.front().first, table.front().second);
+	}
+}
+
+std::pair<ircd::string_view, ircd::string_view>
+ircd::http2::hpack::decoder::get(const size_t &index)
+const
+{
+	if(likely(index > 0 && index <= static_table.size()))
+		return static_table[index - 1];
+
+	if(likely(index > static_table.size() && index - static_table.size() <= table.size()))
+	{
+		const auto &[name, value]
+		{
+			table.at(index - static_table.size() - 1)
+		};
+
+		return { name, value };
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "index %zu out of range", index
+	};
+}
+
+void
+ircd::http2::hpack::decoder::insert(entry &&e)
+{
+	const size_t esize
+	{
+		size(e.first) + size(e.second) + 32
+	};
+
+	// An entry larger than the table empties it and is not added (4.4).
+	if(esize > table_max)
+	{
+		evict(0);
+		return;
+	}
+
+	evict(table_max - esize);
+	table.emplace_front(std::move(e));
+	table_size += esize;
+}
+
+void
+ircd::http2::hpack::decoder::evict(const size_t &max)
+{
+	while(table_size > max && !table.empty())
+	{
+		const auto &e(table.back());
+		table_size -= size(e.first) + size(e.second) + 32;
+		table.pop_back();
+	}
+}
+
+//
+// hpack
+//
+
+void
+ircd::http2::hpack::write(window_buffer &out,
+                          const http::header &header)
+{
+	// 6.2.2 Literal Header Field without Indexing -- New Name
+	write_int(out, 0, 4, 0x00);
+	write_str(out, header.first, true);
+	write_str(out, header.second);
+}
+
+/// Bits are consumed from the most significant end; the decoder walks a
+/// binary tree built once from the code table.
+ircd::string_view
+ircd::http2::hpack::huffman(const mutable_buffer &buf,
+                            const const_buffer &in)
+{
+	static const auto tree{[]
+	{
+		// Each node has two children; a child is either another node (>0)
+		// or a leaf holding ~symbol (<0). Node 0 is the root.
+		std::vector<std::array<int16_t, 2>> tree(1, {0, 0});
+		for(size_t sym(0); sym < huffman_codes.size(); ++sym)
+		{
+			const auto &code(huffman_codes[sym]);
+			size_t node(0);
+			for(int i(code.len - 1); i >= 0; --i)
+			{
+				const bool bit((code.bits >> i) & 1);
+				if(i == 0)
+				{
+					tree[node][bit] = ~int16_t(sym);
+					break;
+				}
+
+				if(!tree[node][bit])
+				{
+					tree[node][bit] = tree.size();
+					tree.push_back({0, 0});
+				}
+
+				node = tree[node][bit];
+			}
+		}
+
+		return tree;
+	}()};
+
+	size_t len(0), node(0), depth(0);
+	for(const uint8_t byte : string_view{in})
+		for(int i(7); i >= 0; --i)
+		{
+			const int16_t next
+			{
+				tree[node][(byte >> i) & 1]
+			};
+
+			++depth;
+			if(next > 0)
+			{
+				node = next;
+				continue;
+			}
+
+			const int sym(~next);
+			if(unlikely(next == 0 || sym == 256))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "invalid huffman code"
+				};
+
+			if(unlikely(len >= size(buf)))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "huffman string exceeds %zu bytes", size(buf)
+				};
+
+			data(buf)[len++] = char(sym);
+			node = 0;
+			depth = 0;
+		}
+
+	// 5.2: the padding is under 8 bits and only a prefix of EOS (all ones).
+	if(unlikely(depth > 7))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "huffman padding of %zu bits", depth
+		};
+
+	return string_view
+	{
+		data(buf), len
+	};
+}
+
+/// 5.1 Integer Representation
+size_t
+ircd::http2::hpack::read_int(const_buffer &in,
+                             const uint8_t &prefix)
+{
+	if(unlikely(empty(in)))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "integer truncated"
+		};
+
+	const uint8_t mask((1U << prefix) - 1);
+	size_t ret(uint8_t(*data(in)) & mask);
+	consume(in, 1);
+	if(ret < mask)
+		return ret;
+
+	for(size_t shift(0); !empty(in); shift += 7)
+	{
+		const uint8_t b(*data(in));
+		consume(in, 1);
+		if(unlikely(shift > 28))
+			break;
+
+		ret += size_t(b & 0x7f) << shift;
+		if(!(b & 0x80))
+			return ret;
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "integer truncated or too large"
+	};
+}
+
+void
+ircd::http2::hpack::write_int(window_buffer &out,
+                              const size_t &val,
+                              const uint8_t &prefix,
+                              const uint8_t &flags)
+{
+	out([&val, &prefix, &flags](const mutable_buffer &buf)
+	{
+		const uint8_t mask((1U << prefix) - 1);
+		const size_t max
+		{
+			val < mask? 1UL : 6UL
+		};
+
+		if(unlikely(size(buf) < max))
+			throw error
+			{
+				error::INTERNAL_ERROR, "no room for header integer"
+			};
+
+		auto *const b(reinterpret_cast<uint8_t *>(data(buf)));
+		if(val < mask)
+		{
+			b[0] = flags | uint8_t(val);
+			return 1UL;
+		}
+
+		size_t i(0), rem(val - mask);
+		b[i++] = flags | mask;
+		for(; rem >= 0x80; rem >>= 7)
+			b[i++] = uint8_t(rem & 0x7f) | 0x80;
+
+		b[i++] = uint8_t(rem);
+		return i;
+	});
+}
+
+/// 5.2 String Literal Representation
+ircd::string_view
+ircd::http2::hpack::read_str(const_buffer &in,
+                             const mutable_buffer &buf)
+{
+	const bool huff
+	{
+		!empty(in) && (uint8_t(*data(in)) & 0x80)
+	};
+
+	const size_t len
+	{
+		read_int(in, 7)
+	};
+
+	if(unlikely(len > size(in)))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "string of %zu bytes truncated at %zu", len, size(in)
+		};
+
+	const const_buffer str
+	{
+		data(in), len
+	};
+
+	consume(in, len);
+	if(huff)
+		return huffman(buf, str);
+
+	// The literal is returned in place; the block outlives the closure.
+	return string_view
+	{
+		data(str), size(str)
+	};
+}
+
+void
+ircd::http2::hpack::write_str(window_buffer &out,
+                              const string_view &str,
+                              const bool &lower)
+{
+	write_int(out, size(str), 7, 0x00);
+	out([&str, &lower](const mutable_buffer &buf)
+	{
+		if(unlikely(size(buf) < size(str)))
+			throw error
+			{
+				error::INTERNAL_ERROR, "no room for header string of %zu bytes", size(str)
+			};
+
+		if(lower)
+			return size(tolower(buf, str));
+
+		return copy(buf, str);
+	});
+}
@@ -1674,6 +1674,29 @@ ircd::json::stack::member::append(const json::value &value)
 	});
 }
 
+/// Appends JSON which was already strung (i.e. by another json::stack) as
+/// the value. It is copied in pieces so it may be larger than the buffer.
+void
+ircd::json::stack::member::splice(const string_view &strung)
+{
+	assert(s);
+	_pre_append();
+	const unwind post{[this]
+	{
+		_post_append();
+	}};
+
+	const size_t piece_max
+	{
+		std::max(size(s->buf.base) / 2, 1UL)
+	};
+
+	for(size_t i(0); i < size(strung); i += piece_max)
+		s->append(strung.substr(i, piece_max));
+
+	s->rethrow_exception();
+}
+
 void
 ircd::json::stack::member::_pre_append()
 {
@@ -9,6 +9,8 @@
 // full license for this software is available in the LICENSE file.
 
 #include <RB_INC_IOSTREAM
+#include <RB_INC_FCNTL_H
+#include <sys/uio.h>
 // <iostream> inclusion here runs std::ios_base::Init() statically as this unit
 // is initialized (GNU initialization order given in Makefile).
 
@@ -18,10 +20,13 @@ namespace ircd::log
 
 	static bool is_conf_mask_file(const string_view &name);
 	static bool is_conf_mask_console(const string_view &name);
+	static bool is_conf_binary_file(const string_view &name);
 	static void slog(const log &, const level &, const window_buffer::closure &) noexcept;
 	static void vlog_threadsafe(const log &, const level &, const string_view &fmt, const va_rtti &ap);
 	static std::string file_path(const level &);
 	static void open(const level &);
+	static void close(const level &);
+	static bool is_open(const level &);
 	static void mkdir();
 
 	extern const size_t CTX_NAME_TRUNC;
@@ -33,6 +38,7 @@ namespace ircd::log
 	extern conf::item<std::string> unmask_console;
 	extern conf::item<std::string> mask_file;
 	extern conf::item<std::string> mask_console;
+	extern conf::item<std::string> binary_file;
 	extern std::array<std::ofstream, num_of<level>()> file;
 	extern std::array<ulong, num_of<level>()> console_quiet_stdout;
 	extern std::array<ulong, num_of<level>()> console_quiet_stderr;
@@ -49,6 +55,103 @@ struct ircd::log::confs
 	conf::item<bool> console_flush;
 };
 
+/// Asynchronous output. Formatted records are copied into a ring buffer by
+/// the main thread (the only producer, see slog()) and a dedicated writer
+/// thread drains the ring with batched writev(2) to each sink. The event loop
+/// no longer blocks on the terminal or the disk unless the ring is full and
+/// the overflow policy is "block", or the record is CRITICAL.
+namespace ircd::log::async
+{
+	struct header;
+	struct binary;
+	struct writer;
+	enum sink :uint8_t;
+
+	static size_t pad(const size_t &) noexcept;
+	static bool active() noexcept;
+	static bool push(const sink &, const vector_view<const const_buffer> &) noexcept;
+	static bool push(const sink &, const const_buffer &) noexcept;
+	static bool push_binary(const log &, const level &, const string_view &) noexcept;
+	static void drain() noexcept;
+	static void wake() noexcept;
+	static int open(const std::string &path);
+	static void close(const uint8_t &sink) noexcept;
+	static void start();
+	static void stop() noexcept;
+	static size_t write(const int &fd, std::vector<struct ::iovec> &) noexcept;
+	static size_t batch() noexcept;
+	static void worker() noexcept;
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> ring_size;
+	extern conf::item<std::string> overflow;
+	extern stats::item enqueued;
+	extern stats::item dropped;
+	extern stats::item blocked;
+
+	std::unique_ptr<char[]> ring;
+	size_t ring_mask;
+	std::atomic<size_t> head;         // advanced by the producer
+	std::atomic<size_t> tail;         // advanced by the writer
+	std::atomic<bool> sleeping;
+	std::atomic<bool> terminate;
+	std::mutex mutex;
+	std::condition_variable cond;     // writer waits for records
+	std::condition_variable space;    // producer waits for the writer
+	extern std::array<int, num_of<level>() + 3> fd;
+
+	// Captured by slog() for the binary record of the message in flight.
+	uint64_t last_ts, last_epoch, last_ctx;
+	size_t last_prefix;
+}
+
+/// Each ring record is preceded by this header and padded to a multiple of
+/// its size, so a header always fits in whatever remains before the end of
+/// the ring.
+struct ircd::log::async::header
+{
+	uint32_t size;                    // payload bytes following the header
+	uint8_t sink;                     // enum sink
+	uint8_t _pad[3];
+};
+
+/// Binary file record. All integers are host byte order. The record is
+/// followed immediately by `name_len` bytes of the logger name and then
+/// `msg_len` bytes of the message without prefix or line ending.
+struct ircd::log::async::binary
+{
+	uint32_t size;                    // total bytes including this header
+	uint8_t level;
+	uint8_t name_len;
+	uint16_t msg_len;
+	uint64_t ts;                      // microseconds since the unix epoch
+	uint64_t epoch;                   // ctx or ios slice epoch
+	uint64_t ctx;                     // ctx::id() or 0
+};
+
+/// Levels occupy the low values so a level file is its own sink.
+enum ircd::log::async::sink
+:uint8_t
+{
+	PAD     = 0xFF,
+	STDOUT  = num_of<level>() + 0,
+	STDERR  = num_of<level>() + 1,
+	BINARY  = num_of<level>() + 2,
+};
+
+/// Owns the writer thread so it is joined even if fini() is never reached.
+struct ircd::log::async::writer
+{
+	std::thread thread;
+
+	~writer() noexcept;
+};
+
+namespace ircd::log::async
+{
+	extern writer writer_thread;
+}
+
 /// Linkage for list of named loggers.
 template<>
 decltype(ircd::instance_list<ircd::log::log>::allocator)
@@ -129,6 +232,9 @@ ircd::log::init()
 		console_disable(level::DWARNING);
 	}
 
+	if(bool(async::enable))
+		async::start();
+
 	if(ircd::write_avoid)
 		return;
 
@@ -140,6 +246,7 @@ ircd::log::fini()
 {
 	flush();
 	close();
+	async::stop();
 }
 
 void
@@ -172,31 +279,39 @@ ircd::log::open()
 		if(!bool(conf.file_enable))
 			return;
 
-		if(file[lev].is_open())
-			file[lev].close();
+		if(is_open(lev))
+			close(lev);
 
 		file[lev].clear();
 		file[lev].exceptions(std::ios::badbit | std::ios::failbit);
 		open(lev);
 	});
+
+	async::close(async::BINARY);
+	if(async::active() && !empty(string_view(binary_file)))
+		async::fd[async::BINARY] = async::open(fs::path_string(fs::base::LOG, "binary"));
 }
 
 void
 ircd::log::close()
 {
+	async::drain();
 	for_each<level>([](const level &lev)
 	{
 		if(lev > RB_LOG_LEVEL)
 			return;
 
-		if(file[lev].is_open())
-			file[lev].close();
+		if(is_open(lev))
+			close(lev);
 	});
+
+	async::close(async::BINARY);
 }
 
 void
 ircd::log::flush()
 {
+	async::drain();
 	for_each<level>([](const level &lev)
 	{
 		if(lev > RB_LOG_LEVEL)
@@ -213,8 +328,14 @@ void
 ircd::log::open(const level &lev)
 try
 {
-	const auto &mode(std::ios::app);
 	const auto &path(file_path(lev));
+	if(async::active())
+	{
+		async::fd[lev] = async::open(path);
+		return;
+	}
+
+	const auto &mode(std::ios::app);
 	file[lev].open(path.c_str(), mode);
 }
 catch(const std::exception &e)
@@ -225,6 +346,20 @@ catch(const std::exception &e)
 	throw;
 }
 
+void
+ircd::log::close(const level &lev)
+{
+	async::close(lev);
+	if(file[lev].is_open())
+		file[lev].close();
+}
+
+bool
+ircd::log::is_open(const level &lev)
+{
+	return file[lev].is_open() || async::fd[lev] >= 0;
+}
+
 std::string
 ircd::log::file_path(const level &lev)
 {
@@ -287,6 +422,13 @@ ircd::log::file_unmask(const vector_view<const string_view> &list)
 		log->fmasked = std::find(begin(list), end(list), log->name) == end(list);
 }
 
+void
+ircd::log::file_binary(const vector_view<const string_view> &list)
+{
+	for(auto *const &log : log::list)
+		log->fbinary = std::find(begin(list), end(list), log->name) != end(list);
+}
+
 void
 ircd::log::console_mask(const vector_view<const string_view> &list)
 {
@@ -408,6 +550,10 @@ ircd::log::log::log(const string_view &name,
 {
 	is_conf_mask_file(name)
 }
+,fbinary
+{
+	is_conf_binary_file(name)
+}
 {
 	for(const auto *const &other : list)
 	{
@@ -589,6 +735,10 @@ noexcept
 
 	// Compose the user message after prefix
 	const size_t pos(s.tellp());
+	async::last_ts = ircd::time<microseconds>();
+	async::last_epoch = epoch;
+	async::last_ctx = ctx::id();
+	async::last_prefix = pos;
 	const mutable_buffer userspace{buf + pos, max - pos};
 	window_buffer sb{userspace};
 	sb(closure);
@@ -662,7 +812,7 @@ noexcept
 
 	const bool copy_to_file
 	{
-		file[lev].is_open()
+		is_open(lev)
 		&& (log.fmasked || lev == level::CRITICAL)
 	};
 
@@ -670,6 +820,19 @@ noexcept
 	if(!copy_to_file || !msg)
 		return;
 
+	if(async::active())
+	{
+		if(log.fbinary && async::fd[async::BINARY] >= 0)
+			async::push_binary(log, lev, msg);
+		else
+			async::push(async::sink(lev), msg);
+
+		if(unlikely(lev == level::CRITICAL))
+			async::drain();
+
+		return;
+	}
+
 	file[lev].clear();
 	check(file[lev]);
 	file[lev].write(data(msg), size(msg));
@@ -711,6 +874,20 @@ noexcept
 	if((!copy_to_stdout && !copy_to_stderr) || !msg)
 		return;
 
+	if(async::active())
+	{
+		if(unlikely(copy_to_stderr))
+			async::push(async::STDERR, msg);
+
+		if(likely(copy_to_stdout))
+			async::push(async::STDOUT, msg);
+
+		if(unlikely(lev == level::CRITICAL))
+			async::drain();
+
+		return;
+	}
+
 	if(unlikely(copy_to_stderr))
 	{
 		err_console.clear();
@@ -728,6 +905,537 @@ noexcept
 	}
 }
 
+//
+// async
+//
+
+/// Toggling this at runtime starts or stops the writer; open log files are
+/// closed and reopened for the path which writes them. Until init() this
+/// only sets whether init() starts the writer.
+decltype(ircd::log::async::enable)
+ircd::log::async::enable
+{
+	{
+		{ "name",     "ircd.log.async.enable" },
+		{ "default",  false                   },
+	}, []
+	{
+		if(run::level == run::level::HALT)
+			return;
+
+		if(bool(enable) == active())
+			return;
+
+		bool reopen(fd[BINARY] >= 0);
+		for_each<level>([&reopen](const level &lev)
+		{
+			if(lev <= RB_LOG_LEVEL)
+				reopen |= ircd::log::is_open(lev);
+		});
+
+		if(reopen)
+			ircd::log::close();
+
+		if(bool(enable))
+			start();
+		else
+			stop();
+
+		if(reopen)
+			ircd::log::open();
+	}
+};
+
+decltype(ircd::log::async::ring_size)
+ircd::log::async::ring_size
+{
+	{ "name",     "ircd.log.async.ring.size" },
+	{ "default",  long(8_MiB)                },
+};
+
+/// Policy when the ring is full: "block" stalls the main thread until the
+/// writer makes room; "drop" discards the record and counts it.
+decltype(ircd::log::async::overflow)
+ircd::log::async::overflow
+{
+	{ "name",     "ircd.log.async.overflow" },
+	{ "default",  "block"                   },
+};
+
+decltype(ircd::log::async::enqueued)
+ircd::log::async::enqueued
+{
+	{ "name", "ircd.log.async.enqueued" },
+	{ "desc", "Number of records copied into the log ring" },
+};
+
+decltype(ircd::log::async::dropped)
+ircd::log::async::dropped
+{
+	{ "name", "ircd.log.async.dropped" },
+	{ "desc", "Number of records discarded because the log ring was full" },
+};
+
+decltype(ircd::log::async::blocked)
+ircd::log::async::blocked
+{
+	{ "name", "ircd.log.async.blocked" },
+	{ "desc", "Number of times the main thread waited for room in the log ring" },
+};
+
+decltype(ircd::log::async::fd)
+ircd::log::async::fd
+{[]
+{
+	std::array<int, num_of<level>() + 3> ret;
+	ret.fill(-1);
+	ret[STDOUT] = STDOUT_FILENO;
+	ret[STDERR] = STDERR_FILENO;
+	return ret;
+}()};
+
+// Must be defined after the state it references so it's destroyed first.
+decltype(ircd::log::async::writer_thread)
+ircd::log::async::writer_thread;
+
+ircd::log::async::writer::~writer()
+noexcept
+{
+	stop();
+}
+
+void
+ircd::log::async::start()
+{
+	if(writer_thread.thread.joinable())
+		return;
+
+	size_t size(64_KiB);
+	while(size < size_t(ring_size))
+		size <<= 1;
+
+	// Anything buffered by the streams has to be out before the writer
+	// starts writing to the same descriptors.
+	std::flush(out_console);
+	std::flush(err_console);
+
+	ring.reset(new char[size]);
+	ring_mask = size - 1;
+	head = 0;
+	tail = 0;
+	terminate = false;
+	writer_thread.thread = std::thread{&worker};
+}
+
+void
+ircd::log::async::stop()
+noexcept
+{
+	if(!writer_thread.thread.joinable())
+		return;
+
+	drain();
+	{
+		const std::lock_guard lock
+		{
+			mutex
+		};
+
+		terminate = true;
+		cond.notify_all();
+	}
+
+	writer_thread.thread.join();
+
+	// Files opened for the writer are unusable by the synchronous path.
+	for(size_t i(0); i < fd.size(); ++i)
+		if(i != STDOUT && i != STDERR && fd[i] >= 0)
+		{
+			::close(fd[i]);
+			fd[i] = -1;
+		}
+}
+
+size_t
+ircd::log::async::pad(const size_t &size)
+noexcept
+{
+	static_assert(sizeof(header) >= alignof(header));
+	static_assert((sizeof(header) & (sizeof(header) - 1)) == 0);
+	return (size + sizeof(header) - 1) & ~(sizeof(header) - 1);
+}
+
+bool
+ircd::log::async::active()
+noexcept
+{
+	return writer_thread.thread.joinable() && !terminate;
+}
+
+int
+ircd::log::async::open(const std::string &path)
+{
+	const int ret
+	{
+		::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)
+	};
+
+	if(unlikely(ret < 0))
+		throw std::system_error
+		{
+			errno, std::system_category()
+		};
+
+	return ret;
+}
+
+/// The ring must be drained before a descriptor is closed.
+void
+ircd::log::async::close(const uint8_t &sink)
+noexcept
+{
+	if(fd[sink] < 0 || sink == STDOUT || sink == STDERR)
+		return;
+
+	drain();
+	::close(fd[sink]);
+	fd[sink] = -1;
+}
+
+/// Blocks the caller until the writer has consumed everything enqueued
+/// prior to this call.
+void
+ircd::log::async::drain()
+noexcept
+{
+	if(!writer_thread.thread.joinable())
+		return;
+
+	const size_t target
+	{
+		head.load(std::memory_order_acquire)
+	};
+
+	std::unique_lock lock
+	{
+		mutex
+	};
+
+	cond.notify_all();
+	space.wait(lock, [&target]
+	{
+		return tail.load(std::memory_order_acquire) >= target || terminate;
+	});
+}
+
+void
+ircd::log::async::wake()
+noexcept
+{
+	if(!sleeping.load())
+		return;
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	cond.notify_one();
+}
+
+bool
+ircd::log::async::push_binary(const log &log,
+                              const level &lev,
+                              const string_view &msg)
+noexcept
+{
+	// Strip the text prefix and the line ending composed by slog().
+	const string_view text
+	{
+		msg.substr(std::min(last_prefix, size(msg)), std::min(size(msg), 1024UL))
+	};
+
+	const string_view message
+	{
+		rstrip(text, "\r\n")
+	};
+
+	const string_view name
+	{
+		trunc(log.name, 255)
+	};
+
+	const binary bin
+	{
+		uint32_t(sizeof(binary) + size(name) + size(message)),
+		uint8_t(lev),
+		uint8_t(size(name)),
+		uint16_t(size(message)),
+		last_ts,
+		last_epoch,
+		last_ctx,
+	};
+
+	const const_buffer bufs[]
+	{
+		{ reinterpret_cast<const char *>(&bin), sizeof(bin) },
+		name,
+		message,
+	};
+
+	return push(BINARY, bufs);
+}
+
+bool
+ircd::log::async::push(const sink &sink,
+                       const const_buffer &buf)
+noexcept
+{
+	return push(sink, vector_view<const const_buffer>{&buf, 1});
+}
+
+/// Copies the record into the ring. Only the main thread calls this, so
+/// the head is never contended; the release store publishes the payload to
+/// the writer.
+bool
+ircd::log::async::push(const sink &sink,
+                       const vector_view<const const_buffer> &bufs)
+noexcept
+{
+	const size_t payload
+	{
+		buffers::size(bufs)
+	};
+
+	const size_t need
+	{
+		sizeof(header) + pad(payload)
+	};
+
+	const size_t cap
+	{
+		ring_mask + 1
+	};
+
+	const size_t pos
+	{
+		head.load(std::memory_order_relaxed)
+	};
+
+	// A record never wraps; the remainder of the ring is skipped with a
+	// PAD record instead. Every record is a multiple of the header size and
+	// the ring is a power of two, so the remainder always holds a header.
+	const size_t remain
+	{
+		cap - (pos & ring_mask)
+	};
+
+	assert(remain >= sizeof(header));
+	assert(remain % sizeof(header) == 0);
+	if(unlikely(need > cap))
+	{
+		++dropped;
+		return false;
+	}
+
+	const size_t skip
+	{
+		remain < need? remain : 0
+	};
+
+	const auto fits{[&]
+	{
+		return pos + skip + need - tail.load(std::memory_order_acquire) <= cap;
+	}};
+
+	if(unlikely(!fits()))
+	{
+		if(string_view(overflow) == "drop")
+		{
+			++dropped;
+			return false;
+		}
+
+		++blocked;
+		std::unique_lock lock
+		{
+			mutex
+		};
+
+		cond.notify_all();
+		space.wait(lock, [&fits]
+		{
+			return fits() || terminate;
+		});
+
+		if(unlikely(terminate))
+			return false;
+	}
+
+	if(skip)
+	{
+		auto *const pad(reinterpret_cast<header *>(ring.get() + (pos & ring_mask)));
+		pad->size = skip - sizeof(header);
+		pad->sink = PAD;
+	}
+
+	const size_t at
+	{
+		(pos + skip) & ring_mask
+	};
+
+	auto *const hdr(reinterpret_cast<header *>(ring.get() + at));
+	hdr->size = payload;
+	hdr->sink = sink;
+
+	mutable_buffer out
+	{
+		ring.get() + at + sizeof(header), payload
+	};
+
+	for(const auto &buf : bufs)
+		consume(out, copy(out, buf));
+
+	head.store(pos + skip + need, std::memory_order_release);
+	++enqueued;
+	wake();
+	return true;
+}
+
+void
+ircd::log::async::worker()
+noexcept
+{
+	while(1)
+	{
+		if(batch())
+			continue;
+
+		std::unique_lock lock
+		{
+			mutex
+		};
+
+		sleeping = true;
+		cond.wait_for(lock, 50ms, []
+		{
+			return head.load() != tail.load() || terminate;
+		});
+
+		sleeping = false;
+		if(terminate && head.load() == tail.load())
+			return;
+	}
+}
+
+/// Gathers every complete record in the ring into per-sink iovecs, writes
+/// them, then releases the space back to the producer.
+size_t
+ircd::log::async::batch()
+noexcept
+{
+	thread_local std::array<std::vector<struct ::iovec>, num_of<level>() + 3> iov;
+
+	const size_t stop
+	{
+		head.load(std::memory_order_acquire)
+	};
+
+	size_t pos
+	{
+		tail.load(std::memory_order_relaxed)
+	};
+
+	if(pos == stop)
+		return 0;
+
+	size_t count(0);
+	while(pos != stop)
+	{
+		const auto *const hdr
+		{
+			reinterpret_cast<const header *>(ring.get() + (pos & ring_mask))
+		};
+
+		if(hdr->sink != PAD && hdr->sink < iov.size())
+			iov[hdr->sink].emplace_back(::iovec
+			{
+				const_cast<char *>(reinterpret_cast<const char *>(hdr + 1)), hdr->size
+			});
+
+		pos += sizeof(header) + pad(hdr->size);
+		++count;
+	}
+
+	for(size_t i(0); i < iov.size(); ++i)
+	{
+		if(!iov[i].empty())
+			write(fd[i], iov[i]);
+
+		iov[i].clear();
+	}
+
+	tail.store(pos, std::memory_order_release);
+	{
+		const std::lock_guard lock
+		{
+			mutex
+		};
+
+		space.notify_all();
+	}
+
+	return count;
+}
+
+size_t
+ircd::log::async::write(const int &fd,
+                        std::vector<struct ::iovec> &iov)
+noexcept
+{
+	static const size_t iov_max
+	{
+		size_t(std::max(::sysconf(_SC_IOV_MAX), 16L))
+	};
+
+	if(fd < 0)
+		return 0;
+
+	size_t ret(0), i(0);
+	while(i < iov.size())
+	{
+		const int cnt
+		{
+			int(std::min(iov.size() - i, iov_max))
+		};
+
+		const ssize_t wrote
+		{
+			::writev(fd, iov.data() + i, cnt)
+		};
+
+		if(unlikely(wrote < 0 && errno == EINTR))
+			continue;
+
+		if(unlikely(wrote <= 0))
+			break;
+
+		// Advance past what was written; a short write leaves a partial
+		// iovec to resume from.
+		ret += wrote;
+		for(size_t rem(wrote); rem && i < iov.size(); )
+		{
+			const size_t take(std::min(rem, size_t(iov[i].iov_len)));
+			iov[i].iov_base = static_cast<char *>(iov[i].iov_base) + take;
+			iov[i].iov_len -= take;
+			rem -= take;
+			i += !iov[i].iov_len;
+		}
+	}
+
+	return ret;
+}
+
 //
 // ircd::log util
 //
@@ -828,6 +1536,12 @@ ircd::log::is_conf_mask_console(const string_view &name)
 	return empty(string_view(mask_console));
 }
 
+bool
+ircd::log::is_conf_binary_file(const string_view &name)
+{
+	return token_exists(string_view(binary_file), ' ', name);
+}
+
 bool
 ircd::log::is_conf_mask_file(const string_view &name)
 {
@@ -880,6 +1594,18 @@ ircd::log::mask_file
 	}
 };
 
+decltype(ircd::log::binary_file)
+ircd::log::binary_file
+{
+	{
+		{ "name",     "ircd.log.file.binary" },
+		{ "default",  string_view{}          },
+	}, []
+	{
+		file_binary(tokens<std::vector>(binary_file, ' '));
+	}
+};
+
 decltype(ircd::log::mask_console)
 ircd::log::mask_console
 {
@@ -1296,6 +1296,9 @@ ircd::net::socket::handshake(const open_opts &opts,
 	if(opts.send_sni && server_name(opts))
 		openssl::server_name(*this, server_name(opts));
 
+	if(!empty(opts.alpn))
+		openssl::alpn(*this, opts.alpn);
+
 	ssl.set_verify_callback(std::move(verify_handler));
 	ssl.async_handshake(handshake_type::client, ios::handle(desc, std::move(handshake_handler)));
 }
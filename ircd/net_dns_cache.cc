@@ -29,6 +29,58 @@ ircd::net::dns::cache::nxdomain_ttl
 	{ "default",  86400L                            },
 };
 
+/// Time past expiration during which a cached answer is still served to
+/// callers while a refresh is conducted in the background. Errors are never
+/// served stale.
+decltype(ircd::net::dns::cache::stale_ttl)
+ircd::net::dns::cache::stale_ttl
+{
+	{ "name",     "ircd.net.dns.cache.stale_ttl" },
+	{ "default",  3600L                          },
+};
+
+/// Number of hits an entry requires before it is refreshed ahead of its
+/// expiration.
+decltype(ircd::net::dns::cache::prefetch_hits)
+ircd::net::dns::cache::prefetch_hits
+{
+	{ "name",     "ircd.net.dns.cache.prefetch.hits" },
+	{ "default",  4L                                 },
+};
+
+/// A popular entry is refreshed once less than this percentage of its
+/// lifetime remains.
+decltype(ircd::net::dns::cache::prefetch_pct)
+ircd::net::dns::cache::prefetch_pct
+{
+	{ "name",     "ircd.net.dns.cache.prefetch.pct" },
+	{ "default",  10L                               },
+};
+
+/// Maximum number of entries held in memory.
+decltype(ircd::net::dns::cache::mem_max)
+ircd::net::dns::cache::mem_max
+{
+	{ "name",     "ircd.net.dns.cache.mem.max" },
+	{ "default",  65536L                       },
+};
+
+/// Answers are written to the cache room no sooner than this after they
+/// were received, so bursts are persisted together.
+decltype(ircd::net::dns::cache::persist_interval)
+ircd::net::dns::cache::persist_interval
+{
+	{ "name",     "ircd.net.dns.cache.persist.interval" },
+	{ "default",  2000L                                 },
+};
+
+decltype(ircd::net::dns::cache::persist_batch)
+ircd::net::dns::cache::persist_batch
+{
+	{ "name",     "ircd.net.dns.cache.persist.batch" },
+	{ "default",  64L                                },
+};
+
 decltype(ircd::net::dns::cache::waiting)
 ircd::net::dns::cache::waiting;
 
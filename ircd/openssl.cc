@@ -96,6 +96,50 @@ ircd::openssl::server_name(const SSL &ssl)
 	return ::SSL_get_servername(&ssl, type);
 }
 
+//
+// ALPN suite
+//
+
+void
+ircd::openssl::alpn(SSL &ssl,
+                    const vector_view<const string_view> &protos)
+{
+	// Wire format is a sequence of length-prefixed names (RFC 7301 3.1).
+	thread_local uint8_t buf[256];
+	size_t len(0);
+	for(const auto &proto : protos)
+	{
+		if(unlikely(empty(proto) || size(proto) > 255 || len + 1 + size(proto) > sizeof(buf)))
+			throw error
+			{
+				"ALPN protocol '%s' is invalid or the list is too long", proto
+			};
+
+		buf[len++] = size(proto);
+		memcpy(buf + len, data(proto), size(proto));
+		len += size(proto);
+	}
+
+	// Note the inverted return value of this function; zero is success.
+	if(unlikely(::SSL_set_alpn_protos(&ssl, buf, len) != 0))
+		throw error
+		{
+			"SSL_set_alpn_protos() failed"
+		};
+}
+
+ircd::string_view
+ircd::openssl::alpn(const SSL &ssl)
+{
+	const unsigned char *data {nullptr};
+	unsigned int len {0};
+	::SSL_get0_alpn_selected(&ssl, &data, &len);
+	return string_view
+	{
+		reinterpret_cast<const char *>(data), len
+	};
+}
+
 //
 // Cipher suite
 //
@@ -316,6 +316,59 @@ const
 	return retired;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// prof/counters.h
+//
+
+ircd::prof::counters::counters()
+{
+	create(this->group, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true, false);
+	create(this->group, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true, false);
+	create(this->group, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, true, false);
+
+	const bool available
+	{
+		group.size() == std::tuple_size<sample_type>()
+		&& std::all_of(begin(group), end(group), [](const auto &event)
+		{
+			return event && event->head && event->head->cap_user_rdpmc;
+		})
+	};
+
+	if(!available)
+	{
+		group.clear();
+		throw error
+		{
+			"Hardware counters are not available to userspace."
+		};
+	}
+
+	reset(this->group);
+	start(this->group);
+}
+
+ircd::prof::counters::~counters()
+noexcept
+{
+	if(!group.empty())
+		stop(this->group);
+}
+
+ircd::prof::counters::sample_type
+IRCD_PROF_ALWAYS_OPTIMIZE
+ircd::prof::counters::sample()
+const
+{
+	return sample_type
+	{
+		group[CYCLES]->rdpmc(),
+		group[INSTRUCTIONS]->rdpmc(),
+		group[CACHE_MISSES]->rdpmc(),
+	};
+}
+
 //
 // time_*() suite
 //
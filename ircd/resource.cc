@@ -331,6 +331,45 @@ namespace ircd
 decltype(ircd::resource::method::idle_dock)
 ircd::resource::method::idle_dock;
 
+/// When set, requests which may write (anything other than GET, HEAD or
+/// OPTIONS) are relayed to this remote instead of being handled here. This
+/// is intended for secondary instances which cannot write to the database;
+/// the value is the hostport of the primary instance's listener.
+decltype(ircd::resource::method::forward_remote)
+ircd::resource::method::forward_remote
+{
+	{ "name",     "ircd.resource.forward.remote" },
+	{ "default",  string_view{}                  },
+};
+
+decltype(ircd::resource::method::forward_timeout)
+ircd::resource::method::forward_timeout
+{
+	{ "name",     "ircd.resource.forward.timeout" },
+	{ "default",  30L                             },
+};
+
+//
+// method::tap
+//
+
+template<>
+decltype(ircd::resource::method::tap::allocator)
+ircd::util::instance_list<ircd::resource::method::tap>::allocator
+{};
+
+template<>
+decltype(ircd::resource::method::tap::list)
+ircd::util::instance_list<ircd::resource::method::tap>::list
+{
+	allocator
+};
+
+ircd::resource::method::tap::~tap()
+noexcept
+{
+}
+
 //
 // method::method
 //
@@ -485,7 +524,16 @@ try
 		content_partial
 	};
 
-	if(content_remain && ~opts->flags & CONTENT_DISCRETION)
+	// Requests relayed to another instance need all of their content here.
+	const bool forwarding
+	{
+		!empty(string_view(forward_remote))
+		&& head.method != "GET"
+		&& head.method != "HEAD"
+		&& head.method != "OPTIONS"
+	};
+
+	if(content_remain && (forwarding || ~opts->flags & CONTENT_DISCRETION))
 	{
 		// Copy any partial content to the final contiguous allocated buffer;
 		client.content_buffer = unique_buffer<mutable_buffer>{head.content_length};
@@ -534,6 +582,23 @@ try
 		++stats->completions;
 	}};
 
+	for(const auto *const tap : tap::list)
+		tap->function(*this, client, client.request);
+
+	if(forwarding)
+		return forward(client, client.request);
+
+	// Charge the execution of the handler to this method of the resource.
+	const ctx::prof::scope prof_resource
+	{
+		resource->path
+	};
+
+	const ctx::prof::scope prof_method
+	{
+		name
+	};
+
 	// Finally handle the request.
 	return call_handler(client, client.request);
 }
@@ -558,6 +623,139 @@ catch(...)
 	throw;
 }
 
+ircd::resource::response
+ircd::resource::method::forward(client &client,
+                                resource::request &request)
+try
+{
+	const auto &head
+	{
+		request.head
+	};
+
+	const net::hostport remote
+	{
+		string_view{forward_remote}
+	};
+
+	// Hop-by-hop and framing headers are regenerated for the relayed request.
+	static const string_view skip[]
+	{
+		"host", "content-length", "content-type", "connection",
+		"transfer-encoding", "expect", "upgrade", "te",
+	};
+
+	size_t headers_count(0);
+	http::header headers[32];
+	http::headers{head.headers}.for_each([&headers, &headers_count]
+	(const http::header &header)
+	{
+		const bool skipped
+		{
+			std::any_of(begin(skip), end(skip), [&header]
+			(const string_view &key)
+			{
+				return iequals(header.first, key);
+			})
+		};
+
+		if(!skipped)
+			headers[headers_count++] = header;
+
+		return headers_count < std::size(headers);
+	});
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	window_buffer wb
+	{
+		buf
+	};
+
+	http::request
+	{
+		wb, host(remote), head.method, head.uri, size(request.content), head.content_type,
+		{
+			headers, headers_count
+		}
+	};
+
+	const const_buffer out_head
+	{
+		wb.completed()
+	};
+
+	const mutable_buffer in_head
+	{
+		buf + size(out_head)
+	};
+
+	server::request::opts sopts;
+	sopts.http_exceptions = false;
+	server::request req
+	{
+		remote, { out_head, request.content }, { in_head, mutable_buffer{} }, &sopts
+	};
+
+	req.wait(seconds(forward_timeout));
+	const auto code
+	{
+		req.get()
+	};
+
+	const auto response_head
+	{
+		server::in::gethead(req)
+	};
+
+	// Hop-by-hop, framing and coding headers of the relayed response are
+	// regenerated here; the content was already decoded by ircd::server.
+	static const string_view skip_response[]
+	{
+		"connection", "keep-alive", "transfer-encoding", "content-length",
+		"content-type", "content-encoding", "server", "date",
+		"access-control-allow-origin", "x-ircd-request-timer",
+	};
+
+	size_t response_headers_count(0);
+	http::header response_headers[32];
+	http::headers{response_head.headers}.for_each([&response_headers, &response_headers_count]
+	(const http::header &header)
+	{
+		const bool skipped
+		{
+			std::any_of(begin(skip_response), end(skip_response), [&header]
+			(const string_view &key)
+			{
+				return iequals(header.first, key);
+			})
+		};
+
+		if(!skipped)
+			response_headers[response_headers_count++] = header;
+
+		return response_headers_count < std::size(response_headers);
+	});
+
+	return response
+	{
+		client, req.in.content, response_head.content_type, code,
+		{
+			response_headers, response_headers_count
+		}
+	};
+}
+catch(const ctx::timeout &e)
+{
+	throw http::error
+	{
+		"%s", http::GATEWAY_TIMEOUT, e.what()
+	};
+}
+
 ircd::resource::response
 ircd::resource::method::call_handler(client &client,
                                      resource::request &request)
@@ -688,9 +886,35 @@ ircd::resource::response::chunked::chunked(client &client,
                                            const string_view &content_type,
                                            const string_view &headers,
                                            const size_t &buffer_size)
+:chunked
+{
+	client,
+	code,
+	content_type,
+	headers,
+	buffer_size,
+	coding(client, code, content_type, headers, size_t(-1))
+}
+{
+}
+
+/// The coding is decided once by the caller; the headers might be in a TLS
+/// buffer which is no longer valid after the head is sent.
+ircd::resource::response::chunked::chunked(client &client,
+                                           const http::code &code,
+                                           const string_view &content_type,
+                                           const string_view &headers,
+                                           const size_t &buffer_size,
+                                           const compress::type &coding)
 :response
 {
-	client, code, content_type, size_t(-1), headers
+	client, code, content_type, size_t(-1), [&headers, &coding]
+	{
+		// Composed into another TLS buffer with the same caveat as above;
+		// the incoming headers may already be in that other one.
+		thread_local char buffer[4_KiB];
+		return coding_headers(buffer, headers, coding);
+	}()
 }
 ,c
 {
@@ -700,6 +924,12 @@ ircd::resource::response::chunked::chunked(client &client,
 {
 	buffer_size
 }
+,deflate
+{
+	coding != compress::type::IDENTITY?
+		std::make_unique<compress::deflate>(coding):
+		nullptr
+}
 {
 	assert(!empty(content_type));
 }
@@ -747,15 +977,19 @@ ircd::resource::response::chunked::flush(const const_buffer &buf)
 		write(buf, true)
 	};
 
+	// When compressing, what went out on the socket is smaller than the
+	// input; the whole input was still consumed.
 	assert(wrote > 0 || empty(buf));
 	const size_t flushed
 	{
-		std::min(size(buf), wrote)
+		deflate?
+			size(buf):
+			std::min(size(buf), wrote)
 	};
 
 	assert(flushed <= size(buf));
 	this->flushed += flushed;
-	assert(this->flushed <= this->wrote);
+	assert(this->flushed <= this->wrote || deflate);
 	return const_buffer
 	{
 		data(buf), flushed
@@ -765,7 +999,6 @@ ircd::resource::response::chunked::flush(const const_buffer &buf)
 size_t
 ircd::resource::response::chunked::write(const const_buffer &chunk,
                                          const bool &ignore_empty)
-try
 {
 	assert(size(chunk) <= size(this->buf) || empty(this->buf));
 	assert(!finished);
@@ -775,6 +1008,37 @@ try
 	if(empty(chunk) && ignore_empty)
 		return 0UL;
 
+	if(!deflate)
+		return write_chunk(chunk);
+
+	const size_t required
+	{
+		compress::bound(deflate->coding, size(chunk))
+	};
+
+	if(size(zbuf) < required)
+		zbuf = unique_buffer<mutable_buffer>
+		{
+			std::max(required, compress::bound(deflate->coding, size(buf)))
+		};
+
+	// An empty chunk ends the stream; the compressor's trailer is sent as
+	// the last data chunk before the terminating empty chunk.
+	const const_buffer encoded
+	{
+		(*deflate)(zbuf, chunk, empty(chunk))
+	};
+
+	size_t ret(0);
+	ret += !empty(encoded)? write_chunk(encoded) : 0UL;
+	ret += empty(chunk)? write_chunk(const_buffer{}) : 0UL;
+	return ret;
+}
+
+size_t
+ircd::resource::response::chunked::write_chunk(const const_buffer &chunk)
+try
+{
 	char headbuf[32];
 	const size_t wrote
 	{
@@ -1010,6 +1274,63 @@ ircd::resource::response::response(client &client,
 {
 	assert(empty(content) || !empty(content_type));
 
+	const auto coding
+	{
+		response::coding(client, code, content_type, headers, size(content))
+	};
+
+	if(coding != compress::type::IDENTITY)
+	{
+		// The headers are composed before compressing because they might
+		// be in a TLS buffer which the offload's context switch exposes.
+		const unique_buffer<mutable_buffer> buf
+		{
+			size(headers) + 64 + compress::bound(coding, size(content))
+		};
+
+		const string_view composed_headers
+		{
+			coding_headers(buf, headers, coding)
+		};
+
+		const mutable_buffer zbuf
+		{
+			data(buf) + size(composed_headers), size(buf) - size(composed_headers)
+		};
+
+		compress::deflate deflate
+		{
+			coding
+		};
+
+		const_buffer encoded;
+		const auto encode{[&]
+		{
+			encoded = deflate(zbuf, content, true);
+		}};
+
+		if(size(content) >= size_t(compress_offload_size))
+			ctx::offload
+			{
+				ctx::ole::opts{"resource.compress"}, encode
+			};
+		else
+			encode();
+
+		response
+		{
+			client, code, content_type, size(encoded), composed_headers
+		};
+
+		const size_t written
+		{
+			client.write_all(encoded)
+		};
+
+		assert(written == size(encoded));
+		return;
+	}
+
 	// Head gets sent
 	response
 	{
@@ -1034,6 +1355,103 @@ ircd::resource::response::access_control_allow_origin
 	{ "default",   "*"                                         }
 };
 
+decltype(ircd::resource::response::compress_enable)
+ircd::resource::response::compress_enable
+{
+	{ "name",     "ircd.resource.response.compress.enable" },
+	{ "default",  true                                     },
+	{ "description",
+
+	R"(
+	Compress response content with a coding from the request's
+	Accept-Encoding when the content type is textual.
+	)"}
+};
+
+decltype(ircd::resource::response::compress_min_size)
+ircd::resource::response::compress_min_size
+{
+	{ "name",     "ircd.resource.response.compress.min_size" },
+	{ "default",  long(1_KiB)                                },
+	{ "description",
+
+	R"(
+	Content smaller than this is sent as-is; the saving would not make up
+	for the headers and the cpu.
+	)"}
+};
+
+decltype(ircd::resource::response::compress_offload_size)
+ircd::resource::response::compress_offload_size
+{
+	{ "name",     "ircd.resource.response.compress.offload_size" },
+	{ "default",  long(256_KiB)                                  },
+	{ "description",
+
+	R"(
+	Content at least this large is compressed on an offload thread rather
+	than stalling the main thread.
+	)"}
+};
+
+/// Selects the content-coding for a response to the client's current
+/// request; identity when the response should not or cannot be compressed.
+/// A content_length of -1 is a chunked response of unknown length.
+ircd::compress::type
+ircd::resource::response::coding(const client &client,
+                                 const http::code &code,
+                                 const string_view &content_type,
+                                 const string_view &headers,
+                                 const size_t &content_length)
+{
+	if(!compress_enable)
+		return compress::type::IDENTITY;
+
+	if(content_length < size_t(compress_min_size))
+		return compress::type::IDENTITY;
+
+	if(code == http::NO_CONTENT || code == http::NOT_MODIFIED || code == http::PARTIAL_CONTENT)
+		return compress::type::IDENTITY;
+
+	if(client.request.head.method == "HEAD")
+		return compress::type::IDENTITY;
+
+	if(ihas(headers, "content-encoding:"_sv))
+		return compress::type::IDENTITY;
+
+	const bool compressible
+	{
+		startswith(content_type, "application/json")
+		|| startswith(content_type, "text/")
+		|| startswith(content_type, "application/javascript")
+		|| startswith(content_type, "application/xml")
+		|| startswith(content_type, "image/svg+xml")
+	};
+
+	if(!compressible)
+		return compress::type::IDENTITY;
+
+	return compress::negotiate(client.request.head.accept_encoding);
+}
+
+/// Composes headers followed by the ones announcing the coding into buf;
+/// the headers are returned as-is for identity.
+ircd::string_view
+ircd::resource::response::coding_headers(const mutable_buffer &buf,
+                                         const string_view &headers,
+                                         const compress::type &coding)
+{
+	if(coding == compress::type::IDENTITY)
+		return headers;
+
+	return fmt::sprintf
+	{
+		buf, "%sContent-Encoding: %s\r\nVary: Accept-Encoding\r\n",
+		headers,
+		compress::reflect(coding),
+	};
+}
+
 __attribute__((stack_protect))
 ircd::resource::response::response(client &client,
                                    const http::code &code,
@@ -18,6 +18,11 @@ namespace ircd::server
 	template<class F> static size_t accumulate_links(F&&);
 	template<class F> static size_t accumulate_tags(F&&);
 	static string_view canonize(const hostport &); // TLS buffer
+	static void content_decode(request &, const size_t &max);
+
+	// Internal conf
+	extern conf::item<size_t> content_decode_offload;
+	static constexpr const size_t &content_decode_error_max {64_KiB};
 
 	// Internal control
 	static decltype(ircd::server::peers)::iterator
@@ -384,6 +389,65 @@ decltype(ircd::server::request::opts_default)
 ircd::server::request::opts_default
 {};
 
+decltype(ircd::server::content_decode_offload)
+ircd::server::content_decode_offload
+{
+	{ "name",     "ircd.server.content.decode.offload_size" },
+	{ "default",  long(64_KiB)                              },
+	{ "description",
+
+	R"(
+	Coded content at least this large is decoded on an offload thread rather
+	than on the context waiting for the response.
+	)"}
+};
+
+ircd::http::code
+ircd::server::request::get()
+{
+	const http::code ret
+	{
+		ctx::future<http::code>::get()
+	};
+
+	if(in.coding != compress::type::IDENTITY)
+		content_decode(*this, opt->content_decode_maxalloc);
+
+	return ret;
+}
+
+/// Replaces the dynamic content received with a content-coding by its
+/// decoding. This is called by the user's context once the response is
+/// complete, and large content is decoded on an offload thread.
+void
+ircd::server::content_decode(request &req,
+                             const size_t &max)
+{
+	assert(req.in.coding != compress::type::IDENTITY);
+	unique_buffer<mutable_buffer> buf;
+	const_buffer decoded;
+	const auto decode{[&req, &buf, &decoded, &max]
+	{
+		decoded = compress::inflate(buf, req.in.coding, req.in.content, max);
+	}};
+
+	if(ctx::current && size(req.in.content) >= size_t(content_decode_offload))
+		ctx::offload
+		{
+			ctx::ole::opts{"server.decode"}, decode
+		};
+	else
+		decode();
+
+	req.in.content = mutable_buffer
+	{
+		data(buf), size(decoded)
+	};
+
+	req.in.dynamic = std::move(buf);
+	req.in.coding = compress::type::IDENTITY;
+}
+
 /// Canceling a request is tricky. This allows a robust way to let the user's
 /// request go out of scope at virtually any time without disrupting the
 /// pipeline and other requests.
@@ -655,6 +719,10 @@ ircd::server::peer::peer(const net::hostport &hostport,
 	// Cert verify this name.
 	this->open_opts.common_name = host(canon);
 
+	// Offer HTTP/2; the link falls back to HTTP/1.1 when it's not selected.
+	if(link::http2_enable)
+		this->open_opts.alpn = link::alpn;
+
 	if(rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host(canon)))
 		this->remote =
 		{
@@ -988,6 +1056,7 @@ ircd::server::peer::handle_error(link &link,
                                  std::exception_ptr eptr)
 {
 	assert(bool(eptr));
+	tag_fail += link.tag_committed();
 	link.cancel_committed(eptr);
 	log::derror
 	{
@@ -1076,6 +1145,25 @@ noexcept try
 		link.tag_count() - 1
 	};
 
+	// Smoothed response time and its deviation (as RFC 6298) for callers
+	// weighing this peer against others; see m::fetch.
+	const auto sample
+	{
+		duration_cast<nanoseconds>(now<steady_point>() - tag.state.started)
+	};
+
+	const auto deviation
+	{
+		rtt > sample? rtt - sample : sample - rtt
+	};
+
+	rtt_var = rtt.count()? (rtt_var * 3 + deviation) / 4 : sample / 2;
+	rtt = rtt.count()? (rtt * 7 + sample) / 8 : sample;
+	if(uint(tag.state.status) < 300)
+		++tag_done;
+	else
+		++tag_fail;
+
 	if(tag.request)
 	{
 		assert(link.peer);
@@ -1768,6 +1856,65 @@ ircd::server::link::tag_commit_max_default
 	{ "default",  3L                                }
 };
 
+decltype(ircd::server::link::http2_enable)
+ircd::server::link::http2_enable
+{
+	{ "name",     "ircd.server.link.http2.enable" },
+	{ "default",  true                            },
+	{ "description",
+
+	R"(
+	Offer h2 by ALPN when connecting to remote servers. Requests to a server
+	which accepts are multiplexed as streams over a single link rather than
+	pipelined over several. This affects new connections only.
+	)"}
+};
+
+decltype(ircd::server::link::http2_streams_max)
+ircd::server::link::http2_streams_max
+{
+	{ "name",     "ircd.server.link.http2.streams_max" },
+	{ "default",  128L                                 },
+	{ "description",
+
+	R"(
+	Maximum number of concurrent streams opened on an HTTP/2 link. The remote's
+	SETTINGS_MAX_CONCURRENT_STREAMS lowers this when it is less.
+	)"}
+};
+
+decltype(ircd::server::link::http2_stream_window)
+ircd::server::link::http2_stream_window
+{
+	{ "name",     "ircd.server.link.http2.stream_window" },
+	{ "default",  long(1_MiB)                            },
+	{ "description",
+
+	R"(
+	Flow-control window advertised for each HTTP/2 stream; bounds how much
+	response content the remote sends ahead of our reading it.
+	)"}
+};
+
+decltype(ircd::server::link::http2_conn_window)
+ircd::server::link::http2_conn_window
+{
+	{ "name",     "ircd.server.link.http2.conn_window" },
+	{ "default",  long(16_MiB)                         },
+	{ "description",
+
+	R"(
+	Flow-control window advertised for the whole HTTP/2 connection across
+	all of its streams.
+	)"}
+};
+
+decltype(ircd::server::link::alpn)
+ircd::server::link::alpn
+{
+	"h2", "http/1.1"
+};
+
 decltype(ircd::server::link::ids)
 ircd::server::link::ids;
 
@@ -1813,6 +1960,68 @@ ircd::server::loghead(const mutable_buffer &buf,
 	};
 }
 
+/// HTTP/2 session of a link. Tags keep their HTTP/1.1 buffers: the request
+/// head is re-encoded into a HEADERS frame and the response is translated
+/// back into HTTP/1.1 for the tag's own parser, with chunked framing when the
+/// remote gives no content-length.
+struct ircd::server::link::h2
+{
+	struct stream
+	{
+		int64_t send_window {0};                 // remote's window for our DATA
+		size_t recv_unacked {0};                 // DATA read since WINDOW_UPDATE
+		bool head {false};                       // final response head read
+		bool chunked {false};                    // content translated to chunks
+	};
+
+	http2::settings remote;                      // remote's SETTINGS
+	http2::hpack::decoder hpack;
+	std::map<uint32_t, stream> streams;          // open streams
+	int64_t send_window {65535};                 // connection window for our DATA
+	size_t recv_unacked {0};                     // DATA read since WINDOW_UPDATE
+	uint32_t next_id {1};                        // next client stream id
+	uint32_t block_id {0};                       // stream of header block in progress
+	uint8_t block_flags {0};                     // flags from its HEADERS frame
+	bool preface {false};                        // connection preface sent
+	bool goaway {false};                         // remote refuses new streams
+	bool streams_limited {false};                // remote sent MAX_CONCURRENT_STREAMS
+	std::string block;                           // header block in progress
+	std::string control;                         // frames waiting for the writer
+	unique_buffer<mutable_buffer> in {64_KiB};
+	size_t in_len {0};
+	unique_buffer<mutable_buffer> out {64_KiB};
+	size_t out_pos {0};
+	size_t out_len {0};
+
+	tag *find(link &, const uint32_t &id);
+	void erase(link &, tag &);
+	void ctrl(const http2::frame::type &, const uint8_t &flags, const uint32_t &id, const const_buffer & = {});
+	void window_update(const uint32_t &id, const size_t &increment);
+	void rst(const uint32_t &id, const enum http2::error::code &);
+	void feed(link &, tag &, const_buffer, bool &done);
+	void done(link &, tag &);
+	void fail(link &, tag &, std::exception_ptr);
+	void requeue(link &, tag &);
+
+	bool flush(link &);
+	bool compose_head(tag &);
+	bool compose_data(tag &);
+	bool compose(link &);
+
+	void handle_content(link &, const uint32_t &id, const const_buffer &, const bool &end);
+	void handle_block(link &);
+	void handle_data(link &, const http2::frame::header &, const const_buffer &);
+	void handle_headers(link &, const http2::frame::header &, const const_buffer &);
+	void handle_rst(link &, const http2::frame::header &, const const_buffer &);
+	void handle_settings(const http2::frame::header &, const const_buffer &);
+	void handle_goaway(link &, const const_buffer &);
+	void handle_window(const http2::frame::header &, const const_buffer &);
+	void handle(link &, const http2::frame::header &, const const_buffer &);
+
+  public:
+	size_t streams_max() const;
+};
+
 //
 // link::link
 //
@@ -1928,7 +2137,16 @@ ircd::server::link::cleanup_canceled()
 	// If every committed tag in the pipe is canceled we can close this link
 	// to quickly disperse any queued tags to another link or simply kill this
 	// link if it's timing out.
+	// Streams are reset individually on an h2 link; the writer does that.
 	assert(dead <= tag_committed());
+	if(dead && h2)
+	{
+		if(ready())
+			wait_writable();
+
+		return;
+	}
+
 	if(dead && dead == tag_committed())
 	{
 		log::dwarning
@@ -1983,9 +2201,16 @@ ircd::server::link::handle_open(std::exception_ptr eptr)
 	op_init = false;
 	synack_ts = time<seconds>();
 
+	if(!eptr && !op_fini && openssl::alpn(*socket) == "h2")
+		h2 = std::make_unique<struct h2>();
+
 	if(!eptr && !op_fini)
 		wait_writable();
 
+	// An h2 link always reads; the remote sends SETTINGS, PING etc at will.
+	if(!eptr && !op_fini && h2)
+		wait_readable();
+
 	if(peer)
 		peer->handle_open(*this, std::move(eptr));
 }
@@ -2099,6 +2324,9 @@ void
 ircd::server::link::handle_writable_success()
 {
 	assert(socket);
+	if(h2)
+		return handle_writable_h2();
+
 	auto it(begin(queue));
 	while(it != end(queue))
 	{
@@ -2287,6 +2515,9 @@ void
 ircd::server::link::handle_readable_success()
 {
 	assert(socket);
+	if(h2)
+		return handle_readable_h2();
+
 	if(!tag_committed())
 	{
 		discard_read();
@@ -2639,7 +2870,9 @@ size_t
 ircd::server::link::tag_commit_max()
 const
 {
-	return tag_commit_max_default;
+	return h2?
+		h2->streams_max():
+		size_t(tag_commit_max_default);
 }
 
 size_t
@@ -2663,178 +2896,1357 @@ const
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// server/tag.h
+// link::h2
 //
 
-/// Monotonic counter for tags.
-decltype(ircd::server::tag::state::ids)
-ircd::server::tag::state::ids;
-
-/// This is tricky. When a user cancels a request which has committed some
-/// writes to the remote we have to continue to service it through to
-/// completion without disrupting the linearity of the link's pipeline
-/// and causing trouble with other requests. This all depends on what phase
-/// the request is currently in.
-///
-/// In any case, the goal here is to swap out the user's request buffers
-/// and replace them with cancellation buffers which will be transparent
-/// to the link as it completes the request.
 void
-ircd::server::cancel(request &request,
-                     tag &tag)
-noexcept
+ircd::server::link::handle_writable_h2()
 {
-	// Must have a fully associated request/tag which has committed some
-	// data to the wire to enter this routine.
-	assert(tag.committed());
-	assert(!tag.canceled());
-	assert(request.tag == &tag);
-	assert(tag.request == &request);
-	assert(!tag.cancellation);
-
-	// The cancellation is a straightforward facsimile except in the case of
-	// dynamic chunked encoding mode where we need to add additional scratch.
-	const size_t additional_scratch
+	assert(h2);
+	do
 	{
-		tag.state.chunk_length != 0 && null(request.in.content)?
-			std::max(tag.state.head_rem, size_t(8_KiB)) : 0_KiB
-	};
+		if(!h2->flush(*this))
+		{
+			wait_writable();
+			return;
+		}
+	}
+	while(h2->compose(*this));
+}
 
-	const size_t cancellation_size
+void
+ircd::server::link::handle_readable_h2()
+{
+	assert(h2);
+	auto &s(*h2);
+	for(;;)
 	{
-		size(request.out) + size(request.in) + additional_scratch
-	};
+		if(unlikely(s.in_len >= size(s.in)))
+			throw http2::error
+			{
+				http2::error::FRAME_SIZE_ERROR, "frame exceeds %zu bytes", size(s.in)
+			};
 
-	// Disassociate the user's request and add our dummy request in its place.
-	disassociate(request, tag);
+		const const_buffer got
+		{
+			read(s.in + s.in_len)
+		};
 
-	assert(tag.request == nullptr);
-	tag.request = new server::request{};
-	tag.request->tag = &tag;
+		if(empty(got))
+			break;
 
-	// Setup the cancellation buffers by mirroring the current state of the
-	// user's buffers.
+		s.in_len += size(got);
+		size_t pos(0);
+		while(s.in_len - pos >= http2::frame::header_size)
+		{
+			const auto header
+			{
+				http2::frame::read(const_buffer{data(s.in) + pos, s.in_len - pos})
+			};
 
-	assert(!tag.cancellation);
-	tag.cancellation = unique_buffer<mutable_buffer>
-	{
-		cancellation_size
-	};
+			// We never raise SETTINGS_MAX_FRAME_SIZE from its default.
+			if(unlikely(header.len > 16384))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "%s frame of %u bytes",
+					http2::frame::reflect(header.type),
+					uint(header.len),
+				};
 
-	char *ptr
-	{
-		data(tag.cancellation)
-	};
+			if(s.in_len - pos < http2::frame::header_size + header.len)
+				break;
 
-	const mutable_buffer out_head{ptr, size(request.out.head)};
-	tag.request->out.head = out_head;
-	ptr += size(out_head);
+			const const_buffer payload
+			{
+				data(s.in) + pos + http2::frame::header_size, header.len
+			};
 
-	const mutable_buffer out_content{ptr, size(request.out.content)};
-	tag.request->out.content = out_content;
-	ptr += size(out_content);
+			pos += http2::frame::header_size + header.len;
+			s.handle(*this, header, payload);
+			if(op_fini)
+				return;
+		}
 
-	// The in_head buffer is a straightforward facsimile except in the case of
-	// dynamic chunked encoding mode where we need to add additional scratch.
-	const mutable_buffer in_head{ptr, size(request.in.head)};
-	tag.request->in.head = in_head;
-	ptr += size(in_head) + additional_scratch;
+		std::memmove(data(s.in), data(s.in) + pos, s.in_len - pos);
+		s.in_len -= pos;
+	}
 
-	const mutable_buffer in_content{ptr, size(request.in.content)};
-	// The nullity (btw that's a real word) of in.content has to be preserved
-	// between the user's tag and the cancellation tag. This is important for
-	// a dynamic chunked encoded response which has null in.content until done.
-	if(!null(request.in.content))
+	if(ready() && (!s.control.empty() || tag_uncommitted() || write_remaining()))
+		wait_writable();
+
+	if(queue.empty())
 	{
-		tag.request->in.content = in_content;
-		ptr += size(in_content);
+		assert(peer);
+		peer->handle_link_done(*this);
+		return;
 	}
-	else tag.request->in.content = request.in.content;
 
-	assert(size_t(std::distance(data(tag.cancellation), ptr)) == cancellation_size);
+	wait_readable();
+}
 
-	// If the head is not completely written we have to copy the remainder from where
-	// the socket left off.
-	if(tag.state.written < size(request.out.head))
+size_t
+ircd::server::link::h2::streams_max()
+const
+{
+	const size_t remote_max
 	{
-		const const_buffer src
+		remote[http2::settings::code::MAX_CONCURRENT_STREAMS]
+	};
+
+	// The remote's limit applies once received even when it is zero; until
+	// then the default is unlimited (RFC 7540 6.5.2).
+	return streams_limited?
+		std::min(size_t(http2_streams_max), remote_max):
+		size_t(http2_streams_max);
+}
+
+/// Write the next frames to the socket; false when it would block.
+bool
+ircd::server::link::h2::flush(link &link)
+{
+	while(out_pos < out_len)
+	{
+		const const_buffer buf
 		{
-			request.out.head + tag.state.written
+			data(out) + out_pos, out_len - out_pos
 		};
 
-		const mutable_buffer dst
+		const const_buffer written
 		{
-			out_head + tag.state.written
+			link.process_write_next(buf)
 		};
 
-		copy(dst, src);
+		out_pos += size(written);
+		if(size(written) < size(buf))
+			return false;
 	}
 
-	// If the content is not completely written we have to copy the remainder from where
-	// the socket left off.
-	const size_t content_written
+	out_pos = 0;
+	out_len = 0;
+	return true;
+}
+
+/// Fill the output buffer with frames; false when there was nothing to add.
+bool
+ircd::server::link::h2::compose(link &link)
+{
+	using namespace http2;
+	using code = settings::code;
+
+	const size_t before
 	{
-		tag.state.written > size(request.out.head)? tag.state.written - size(request.out.head) : 0
+		out_len
 	};
 
-	if(content_written < size(request.out.content))
+	if(!preface)
 	{
-		const const_buffer src
+		const struct frame::settings::param param[]
 		{
-			request.out.content + content_written
+			{ htons(code::ENABLE_PUSH),          htonl(0)                             },
+			{ htons(code::INITIAL_WINDOW_SIZE),  htonl(uint32_t(http2_stream_window)) },
 		};
 
-		const mutable_buffer dst
+		out_len += copy(out, connection_preface);
+		out_len += size(frame::write(out + out_len, frame::SETTINGS, 0, 0, const_buffer
 		{
-			out_content + content_written
-		};
+			reinterpret_cast<const char *>(param), sizeof(param)
+		}));
 
-		copy(dst, src);
+		if(size_t(http2_conn_window) > 65535)
+			window_update(0, size_t(http2_conn_window) - 65535);
+
+		preface = true;
 	}
 
-	// If the head is not completely read we have to copy what's been received so far so
-	// we can parse a coherent head.
-	if(tag.state.head_read > 0 && tag.state.head_read < size(request.in.head))
+	const auto append_control{[this]
 	{
-		const const_buffer src
+		if(control.empty() || size(control) > size(out) - out_len)
+			return;
+
+		out_len += copy(out + out_len, string_view{control});
+		control.clear();
+	}};
+
+	append_control();
+	for(auto it(begin(link.queue)); it != end(link.queue); ) try
+	{
+		auto &tag{*it};
+		if((tag.abandoned() || tag.canceled()) && !tag.committed())
 		{
-			request.in.head, tag.state.head_read
-		};
+			it = link.queue.erase(it);
+			continue;
+		}
 
-		const mutable_buffer dst
+		// The remote is told to stop; the link carries on with the others.
+		if(tag.canceled())
 		{
-			in_head
-		};
+			if(streams.count(tag.state.stream_id))
+				rst(tag.state.stream_id, http2::error::CANCEL);
 
-		copy(dst, src);
-	}
+			it = link.queue.erase(it);
+			continue;
+		}
 
-	// Normally we have no reason to copy content, but there is one exception:
-	// If the content is chunked encoding and the tag is in the phase of
-	// receiving the chunk head we have to copy what's been received of that
-	// head so far so the grammar can parse a coherent head to continue.
-	if(tag.state.chunk_length == size_t(-1) && !null(request.in.content))
-	{
-		assert(tag.state.content_read >= tag.state.content_length);
-		const const_buffer src
+		if(!tag.committed())
 		{
-			request.in.content + tag.state.content_length,
-			tag.state.content_read - tag.state.content_length
-		};
+			if(goaway || streams.size() >= streams_max() || next_id > 0x7fffffffU)
+				break;
 
-		const mutable_buffer dst
+			if(!compose_head(tag))
+				break;
+		}
+
+		if(tag.write_remaining())
+			compose_data(tag);
+
+		++it;
+	}
+	catch(const std::exception &e)
+	{
+		auto &tag{*it};
+		log::derror
 		{
-			in_content + tag.state.content_length
+			log, "%s tag:%lu stream:%u :%s",
+			loghead(link),
+			tag.state.id,
+			tag.state.stream_id,
+			e.what(),
 		};
 
-		copy(dst, src);
+		if(streams.count(tag.state.stream_id))
+			rst(tag.state.stream_id, http2::error::INTERNAL_ERROR);
+
+		tag.set_exception(std::current_exception());
+		it = link.queue.erase(it);
 	}
 
-	// Moving the dynamic buffer should have no real effect because the
-	// cancellation buffer already took over for it. We could do it anyway
-	// to prevent regressions but at the cost of maintaining twice the memory
-	// allocated. For now it's commented to let it die with the user's req.
-	//tag.request->in.dynamic = std::move(request.in.dynamic);
+	append_control();
+	return out_len > before;
+}
+
+/// Open a stream for the tag with its request head; false without room.
+bool
+ircd::server::link::h2::compose_head(tag &tag)
+{
+	using namespace http2;
+	using code = settings::code;
+
+	assert(tag.request);
+	assert(!tag.committed());
+	const auto &request
+	{
+		*tag.request
+	};
+
+	http::header headers[64];
+	size_t headers_count(0);
+	parse::buffer pb{request.out.head};
+	parse::capstan pc{pb, [](char *&read, char *stop)
+	{
+		read = stop;
+	}};
+
+	pc.read += size(request.out.head);
+	const http::request::head head
+	{
+		pc, [&headers, &headers_count](const auto &header)
+		{
+			if(unlikely(headers_count >= std::size(headers)))
+				throw http::error
+				{
+					http::REQUEST_HEADER_FIELDS_TOO_LARGE
+				};
+
+			headers[headers_count++] = header;
+		}
+	};
+
+	thread_local char block_buf[16_KiB];
+	window_buffer block{block_buf};
+	http2::hpack::write(block, { ":method",     head.method  });
+	http2::hpack::write(block, { ":scheme",     "https"      });
+	http2::hpack::write(block, { ":authority",  head.host    });
+	http2::hpack::write(block, { ":path",       head.uri     });
+	for(size_t i(0); i < headers_count; ++i)
+	{
+		// Connection-specific fields are prohibited (RFC 7540 8.1.2.2).
+		const auto &header{headers[i]};
+		if(header == "host" ||
+		   header == "connection" ||
+		   header == "keep-alive" ||
+		   header == "proxy-connection" ||
+		   header == "transfer-encoding" ||
+		   header == "upgrade")
+			continue;
+
+		if(header == "te" && !iequals(header.second, "trailers"))
+			continue;
+
+		http2::hpack::write(block, header);
+	}
+
+	const size_t max_frame
+	{
+		remote[code::MAX_FRAME_SIZE]
+	};
+
+	const size_t frames
+	{
+		std::max(block.consumed() / max_frame + bool(block.consumed() % max_frame), 1UL)
+	};
+
+	const size_t required
+	{
+		block.consumed() + frames * frame::header_size
+	};
+
+	if(required > size(out) - out_len)
+	{
+		if(out_len == 0)
+			throw http2::error
+			{
+				http2::error::INTERNAL_ERROR, "header block of %zu bytes exceeds %zu",
+				block.consumed(),
+				size(out),
+			};
+
+		return false;
+	}
+
+	const uint32_t id
+	{
+		next_id
+	};
+
+	const bool end_stream
+	{
+		empty(request.out.content)
+	};
+
+	const_buffer remain
+	{
+		block.completed()
+	};
+
+	for(size_t i(0); i < frames; ++i)
+	{
+		const const_buffer payload
+		{
+			data(remain), std::min(size(remain), max_frame)
+		};
+
+		consume(remain, size(payload));
+		const uint8_t flags
+		(
+			(empty(remain)? frame::END_HEADERS : 0) |
+			(!i && end_stream? frame::END_STREAM : 0)
+		);
+
+		out_len += size(frame::write(out + out_len, !i? frame::HEADERS : frame::CONTINUATION, flags, id, payload));
+	}
+
+	next_id += 2;
+	streams.emplace(id, stream
+	{
+		int64_t(remote[code::INITIAL_WINDOW_SIZE])
+	});
+
+	tag.state.stream_id = id;
+	tag.wrote_buffer(tag.make_write_buffer());
+	assert(tag.committed());
+	log::debug
+	{
+		log, "tag:%lu stream:%u opened; %zu of %zu streams [%s]",
+		tag.state.id,
+		id,
+		streams.size(),
+		streams_max(),
+		loghead(request),
+	};
+
+	return true;
+}
+
+/// Send as much request content as flow-control and buffer room allow.
+bool
+ircd::server::link::h2::compose_data(tag &tag)
+{
+	using namespace http2;
+	using code = settings::code;
+
+	const auto it
+	{
+		streams.find(tag.state.stream_id)
+	};
+
+	if(it == end(streams))
+		return false;
+
+	auto &stream{it->second};
+	const int64_t credit
+	{
+		std::min(send_window, stream.send_window)
+	};
+
+	const size_t room
+	{
+		size(out) - out_len
+	};
+
+	if(credit <= 0 || room <= frame::header_size)
+		return false;
+
+	const const_buffer buffer
+	{
+		tag.make_write_buffer()
+	};
+
+	const size_t len
+	{
+		std::min
+		({
+			size(buffer),
+			size_t(credit),
+			size_t(remote[code::MAX_FRAME_SIZE]),
+			room - frame::header_size,
+		})
+	};
+
+	const const_buffer payload
+	{
+		data(buffer), len
+	};
+
+	const bool end_stream
+	{
+		len == tag.write_remaining()
+	};
+
+	out_len += size(frame::write(out + out_len, frame::DATA, end_stream? frame::END_STREAM : 0, tag.state.stream_id, payload));
+	send_window -= len;
+	stream.send_window -= len;
+	tag.wrote_buffer(payload);
+	return true;
+}
+
+void
+ircd::server::link::h2::handle(link &link,
+                               const http2::frame::header &header,
+                               const const_buffer &payload)
+{
+	using namespace http2;
+
+	// A header block is contiguous on the connection (RFC 7540 6.10).
+	if(unlikely(block_id && header.type != frame::CONTINUATION))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "%s frame within header block of stream:%u",
+			frame::reflect(header.type),
+			block_id,
+		};
+
+	switch(header.type)
+	{
+		case frame::DATA:
+			return handle_data(link, header, payload);
+
+		case frame::HEADERS:
+			return handle_headers(link, header, payload);
+
+		case frame::CONTINUATION:
+			if(unlikely(!block_id || header.stream_id != block_id))
+				throw http2::error
+				{
+					http2::error::PROTOCOL_ERROR, "CONTINUATION of stream:%u without HEADERS",
+					uint(header.stream_id),
+				};
+
+			block.append(data(payload), size(payload));
+			if(header.flags & frame::END_HEADERS)
+				handle_block(link);
+
+			return;
+
+		case frame::RST_STREAM:
+			return handle_rst(link, header, payload);
+
+		case frame::SETTINGS:
+			return handle_settings(header, payload);
+
+		case frame::PING:
+			if(!(header.flags & frame::ACK))
+				ctrl(frame::PING, frame::ACK, 0, payload);
+
+			return;
+
+		case frame::GOAWAY:
+			return handle_goaway(link, payload);
+
+		case frame::WINDOW_UPDATE:
+			return handle_window(header, payload);
+
+		case frame::PUSH_PROMISE:
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "PUSH_PROMISE while push is disabled"
+			};
+
+		case frame::PRIORITY:
+		default:
+			return;
+	}
+}
+
+namespace ircd::server
+{
+	static const_buffer h2_unpad(const http2::frame::header &, const const_buffer &);
+}
+
+ircd::const_buffer
+ircd::server::h2_unpad(const http2::frame::header &header,
+                       const const_buffer &payload)
+{
+	using namespace http2;
+
+	if(!(header.flags & frame::PADDED))
+		return payload;
+
+	const uint8_t pad
+	(
+		!empty(payload)? uint8_t(*data(payload)) : 0
+	);
+
+	if(unlikely(empty(payload) || pad >= size(payload)))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "%s frame padding exceeds its %zu bytes",
+			frame::reflect(header.type),
+			size(payload),
+		};
+
+	return const_buffer
+	{
+		data(payload) + 1, size(payload) - 1 - pad
+	};
+}
+
+void
+ircd::server::link::h2::handle_data(link &link,
+                                    const http2::frame::header &header,
+                                    const const_buffer &payload)
+{
+	using namespace http2;
+
+	// Flow-control counts the whole frame including any padding; the windows
+	// are replenished once half of them are consumed.
+	recv_unacked += header.len;
+	if(recv_unacked >= size_t(http2_conn_window) / 2)
+	{
+		window_update(0, recv_unacked);
+		recv_unacked = 0;
+	}
+
+	const bool end_stream
+	{
+		bool(header.flags & frame::END_STREAM)
+	};
+
+	const auto it
+	{
+		streams.find(header.stream_id)
+	};
+
+	if(it != end(streams) && !end_stream)
+	{
+		auto &stream{it->second};
+		stream.recv_unacked += header.len;
+		if(stream.recv_unacked >= size_t(http2_stream_window) / 2)
+		{
+			window_update(header.stream_id, stream.recv_unacked);
+			stream.recv_unacked = 0;
+		}
+	}
+
+	handle_content(link, header.stream_id, h2_unpad(header, payload), end_stream);
+}
+
+void
+ircd::server::link::h2::handle_headers(link &link,
+                                       const http2::frame::header &header,
+                                       const const_buffer &payload)
+{
+	using namespace http2;
+
+	if(unlikely(!header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "HEADERS on stream 0"
+		};
+
+	const_buffer fragment
+	{
+		h2_unpad(header, payload)
+	};
+
+	// Skip the stream dependency and weight.
+	if(header.flags & frame::PRIO)
+	{
+		if(unlikely(size(fragment) < 5))
+			throw http2::error
+			{
+				http2::error::FRAME_SIZE_ERROR, "HEADERS priority truncated"
+			};
+
+		consume(fragment, 5);
+	}
+
+	block.assign(data(fragment), size(fragment));
+	block_id = header.stream_id;
+	block_flags = header.flags;
+	if(header.flags & frame::END_HEADERS)
+		handle_block(link);
+}
+
+/// Decode a complete header block. The connection's HPACK state advances
+/// with every block even when the stream is no longer wanted.
+void
+ircd::server::link::h2::handle_block(link &link)
+{
+	using namespace http2;
+
+	const uint32_t id
+	{
+		block_id
+	};
+
+	const bool end_stream
+	{
+		bool(block_flags & frame::END_STREAM)
+	};
+
+	block_id = 0;
+	const auto it
+	{
+		streams.find(id)
+	};
+
+	// Only the first block opens the response; a later one is trailers.
+	const bool want
+	{
+		it != end(streams) && !it->second.head
+	};
+
+	thread_local char head_buf[16_KiB];
+	window_buffer head{head_buf};
+	ushort status(0);
+	bool content_length(false);
+	hpack(const_buffer{block}, [&](const string_view &name, const string_view &value)
+	{
+		if(!want)
+			return;
+
+		if(name == ":status")
+		{
+			status = lex_cast<ushort>(value);
+			head([&status](const mutable_buffer &buf) -> size_t
+			{
+				return fmt::sprintf
+				{
+					buf, "HTTP/1.1 %u %s\r\n", status, http::status(http::code(status))
+				};
+			});
+
+			return;
+		}
+
+		if(unlikely(!status))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "stream:%u response without :status", id
+			};
+
+		if(startswith(name, ':') || name == "connection" || name == "transfer-encoding")
+			return;
+
+		content_length |= name == "content-length";
+		http::write(head, http::header{name, value});
+	});
+
+	block.clear();
+	if(!want)
+	{
+		if(end_stream)
+			handle_content(link, id, {}, true);
+
+		return;
+	}
+
+	// Informational heads precede the actual response.
+	if(status >= 100 && status < 200 && !end_stream)
+		return;
+
+	auto &stream{it->second};
+	stream.head = true;
+	stream.chunked = !content_length && !end_stream;
+	if(!content_length)
+		http::write(head, end_stream?
+			http::header{"content-length", "0"}:
+			http::header{"transfer-encoding", "chunked"});
+
+	http::writeline(head);
+	if(end_stream)
+		streams.erase(it);
+
+	auto *const tag
+	{
+		find(link, id)
+	};
+
+	if(!tag)
+		return;
+
+	try
+	{
+		bool done{false};
+		feed(link, *tag, head.completed(), done);
+		if(done)
+			return this->done(link, *tag);
+
+		if(end_stream)
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "stream:%u ended without content-length of content", id
+			};
+	}
+	catch(const std::exception &e)
+	{
+		fail(link, *tag, std::current_exception());
+	}
+}
+
+void
+ircd::server::link::h2::handle_content(link &link,
+                                       const uint32_t &id,
+                                       const const_buffer &content,
+                                       const bool &end_stream)
+{
+	using namespace http2;
+
+	const auto it
+	{
+		streams.find(id)
+	};
+
+	if(it == end(streams))
+		return;
+
+	const bool head
+	{
+		it->second.head
+	};
+
+	const bool chunked
+	{
+		it->second.chunked
+	};
+
+	if(end_stream)
+		streams.erase(it);
+
+	auto *const tag
+	{
+		find(link, id)
+	};
+
+	if(!tag)
+		return;
+
+	try
+	{
+		if(unlikely(!head))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "stream:%u content before the response head", id
+			};
+
+		bool done{false};
+		if(chunked && !empty(content))
+		{
+			char buf[16];
+			feed(link, *tag, http::writechunk(buf, size(content)), done);
+			feed(link, *tag, content, done);
+			feed(link, *tag, "\r\n"_sv, done);
+		}
+		else feed(link, *tag, content, done);
+
+		if(chunked && end_stream && !done)
+			feed(link, *tag, "00000000\r\n\r\n"_sv, done);
+
+		if(done)
+			return this->done(link, *tag);
+
+		if(end_stream)
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "stream:%u ended before the content was complete", id
+			};
+	}
+	catch(const std::exception &e)
+	{
+		fail(link, *tag, std::current_exception());
+	}
+}
+
+void
+ircd::server::link::h2::handle_rst(link &link,
+                                   const http2::frame::header &header,
+                                   const const_buffer &payload)
+{
+	using namespace http2;
+
+	if(unlikely(size(payload) != 4))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "RST_STREAM of %zu bytes", size(payload)
+		};
+
+	const auto code
+	{
+		static_cast<enum http2::error::code>(ntoh(*reinterpret_cast<const uint32_t *>(data(payload))))
+	};
+
+	streams.erase(header.stream_id);
+	auto *const tag
+	{
+		find(link, header.stream_id)
+	};
+
+	// The remote did no processing of a refused stream (RFC 7540 8.1.4) so
+	// the request can be sent again.
+	if(tag && code == http2::error::REFUSED_STREAM && !tag->state.head_read)
+		return requeue(link, *tag);
+
+	if(tag)
+		fail(link, *tag, make_exception_ptr<http2::error>
+		(
+			code, "stream reset by remote"
+		));
+}
+
+void
+ircd::server::link::h2::handle_settings(const http2::frame::header &header,
+                                        const const_buffer &payload)
+{
+	using namespace http2;
+	using code = settings::code;
+
+	if(unlikely(header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "SETTINGS on stream:%u", uint(header.stream_id)
+		};
+
+	if(header.flags & frame::ACK)
+		return;
+
+	if(unlikely(size(payload) % sizeof(struct frame::settings::param)))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "SETTINGS of %zu bytes", size(payload)
+		};
+
+	const vector_view<const struct frame::settings::param> params
+	{
+		reinterpret_cast<const struct frame::settings::param *>(data(payload)),
+		size(payload) / sizeof(struct frame::settings::param)
+	};
+
+	for(const auto &param : params)
+	{
+		const uint16_t id(ntoh(param.id));
+		const uint32_t value(ntoh(param.value));
+
+		// Unknown settings are ignored (RFC 7540 6.5.2).
+		if(!id || id >= code::_NUM_)
+			continue;
+
+		if(id == code::INITIAL_WINDOW_SIZE)
+		{
+			if(unlikely(value > 0x7fffffffU))
+				throw http2::error
+				{
+					http2::error::FLOW_CONTROL_ERROR, "INITIAL_WINDOW_SIZE of %u", value
+				};
+
+			const int64_t delta
+			{
+				int64_t(value) - int64_t(remote[code::INITIAL_WINDOW_SIZE])
+			};
+
+			for(auto &stream : streams)
+				stream.second.send_window += delta;
+		}
+
+		if(id == code::MAX_CONCURRENT_STREAMS)
+			streams_limited = true;
+
+		if(id == code::MAX_FRAME_SIZE && unlikely(value < 16384 || value > 16777215))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "MAX_FRAME_SIZE of %u", value
+			};
+
+		remote[code(id)] = value;
+	}
+
+	ctrl(frame::SETTINGS, frame::ACK, 0);
+}
+
+void
+ircd::server::link::h2::handle_goaway(link &link,
+                                      const const_buffer &payload)
+{
+	using namespace http2;
+
+	if(unlikely(size(payload) < 8))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "GOAWAY of %zu bytes", size(payload)
+		};
+
+	const uint32_t last
+	{
+		ntoh(*reinterpret_cast<const uint32_t *>(data(payload))) & 0x7fffffffU
+	};
+
+	const auto code
+	{
+		static_cast<enum http2::error::code>(ntoh(*reinterpret_cast<const uint32_t *>(data(payload) + 4)))
+	};
+
+	log::dwarning
+	{
+		log, "%s GOAWAY last stream:%u %s :%s",
+		loghead(link),
+		last,
+		reflect(code),
+		string_view{data(payload) + 8, size(payload) - 8},
+	};
+
+	// The link takes no more requests. Streams above the last were not
+	// processed by the remote; those and the requests not yet sent are
+	// submitted again to another link.
+	goaway = true;
+	link.exclude = true;
+	std::vector<tag *> moved;
+	for(auto &tag : link.queue)
+		if(!tag.committed() || tag.state.stream_id > last)
+			moved.emplace_back(std::addressof(tag));
+
+	for(auto *const tag : moved)
+		requeue(link, *tag);
+
+	if(!link.tag_committed())
+		link.close();
+}
+
+void
+ircd::server::link::h2::handle_window(const http2::frame::header &header,
+                                      const const_buffer &payload)
+{
+	using namespace http2;
+
+	if(unlikely(size(payload) != 4))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "WINDOW_UPDATE of %zu bytes", size(payload)
+		};
+
+	const uint32_t increment
+	{
+		ntoh(*reinterpret_cast<const uint32_t *>(data(payload))) & 0x7fffffffU
+	};
+
+	if(unlikely(!increment))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "WINDOW_UPDATE of 0 on stream:%u", uint(header.stream_id)
+		};
+
+	if(!header.stream_id)
+	{
+		send_window += increment;
+		return;
+	}
+
+	const auto it
+	{
+		streams.find(header.stream_id)
+	};
+
+	if(it != end(streams))
+		it->second.send_window += increment;
+}
+
+/// Copy response data into the tag as if it arrived over HTTP/1.1.
+void
+ircd::server::link::h2::feed(link &link,
+                             tag &tag,
+                             const_buffer buf,
+                             bool &done)
+{
+	while(!empty(buf) && !done)
+	{
+		const mutable_buffer dst
+		{
+			tag.make_read_buffer()
+		};
+
+		const size_t copied
+		{
+			copy(dst, buf)
+		};
+
+		if(unlikely(!copied))
+			throw buffer_overrun
+			{
+				"no buffer for %zu bytes of stream:%u",
+				size(buf),
+				tag.state.stream_id,
+			};
+
+		consume(buf, copied);
+		tag.read_buffer(const_buffer{data(dst), copied}, done, link);
+	}
+}
+
+void
+ircd::server::link::h2::done(link &link,
+                             tag &tag)
+{
+	// The remote may still expect content we no longer need to send.
+	if(streams.count(tag.state.stream_id))
+		rst(tag.state.stream_id, http2::error::CANCEL);
+
+	assert(link.peer);
+	link.peer->handle_tag_done(link, tag);
+	erase(link, tag);
+	if(goaway && !link.tag_committed())
+		link.close();
+}
+
+void
+ircd::server::link::h2::fail(link &link,
+                             tag &tag,
+                             std::exception_ptr eptr)
+{
+	log::derror
+	{
+		log, "%s tag:%lu stream:%u :%s",
+		loghead(link),
+		tag.state.id,
+		tag.state.stream_id,
+		what(eptr),
+	};
+
+	if(streams.count(tag.state.stream_id))
+		rst(tag.state.stream_id, http2::error::CANCEL);
+
+	assert(link.peer);
+	++link.peer->tag_fail;
+	tag.set_exception(std::move(eptr));
+	erase(link, tag);
+	if(goaway && !link.tag_committed())
+		link.close();
+}
+
+/// Submit the tag's request again to another link of the peer. The tag must
+/// not have received any of its response.
+void
+ircd::server::link::h2::requeue(link &link,
+                                tag &tag)
+{
+	assert(!tag.state.head_read);
+	streams.erase(tag.state.stream_id);
+	tag.state.stream_id = 0;
+	tag.state.written = 0;
+	if(!tag.request)
+		return erase(link, tag);
+
+	log::dwarning
+	{
+		log, "%s tag:%lu resubmitting to another link",
+		loghead(link),
+		tag.state.id,
+	};
+
+	// The link is excluded while the peer selects another for the request;
+	// this leaves the tag empty in our queue.
+	const bool exclude(link.exclude);
+	const unwind restore{[&link, &exclude]
+	{
+		link.exclude = exclude;
+	}};
+
+	link.exclude = true;
+	assert(link.peer);
+	link.peer->submit(*tag.request);
+	erase(link, tag);
+}
+
+ircd::server::tag *
+ircd::server::link::h2::find(link &link,
+                             const uint32_t &id)
+{
+	const auto it
+	{
+		std::find_if(begin(link.queue), end(link.queue), [&id]
+		(const auto &tag)
+		{
+			return tag.state.stream_id == id;
+		})
+	};
+
+	return it != end(link.queue)?
+		std::addressof(*it):
+		nullptr;
+}
+
+void
+ircd::server::link::h2::erase(link &link,
+                              tag &tag)
+{
+	const auto it
+	{
+		std::find_if(begin(link.queue), end(link.queue), [&tag]
+		(const auto &queued)
+		{
+			return std::addressof(queued) == std::addressof(tag);
+		})
+	};
+
+	assert(it != end(link.queue));
+	link.queue.erase(it);
+}
+
+void
+ircd::server::link::h2::rst(const uint32_t &id,
+                            const enum http2::error::code &code)
+{
+	const uint32_t payload
+	{
+		htonl(code)
+	};
+
+	streams.erase(id);
+	ctrl(http2::frame::RST_STREAM, 0, id, const_buffer
+	{
+		reinterpret_cast<const char *>(&payload), sizeof(payload)
+	});
+}
+
+void
+ircd::server::link::h2::window_update(const uint32_t &id,
+                                      const size_t &increment)
+{
+	const uint32_t payload
+	{
+		htonl(uint32_t(increment) & 0x7fffffffU)
+	};
+
+	ctrl(http2::frame::WINDOW_UPDATE, 0, id, const_buffer
+	{
+		reinterpret_cast<const char *>(&payload), sizeof(payload)
+	});
+}
+
+void
+ircd::server::link::h2::ctrl(const http2::frame::type &type,
+                             const uint8_t &flags,
+                             const uint32_t &id,
+                             const const_buffer &payload)
+{
+	char buf[http2::frame::header_size + 64];
+	control.append(string_view
+	{
+		http2::frame::write(buf, type, flags, id, payload)
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// server/tag.h
+//
+
+/// Monotonic counter for tags.
+decltype(ircd::server::tag::state::ids)
+ircd::server::tag::state::ids;
+
+/// This is tricky. When a user cancels a request which has committed some
+/// writes to the remote we have to continue to service it through to
+/// completion without disrupting the linearity of the link's pipeline
+/// and causing trouble with other requests. This all depends on what phase
+/// the request is currently in.
+///
+/// In any case, the goal here is to swap out the user's request buffers
+/// and replace them with cancellation buffers which will be transparent
+/// to the link as it completes the request.
+void
+ircd::server::cancel(request &request,
+                     tag &tag)
+noexcept
+{
+	// Must have a fully associated request/tag which has committed some
+	// data to the wire to enter this routine.
+	assert(tag.committed());
+	assert(!tag.canceled());
+	assert(request.tag == &tag);
+	assert(tag.request == &request);
+	assert(!tag.cancellation);
+
+	// The cancellation is a straightforward facsimile except in the case of
+	// dynamic chunked encoding mode where we need to add additional scratch.
+	const size_t additional_scratch
+	{
+		tag.state.chunk_length != 0 && null(request.in.content)?
+			std::max(tag.state.head_rem, size_t(8_KiB)) : 0_KiB
+	};
+
+	const size_t cancellation_size
+	{
+		size(request.out) + size(request.in) + additional_scratch
+	};
+
+	// Disassociate the user's request and add our dummy request in its place.
+	disassociate(request, tag);
+
+	assert(tag.request == nullptr);
+	tag.request = new server::request{};
+	tag.request->tag = &tag;
+
+	// Setup the cancellation buffers by mirroring the current state of the
+	// user's buffers.
+
+	assert(!tag.cancellation);
+	tag.cancellation = unique_buffer<mutable_buffer>
+	{
+		cancellation_size
+	};
+
+	char *ptr
+	{
+		data(tag.cancellation)
+	};
+
+	const mutable_buffer out_head{ptr, size(request.out.head)};
+	tag.request->out.head = out_head;
+	ptr += size(out_head);
+
+	const mutable_buffer out_content{ptr, size(request.out.content)};
+	tag.request->out.content = out_content;
+	ptr += size(out_content);
+
+	// The in_head buffer is a straightforward facsimile except in the case of
+	// dynamic chunked encoding mode where we need to add additional scratch.
+	const mutable_buffer in_head{ptr, size(request.in.head)};
+	tag.request->in.head = in_head;
+	ptr += size(in_head) + additional_scratch;
+
+	const mutable_buffer in_content{ptr, size(request.in.content)};
+	// The nullity (btw that's a real word) of in.content has to be preserved
+	// between the user's tag and the cancellation tag. This is important for
+	// a dynamic chunked encoded response which has null in.content until done.
+	if(!null(request.in.content))
+	{
+		tag.request->in.content = in_content;
+		ptr += size(in_content);
+	}
+	else tag.request->in.content = request.in.content;
+
+	assert(size_t(std::distance(data(tag.cancellation), ptr)) == cancellation_size);
+
+	// If the head is not completely written we have to copy the remainder from where
+	// the socket left off.
+	if(tag.state.written < size(request.out.head))
+	{
+		const const_buffer src
+		{
+			request.out.head + tag.state.written
+		};
+
+		const mutable_buffer dst
+		{
+			out_head + tag.state.written
+		};
+
+		copy(dst, src);
+	}
+
+	// If the content is not completely written we have to copy the remainder from where
+	// the socket left off.
+	const size_t content_written
+	{
+		tag.state.written > size(request.out.head)? tag.state.written - size(request.out.head) : 0
+	};
+
+	if(content_written < size(request.out.content))
+	{
+		const const_buffer src
+		{
+			request.out.content + content_written
+		};
+
+		const mutable_buffer dst
+		{
+			out_content + content_written
+		};
+
+		copy(dst, src);
+	}
+
+	// If the head is not completely read we have to copy what's been received so far so
+	// we can parse a coherent head.
+	if(tag.state.head_read > 0 && tag.state.head_read < size(request.in.head))
+	{
+		const const_buffer src
+		{
+			request.in.head, tag.state.head_read
+		};
+
+		const mutable_buffer dst
+		{
+			in_head
+		};
+
+		copy(dst, src);
+	}
+
+	// Normally we have no reason to copy content, but there is one exception:
+	// If the content is chunked encoding and the tag is in the phase of
+	// receiving the chunk head we have to copy what's been received of that
+	// head so far so the grammar can parse a coherent head to continue.
+	if(tag.state.chunk_length == size_t(-1) && !null(request.in.content))
+	{
+		assert(tag.state.content_read >= tag.state.content_length);
+		const const_buffer src
+		{
+			request.in.content + tag.state.content_length,
+			tag.state.content_read - tag.state.content_length
+		};
+
+		const mutable_buffer dst
+		{
+			in_content + tag.state.content_length
+		};
+
+		copy(dst, src);
+	}
+
+	// Moving the dynamic buffer should have no real effect because the
+	// cancellation buffer already took over for it. We could do it anyway
+	// to prevent regressions but at the cost of maintaining twice the memory
+	// allocated. For now it's commented to let it die with the user's req.
+	//tag.request->in.dynamic = std::move(request.in.dynamic);
 
 	// Moving the chunk vector is important to maintain the state of dynamic
 	// chunk transfers through this cancel. There is no condition here for if
@@ -3145,6 +4557,14 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 	assert(link.peer);
 	link.peer->handle_head_recv(link, *this, head);
 
+	// A content-coding is only decoded into dynamic content; the user's own
+	// buffer receives the content as it was sent.
+	if(dynamic && head.content_encoding)
+	{
+		state.coding = compress::parse(head.content_encoding);
+		req.in.coding = state.coding;
+	}
+
 	if(contiguous)
 	{
 		const auto content_max
@@ -3781,8 +5201,14 @@ ircd::server::chunk_dynamic_content_completed(tag &tag,
 		return;
 
 	assert(state.chunk_read == 0);
+	// Coded content is only decoded as a whole, which requires the copy.
 	assert(req.opt);
-	if(req.opt->contiguous_content && !req.in.chunks.empty())
+	const bool contiguous
+	{
+		req.opt->contiguous_content || state.coding != compress::type::IDENTITY
+	};
+
+	if(contiguous && !req.in.chunks.empty())
 		chunk_dynamic_contiguous_copy(state, req);
 
 	assert(!done);
@@ -4132,6 +5558,21 @@ ircd::server::tag::set_value(args&&... a)
 	assert(request->opt);
 	if(request->opt->http_exceptions && code >= http::code(300))
 	{
+		// The error is thrown from the future, so its content is decoded
+		// here; the expansion is bounded to what an error should carry.
+		if(request->in.coding != compress::type::IDENTITY) try
+		{
+			content_decode(*request, content_decode_error_max);
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				request::log, "Failed to decode error content :%s",
+				e.what(),
+			};
+		}
+
 		const string_view content
 		{
 			data(request->in.content), size(request->in.content)
@@ -125,6 +125,8 @@ ircd::m::dbs::init::init(const string_view &servername,
 	room_events = db::domain{*events, desc::room_events.name};
 	room_type = db::domain{*events, desc::room_type.name};
 	room_joined = db::domain{*events, desc::room_joined.name};
+	user_mitsein = db::domain{*events, desc::user_mitsein.name};
+	user_unread = db::column{*events, desc::user_unread.name};
 	room_state = db::domain{*events, desc::room_state.name};
 	room_state_space = db::domain{*events, desc::room_state_space.name};
 }
@@ -315,6 +317,9 @@ ircd::m::dbs::_index_room(db::txn &txn,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			_index_room_joined(txn, event, opts);
+
+		if(opts.appendix.test(appendix::USER_MITSEIN) && at<"type"_>(event) == "m.room.member")
+			_index_user_mitsein(txn, event, opts);
 	}
 
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
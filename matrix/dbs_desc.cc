@@ -529,6 +529,14 @@ ircd::m::dbs::desc::events
 	// Mapping of all current head events for a room.
 	room_head,
 
+	// (user_id, (other_user_id, room_id))
+	// Sequence of users and servers in the PRESENTLY JOINED rooms of a user.
+	user_mitsein,
+
+	// (user_id, room_id) => (notification_count, highlight_count)
+	// Unread counts of our users in each room since their read receipt.
+	user_unread,
+
 	//
 	// These columns are legacy; they have been dropped from the schema.
 	//
@@ -0,0 +1,399 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+decltype(ircd::m::dbs::user_mitsein)
+ircd::m::dbs::user_mitsein;
+
+decltype(ircd::m::dbs::desc::user_mitsein__block__size)
+ircd::m::dbs::desc::user_mitsein__block__size
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.block.size" },
+	{ "default",  512L                                  },
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__meta_block__size)
+ircd::m::dbs::desc::user_mitsein__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.meta_block.size" },
+	{ "default",  long(8_KiB)                                },
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__cache__size)
+ircd::m::dbs::desc::user_mitsein__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_mitsein.cache.size" },
+		{ "default",  long(8_MiB)                           },
+	}, []
+	{
+		const size_t &value{user_mitsein__cache__size};
+		db::capacity(db::cache(dbs::user_mitsein), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__cache_comp__size)
+ircd::m::dbs::desc::user_mitsein__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_mitsein.cache_comp.size" },
+		{ "default",  long(8_MiB)                                },
+	}, []
+	{
+		const size_t &value{user_mitsein__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::user_mitsein), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_mitsein__bloom__bits)
+ircd::m::dbs::desc::user_mitsein__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._user_mitsein.bloom.bits" },
+	{ "default",  6L                                    },
+};
+
+/// Prefix transform for the user_mitsein; the prefix is the user_id.
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::user_mitsein__pfx
+{
+	"_user_mitsein",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, '\0').first;
+	}
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::user_mitsein
+{
+	// name
+	"_user_mitsein",
+
+	// explanation
+	R"(Indexes the users and servers sharing joined rooms with each of our users.
+
+	[user_id | other_user_id + "\0" + room_id]
+	[user_id | "\0" + origin + "\0" + room_id]
+	[user_id | "\0"]
+
+	There is an entry for each room a pair shares, so these are removed only
+	when the last shared room is left. Only our own users have entries. The
+	last form marks the entries of the user as complete once rebuilt; until
+	then queries for the user don't use this index.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	user_mitsein__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(user_mitsein__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(user_mitsein__block__size),
+
+	// meta_block size
+	size_t(user_mitsein__meta_block__size),
+
+	// compression
+	"kLZ4Compression;kSnappyCompression"s,
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+namespace ircd::m::dbs
+{
+	static string_view _user_mitsein_origin_key(const mutable_buffer &, const id::room &, const string_view &origin, const bool &past);
+	static bool _user_mitsein_origin_remains(const id::room &, const string_view &origin, const id::user &);
+}
+
+/// Adds the entries for the user_mitsein column into the txn when a member
+/// joins or parts the room. The members presently joined are read from
+/// room_joined, so this must be composed before that column is written.
+void
+ircd::m::dbs::_index_user_mitsein(db::txn &txn,
+                                  const event &event,
+                                  const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::USER_MITSEIN));
+	assert(at<"type"_>(event) == "m.room.member");
+
+	if(!opts.allow_queries)
+		return;
+
+	const string_view &membership
+	{
+		m::membership(event)
+	};
+
+	const bool joining
+	{
+		opts.op == db::op::SET && membership == "join"
+	};
+
+	const bool parting
+	{
+		opts.op == db::op::DELETE ||
+		(opts.op == db::op::SET && (membership == "leave" || membership == "ban"))
+	};
+
+	if(!joining && !parting)
+		return;
+
+	const m::room::id &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	const m::user::id &user_id
+	{
+		at<"state_key"_>(event)
+	};
+
+	// The server of the member rather than of the event, which differs for
+	// a kick or ban from another server.
+	const string_view &origin
+	{
+		user_id.host()
+	};
+
+	// Only transitions change the index; not a join over a join (i.e. a
+	// profile change) nor a part without a join.
+	char joined_buf[ROOM_JOINED_KEY_MAX_SIZE];
+	const bool joined
+	{
+		db::has(room_joined, room_joined_key(joined_buf, room_id, origin, user_id))
+	};
+
+	if(joining == joined)
+		return;
+
+	const db::op op
+	{
+		joining? db::op::SET : db::op::DELETE
+	};
+
+	const bool mine
+	{
+		my(user_id)
+	};
+
+	const auto append{[&txn, &op, &room_id]
+	(const id::user &user_id, const string_view &other)
+	{
+		char buf[USER_MITSEIN_KEY_MAX_SIZE];
+		db::txn::append
+		{
+			txn, user_mitsein,
+			{
+				op,
+				user_mitsein_key(buf, user_id, other, room_id),
+			}
+		};
+	}};
+
+	if(mine)
+	{
+		append(user_id, user_id);
+		append(user_id, origin);
+	}
+
+	// Our users keep the origin of a parting member while any other member
+	// from there remains joined; a joining member always sets it.
+	const bool origin_remains
+	{
+		parting && _user_mitsein_origin_remains(room_id, origin, user_id)
+	};
+
+	// When the member isn't ours only our members are of interest; the
+	// members of other origins are skipped with a seek.
+	string_view last;
+	char lastbuf[rfc1035::NAME_BUFSIZE];
+	auto it
+	{
+		room_joined.begin(room_id)
+	};
+
+	while(bool(it))
+	{
+		const auto &[member_origin, member]
+		{
+			room_joined_key(it->first)
+		};
+
+		if(!mine && !my_host(member_origin))
+		{
+			char keybuf[ROOM_JOINED_KEY_MAX_SIZE];
+			seek(it, _user_mitsein_origin_key(keybuf, room_id, member_origin, true));
+			last = {};
+			continue;
+		}
+
+		if(member != user_id && mine)
+		{
+			append(user_id, member);
+			if(member_origin != last)
+				append(user_id, member_origin);
+		}
+
+		if(member != user_id && my(id::user(member)))
+		{
+			append(member, user_id);
+			if(!origin_remains)
+				append(member, origin);
+		}
+
+		last = { lastbuf, copy(lastbuf, member_origin) };
+		++it;
+	}
+}
+
+bool
+ircd::m::dbs::_user_mitsein_origin_remains(const id::room &room_id,
+                                           const string_view &origin,
+                                           const id::user &user_id)
+{
+	char keybuf[ROOM_JOINED_KEY_MAX_SIZE];
+	auto it
+	{
+		room_joined.begin(_user_mitsein_origin_key(keybuf, room_id, origin, false))
+	};
+
+	for(; bool(it); ++it)
+	{
+		const auto &[member_origin, member]
+		{
+			room_joined_key(it->first)
+		};
+
+		if(member_origin != origin)
+			return false;
+
+		if(member != user_id)
+			return true;
+	}
+
+	return false;
+}
+
+/// The room_joined keys are origin + member without a separator, so the
+/// members of an origin start at origin + "@"; other origins with the same
+/// prefix (i.e. "host:8448" or "host.x" for "host") sort on either side.
+/// With past, the key is just beyond the members of the origin instead.
+ircd::string_view
+ircd::m::dbs::_user_mitsein_origin_key(const mutable_buffer &out,
+                                       const id::room &room_id,
+                                       const string_view &origin,
+                                       const bool &past)
+{
+	const auto key
+	{
+		room_joined_key(out, room_id, origin)
+	};
+
+	assert(size(key) < size(out));
+	data(out)[size(key)] = past? '@' + 1 : '@';
+	return { data(key), size(key) + 1 };
+}
+
+//
+// built
+//
+
+/// True when the entries of the user are complete; the index is used for a
+/// user only after it was rebuilt for them, which writes this marker.
+bool
+ircd::m::dbs::user_mitsein_built(const id::user &user_id)
+{
+	char keybuf[USER_MITSEIN_KEY_MAX_SIZE];
+	return db::has(user_mitsein, user_mitsein_key(keybuf, user_id, string_view{}));
+}
+
+//
+// key
+//
+
+std::tuple<ircd::string_view, ircd::string_view>
+ircd::m::dbs::user_mitsein_key(const string_view &amalgam)
+{
+	// The leading separator from the prefix, then another for an origin.
+	string_view key{amalgam};
+	for(size_t i(0); i < 2 && startswith(key, '\0'); ++i)
+		key = string_view{key.substr(1)};
+
+	const auto &s
+	{
+		split(key, '\0')
+	};
+
+	return
+	{
+		s.first, s.second
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::user_mitsein_key(const mutable_buffer &out_,
+                               const id::user &user_id,
+                               const string_view &other,
+                               const id::room &room_id)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, user_id));
+	consume(out, copy(out, '\0'));
+	if(!startswith(other, '@'))
+		consume(out, copy(out, '\0'));
+
+	consume(out, copy(out, other));
+	if(room_id)
+	{
+		consume(out, copy(out, '\0'));
+		consume(out, copy(out, room_id));
+	}
+
+	return { data(out_), data(out) };
+}
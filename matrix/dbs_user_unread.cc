@@ -0,0 +1,137 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+decltype(ircd::m::dbs::user_unread)
+ircd::m::dbs::user_unread;
+
+decltype(ircd::m::dbs::desc::user_unread__block__size)
+ircd::m::dbs::desc::user_unread__block__size
+{
+	{ "name",     "ircd.m.dbs._user_unread.block.size" },
+	{ "default",  512L                                 },
+};
+
+decltype(ircd::m::dbs::desc::user_unread__meta_block__size)
+ircd::m::dbs::desc::user_unread__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._user_unread.meta_block.size" },
+	{ "default",  long(4_KiB)                               },
+};
+
+decltype(ircd::m::dbs::desc::user_unread__cache__size)
+ircd::m::dbs::desc::user_unread__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_unread.cache.size" },
+		{ "default",  long(8_MiB)                          },
+	}, []
+	{
+		const size_t &value{user_unread__cache__size};
+		db::capacity(db::cache(dbs::user_unread), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_unread__cache_comp__size)
+ircd::m::dbs::desc::user_unread__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_unread.cache_comp.size" },
+		{ "default",  long(4_MiB)                               },
+	}, []
+	{
+		const size_t &value{user_unread__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::user_unread), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_unread__bloom__bits)
+ircd::m::dbs::desc::user_unread__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._user_unread.bloom.bits" },
+	{ "default",  10L                                  },
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::user_unread
+{
+	// name
+	"_user_unread",
+
+	// explanation
+	R"(Counts the notifications of our users in each room since their receipt.
+
+	user_id + room_id => notification_count, highlight_count
+
+	The value is two 8 byte signed integers. Push evaluation increments them
+	for each event which notifies the user, and the user's read receipt in the
+	room deletes the entry; a missing entry counts zero.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(user_unread__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(user_unread__block__size),
+
+	// meta_block size
+	size_t(user_unread__meta_block__size),
+
+	// compression
+	"kLZ4Compression;kSnappyCompression"s,
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// key
+//
+
+/// The sigils keep the concatenation unambiguous.
+ircd::string_view
+ircd::m::dbs::user_unread_key(const mutable_buffer &out_,
+                              const id::user &user_id,
+                              const id::room &room_id)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, user_id));
+	consume(out, copy(out, room_id));
+	return { data(out_), data(out) };
+}
@@ -11,6 +11,11 @@
 namespace ircd::m
 {
 	static json::object make_hashes(const mutable_buffer &out, const sha256::buf &hash);
+	static string_view make_content_preimage(mutable_buffer &out, const json::object &);
+	static string_view make_content_preimage(mutable_buffer &out, const event &);
+	static ed25519::sig signature(const event &, const string_view &origin, const string_view &keyid);
+	static bool verify_key(const event &, const event::preimage *const &, const string_view &origin, const string_view &keyid);
+	static bool verify_origin(const event &, const event::preimage *const &, const string_view &origin);
 }
 
 /// The maximum size of an event we will create. This may also be used in
@@ -64,6 +69,20 @@ ircd::m::make_hashes(const mutable_buffer &out,
 
 ircd::sha256::buf
 ircd::m::event::hash(const json::object &event)
+{
+	thread_local char buf[event::MAX_SIZE];
+	mutable_buffer out{buf};
+	const string_view preimage
+	{
+		make_content_preimage(out, event)
+	};
+
+	return sha256{preimage};
+}
+
+ircd::string_view
+ircd::m::make_content_preimage(mutable_buffer &out,
+                               const json::object &event)
 try
 {
 	static const size_t iov_max{json::iov::max_size};
@@ -83,13 +102,7 @@ try
 		member.at(i++) = m;
 	}
 
-	thread_local char buf[event::MAX_SIZE];
-	const string_view reimage
-	{
-		json::stringify(buf, member.data(), member.data() + i)
-	};
-
-	return sha256{reimage};
+	return json::stringify(out, member.data(), member.data() + i);
 }
 catch(const std::out_of_range &e)
 {
@@ -100,6 +113,19 @@ catch(const std::out_of_range &e)
 	};
 }
 
+ircd::string_view
+ircd::m::make_content_preimage(mutable_buffer &out,
+                               const event &event)
+{
+	if(event.source)
+		return make_content_preimage(out, event.source);
+
+	m::event event_{event};
+	json::get<"signatures"_>(event_) = {};
+	json::get<"hashes"_>(event_) = {};
+	return stringify(out, event_);
+}
+
 ircd::sha256::buf
 ircd::m::event::hash(json::iov &event,
                      const string_view &content)
@@ -115,22 +141,58 @@ ircd::m::event::hash(json::iov &event,
 ircd::sha256::buf
 ircd::m::hash(const event &event)
 {
-	if(event.source)
-		return event::hash(event.source);
-
-	m::event event_{event};
-	json::get<"signatures"_>(event_) = {};
-	json::get<"hashes"_>(event_) = {};
-
 	thread_local char buf[event::MAX_SIZE];
+	mutable_buffer out{buf};
 	const string_view preimage
 	{
-		stringify(buf, event_)
+		make_content_preimage(out, event)
 	};
 
 	return sha256{preimage};
 }
 
+//
+// event::preimage
+//
+
+size_t
+ircd::m::event::preimage::buffer_size(const event &event)
+{
+	const size_t source_size
+	{
+		std::max(ircd::size(string_view{event.source}), serialized(event))
+	};
+
+	// One region for the redacted content and one for the reference
+	// preimage; neither exceeds the event itself.
+	return source_size * 2 + 16;
+}
+
+ircd::m::event::preimage::preimage(const mutable_buffer &buf_,
+                                   const event &event)
+{
+	mutable_buffer buf
+	{
+		buf_
+	};
+
+	// The redacted content is never larger than the original content; a
+	// little extra allows an empty original to become "{}".
+	const mutable_buffer essential_content
+	{
+		ircd::data(buf), ircd::size(string_view{json::get<"content"_>(event)}) + 16
+	};
+
+	const m::event essential
+	{
+		m::essential(event, essential_content)
+	};
+
+	consume(buf, ircd::size(essential_content));
+	reference = stringify(buf, essential);
+	reference_hash = sha256{reference};
+}
+
 bool
 ircd::m::verify_hash(const event &event)
 {
@@ -423,6 +485,64 @@ ircd::m::verify(const event &event)
 bool
 ircd::m::verify(const event &event,
                 const string_view &origin)
+{
+	return verify_origin(event, nullptr, origin);
+}
+
+bool
+ircd::m::verify(const event &event,
+                const string_view &origin,
+                const string_view &keyid)
+{
+	return verify_key(event, nullptr, origin, keyid);
+}
+
+bool
+ircd::m::verify(const event &event,
+                const ed25519::pk &pk,
+                const string_view &origin,
+                const string_view &keyid)
+{
+	const ed25519::sig sig
+	{
+		signature(event, origin, keyid)
+	};
+
+	return verify(event, pk, sig);
+}
+
+bool
+ircd::m::verify(const event &event,
+                const event::preimage &preimage)
+{
+	const string_view &origin
+	{
+		at<"origin"_>(event)
+	};
+
+	return verify(event, preimage, origin);
+}
+
+bool
+ircd::m::verify(const event &event,
+                const event::preimage &preimage,
+                const string_view &origin)
+{
+	return verify_origin(event, &preimage, origin);
+}
+
+bool
+ircd::m::verify(const event::preimage &preimage,
+                const ed25519::pk &pk,
+                const ed25519::sig &sig)
+{
+	return pk.verify(preimage.reference, sig);
+}
+
+bool
+ircd::m::verify_origin(const event &event,
+                       const event::preimage *const &preimage,
+                       const string_view &origin)
 {
 	const json::object &signatures
 	{
@@ -435,16 +555,17 @@ ircd::m::verify(const event &event,
 	};
 
 	for(const auto &[keyid, sig] : origin_sigs)
-		if(verify(event, origin, json::string(keyid)))
+		if(verify_key(event, preimage, origin, json::string(keyid)))
 			return true;
 
 	return false;
 }
 
 bool
-ircd::m::verify(const event &event,
-                const string_view &origin,
-                const string_view &keyid)
+ircd::m::verify_key(const event &event,
+                    const event::preimage *const &preimage,
+                    const string_view &origin,
+                    const string_view &keyid)
 try
 {
 	const m::node node
@@ -453,10 +574,17 @@ try
 	};
 
 	bool ret{false};
-	node.key(keyid, [&ret, &event, &origin, &keyid]
+	node.key(keyid, [&ret, &event, &preimage, &origin, &keyid]
 	(const ed25519::pk &pk)
 	{
-		ret = verify(event, pk, origin, keyid);
+		const ed25519::sig sig
+		{
+			signature(event, origin, keyid)
+		};
+
+		ret = preimage?
+			verify(*preimage, pk, sig):
+			verify(event, pk, sig);
 	});
 
 	return ret;
@@ -475,11 +603,10 @@ catch(const m::NOT_FOUND &e)
 	return false;
 }
 
-bool
-ircd::m::verify(const event &event,
-                const ed25519::pk &pk,
-                const string_view &origin,
-                const string_view &keyid)
+ircd::ed25519::sig
+ircd::m::signature(const event &event,
+                   const string_view &origin,
+                   const string_view &keyid)
 {
 	const json::object &signatures
 	{
@@ -491,15 +618,13 @@ ircd::m::verify(const event &event,
 		signatures.at(origin)
 	};
 
-	const ed25519::sig sig
+	return ed25519::sig
 	{
 		[&origin_sigs, &keyid](auto &buf)
 		{
 			b64decode(buf, json::string(origin_sigs.at(keyid)));
 		}
 	};
-
-	return verify(event, pk, sig);
 }
 
 bool
@@ -925,6 +1050,40 @@ catch(...)
 	return false;
 }
 
+bool
+ircd::m::check_id(const event &event,
+                  const event::preimage &preimage)
+noexcept try
+{
+	if(!event.event_id)
+		return false;
+
+	const string_view &version
+	{
+		event.event_id.version()
+	};
+
+	if(version == "1" || version == "2")
+		return event.event_id == json::get<"event_id"_>(event);
+
+	event::id::buf buf;
+	const event::id &check_id
+	{
+		make_id(event, version, buf, preimage.reference_hash)
+	};
+
+	return event.event_id == check_id;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		"m::check_id() :%s", e.what()
+	};
+
+	return false;
+}
+
 bool
 ircd::m::before(const event &a,
                 const event &b)
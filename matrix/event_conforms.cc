@@ -124,11 +124,11 @@ ircd::m::vm::conform_report
 			return;
 		}
 
-		// Generate the report here.
-		eval.report = event::conforms
-		{
-			event, opts.non_conform.report
-		};
+		// Generate the report here; the event_id check reuses the preimage
+		// when the eval has already computed one.
+		eval.report = eval.preimage?
+			event::conforms{event, *eval.preimage, opts.non_conform.report}:
+			event::conforms{event, opts.non_conform.report};
 
 		// When opts.conforming is false a bad report is not an error.
 		if(!opts.conforming)
@@ -225,7 +225,21 @@ ircd::m::event::conforms::conforms(const event &e,
 	report &= ~skip;
 }
 
+ircd::m::event::conforms::conforms(const event &e,
+                                   const preimage &preimage,
+                                   const uint64_t &skip)
+:conforms{e, &preimage}
+{
+	report &= ~skip;
+}
+
 ircd::m::event::conforms::conforms(const event &e)
+:conforms{e, nullptr}
+{
+}
+
+ircd::m::event::conforms::conforms(const event &e,
+                                   const preimage *const &preimage)
 :report{0}
 {
 	if(!e.event_id)
@@ -236,7 +250,7 @@ ircd::m::event::conforms::conforms(const event &e)
 			set(INVALID_OR_MISSING_EVENT_ID);
 
 	if(!has(INVALID_OR_MISSING_EVENT_ID))
-		if(!m::check_id(e))
+		if(!(preimage? m::check_id(e, *preimage): m::check_id(e)))
 			set(MISMATCH_EVENT_ID);
 
 	if(!valid(m::id::ROOM, json::get<"room_id"_>(e)))
@@ -10,7 +10,11 @@
 
 namespace ircd::m::events
 {
+	static void ingest__phase(const vector_view<const event> &, const event::idx &, const dbs::write_opts &, const string_view &dir, const string_view &tag);
+	static void ingest__batch(const vector_view<const event> &, const event::idx &, const string_view &dir, const size_t &num);
+
 	extern conf::item<size_t> dump_buffer_size;
+	extern conf::item<size_t> ingest_buffer_size;
 }
 
 decltype(ircd::m::events::dump_buffer_size)
@@ -20,6 +24,15 @@ ircd::m::events::dump_buffer_size
 	{ "default",  int64_t(512_KiB)                 },
 };
 
+/// Each fill of this buffer becomes one batch of external SST files; larger
+/// values mean fewer, larger files ingested into the database.
+decltype(ircd::m::events::ingest_buffer_size)
+ircd::m::events::ingest_buffer_size
+{
+	{ "name",     "ircd.m.events.ingest.buffer_size" },
+	{ "default",  int64_t(64_MiB)                    },
+};
+
 void
 ircd::m::events::rebuild()
 {
@@ -195,6 +208,289 @@ ircd::m::events::dump__file(const string_view &filename)
 	};
 }
 
+/// Bulk load a file of events in the format written by dump__file() by
+/// generating external SST files for every m::dbs column and ingesting them
+/// directly, bypassing the memtable, the WAL and the vm entirely.
+///
+/// This is a trusted mode: nothing is verified, authorized or sent anywhere.
+/// The input must be pre-validated and events must appear in the order they
+/// are to be sequenced (e.g. the output of another server's dump). Events
+/// without an event_id are assumed to be of room version 4 or later. Events
+/// already known to the server are skipped. The server should not be evaluating other events meanwhile.
+///
+/// Each batch is ingested in two phases; first the event_id index and the
+/// event's own columns, so the indexers of the second phase can resolve
+/// references to events within the same batch. The state reference graph is
+/// not generated here; run `event refs rebuild` after loading.
+size_t
+ircd::m::events::ingest__file(const string_view &filename)
+{
+	if(unlikely(ircd::read_only || ircd::write_avoid))
+		throw error
+		{
+			"Cannot ingest events in read-only or write-avoid mode."
+		};
+
+	if(unlikely(vm::eval::executing || vm::eval::injecting))
+		throw error
+		{
+			"Cannot ingest events while the vm is evaluating others."
+		};
+
+	const fs::fd file
+	{
+		filename
+	};
+
+	// POSIX_FADV_DONTNEED
+	fs::evict(file);
+
+	const std::string dir
+	{
+		fs::path_string(fs::path_view
+		{
+			db::path(db::name(*dbs::events)), "ingest"
+		})
+	};
+
+	if(!fs::is_dir(dir))
+		fs::mkdir(dir);
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		size_t(ingest_buffer_size)
+	};
+
+	std::vector<m::event> events;
+	std::deque<event::id::buf> ids;
+	std::set<string_view> batch_ids;
+	size_t foff{0}, ecount{0}, skipped{0}, batches{0};
+	for(;; ++batches)
+	{
+		const string_view read
+		{
+			fs::read(file, buf, foff)
+		};
+
+		if(empty(read))
+			break;
+
+		size_t boff(0);
+		json::vector vector{read};
+		for(; boff < size(read); ) try
+		{
+			const json::object object
+			{
+				*begin(vector)
+			};
+
+			boff += size(string_view{object});
+			vector = { data(read) + boff, size(read) - boff };
+			auto &event_id
+			{
+				ids.emplace_back()
+			};
+
+			const m::event event
+			{
+				event_id, object
+			};
+
+			// Duplicates within the batch aren't found in the database yet.
+			if(m::exists(event.event_id) || !batch_ids.emplace(event.event_id).second)
+			{
+				ids.pop_back();
+				++skipped;
+				continue;
+			}
+
+			events.emplace_back(event);
+		}
+		catch(const json::parse_error &e)
+		{
+			// The last object in the buffer is usually cut off; it is read
+			// again from the start of the next batch. Nothing parsed at all
+			// means the object can never fit or the input is malformed.
+			if(boff == 0)
+				throw error
+				{
+					"ingest[%s] at offset %zu: %s :%s",
+					filename,
+					foff,
+					size(read) == size(buf)?
+						"event exceeds ircd.m.events.ingest.buffer_size":
+						"malformed input",
+					e.what(),
+				};
+
+			break;
+		}
+
+		if(!events.empty())
+		{
+			const event::idx start
+			{
+				vm::sequence::retired + 1
+			};
+
+			ingest__batch(events, start, dir, batches);
+			ecount += events.size();
+			vm::sequence::retired = start + events.size() - 1;
+			vm::sequence::committed = vm::sequence::retired;
+			vm::sequence::uncommitted = vm::sequence::retired;
+			vm::sequence::dock.notify_all();
+			events.clear();
+		}
+
+		batch_ids.clear();
+		ids.clear();
+
+		char pbuf[48];
+		log::info
+		{
+			log, "ingest[%s] batch:%zu events:%zu skipped:%zu %s @ seq %zu",
+			filename,
+			batches,
+			ecount,
+			skipped,
+			pretty(pbuf, iec(foff + boff)),
+			vm::sequence::retired,
+		};
+
+		foff += boff;
+	}
+
+	log::notice
+	{
+		log, "ingest[%s] complete events:%zu skipped:%zu from %s in batches:%zu",
+		filename,
+		ecount,
+		skipped,
+		pretty(iec(foff)),
+		batches,
+	};
+
+	return ecount;
+}
+
+void
+ircd::m::events::ingest__batch(const vector_view<const event> &events,
+                               const event::idx &start,
+                               const string_view &dir,
+                               const size_t &num)
+{
+	dbs::write_opts wopts;
+	wopts.appendix.reset();
+	wopts.appendix.set(dbs::appendix::EVENT_ID);
+	wopts.appendix.set(dbs::appendix::EVENT_COLS);
+	wopts.appendix.set(dbs::appendix::EVENT_JSON);
+	wopts.json_source = true;
+
+	char tag[32];
+	ingest__phase(events, start, wopts, dir, fmt::sprintf
+	{
+		tag, "%zu.0", num
+	});
+
+	wopts.appendix = dbs::write_opts::appendix_all;
+	wopts.appendix.reset(dbs::appendix::EVENT_ID);
+	wopts.appendix.reset(dbs::appendix::EVENT_COLS);
+	wopts.appendix.reset(dbs::appendix::EVENT_JSON);
+	wopts.event_refs.reset(uint(dbs::ref::NEXT_STATE));
+	wopts.event_refs.reset(uint(dbs::ref::PREV_STATE));
+	ingest__phase(events, start, wopts, dir, fmt::sprintf
+	{
+		tag, "%zu.1", num
+	});
+}
+
+void
+ircd::m::events::ingest__phase(const vector_view<const event> &events,
+                               const event::idx &start,
+                               const dbs::write_opts &opts,
+                               const string_view &dir,
+                               const string_view &tag)
+{
+	auto &database
+	{
+		*dbs::events
+	};
+
+	std::map<std::string, db::database::sst::writer, std::less<>> writers;
+	const auto stage{[&database, &writers, &dir, &tag]
+	(const db::delta &delta)
+	{
+		const auto &colname
+		{
+			std::get<db::delta::COL>(delta)
+		};
+
+		auto it
+		{
+			writers.lower_bound(colname)
+		};
+
+		if(it == end(writers) || it->first != colname)
+		{
+			const std::string filename
+			{
+				fmt::snstringf
+				{
+					fs::NAME_MAX_LEN, "%s.%s.sst", colname, tag
+				}
+			};
+
+			it = writers.emplace_hint(it, colname, db::database::sst::writer
+			{
+				db::column{database, colname},
+				fs::path_string(fs::path_view{dir, filename}),
+			});
+		}
+
+		auto &writer(it->second);
+		writer(std::get<db::delta::OP>(delta), std::get<db::delta::KEY>(delta), std::get<db::delta::VAL>(delta));
+	}};
+
+	db::txn txn
+	{
+		database
+	};
+
+	auto wopts(opts);
+	for(size_t i(0); i < events.size(); ++i)
+	{
+		wopts.event_idx = start + i;
+		dbs::write(txn, events[i], wopts);
+		db::for_each(txn, db::delta_closure{stage});
+		txn.clear();
+	}
+
+	std::vector<std::string> paths;
+	paths.reserve(writers.size());
+
+	std::vector<std::pair<string_view, string_view>> files;
+	files.reserve(writers.size());
+	for(auto &[colname, writer] : writers)
+	{
+		const auto info
+		{
+			writer.finish()
+		};
+
+		if(!info.entries)
+			continue;
+
+		paths.emplace_back(info.path);
+		files.emplace_back(colname, paths.back());
+	}
+
+	if(!files.empty())
+		db::ingest(database, files);
+
+	for(const auto &path : paths)
+		fs::remove(std::nothrow, path);
+}
+
 bool
 ircd::m::events::for_each(const range &range,
                           const event_filter &filter,
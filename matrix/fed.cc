@@ -1414,12 +1414,27 @@ ircd::m::fed::request::request(const mutable_buffer &buf_,
 		buf_ + size(remote)
 	};
 
-	// Generate the request head including the X-Matrix into buffer.
-	opts.out.head = opts.request(buf,
+	// The response can only be decoded into memory the server::request
+	// allocates; a coded response can't be partitioned into the user's buffer.
+	const bool dynamic
+	{
+		opts.dynamic && !size(opts.in)
+	};
+
+	const http::header addl_headers[]
 	{
 		// Note that we override the HTTP Host header with the well-known
 		// remote; otherwise default is the destination above which may differ.
-		{ "Host", remote }
+		{ "Host", remote },
+
+		// Offered only when the content will be dynamically allocated.
+		{ "Accept-Encoding", compress::accept() },
+	};
+
+	// Generate the request head including the X-Matrix into buffer.
+	opts.out.head = opts.request(buf,
+	{
+		addl_headers, dynamic? 2UL: 1UL
 	});
 
 	// Setup some buffering features which can optimize the server::request
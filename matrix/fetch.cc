@@ -27,21 +27,31 @@ namespace ircd::m::fetch
 	extern conf::item<size_t> requests_max;
 	extern conf::item<seconds> timeout;
 	extern conf::item<bool> enable;
+	extern conf::item<bool> hedge_enable;
+	extern conf::item<milliseconds> hedge_delay_default;
+	extern conf::item<milliseconds> hedge_delay_min;
 	extern log::log log;
 
 	static bool timedout(const request &, const system_point &now);
 	static void _check_event(const request &, const m::event &);
 	static void check_response(const request &, const json::object &);
+	static uint64_t weight(const string_view &origin);
+	static milliseconds hedge_delay(const string_view &origin);
 	static string_view select_origin(request &, const string_view &);
 	static string_view select_random_origin(request &);
 	static void finish(request &);
 	static void retry(request &);
+	static void promote(request &);
+	static void cancel_hedge(request &);
+	static bool hedge(request &);
+	static std::unique_ptr<server::request> submit(request &, const string_view &remote, const mutable_buffer &);
 	static bool start(request &, const string_view &remote);
 	static bool start(request &);
 	static void handle_result(request &);
+	static bool handle_hedge(request &);
 	static bool handle(request &);
 
-	static bool request_handle(const decltype(requests)::iterator &);
+	static bool request_handle(const decltype(requests)::iterator &, const bool &hedge);
 	static void request_handle();
 	static size_t request_cleanup();
 	static void request_worker();
@@ -67,6 +77,29 @@ ircd::m::fetch::timeout
 	{ "default",  5L                     },
 };
 
+decltype(ircd::m::fetch::hedge_enable)
+ircd::m::fetch::hedge_enable
+{
+	{ "name",     "ircd.m.fetch.hedge.enable" },
+	{ "default",  true                        },
+};
+
+/// Hedge delay for a server we have no response time history for; this
+/// also scales the selection weight of such servers.
+decltype(ircd::m::fetch::hedge_delay_default)
+ircd::m::fetch::hedge_delay_default
+{
+	{ "name",     "ircd.m.fetch.hedge.delay.default" },
+	{ "default",  1500L                              },
+};
+
+decltype(ircd::m::fetch::hedge_delay_min)
+ircd::m::fetch::hedge_delay_min
+{
+	{ "name",     "ircd.m.fetch.hedge.delay.min" },
+	{ "default",  250L                           },
+};
+
 decltype(ircd::m::fetch::requests_max)
 ircd::m::fetch::requests_max
 {
@@ -274,15 +307,31 @@ ircd::m::fetch::request_handle()
 		// during this pass we reference this default constructed static
 		// instance which when_any() will treat as a no-op.
 		static server::request request_skip;
-		auto &request(mutable_cast(*it));
-		return request.future?
-			*request.future:
+		auto &request(mutable_cast(*it->first));
+		auto &future(it->second? request.hedge : request.future);
+		return future?
+			*future:
 			request_skip;
 	}};
 
+	// Every request is waited on, and its hedge as a second element.
+	std::vector<std::pair<decltype(requests)::iterator, bool>> futures;
+	futures.reserve(requests.size() + 1);
+
+	auto now(ircd::now<system_point>());
+	auto until(now + seconds(timeout));
+	for(auto it(begin(requests)); it != end(requests); ++it)
+	{
+		futures.emplace_back(it, false);
+		if(it->hedge)
+			futures.emplace_back(it, true);
+		else if(it->future && it->hedge_at != system_point{})
+			until = std::min(until, it->hedge_at);
+	}
+
 	auto next
 	{
-		ctx::when_any(requests.begin(), requests.end(), dereferencer)
+		ctx::when_any(futures.begin(), futures.end(), dereferencer)
 	};
 
 	bool timedout{true};
@@ -292,7 +341,13 @@ ircd::m::fetch::request_handle()
 			lock
 		};
 
-		timedout = !next.wait(seconds(timeout), std::nothrow);
+		// Wake for the next hedge deadline or the timeout.
+		const auto wait
+		{
+			std::max(duration_cast<milliseconds>(until - now), 0ms)
+		};
+
+		timedout = !next.wait(wait, std::nothrow);
 	};
 
 	if(likely(!timedout))
@@ -302,8 +357,8 @@ ircd::m::fetch::request_handle()
 			next.get()
 		};
 
-		if(it != end(requests))
-			if(!request_handle(it))
+		if(it != end(futures) && it->first != end(requests))
+			if(!request_handle(it->first, it->second))
 				return;
 	}
 
@@ -311,7 +366,8 @@ ircd::m::fetch::request_handle()
 }
 
 bool
-ircd::m::fetch::request_handle(const decltype(requests)::iterator &it)
+ircd::m::fetch::request_handle(const decltype(requests)::iterator &it,
+                               const bool &hedge)
 {
 	auto &request
 	{
@@ -319,7 +375,7 @@ ircd::m::fetch::request_handle(const decltype(requests)::iterator &it)
 	};
 
 	if(!request.finished)
-		if(!handle(request))
+		if(!(hedge? handle_hedge(request) : handle(request)))
 			return false;
 
 	requests.erase(it);
@@ -344,6 +400,10 @@ try
 
 		else if(!request.finished && timedout(request, now))
 			retry(request);
+
+		else if(!request.finished && !request.hedge && request.hedge_at != system_point{})
+			if(request.hedge_at <= now)
+				hedge(request);
 	}
 
 	auto it(begin(requests)); while(it != end(requests))
@@ -392,9 +452,9 @@ try
 		request.started = ircd::now<system_point>();
 
 	if(!request.origin)
-		select_random_origin(request);
+		request.origin = select_random_origin(request);
 
-	for(; request.origin; select_random_origin(request))
+	for(; request.origin; request.origin = select_random_origin(request))
 	{
 		if(start(request, request.origin))
 			return true;
@@ -436,57 +496,10 @@ try
 	if(!request.started)
 		request.started = request.last;
 
-	switch(request.opts.op)
-	{
-		case op::noop:
-			break;
-
-		case op::auth:
-		{
-			fed::event_auth::opts opts;
-			opts.remote = remote;
-			request.future = std::make_unique<fed::event_auth>
-			(
-				request.opts.room_id,
-				request.opts.event_id,
-				request.buf,
-				std::move(opts)
-			);
-
-			break;
-		}
-
-		case op::event:
-		{
-			fed::event::opts opts;
-			opts.remote = remote;
-			request.future = std::make_unique<fed::event>
-			(
-				request.opts.event_id,
-				request.buf,
-				std::move(opts)
-			);
-
-			break;
-		}
-
-		case op::backfill:
-		{
-			fed::backfill::opts opts;
-			opts.remote = remote;
-			opts.limit = request.opts.backfill_limit;
-			opts.limit = opts.limit?: size_t(backfill_limit_default);
-			opts.event_id = request.opts.event_id;
-			request.future = std::make_unique<fed::backfill>
-			(
-				request.opts.room_id,
-				request.buf,
-				std::move(opts)
-			);
-
-			break;
-		}
-	}
+	request.future = submit(request, remote, request.buf);
+	request.hedge_at = hedge_enable?
+		request.last + hedge_delay(remote):
+		system_point{};
 
 	log::debug
 	{
@@ -494,7 +507,7 @@ try
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		remote,
 	};
 
 	dock.notify_all();
@@ -516,7 +529,7 @@ catch(const http::error &e)
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		remote,
 		e.what(),
 		e.content,
 	};
@@ -531,7 +544,7 @@ catch(const server::error &e)
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		remote,
 		e.what(),
 	};
 
@@ -545,13 +558,68 @@ catch(const std::exception &e)
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		remote,
 		e.what()
 	};
 
 	return false;
 }
 
+/// Constructs the federation request for the operation to the remote.
+std::unique_ptr<ircd::server::request>
+ircd::m::fetch::submit(request &request,
+                       const string_view &remote,
+                       const mutable_buffer &buf)
+{
+	switch(request.opts.op)
+	{
+		case op::noop:
+			break;
+
+		case op::auth:
+		{
+			fed::event_auth::opts opts;
+			opts.remote = remote;
+			return std::make_unique<fed::event_auth>
+			(
+				request.opts.room_id,
+				request.opts.event_id,
+				buf,
+				std::move(opts)
+			);
+		}
+
+		case op::event:
+		{
+			fed::event::opts opts;
+			opts.remote = remote;
+			return std::make_unique<fed::event>
+			(
+				request.opts.event_id,
+				buf,
+				std::move(opts)
+			);
+		}
+
+		case op::backfill:
+		{
+			fed::backfill::opts opts;
+			opts.remote = remote;
+			opts.limit = request.opts.backfill_limit;
+			opts.limit = opts.limit?: size_t(backfill_limit_default);
+			opts.event_id = request.opts.event_id;
+			return std::make_unique<fed::backfill>
+			(
+				request.opts.room_id,
+				buf,
+				std::move(opts)
+			);
+		}
+	}
+
+	return {};
+}
+
 ircd::string_view
 ircd::m::fetch::select_random_origin(request &request)
 {
@@ -560,13 +628,6 @@ ircd::m::fetch::select_random_origin(request &request)
 		request.opts.room_id
 	};
 
-	// copies randomly selected origin into the attempted set.
-	const auto closure{[&request]
-	(const string_view &origin)
-	{
-		select_origin(request, origin);
-	}};
-
 	// Tests if origin is potentially viable
 	const auto proffer{[&request]
 	(const string_view &origin)
@@ -586,9 +647,30 @@ ircd::m::fetch::select_random_origin(request &request)
 		return true;
 	}};
 
-	request.origin = {};
-	origins.random(closure, proffer);
-	return request.origin;
+	// Weighted reservoir selection over the viable origins in one pass; each
+	// origin replaces the choice with probability weight / total weight so far.
+	uint64_t total(0);
+	std::string choice;
+	origins.for_each([&proffer, &total, &choice]
+	(const string_view &origin)
+	{
+		if(!proffer(origin))
+			return;
+
+		const auto weight
+		{
+			fetch::weight(origin)
+		};
+
+		total += weight;
+		if(rand::integer(1, total) <= weight)
+			choice = origin;
+	});
+
+	// copies selected origin into the attempted set.
+	return !choice.empty()?
+		select_origin(request, choice):
+		string_view{};
 }
 
 ircd::string_view
@@ -600,8 +682,197 @@ ircd::m::fetch::select_origin(request &request,
 		request.attempted.emplace(std::string{origin})
 	};
 
-	request.origin = *iit.first;
-	return request.origin;
+	return *iit.first;
+}
+
+/// Selection weight of a server from what ircd::server has observed: the
+/// smoothed success ratio divided by the smoothed response time. Servers
+/// without any history are given the default hedge delay as their time.
+uint64_t
+ircd::m::fetch::weight(const string_view &origin)
+{
+	const net::hostport hostport
+	{
+		fed::matrix_service(origin)
+	};
+
+	milliseconds rtt
+	{
+		hedge_delay_default
+	};
+
+	double done(0), fail(0);
+	if(server::exists(hostport))
+	{
+		const auto &peer
+		{
+			server::find(hostport)
+		};
+
+		done = peer.tag_done;
+		fail = peer.tag_fail;
+		if(peer.rtt.count())
+			rtt = duration_cast<milliseconds>(peer.rtt);
+	}
+
+	const double ratio
+	{
+		(done + 1.0) / (done + fail + 2.0)
+	};
+
+	const double time
+	(
+		std::max(rtt.count(), 10L)
+	);
+
+	return 1UL + uint64_t(1000000.0 * ratio / time);
+}
+
+/// How long to wait for a response from origin before hedging with another
+/// server; the smoothed response time plus four deviations, as with an RTO.
+ircd::milliseconds
+ircd::m::fetch::hedge_delay(const string_view &origin)
+{
+	const net::hostport hostport
+	{
+		fed::matrix_service(origin)
+	};
+
+	milliseconds ret
+	{
+		hedge_delay_default
+	};
+
+	if(server::exists(hostport))
+	{
+		const auto &peer
+		{
+			server::find(hostport)
+		};
+
+		if(peer.rtt.count())
+			ret = duration_cast<milliseconds>(peer.rtt + 4 * peer.rtt_var);
+	}
+
+	return std::clamp
+	(
+		ret,
+		milliseconds(hedge_delay_min),
+		std::max(milliseconds(hedge_delay_min), duration_cast<milliseconds>(seconds(timeout)))
+	);
+}
+
+/// Starts a second request to another server while the current attempt is
+/// still outstanding.
+bool
+ircd::m::fetch::hedge(request &request)
+try
+{
+	assert(!request.finished);
+	assert(!request.hedge);
+
+	// Whether or not we find a server this is only tried once per attempt.
+	request.hedge_at = system_point{};
+
+	if(request.opts.attempt_limit && request.attempted.size() >= request.opts.attempt_limit)
+		return false;
+
+	const string_view origin
+	{
+		select_random_origin(request)
+	};
+
+	if(!origin)
+		return false;
+
+	if(!request.hedge_buf)
+		request.hedge_buf = unique_buffer<mutable_buffer>
+		{
+			size(request.buf)
+		};
+
+	request.hedge = submit(request, origin, request.hedge_buf);
+	request.hedge_origin = origin;
+	request.hedged = ircd::now<system_point>();
+
+	log::debug
+	{
+		log, "Hedging %s request for %s in %s from '%s' after %ld ms without '%s'",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.hedge_origin},
+		duration_cast<milliseconds>(request.hedged - request.last).count(),
+		string_view{request.origin},
+	};
+
+	dock.notify_all();
+	return true;
+}
+catch(const ctx::interrupted &e)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Hedging %s request for %s in %s :%s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		e.what(),
+	};
+
+	request.hedge.reset(nullptr);
+	request.hedge_origin = {};
+	return false;
+}
+
+/// Exchanges the hedge request with the current attempt.
+void
+ircd::m::fetch::promote(request &request)
+{
+	using std::swap;
+
+	swap(request.future, request.hedge);
+	swap(request.buf, request.hedge_buf);
+	swap(request.origin, request.hedge_origin);
+	swap(request.last, request.hedged);
+}
+
+void
+ircd::m::fetch::cancel_hedge(request &request)
+{
+	if(request.hedge)
+	{
+		server::cancel(*request.hedge);
+		request.hedge.reset(nullptr);
+	}
+
+	request.hedge_origin = {};
+	request.hedged = system_point{};
+}
+
+/// The hedge responded first. If satisfactory it becomes the result and the
+/// original attempt is abandoned; otherwise it is dropped and the original
+/// attempt continues as if nothing happened.
+bool
+ircd::m::fetch::handle_hedge(request &request)
+{
+	assert(request.hedge);
+	promote(request);
+	handle_result(request);
+	if(!request.eptr)
+	{
+		finish(request);
+		return true;
+	}
+
+	request.eptr = std::exception_ptr{};
+	promote(request);
+	cancel_hedge(request);
+	return false;
 }
 
 bool
@@ -677,6 +948,15 @@ try
 
 	request.eptr = std::exception_ptr{};
 	request.origin = {};
+
+	// The hedge already in flight takes over as the current attempt.
+	if(request.hedge)
+	{
+		promote(request);
+		request.hedge_at = system_point{};
+		return;
+	}
+
 	start(request);
 }
 catch(...)
@@ -689,6 +969,7 @@ void
 ircd::m::fetch::finish(request &request)
 {
 	request.finished = ircd::now<system_point>();
+	cancel_hedge(request);
 
 	#if 0
 	log::logf
@@ -855,7 +1136,18 @@ void
 ircd::m::fetch::_check_event(const request &request,
                              const m::event &event)
 {
-	if(check_event_id && !m::check_id(event))
+	// The canonical preimage is computed once for all of the checks below.
+	const unique_mutable_buffer preimage_buf
+	{
+		m::event::preimage::buffer_size(event)
+	};
+
+	const m::event::preimage preimage
+	{
+		preimage_buf, event
+	};
+
+	if(check_event_id && !m::check_id(event, preimage))
 	{
 		event::id::buf buf;
 		const m::event &claim
@@ -876,7 +1168,7 @@ ircd::m::fetch::_check_event(const request &request,
 		thread_local char buf[128];
 		const m::event::conforms conforms
 		{
-			event
+			event, preimage
 		};
 
 		const string_view failures
@@ -923,7 +1215,7 @@ ircd::m::fetch::_check_event(const request &request,
 			};
 
 		if(m::keys::cache::has(server, key_id))
-			if(!verify(event, server))
+			if(!verify(event, preimage, server))
 				throw ircd::error
 				{
 					"Signature verification failed."
@@ -1046,5 +1338,6 @@ ircd::m::fetch::request::~request()
 noexcept
 {
 	//TODO: bad things unless this first here
+	hedge.reset(nullptr);
 	future.reset(nullptr);
 }
@@ -270,6 +270,9 @@ ircd::m::homeserver::homeserver(const struct opts *const &opts)
 	if(primary == this)
 		mods::imports.emplace("net_dns_cache"s, "net_dns_cache"s);
 
+	if(primary == this)
+		m::init::mitsein::init();
+
 	if(primary == this)
 		m::init::backfill::init();
 }
@@ -284,6 +287,7 @@ noexcept
 		server::init::close();           //TODO: XXX
 		client::close_all();             //TODO: XXX
 		m::init::backfill::fini();
+		m::init::mitsein::fini();
 		client::wait_all();              //TODO: XXX
 		server::init::wait();            //TODO: XXX
 		m::sync::pool.join();
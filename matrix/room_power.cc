@@ -8,6 +8,237 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+/// Decoded power_levels content. The content is copied here and the views in
+/// the hashed collections point into that copy.
+struct ircd::m::room::power::table
+{
+	using levels = std::unordered_map<string_view, int64_t>;
+
+	std::string content;
+	levels users;
+	levels events;
+	int64_t users_default {default_user_level};
+	int64_t events_default {default_event_level};
+	int64_t state_default {default_power_level};
+
+	table(const json::object &content);
+	table(const table &) = delete;
+};
+
+namespace ircd::m
+{
+	using power_table_ptr = std::shared_ptr<const room::power::table>;
+
+	static int64_t power_table_level(const json::object &, const string_view &, const int64_t &);
+	static void power_table_decode(room::power::table::levels &, const json::object &);
+	static power_table_ptr power_table(const event::idx &, const json::object &);
+	static power_table_ptr power_table(const event::idx &);
+	static void power_table_clear(const m::event &, vm::eval &);
+
+	extern conf::item<size_t> power_cache_max;
+	extern conf::item<size_t> power_cache_min;
+	extern stats::item power_cache_hits;
+	extern stats::item power_cache_misses;
+	extern std::unordered_map<event::idx, power_table_ptr> power_cache;
+	extern hookfn<vm::eval &> power_cache_redact;
+}
+
+decltype(ircd::m::power_cache_max)
+ircd::m::power_cache_max
+{
+	{ "name",     "ircd.m.room.power.cache.max" },
+	{ "default",  4096L                         },
+};
+
+/// Minimum size of power_levels content given directly by event (rather
+/// than by event::idx) for the cache to be used; smaller content is faster
+/// to scan than to resolve the event::idx for.
+decltype(ircd::m::power_cache_min)
+ircd::m::power_cache_min
+{
+	{ "name",     "ircd.m.room.power.cache.min" },
+	{ "default",  long(4_KiB)                   },
+};
+
+decltype(ircd::m::power_cache_hits)
+ircd::m::power_cache_hits
+{
+	{ "name", "ircd.m.room.power.cache.hits" },
+};
+
+decltype(ircd::m::power_cache_misses)
+ircd::m::power_cache_misses
+{
+	{ "name", "ircd.m.room.power.cache.misses" },
+};
+
+decltype(ircd::m::power_cache)
+ircd::m::power_cache;
+
+/// Redaction changes the content of a power_levels event while its
+/// event::idx remains the same.
+decltype(ircd::m::power_cache_redact)
+ircd::m::power_cache_redact
+{
+	{
+		{ "_site",  "vm.effect"         },
+		{ "type",   "m.room.redaction"  },
+	},
+	power_table_clear
+};
+
+void
+ircd::m::power_table_clear(const m::event &event,
+                           vm::eval &)
+{
+	if(power_cache.empty())
+		return;
+
+	const auto &redacts
+	{
+		json::get<"redacts"_>(event)
+	};
+
+	if(!valid(m::id::EVENT, redacts))
+		return;
+
+	const auto event_idx
+	{
+		m::index(std::nothrow, m::event::id(redacts))
+	};
+
+	power_cache.erase(event_idx);
+}
+
+ircd::m::power_table_ptr
+ircd::m::power_table(const event::idx &event_idx)
+{
+	const auto it
+	{
+		power_cache.find(event_idx)
+	};
+
+	if(it != end(power_cache))
+	{
+		++power_cache_hits;
+		return it->second;
+	}
+
+	power_table_ptr ret;
+	m::get(std::nothrow, event_idx, "content", [&event_idx, &ret]
+	(const json::object &content)
+	{
+		ret = power_table(event_idx, content);
+	});
+
+	return ret;
+}
+
+ircd::m::power_table_ptr
+ircd::m::power_table(const event::idx &event_idx,
+                     const json::object &content)
+{
+	auto it
+	{
+		power_cache.find(event_idx)
+	};
+
+	if(it != end(power_cache))
+	{
+		++power_cache_hits;
+		return it->second;
+	}
+
+	++power_cache_misses;
+	if(!event_idx || empty(content))
+		return {};
+
+	// The entries are immutable, so an arbitrary one is evicted; any users
+	// of it hold their own reference.
+	if(power_cache.size() >= size_t(power_cache_max) && !power_cache.empty())
+		power_cache.erase(begin(power_cache));
+
+	auto ptr
+	{
+		std::make_shared<const room::power::table>(content)
+	};
+
+	it = power_cache.emplace(event_idx, std::move(ptr)).first;
+	return it->second;
+}
+
+void
+ircd::m::power_table_decode(room::power::table::levels &levels,
+                            const json::object &collection)
+{
+	const string_view &_collection{collection};
+	if(!_collection || json::type(_collection) != json::OBJECT)
+		return;
+
+	for(const auto &member : collection)
+	{
+		const string_view &value
+		{
+			member.second
+		};
+
+		// Quoted levels are rejected here as they are by get<int64_t>().
+		if(json::type(value) != json::NUMBER || !lex_castable<int64_t>(value))
+			continue;
+
+		const json::string &key
+		{
+			member.first
+		};
+
+		levels.emplace(key, lex_cast<int64_t>(value));
+	}
+}
+
+int64_t
+ircd::m::power_table_level(const json::object &content,
+                           const string_view &prop,
+                           const int64_t &default_)
+try
+{
+	return content.get<int64_t>(prop, default_);
+}
+catch(const std::exception &e)
+{
+	return default_;
+}
+
+//
+// room::power::table
+//
+
+ircd::m::room::power::table::table(const json::object &content)
+:content
+{
+	content
+}
+,users_default
+{
+	power_table_level(this->content, "users_default", default_user_level)
+}
+,events_default
+{
+	power_table_level(this->content, "events_default", default_event_level)
+}
+,state_default
+{
+	power_table_level(this->content, "state_default", default_power_level)
+}
+{
+	const json::object object
+	{
+		this->content
+	};
+
+	power_table_decode(users, object.get("users"));
+	power_table_decode(events, object.get("events"));
+}
+
 decltype(ircd::m::room::power::default_creator_level)
 ircd::m::room::power::default_creator_level
 {
@@ -168,6 +399,12 @@ ircd::m::room::power::power(const m::room &room,
 {
 	power_event_idx
 }
+,cache
+{
+	power_event_idx?
+		power_table(power_event_idx):
+		nullptr
+}
 {
 }
 
@@ -187,6 +424,16 @@ ircd::m::room::power::power(const m::event &power_event,
 	json::get<"content"_>(power_event), room_creator_id
 }
 {
+	if(!power_event.event_id || size(power_event_content) < size_t(power_cache_min))
+		return;
+
+	const auto event_idx
+	{
+		m::index(std::nothrow, power_event)
+	};
+
+	if(event_idx)
+		cache = power_table(event_idx, power_event_content);
 }
 
 ircd::m::room::power::power(const json::object &power_event_content,
@@ -242,6 +489,14 @@ int64_t
 ircd::m::room::power::level_user(const m::user::id &user_id)
 const try
 {
+	if(cache)
+	{
+		const auto it(cache->users.find(user_id));
+		return it != end(cache->users)?
+			it->second:
+			cache->users_default;
+	}
+
 	int64_t ret
 	{
 		default_user_level
@@ -288,6 +543,14 @@ int64_t
 ircd::m::room::power::level_event(const string_view &type)
 const try
 {
+	if(cache)
+	{
+		const auto it(cache->events.find(type));
+		return it != end(cache->events)?
+			it->second:
+			cache->events_default;
+	}
+
 	int64_t ret
 	{
 		default_event_level
@@ -329,6 +592,14 @@ const try
 	if(!defined(state_key))
 		return level_event(type);
 
+	if(cache)
+	{
+		const auto it(cache->events.find(type));
+		return it != end(cache->events)?
+			it->second:
+			cache->state_default;
+	}
+
 	int64_t ret
 	{
 		default_power_level
@@ -431,6 +702,9 @@ bool
 ircd::m::room::power::has_event(const string_view &type)
 const try
 {
+	if(cache)
+		return cache->events.count(type);
+
 	bool ret{false};
 	view([&type, &ret]
 	(const json::object &content)
@@ -459,6 +733,9 @@ bool
 ircd::m::room::power::has_user(const m::user::id &user_id)
 const try
 {
+	if(cache)
+		return cache->users.count(user_id);
+
 	bool ret{false};
 	view([&user_id, &ret]
 	(const json::object &content)
@@ -590,6 +867,12 @@ bool
 ircd::m::room::power::view(const std::function<void (const json::object &)> &closure)
 const
 {
+	if(cache)
+	{
+		closure(json::object{cache->content});
+		return true;
+	}
+
 	if(power_event_idx)
 		if(m::get(std::nothrow, power_event_idx, "content", closure))
 			return true;
@@ -71,6 +71,18 @@ ircd::m::rooms::has(const opts &opts)
 size_t
 ircd::m::rooms::count(const opts &opts)
 {
+	const bool indexed
+	{
+		opts.summary
+		&& !opts.room_id && !opts.room_alias && !opts.user_id
+		&& !opts.search_term && !opts.since && !opts.join_rule
+		&& !opts.local_only && !opts.remote_only
+		&& !opts.local_joined_only && !opts.remote_joined_only
+	};
+
+	if(indexed)
+		return rooms::summary::index::count(opts.server);
+
 	size_t ret{0};
 	for_each(opts, [&ret]
 	(const m::room::id &)
@@ -91,10 +103,21 @@ ircd::m::rooms::for_each(const room::id::closure_bool &closure)
 bool
 ircd::m::rooms::for_each(const opts &opts,
                          const room::id::closure_bool &closure)
+{
+	return for_each(opts, origin_closure_bool{[&closure]
+	(const room::id &room_id, const string_view &origin)
+	{
+		return closure(room_id);
+	}});
+}
+
+bool
+ircd::m::rooms::for_each(const opts &opts,
+                         const origin_closure_bool &closure)
 {
 	bool ret{true};
 	const auto proffer{[&opts, &closure, &ret]
-	(const m::room::id &room_id)
+	(const m::room::id &room_id, const string_view &origin = {})
 	{
 		if(opts.room_id && !opts.lower_bound)
 		{
@@ -131,11 +154,12 @@ ircd::m::rooms::for_each(const opts &opts,
 			if(opts.server != room_id.host())
 				return;
 
+		// The directory index applies the join_rule of the summary.
 		if(opts.join_rule && !opts.summary)
 			if(!join_rule(room, opts.join_rule))
 				return;
 
-		if(opts.room_alias)
+		if(opts.room_alias && !opts.summary)
 		{
 			const auto match_alias_prefix{[&opts](const auto &alias)
 			{
@@ -146,7 +170,7 @@ ircd::m::rooms::for_each(const opts &opts,
 				return; // no match
 		}
 
-		ret = closure(room);
+		ret = closure(room, origin);
 	}};
 
 	// branch for public rooms of a specific user
@@ -165,31 +189,14 @@ ircd::m::rooms::for_each(const opts &opts,
 		}});
 	}
 
-	// branch for optimized public rooms searches.
+	// branch for optimized public rooms searches; the directory index
+	// applies the server, join_rule, alias and search filters.
 	if(opts.summary)
 	{
-		const room::id::buf public_room_id
-		{
-			"!public", my_host()
-		};
-
-		const room::state state
-		{
-			public_room_id
-		};
-
-		state.for_each("ircd.rooms.summary", [&opts, &proffer, &ret]
-		(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+		rooms::summary::index::for_each(opts, [&proffer, &ret]
+		(const room::id &room_id, const string_view &origin)
 		{
-			const auto &[room_id, origin]
-			{
-				rooms::summary::unmake_state_key(state_key)
-			};
-
-			if(opts.server && origin != opts.server)
-				return true;
-
-			proffer(room_id);
+			proffer(room_id, origin);
 			return ret;
 		});
 
@@ -202,7 +209,12 @@ ircd::m::rooms::for_each(const opts &opts,
 	(const string_view &type, const event::idx &event_idx)
 	{
 		++fetch;
-		fetched += m::get(std::nothrow, event_idx, "room_id", proffer);
+		fetched += m::get(std::nothrow, event_idx, "room_id", [&proffer]
+		(const string_view &room_id)
+		{
+			proffer(room_id);
+		});
+
 		dock.notify_one();
 		return ret;
 	}};
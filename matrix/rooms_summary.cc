@@ -334,6 +334,543 @@ ircd::m::rooms::summary::make_state_key(const mutable_buffer &buf,
 	};
 }
 
+//
+// rooms::summary::index
+//
+
+namespace ircd::m::rooms::summary::index
+{
+	struct entry;
+	struct position;
+
+	template<class closure> static void tokenize(const string_view &, closure&&);
+	static void set(const string_view &state_key, const json::object &summary, const event::idx &);
+	static void del(const string_view &state_key, const event::idx &);
+	static position parse_cursor(const string_view &);
+	static void build();
+
+	extern std::map<std::string, entry, std::less<>> entries;
+	extern std::set<position> ordered;
+	extern std::map<std::string, std::set<string_view>, std::less<>> terms;
+	extern std::map<std::string, size_t, std::less<>> origins;
+	extern std::map<std::string, event::idx, std::less<>> removed;
+	extern ctx::mutex mutex;
+	extern bool built;
+
+	static decltype(entries)::iterator find(const room::id &, const string_view &origin);
+
+	extern hookfn<vm::eval &> hook_set;
+	extern hookfn<vm::eval &> hook_del;
+}
+
+struct ircd::m::rooms::summary::index::entry
+{
+	event::idx event_idx {0};     // summary event this was made from
+	long members {0};
+	std::string join_rule;
+	std::vector<std::string> aliases;
+	std::vector<std::string> tokens;
+};
+
+/// Sort key of the ordered index. The state_key refers to the key of the
+/// entries map, or to a caller's copy when seeking.
+struct ircd::m::rooms::summary::index::position
+{
+	long members {0};
+	string_view state_key;
+
+	friend bool operator<(const position &a, const position &b) noexcept
+	{
+		return a.members != b.members?
+			a.members > b.members:
+			a.state_key < b.state_key;
+	}
+};
+
+decltype(ircd::m::rooms::summary::index::entries)
+ircd::m::rooms::summary::index::entries;
+
+decltype(ircd::m::rooms::summary::index::ordered)
+ircd::m::rooms::summary::index::ordered;
+
+decltype(ircd::m::rooms::summary::index::terms)
+ircd::m::rooms::summary::index::terms;
+
+decltype(ircd::m::rooms::summary::index::origins)
+ircd::m::rooms::summary::index::origins;
+
+/// Entries deleted by hooks while the index is being built, so the build
+/// doesn't restore them from the state it read before yielding.
+decltype(ircd::m::rooms::summary::index::removed)
+ircd::m::rooms::summary::index::removed;
+
+decltype(ircd::m::rooms::summary::index::mutex)
+ircd::m::rooms::summary::index::mutex;
+
+decltype(ircd::m::rooms::summary::index::built)
+ircd::m::rooms::summary::index::built;
+
+decltype(ircd::m::rooms::summary::index::hook_set)
+ircd::m::rooms::summary::index::hook_set
+{
+	{
+		{ "_site",       "vm.effect"           },
+		{ "room_id",     "!public"             },
+		{ "type",        "ircd.rooms.summary"  },
+	},
+	[](const m::event &event, m::vm::eval &eval)
+	{
+		set(at<"state_key"_>(event), json::get<"content"_>(event), vm::sequence::get(eval));
+	}
+};
+
+/// Summaries are delisted by redaction; see summary::del().
+decltype(ircd::m::rooms::summary::index::hook_del)
+ircd::m::rooms::summary::index::hook_del
+{
+	{
+		{ "_site",       "vm.effect"         },
+		{ "room_id",     "!public"           },
+		{ "type",        "m.room.redaction"  },
+	},
+	[](const m::event &event, m::vm::eval &eval)
+	{
+		const auto event_idx
+		{
+			m::index(std::nothrow, json::get<"redacts"_>(event))
+		};
+
+		bool summary {false};
+		m::get(std::nothrow, event_idx, "type", [&summary](const string_view &type)
+		{
+			summary = type == "ircd.rooms.summary";
+		});
+
+		if(!summary)
+			return;
+
+		m::get(std::nothrow, event_idx, "state_key", [&eval](const string_view &state_key)
+		{
+			del(state_key, vm::sequence::get(eval));
+		});
+	}
+};
+
+size_t
+ircd::m::rooms::summary::index::count(const string_view &origin)
+{
+	build();
+	if(!origin)
+		return entries.size();
+
+	const auto it
+	{
+		origins.find(origin)
+	};
+
+	return it != end(origins)? it->second : 0UL;
+}
+
+bool
+ircd::m::rooms::summary::index::for_each(const rooms::opts &opts,
+                                         const closure &closure)
+{
+	build();
+
+	// Each search term narrows the candidates to the entries having a token
+	// with that prefix.
+	bool searching {false};
+	std::set<string_view> candidates;
+	tokenize(opts.search_term, [&searching, &candidates]
+	(const string_view &term)
+	{
+		std::set<string_view> matches;
+		for(auto it(terms.lower_bound(term)); it != end(terms) && startswith(it->first, term); ++it)
+			for(const auto &state_key : it->second)
+				if(!searching || candidates.count(state_key))
+					matches.emplace(state_key);
+
+		candidates = std::move(matches);
+		searching = true;
+	});
+
+	if(searching && candidates.empty())
+		return true;
+
+	const auto match{[&opts](const position &pos, const entry &entry)
+	{
+		const auto &[room_id, origin]
+		{
+			unmake_state_key(pos.state_key)
+		};
+
+		if(opts.server && origin != opts.server)
+			return false;
+
+		if(opts.join_rule && entry.join_rule != opts.join_rule)
+			return false;
+
+		if(opts.room_alias)
+			if(std::none_of(begin(entry.aliases), end(entry.aliases), [&opts]
+			(const auto &alias)
+			{
+				return startswith(alias, opts.room_alias);
+			}))
+				return false;
+
+		return true;
+	}};
+
+	// The closure may yield and the index may change; each step copies the
+	// position out and seeks past it again rather than holding an iterator.
+	const position start
+	{
+		opts.since?
+			parse_cursor(opts.since):
+			position{}
+	};
+
+	std::string state_key;
+	position last {start.members, start.state_key};
+	if(searching)
+	{
+		std::vector<std::pair<long, std::string>> results;
+		results.reserve(candidates.size());
+		for(const auto &state_key : candidates)
+		{
+			const auto &entry
+			{
+				entries.find(state_key)->second
+			};
+
+			const position pos{entry.members, state_key};
+			if((!opts.since || last < pos) && match(pos, entry))
+				results.emplace_back(pos.members, state_key);
+		}
+
+		std::sort(begin(results), end(results), []
+		(const auto &a, const auto &b)
+		{
+			return position{a.first, a.second} < position{b.first, b.second};
+		});
+
+		for(const auto &[members, state_key] : results)
+		{
+			if(!entries.count(state_key))
+				continue;
+
+			const auto &[room_id, origin]
+			{
+				unmake_state_key(state_key)
+			};
+
+			if(!closure(room_id, origin))
+				return false;
+		}
+
+		return true;
+	}
+
+	auto it
+	{
+		opts.since?
+			ordered.upper_bound(last):
+			begin(ordered)
+	};
+
+	for(; it != end(ordered); it = ordered.upper_bound(last))
+	{
+		const auto &entry
+		{
+			entries.find(it->state_key)->second
+		};
+
+		state_key = it->state_key;
+		last = position{it->members, state_key};
+		if(!match(last, entry))
+			continue;
+
+		const auto &[room_id, origin]
+		{
+			unmake_state_key(state_key)
+		};
+
+		if(!closure(room_id, origin))
+			return false;
+	}
+
+	return true;
+}
+
+ircd::string_view
+ircd::m::rooms::summary::index::cursor(const mutable_buffer &buf,
+                                       const room::id &room_id,
+                                       const string_view &origin)
+{
+	const auto it
+	{
+		find(room_id, origin)
+	};
+
+	if(it == end(entries))
+		return {};
+
+	return fmt::sprintf
+	{
+		buf, "%ld.%s",
+		it->second.members,
+		string_view{it->first},
+	};
+}
+
+ircd::m::rooms::summary::index::position
+ircd::m::rooms::summary::index::parse_cursor(const string_view &cursor)
+try
+{
+	const auto &[members, state_key]
+	{
+		split(cursor, '.')
+	};
+
+	return position
+	{
+		lex_cast<long>(members), state_key
+	};
+}
+catch(const bad_lex_cast &)
+{
+	throw m::BAD_REQUEST
+	{
+		"Invalid since token for this server."
+	};
+}
+
+/// Finds the entry for the room from the origin, or from any origin when
+/// none is given.
+decltype(ircd::m::rooms::summary::index::entries)::iterator
+ircd::m::rooms::summary::index::find(const room::id &room_id,
+                                     const string_view &origin)
+{
+	char state_key_buf[event::STATE_KEY_MAX_SIZE];
+	const auto state_key
+	{
+		make_state_key(state_key_buf, room_id, origin)
+	};
+
+	const auto it
+	{
+		entries.lower_bound(state_key)
+	};
+
+	if(it == end(entries))
+		return it;
+
+	if(origin && it->first != state_key)
+		return end(entries);
+
+	if(!origin && unmake_state_key(it->first).first != room_id)
+		return end(entries);
+
+	return it;
+}
+
+/// Index the summary from event_idx, unless the entry was already set or
+/// deleted by a later event; the build may yield between reading the state
+/// and the content while the hooks apply newer summaries.
+void
+ircd::m::rooms::summary::index::set(const string_view &state_key,
+                                    const json::object &summary,
+                                    const event::idx &event_idx)
+{
+	const auto existing
+	{
+		entries.find(state_key)
+	};
+
+	if(existing != end(entries) && existing->second.event_idx > event_idx)
+		return;
+
+	const auto deleted
+	{
+		removed.find(state_key)
+	};
+
+	if(deleted != end(removed) && deleted->second > event_idx)
+		return;
+
+	del(state_key, event_idx);
+
+	// Redacted summaries have no content.
+	if(empty(summary))
+		return;
+
+	entry entry;
+	entry.event_idx = event_idx;
+	entry.members = summary.get<long>("num_joined_members", 0L);
+
+	// Summaries without a join_rule predate it; the directory only lists
+	// public rooms.
+	const json::string &join_rule
+	{
+		summary["join_rule"]
+	};
+
+	entry.join_rule = join_rule? std::string(join_rule) : std::string("public");
+
+	const json::string &canonical_alias
+	{
+		summary["canonical_alias"]
+	};
+
+	if(canonical_alias)
+		entry.aliases.emplace_back(canonical_alias);
+
+	for(const json::string alias : json::array(summary["aliases"]))
+		entry.aliases.emplace_back(alias);
+
+	const auto add_tokens{[&entry](const string_view &text)
+	{
+		tokenize(text, [&entry](const string_view &token)
+		{
+			entry.tokens.emplace_back(token);
+		});
+	}};
+
+	add_tokens(json::string(summary["name"]));
+	add_tokens(json::string(summary["topic"]));
+	for(const auto &alias : entry.aliases)
+		add_tokens(alias);
+
+	std::sort(begin(entry.tokens), end(entry.tokens));
+	entry.tokens.erase(std::unique(begin(entry.tokens), end(entry.tokens)), end(entry.tokens));
+
+	const auto it
+	{
+		entries.emplace(std::string(state_key), std::move(entry)).first
+	};
+
+	const string_view key(it->first);
+	ordered.emplace(position{it->second.members, key});
+	for(const auto &token : it->second.tokens)
+		terms[token].emplace(key);
+
+	++origins[std::string(unmake_state_key(key).second)];
+}
+
+void
+ircd::m::rooms::summary::index::del(const string_view &state_key,
+                                    const event::idx &event_idx)
+{
+	if(!built)
+		removed[std::string(state_key)] = event_idx;
+
+	const auto it
+	{
+		entries.find(state_key)
+	};
+
+	if(it == end(entries))
+		return;
+
+	const string_view key(it->first);
+	ordered.erase(position{it->second.members, key});
+	for(const auto &token : it->second.tokens)
+	{
+		const auto tit(terms.find(token));
+		if(tit == end(terms))
+			continue;
+
+		tit->second.erase(key);
+		if(tit->second.empty())
+			terms.erase(tit);
+	}
+
+	const auto oit(origins.find(unmake_state_key(key).second));
+	if(oit != end(origins) && !--oit->second)
+		origins.erase(oit);
+
+	entries.erase(it);
+}
+
+/// Initial population from the public rooms room; this is the only full
+/// scan. Hooks maintain the index from then on, including while this runs.
+void
+ircd::m::rooms::summary::index::build()
+{
+	if(likely(built))
+		return;
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	if(built)
+		return;
+
+	const m::room::id::buf public_room_id
+	{
+		"public", my_host()
+	};
+
+	const m::room::state state
+	{
+		public_room_id
+	};
+
+	state.for_each("ircd.rooms.summary", []
+	(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+	{
+		m::get(std::nothrow, event_idx, "content", [&state_key, &event_idx]
+		(const json::object &content)
+		{
+			set(state_key, content, event_idx);
+		});
+
+		return true;
+	});
+
+	built = true;
+	removed.clear();
+	log::info
+	{
+		log, "Public rooms directory indexed %zu summaries from %zu servers; %zu terms.",
+		entries.size(),
+		origins.size(),
+		terms.size(),
+	};
+}
+
+/// Words are maximal runs of alphanumerics or non-ASCII bytes, lowercased.
+template<class closure>
+void
+ircd::m::rooms::summary::index::tokenize(const string_view &text,
+                                         closure&& c)
+{
+	char buf[256];
+	size_t len(0);
+	for(size_t i(0); i <= size(text); ++i)
+	{
+		const uint8_t ch
+		{
+			i < size(text)? uint8_t(text[i]) : uint8_t(0)
+		};
+
+		if(ch && (std::isalnum(ch) || ch >= 0x80))
+		{
+			if(len < sizeof(buf))
+				buf[len++] = std::tolower(ch);
+
+			continue;
+		}
+
+		if(len)
+			c(string_view{buf, len});
+
+		len = 0;
+	}
+}
+
 //
 // internal
 //
@@ -472,6 +1009,15 @@ ircd::m::rooms::summary::chunk_local(const m::room &room,
 		};
 	});
 
+	query("m.room.join_rules", "join_rule", [&obj]
+	(const string_view &value)
+	{
+		json::stack::member
+		{
+			obj, "join_rule", value
+		};
+	});
+
 	query("m.room.history_visibility", "history_visibility", [&obj]
 	(const string_view &value)
 	{
@@ -103,6 +103,72 @@ ircd::m::sync::for_each(const string_view &prefix,
 	return true;
 }
 
+//
+// data
+//
+
+ircd::m::sync::data::data(const data &parent,
+                          json::stack &out)
+:range
+{
+	parent.range
+}
+,phased
+{
+	parent.phased
+}
+,client
+{
+	parent.client
+}
+,args
+{
+	parent.args
+}
+,user
+{
+	parent.user
+}
+,user_room
+{
+	parent.user
+}
+,user_state
+{
+	user_room
+}
+,user_rooms
+{
+	parent.user
+}
+,filter_buf
+{
+	parent.filter_buf
+}
+,filter
+{
+	json::object{filter_buf}
+}
+,device_id
+{
+	parent.device_id
+}
+,out
+{
+	&out
+}
+,membership
+{
+	parent.membership
+}
+{
+}
+
+ircd::m::sync::data::~data()
+noexcept
+{
+}
+
 bool
 ircd::m::sync::apropos(const data &d,
                        const event &event)
@@ -8,6 +8,119 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using mitsein_closure = std::function<bool (const string_view &other, const string_view &room_id)>;
+
+	static bool mitsein_indexed(const user::id &, const string_view &membership);
+	static bool mitsein_for_each(const user::id &, const string_view &other, const bool &unique, const mitsein_closure &);
+}
+
+/// The index only has our users and the rooms they're joined to, and is
+/// used for a user once it was built for them.
+bool
+ircd::m::mitsein_indexed(const user::id &user_id,
+                         const string_view &membership)
+{
+	return membership == "join" && my(user_id) && dbs::user_mitsein_built(user_id);
+}
+
+/// Iterates the user_mitsein entries of user_id starting at other, which
+/// is "@" for the users or "" for the servers; otherwise only the entries of
+/// that other user or server are iterated. With unique, only the first room
+/// for each other user or server is presented, and the remainder are skipped
+/// with a seek when there are many.
+bool
+ircd::m::mitsein_for_each(const user::id &user_id,
+                          const string_view &other,
+                          const bool &unique,
+                          const mitsein_closure &closure)
+{
+	db::domain &index
+	{
+		dbs::user_mitsein
+	};
+
+	const bool server
+	{
+		!startswith(other, '@')
+	};
+
+	const bool exact
+	{
+		other != "@" && !empty(other)
+	};
+
+	char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+	auto it
+	{
+		index.begin(dbs::user_mitsein_key(keybuf, user_id, other))
+	};
+
+	size_t repeat{0};
+	string_view last;
+	char lastbuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+	while(bool(it))
+	{
+		const auto &[key_other, room_id]
+		{
+			dbs::user_mitsein_key(it->first)
+		};
+
+		// The server entries are sorted before the user entries.
+		if(server != !startswith(key_other, '@'))
+			break;
+
+		// The marker of a built index sorts first among the servers.
+		if(empty(key_other))
+		{
+			++it;
+			continue;
+		}
+
+		if(exact && key_other != other)
+			break;
+
+		if(!unique || key_other != last)
+		{
+			if(!closure(key_other, room_id))
+				return false;
+
+			last = { lastbuf, copy(lastbuf, key_other) };
+			repeat = 0;
+			++it;
+			continue;
+		}
+
+		// Same as room::origins::for_each(); past this threshold the rest of
+		// the rooms shared with the last user or server are skipped by
+		// seeking just past their keys.
+		static const size_t repeat_threshold
+		{
+			6
+		};
+
+		if(repeat++ > repeat_threshold)
+		{
+			assert(!last.empty());
+			const auto key
+			{
+				dbs::user_mitsein_key(keybuf, user_id, last)
+			};
+
+			assert(size(key) < sizeof(keybuf));
+			keybuf[size(key)] = '\x01';
+			seek(it, string_view{data(key), size(key) + 1});
+			repeat = 0;
+			continue;
+		}
+
+		++it;
+	}
+
+	return true;
+}
+
 bool
 ircd::m::user::mitsein::has(const m::user &other,
                             const string_view &membership)
@@ -63,16 +176,34 @@ ircd::m::user::mitsein::for_each(const string_view &membership,
                                  const closure_bool &closure)
 const
 {
+	if(mitsein_indexed(user, membership))
+		return mitsein_for_each(user, "@", true, [&closure]
+		(const string_view &other, const string_view &room_id)
+		{
+			return closure(m::user{other});
+		});
+
 	const m::user::rooms rooms
 	{
 		user
 	};
 
 	// here we gooooooo :/
-	///TODO: ideal: db schema
-	///TODO: minimally: custom alloc?
-	std::set<std::string, std::less<>> seen;
-	return rooms.for_each(membership, rooms::closure_bool{[&membership, &closure, &seen]
+	// The set and the strings in it are taken from the arena of the request
+	// or eval on this context when there is one, otherwise one of our own.
+	std::optional<allocator::arena> local;
+	allocator::arena *const arena
+	{
+		ctx::this_ctx::arena()?: &local.emplace()
+	};
+
+	using arena_allocator = allocator::arena::allocator<string_view>;
+	std::set<string_view, std::less<>, arena_allocator> seen
+	{
+		arena_allocator{*arena}
+	};
+
+	return rooms.for_each(membership, rooms::closure_bool{[&membership, &closure, &seen, arena]
 	(m::room room, const string_view &)
 	{
 		static const event::fetch::opts fopts
@@ -86,7 +217,7 @@ const
 			room
 		};
 
-		return members.for_each(membership, [&seen, &closure]
+		return members.for_each(membership, [&seen, &closure, arena]
 		(const user::id &other)
 		{
 			const auto it
@@ -97,7 +228,12 @@ const
 			if(it != end(seen) && *it == other)
 				return true;
 
-			seen.emplace_hint(it, std::string{other});
+			const mutable_buffer buf
+			{
+				reinterpret_cast<char *>(arena->allocate(size(other), 1)), size(other)
+			};
+
+			seen.emplace_hint(it, data(buf), copy(buf, other));
 			return closure(m::user{other});
 		});
 	}});
@@ -117,6 +253,20 @@ ircd::m::user::mitsein::for_each(const m::user &user,
                                  const rooms::closure_bool &closure)
 const
 {
+	if(mitsein_indexed(this->user, membership) || mitsein_indexed(user, membership))
+	{
+		const bool ours
+		{
+			mitsein_indexed(this->user, membership)
+		};
+
+		return mitsein_for_each(ours? this->user : user, ours? user.user_id : this->user.user_id, false, [&closure, &membership]
+		(const string_view &other, const string_view &room_id)
+		{
+			return closure(m::room{room::id{room_id}}, membership);
+		});
+	}
+
 	const m::user::rooms our_rooms{this->user};
 	const m::user::rooms their_rooms{user};
 	const bool use_our
@@ -143,3 +293,354 @@ const
 		return closure(room, membership);
 	}});
 }
+
+//
+// mitsein::rebuild
+//
+
+namespace ircd::m
+{
+	using mitsein_fill = std::function<void (db::txn &)>;
+
+	static size_t mitsein_commit(const mitsein_fill &);
+	static bool mitsein_supported(const user::id &, const string_view &other, const room::id &);
+}
+
+/// Fill a txn from the present rooms and commit it so that it can't overwrite
+/// a later write of the indexer: it is only committed when no eval entered
+/// its write phase while it was filled, and then before this ctx yields, so
+/// any write that follows is ordered after it. Returns the size of the txn.
+size_t
+ircd::m::mitsein_commit(const mitsein_fill &fill)
+{
+	static const size_t attempts_max
+	{
+		64
+	};
+
+	for(size_t i(0); i < attempts_max; ++i)
+	{
+		vm::sequence::dock.wait_for(milliseconds(500), []
+		{
+			return vm::sequence::committed <= vm::sequence::retired;
+		});
+
+		const auto committed
+		{
+			vm::sequence::committed
+		};
+
+		if(committed > vm::sequence::retired)
+			continue;
+
+		db::txn txn
+		{
+			*dbs::events
+		};
+
+		fill(txn);
+		if(vm::sequence::committed != committed)
+			continue;
+
+		const auto ret
+		{
+			txn.size()
+		};
+
+		txn();
+		return ret;
+	}
+
+	throw m::UNAVAILABLE
+	{
+		"Mitsein rebuild abandoned after %zu attempts to commit between writes.",
+		attempts_max,
+	};
+}
+
+/// Whether an entry of our user is supported by room_joined.
+bool
+ircd::m::mitsein_supported(const user::id &user_id,
+                           const string_view &other,
+                           const room::id &room_id)
+{
+	char keybuf[dbs::ROOM_JOINED_KEY_MAX_SIZE];
+	if(!db::has(dbs::room_joined, dbs::room_joined_key(keybuf, room_id, user_id.host(), user_id)))
+		return false;
+
+	if(startswith(other, '@'))
+		return db::has(dbs::room_joined, dbs::room_joined_key(keybuf, room_id, user::id(other).host(), other));
+
+	// The members of an origin start at origin + "@"; other origins with
+	// the same prefix sort on either side.
+	const auto prefix
+	{
+		dbs::room_joined_key(keybuf, room_id, other)
+	};
+
+	assert(size(prefix) < sizeof(keybuf));
+	keybuf[size(prefix)] = '@';
+	auto it
+	{
+		dbs::room_joined.begin(string_view{data(prefix), size(prefix) + 1})
+	};
+
+	return bool(it) && std::get<0>(dbs::room_joined_key(it->first)) == other;
+}
+
+/// Entries are set for each joined room of the user in a txn of its own, then
+/// the entries no longer supported are deleted in batches, and finally the
+/// marker is set. Each txn is committed between the writes of evals.
+ircd::m::user::mitsein::rebuild::rebuild(const m::user &user)
+{
+	if(!my(user))
+		throw m::UNSUPPORTED
+	{
+		"The user_mitsein index only has local users."
+	};
+
+	size_t added(0);
+	const m::user::rooms rooms
+	{
+		user
+	};
+
+	rooms.for_each("join", rooms::closure_bool{[&user, &added]
+	(const m::room &room, const string_view &)
+	{
+		added += mitsein_commit([&user, &room](db::txn &txn)
+		{
+			const auto append{[&txn, &user, &room]
+			(const string_view &other)
+			{
+				char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+				db::txn::append
+				{
+					txn, dbs::user_mitsein,
+					{
+						db::op::SET, dbs::user_mitsein_key(keybuf, user, other, room.room_id)
+					}
+				};
+			}};
+
+			string_view last;
+			char lastbuf[rfc1035::NAME_BUFSIZE];
+			for(auto it(dbs::room_joined.begin(room.room_id)); bool(it); ++it)
+			{
+				const auto &[origin, member]
+				{
+					dbs::room_joined_key(it->first)
+				};
+
+				append(member);
+				if(origin == last)
+					continue;
+
+				append(origin);
+				last = { lastbuf, copy(lastbuf, origin) };
+			}
+		});
+
+		return true;
+	}});
+
+	static const size_t batch_max
+	{
+		256
+	};
+
+	// Iteration resumes after the last entry of the previous batch; keys are
+	// the remainder after the user's prefix, as the iterator presents them.
+	size_t deleted(0);
+	std::string last;
+	for(bool done(false); !done;)
+	{
+		std::string next;
+		deleted += mitsein_commit([&user, &last, &next, &done](db::txn &txn)
+		{
+			char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+			const auto key{[&keybuf, &user](const string_view &rest)
+			{
+				mutable_buffer out{keybuf};
+				consume(out, copy(out, user.user_id));
+				consume(out, copy(out, rest));
+				return string_view{keybuf, data(out)};
+			}};
+
+			auto it
+			{
+				last.empty()?
+					dbs::user_mitsein.begin(user.user_id):
+					dbs::user_mitsein.begin(key(last))
+			};
+
+			size_t i(0);
+			next = last;
+			for(done = true; bool(it); ++it)
+			{
+				if(it->first == last)
+					continue;
+
+				if(i++ >= batch_max)
+				{
+					done = false;
+					break;
+				}
+
+				next = it->first;
+				const auto &[other, room_id]
+				{
+					dbs::user_mitsein_key(it->first)
+				};
+
+				// The marker; it's set again below.
+				if(empty(other))
+					continue;
+
+				if(mitsein_supported(user, other, room::id(room_id)))
+					continue;
+
+				db::txn::append
+				{
+					txn, dbs::user_mitsein,
+					{
+						db::op::DELETE, key(it->first)
+					}
+				};
+			}
+		});
+
+		last = std::move(next);
+	}
+
+	mitsein_commit([&user](db::txn &txn)
+	{
+		char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		db::txn::append
+		{
+			txn, dbs::user_mitsein,
+			{
+				db::op::SET, dbs::user_mitsein_key(keybuf, user, string_view{})
+			}
+		};
+	});
+
+	log::info
+	{
+		log, "Mitsein of %s rebuild complete set:%zu del:%zu",
+		string_view{user.user_id},
+		added,
+		deleted,
+	};
+}
+
+//
+// init::mitsein
+//
+
+namespace ircd::m::init::mitsein
+{
+	static void worker();
+
+	extern std::unique_ptr<context> worker_context;
+}
+
+decltype(ircd::m::init::mitsein::worker_context)
+ircd::m::init::mitsein::worker_context;
+
+/// Databases from before the user_mitsein index have no entries for our
+/// users; each is rebuilt once in the background, and their queries iterate
+/// the rooms until then.
+void
+ircd::m::init::mitsein::init()
+{
+	if(ircd::read_only || ircd::write_avoid)
+		return;
+
+	assert(!worker_context);
+	worker_context.reset(new context
+	{
+		"m.init.mitsein",
+		256_KiB,
+		&worker,
+		context::POST
+	});
+}
+
+void
+ircd::m::init::mitsein::fini()
+noexcept
+{
+	worker_context.reset(nullptr);
+}
+
+void
+ircd::m::init::mitsein::worker()
+try
+{
+	run::barrier<ctx::interrupted>{};
+
+	ionice(ctx::cur(), 4);
+	nice(ctx::cur(), 4);
+
+	size_t count(0);
+	m::users::opts opts;
+	opts.hostpart = my_host();
+	m::users::for_each(opts, [&count](const m::user &user)
+	{
+		ctx::interruption_point();
+		if(dbs::user_mitsein_built(user))
+			return true;
+
+		// A user left unbuilt is served by iterating and is tried again on
+		// the next start.
+		try
+		{
+			user::mitsein::rebuild
+			{
+				user
+			};
+
+			++count;
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "Mitsein index build for %s :%s",
+				string_view{user.user_id},
+				e.what(),
+			};
+		}
+
+		return true;
+	});
+
+	if(count)
+		log::notice
+		{
+			log, "Built the mitsein index for %zu users.",
+			count,
+		};
+}
+catch(const ctx::interrupted &e)
+{
+	log::derror
+	{
+		log, "Mitsein index build interrupted; it resumes on the next start."
+	};
+
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Mitsein index build :%s",
+		e.what(),
+	};
+}
@@ -8,6 +8,80 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using unread_counts = std::pair<long, long>;
+
+	static unread_counts unread_decode(const string_view &value);
+	static void unread_clear(const m::event &, vm::eval &);
+
+	extern ctx::mutex unread_mutex;
+	extern hookfn<vm::eval &> unread_clear_hook;
+}
+
+/// Serializes the read-modify-write of counts; two rooms' events notifying
+/// the same user concurrently would otherwise lose an increment.
+decltype(ircd::m::unread_mutex)
+ircd::m::unread_mutex;
+
+/// A read receipt resets the counts for the room.
+decltype(ircd::m::unread_clear_hook)
+ircd::m::unread_clear_hook
+{
+	{
+		{ "_site",  "vm.effect"  },
+		{ "type",   "ircd.read"  },
+	},
+	unread_clear
+};
+
+void
+ircd::m::unread_clear(const m::event &event,
+                      vm::eval &)
+{
+	const auto &state_key
+	{
+		json::get<"state_key"_>(event)
+	};
+
+	if(!valid(m::id::ROOM, state_key))
+		return;
+
+	const m::user::id &user_id
+	{
+		json::get<"sender"_>(event)
+	};
+
+	if(!my(user_id))
+		return;
+
+	char buf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+	const auto key
+	{
+		dbs::user_unread_key(buf, user_id, room::id{state_key})
+	};
+
+	const std::lock_guard lock
+	{
+		unread_mutex
+	};
+
+	db::del(dbs::user_unread, key);
+}
+
+ircd::m::unread_counts
+ircd::m::unread_decode(const string_view &value)
+{
+	if(unlikely(size(value) != 16))
+		return {0L, 0L};
+
+	return
+	{
+		int64_t(byte_view<int64_t>(value.substr(0, 8))),
+		int64_t(byte_view<int64_t>(value.substr(8, 8))),
+	};
+}
+
 decltype(ircd::m::user::notifications::type_prefix)
 ircd::m::user::notifications::type_prefix
 {
@@ -151,3 +225,57 @@ const
 
 	return true;
 }
+
+std::pair<long, long>
+ircd::m::user::notifications::unread(const room::id &room_id)
+const
+{
+	char buf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+	const auto key
+	{
+		dbs::user_unread_key(buf, user.user_id, room_id)
+	};
+
+	unread_counts ret {0L, 0L};
+	dbs::user_unread(key, std::nothrow, [&ret]
+	(const string_view &value)
+	{
+		ret = unread_decode(value);
+	});
+
+	return ret;
+}
+
+/// Counts an event notifying the user in the room.
+void
+ircd::m::user::notifications::notified(const room::id &room_id,
+                                       const bool &highlight)
+const
+{
+	char buf[dbs::USER_UNREAD_KEY_MAX_SIZE];
+	const auto key
+	{
+		dbs::user_unread_key(buf, user.user_id, room_id)
+	};
+
+	const std::lock_guard lock
+	{
+		unread_mutex
+	};
+
+	const auto counts
+	{
+		unread(room_id)
+	};
+
+	const int64_t value[2]
+	{
+		counts.first + 1,
+		counts.second + highlight,
+	};
+
+	db::write(dbs::user_unread, key, const_buffer
+	{
+		reinterpret_cast<const char *>(value), sizeof(value)
+	});
+}
@@ -14,11 +14,11 @@ ircd::m::user::servers::has(const string_view &server,
 const
 {
 	// Return true if broken out of loop.
-	return !for_each(membership, []
-	(const auto &server)
+	return !for_each(membership, [&server]
+	(const auto &origin)
 	{
-		// Break out of loop at first shared room
-		return false;
+		// Break out of loop at the server
+		return origin != server;
 	});
 }
 
@@ -49,6 +49,55 @@ ircd::m::user::servers::for_each(const string_view &membership,
                                  const closure_bool &closure)
 const
 {
+	// The servers of our users' joined rooms are indexed; see user::mitsein.
+	if(membership == "join" && my(user) && dbs::user_mitsein_built(user))
+	{
+		db::domain &index
+		{
+			dbs::user_mitsein
+		};
+
+		char keybuf[dbs::USER_MITSEIN_KEY_MAX_SIZE];
+		auto it
+		{
+			index.begin(dbs::user_mitsein_key(keybuf, user, string_view{}))
+		};
+
+		// One seek past the entries of each server, which has one entry for
+		// each room shared.
+		while(bool(it))
+		{
+			const auto &[origin, room_id]
+			{
+				dbs::user_mitsein_key(it->first)
+			};
+
+			if(startswith(origin, '@'))
+				break;
+
+			// The marker of a built index sorts first.
+			if(empty(origin))
+			{
+				++it;
+				continue;
+			}
+
+			if(!closure(origin))
+				return false;
+
+			const auto key
+			{
+				dbs::user_mitsein_key(keybuf, user, origin)
+			};
+
+			assert(size(key) < sizeof(keybuf));
+			keybuf[size(key)] = '\x01';
+			seek(it, string_view{data(key), size(key) + 1});
+		}
+
+		return true;
+	}
+
 	const m::user::rooms rooms
 	{
 		user
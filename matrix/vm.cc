@@ -26,6 +26,35 @@ ircd::m::vm::default_copts;
 decltype(ircd::m::vm::default_opts)
 ircd::m::vm::default_opts;
 
+namespace ircd::m::vm::sequence
+{
+	static void refresh_worker();
+	static bool refresh();
+
+	extern conf::item<milliseconds> refresh_interval;
+	extern hook::site<> refresh_hook;
+	extern std::unique_ptr<context> refresh_context;
+}
+
+decltype(ircd::m::vm::sequence::refresh_interval)
+ircd::m::vm::sequence::refresh_interval
+{
+	{ "name",     "ircd.m.vm.sequence.refresh.interval" },
+	{ "default",  250L                                  },
+};
+
+/// Called with the latest event after a secondary instance catches up with
+/// its primary; the vm.notify site is not used because nothing was evaluated
+/// here and the federation sender must not act on it.
+decltype(ircd::m::vm::sequence::refresh_hook)
+ircd::m::vm::sequence::refresh_hook
+{
+	{ "name", "vm.refresh" }
+};
+
+decltype(ircd::m::vm::sequence::refresh_context)
+ircd::m::vm::sequence::refresh_context;
+
 //
 // init
 //
@@ -40,6 +69,15 @@ ircd::m::vm::init::init()
 	vm::ready = true;
 	vm::dock.notify_all();
 
+	if(m::dbs::events && m::dbs::events->secondary)
+		sequence::refresh_context.reset(new context
+		{
+			"m.vm.refresh",
+			256_KiB,
+			&sequence::refresh_worker,
+			context::POST
+		});
+
 	log::info
 	{
 		log, "BOOT %s @%lu [%s] db:%lu",
@@ -56,6 +94,7 @@ ircd::m::vm::init::~init()
 noexcept
 {
 	vm::ready = false;
+	sequence::refresh_context.reset(nullptr);
 
 	if(!eval::list.empty())
 		log::warning
@@ -253,6 +292,77 @@ ircd::m::vm::sequence::get(const eval &eval)
 	return eval.sequence;
 }
 
+/// Secondary instances have no evals writing to the database; the sequence
+/// is instead advanced by periodically catching up with the primary.
+void
+ircd::m::vm::sequence::refresh_worker()
+{
+	// Wait for runlevel RUN before proceeding...
+	run::barrier<ctx::interrupted>{};
+
+	while(1) try
+	{
+		ctx::sleep(milliseconds(refresh_interval));
+		if(!refresh())
+			continue;
+
+		const m::event::fetch event
+		{
+			std::nothrow, retired
+		};
+
+		if(event.valid)
+			refresh_hook(event);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Secondary refresh @%lu :%s",
+			retired,
+			e.what(),
+		};
+	}
+}
+
+bool
+ircd::m::vm::sequence::refresh()
+{
+	bool ret(false);
+	for(auto *const &database : db::database::list)
+		ret |= db::refresh(*database);
+
+	if(!ret)
+		return false;
+
+	id::event::buf event_id;
+	const auto sequence
+	{
+		get(event_id)
+	};
+
+	if(sequence <= retired)
+		return false;
+
+	log::debug
+	{
+		log, "Secondary refreshed %lu -> %lu [%s]",
+		retired,
+		sequence,
+		string_view{event_id},
+	};
+
+	retired = sequence;
+	committed = sequence;
+	uncommitted = sequence;
+	dock.notify_all();
+	return true;
+}
+
 //
 // copts (creation options)
 //
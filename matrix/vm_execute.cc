@@ -13,6 +13,7 @@ namespace ircd::m::vm
 	template<class... args> static fault handle_error(const opts &, const fault &, const string_view &fmt, args&&... a);
 	template<class T> static void call_hook(hook::site<T> &, eval &, const event &, T&& data);
 	static size_t calc_txn_reserve(const opts &, const event &);
+	static bool make_preimage(event::preimage &, unique_mutable_buffer &, const event &);
 	static void write_commit(eval &);
 	static void write_append(eval &, const event &);
 	static void write_prepare(eval &, const event &);
@@ -128,6 +129,18 @@ try
 		eval::executing
 	};
 
+	// Allocations made on behalf of this event by subsystems which opt in
+	// are taken from the eval's arena and released when it's done.
+	const unwind reset_arena{[&eval]
+	{
+		eval.arena.reset();
+	}};
+
+	const ctx::scope_arena scope_arena
+	{
+		eval.arena
+	};
+
 	const scope_notify notify
 	{
 		vm::dock
@@ -480,6 +493,21 @@ ircd::m::vm::execute_pdu(eval &eval,
 		opts.auth && !eval.room_internal
 	};
 
+	// The canonical preimage is computed once here and shared by the
+	// event_id check in the conform hook and the signature verification.
+	unique_mutable_buffer preimage_buf;
+	event::preimage preimage;
+	const bool preimaged
+	{
+		((opts.conform && !opts.conformed) || opts.verify) &&
+		make_preimage(preimage, preimage_buf, event)
+	};
+
+	const scope_restore eval_preimage
+	{
+		eval.preimage, preimaged? &preimage: nullptr
+	};
+
 	// The conform hook runs static checks on an event's formatting and
 	// composure; these checks only require the event data itself.
 	if(likely(opts.conform))
@@ -517,7 +545,7 @@ ircd::m::vm::execute_pdu(eval &eval,
 	if(likely(opts.access))
 		call_hook(access_hook, eval, event, eval);
 
-	if(likely(opts.verify) && !verify(event))
+	if(likely(opts.verify) && !(preimaged? verify(event, preimage): verify(event)))
 		throw m::BAD_SIGNATURE
 		{
 			"Signature verification failed"
@@ -748,6 +776,7 @@ ircd::m::vm::write_append(eval &eval,
 
 			wopts.appendix.set(dbs::appendix::ROOM_STATE, pass);
 			wopts.appendix.set(dbs::appendix::ROOM_JOINED, pass);
+			wopts.appendix.set(dbs::appendix::USER_MITSEIN, pass);
 		}
 	}
 
@@ -808,6 +837,43 @@ ircd::m::vm::calc_txn_reserve(const opts &opts,
 	return reserve_event + opts.reserve_index;
 }
 
+/// Computes the canonical preimage of the event into a buffer sized for it.
+/// An event too malformed to reduce returns false, leaving the individual
+/// checks to report the problem as they otherwise would.
+bool
+ircd::m::vm::make_preimage(event::preimage &preimage,
+                           unique_mutable_buffer &buf,
+                           const event &event)
+try
+{
+	buf = unique_mutable_buffer
+	{
+		event::preimage::buffer_size(event)
+	};
+
+	preimage = event::preimage
+	{
+		buf, event
+	};
+
+	return true;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Failed to compute preimage of %s :%s",
+		string_view{event.event_id},
+		e.what(),
+	};
+
+	return false;
+}
+
 template<class T>
 void
 ircd::m::vm::call_hook(hook::site<T> &hook,
@@ -52,7 +52,7 @@ resource::response
 get__publicrooms(client &client,
                  const resource::request &request)
 {
-	char since_buf[m::room::id::buf::SIZE];
+	char since_buf[m::event::STATE_KEY_MAX_SIZE + 32];
 	const string_view &since
 	{
 		request.has("since")?
@@ -60,12 +60,6 @@ get__publicrooms(client &client,
 			url::decode(since_buf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
-		throw m::BAD_REQUEST
-		{
-			"Invalid since token for this server."
-		};
-
 	char server_buf[256];
 	string_view server
 	{
@@ -128,8 +122,7 @@ get__publicrooms(client &client,
 	opts.join_rule = "public";
 	opts.summary = true;
 	opts.search_term = search_term;
-	opts.lower_bound = true;
-	opts.room_id = since;
+	opts.since = since;
 
 	if(m::valid(m::id::USER, search_term))
 		opts.user_id = search_term;
@@ -160,27 +153,29 @@ get__publicrooms(client &client,
 	};
 
 	size_t count{0};
-	m::room::id::buf prev_batch_buf;
-	m::room::id::buf next_batch_buf;
+	char prev_batch_buf[m::event::STATE_KEY_MAX_SIZE + 32];
+	char next_batch_buf[m::event::STATE_KEY_MAX_SIZE + 32];
+	string_view prev_batch, next_batch;
 	json::stack::object top{out};
 	{
 		json::stack::member chunk_m{top, "chunk"};
 		json::stack::array chunk{chunk_m};
-		m::rooms::for_each(opts, [&](const m::room::id &room_id)
+		m::rooms::for_each(opts, m::rooms::origin_closure_bool{[&]
+		(const m::room::id &room_id, const string_view &origin)
 		{
 			json::stack::object obj{chunk};
 			m::rooms::summary::get(obj, room_id);
 			if(!count && !empty(since))
-				prev_batch_buf = room_id; //TODO: ???
+				prev_batch = m::rooms::summary::index::cursor(prev_batch_buf, room_id, origin);
 
-			next_batch_buf = room_id;
+			next_batch = m::rooms::summary::index::cursor(next_batch_buf, room_id, origin);
 			return ++count < limit;
-		});
+		}});
 	}
 
 	// To count the total we clear the since token, otherwise the count
 	// will be the remainder.
-	opts.room_id = {};
+	opts.since = {};
 	json::stack::member
 	{
 		top, "total_room_count_estimate", json::value
@@ -189,16 +184,16 @@ get__publicrooms(client &client,
 		}
 	};
 
-	if(prev_batch_buf)
+	if(prev_batch)
 		json::stack::member
 		{
-			top, "prev_batch", prev_batch_buf
+			top, "prev_batch", prev_batch
 		};
 
-	if(count >= limit)
+	if(count >= limit && next_batch)
 		json::stack::member
 		{
-			top, "next_batch", next_batch_buf
+			top, "next_batch", next_batch
 		};
 
 	return std::move(response);
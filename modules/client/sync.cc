@@ -765,9 +765,11 @@ namespace ircd::m::sync::longpoll
 	static bool polled(data &, const args &);
 	static int poll(data &);
 	static void handle_notify(const m::event &, m::vm::eval &);
+	static void handle_refresh(const m::event &);
 	static void fini() noexcept;
 
 	extern m::hookfn<m::vm::eval &> notified;
+	extern m::hookfn<> refreshed;
 	extern ctx::dock dock;
 }
 
@@ -783,6 +785,15 @@ ircd::m::sync::longpoll::notified
 	}
 };
 
+decltype(ircd::m::sync::longpoll::refreshed)
+ircd::m::sync::longpoll::refreshed
+{
+	handle_refresh,
+	{
+		{ "_site",  "vm.refresh" },
+	}
+};
+
 void
 ircd::m::sync::longpoll::fini()
 noexcept
@@ -822,6 +833,13 @@ catch(const std::exception &e)
 	};
 }
 
+/// Secondary instances are notified after catching up with the primary.
+void
+ircd::m::sync::longpoll::handle_refresh(const m::event &event)
+{
+	dock.notify_all();
+}
+
 /// Longpolling blocks the client's request until a relevant event is processed
 /// by the m::vm. If no event is processed by a timeout this returns false.
 bool
@@ -1157,8 +1175,3 @@ ircd::m::sync::data::data(const m::user &user,
 }
 {
 }
-
-ircd::m::sync::data::~data()
-noexcept
-{
-}
@@ -10,22 +10,101 @@
 
 namespace ircd::m::sync
 {
+	struct polylog_room;
+
 	static bool should_ignore(const data &);
 
+	static bool _rooms_polylog_room_items(data &, const m::room &);
 	static bool _rooms_polylog_room(data &, const m::room &);
+	static void _rooms_polylog_concurrent_room(data &, polylog_room &, size_t &buffered);
+	static bool _rooms_polylog_concurrent(data &, const string_view &membership);
 	static bool _rooms_polylog(data &, const string_view &membership, int64_t &phase);
 	static bool rooms_polylog(data &);
 
 	static bool _rooms_linear(data &, const string_view &membership);
 	static bool rooms_linear(data &);
 
+	extern conf::item<size_t> polylog_concurrency;
+	extern conf::item<size_t> polylog_buffer_size;
+	extern conf::item<size_t> polylog_budget;
+	extern const ctx::pool::opts polylog_pool_opts;
+	extern ctx::pool polylog_pool;
 	extern item rooms;
 }
 
+/// A room of a polylog composed concurrently with others. Its JSON object is
+/// kept here until the rooms before it have been spliced into the response.
+struct ircd::m::sync::polylog_room
+{
+	m::room::id::buf room_id;
+	std::string out;
+	std::exception_ptr eptr;
+	ctx::ctx *worker {nullptr};
+	bool ret {false};
+	bool done {false};
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
-	"Client Sync :Rooms"
+	"Client Sync :Rooms", nullptr, []
+	{
+		ircd::m::sync::polylog_pool.join();
+	}
+};
+
+decltype(ircd::m::sync::polylog_concurrency)
+ircd::m::sync::polylog_concurrency
+{
+	{ "name",     "ircd.client.sync.rooms.polylog.concurrency" },
+	{ "default",  8L                                           },
+	{ "description",
+
+	R"(
+	Number of rooms composed at the same time for a polylog sync which is not
+	phased. Each is composed to its own buffer and spliced into the response
+	in order. The rooms after the one being spliced are composed ahead of it
+	as far as this and the polylog.budget allow. 1 composes one room at a time.
+	When every context of the pool is busy the sync composes its next room
+	itself rather than queueing it.
+	)"}
+};
+
+decltype(ircd::m::sync::polylog_buffer_size)
+ircd::m::sync::polylog_buffer_size
+{
+	{ "name",     "ircd.client.sync.rooms.polylog.buffer_size" },
+	{ "default",  long(256_KiB)                                },
+};
+
+decltype(ircd::m::sync::polylog_budget)
+ircd::m::sync::polylog_budget
+{
+	{ "name",     "ircd.client.sync.rooms.polylog.budget" },
+	{ "default",  long(16_MiB)                            },
+	{ "description",
+
+	R"(
+	Bytes of rooms composed ahead of the response for one sync, counting the
+	output of the rooms being composed as it's produced and the buffer of
+	each. Past this no more rooms are started until the earlier ones have
+	been spliced.
+	)"}
+};
+
+/// The rooms are composed on their own pool because their items submit work
+/// to sync::pool and wait for it; sharing that pool could exhaust it with
+/// waiting rooms.
+decltype(ircd::m::sync::polylog_pool_opts)
+ircd::m::sync::polylog_pool_opts
+{
+	ctx::DEFAULT_STACK_SIZE, 0, -1, -1
+};
+
+decltype(ircd::m::sync::polylog_pool)
+ircd::m::sync::polylog_pool
+{
+	"m.sync.rooms", polylog_pool_opts
 };
 
 decltype(ircd::m::sync::rooms)
@@ -153,6 +232,9 @@ ircd::m::sync::_rooms_polylog(data &data,
 		*data.out, membership
 	};
 
+	if(!data.phased && size_t(polylog_concurrency) > 1)
+		return _rooms_polylog_concurrent(data, membership);
+
 	bool ret{false};
 	const user::rooms::closure_bool closure{[&data, &ret, &phase]
 	(const m::room &room, const string_view &membership_)
@@ -228,6 +310,23 @@ ircd::m::sync::_rooms_polylog_room(data &data,
 		*data.out, room.room_id
 	};
 
+	const bool ret
+	{
+		_rooms_polylog_room_items(data, room)
+	};
+
+	if(!ret)
+		checkpoint.committing(false);
+
+	return ret;
+}
+
+/// Composes the items of the room into the object presently open on the
+/// data's json::stack.
+bool
+ircd::m::sync::_rooms_polylog_room_items(data &data,
+                                         const m::room &room)
+{
 	const auto &[top_event_id, top_depth, top_event_idx]
 	{
 		m::top(std::nothrow, room)
@@ -267,12 +366,209 @@ ircd::m::sync::_rooms_polylog_room(data &data,
 		return true;
 	});
 
-	if(!ret)
-		checkpoint.committing(false);
+	return ret;
+}
+
+bool
+ircd::m::sync::_rooms_polylog_concurrent(data &data,
+                                         const string_view &membership)
+{
+	const size_t concurrency
+	{
+		polylog_concurrency
+	};
+
+	polylog_pool.min(concurrency);
+
+	ctx::dock dock;
+	bool canceled(false);
+	size_t buffered(0), running(0);
+	std::deque<polylog_room> rooms;
+
+	// When this unwinds early the rooms still composing are interrupted and
+	// awaited, as they refer to this frame; those not yet started won't be.
+	const unwind join{[&dock, &rooms, &running, &canceled]
+	{
+		const ctx::uninterruptible::nothrow ui;
+		canceled = true;
+		for(auto &room : rooms)
+			if(room.worker)
+				ctx::interrupt(*room.worker);
+
+		dock.wait([&running]
+		{
+			return !running;
+		});
+	}};
+
+	bool ret{false};
+	const auto splice{[&data, &rooms, &buffered, &ret]
+	{
+		auto &room(rooms.front());
+		assert(room.done);
+		if(room.eptr)
+			std::rethrow_exception(room.eptr);
+
+		if(room.ret)
+		{
+			json::stack::member member
+			{
+				*data.out, room.room_id
+			};
+
+			member.splice(room.out);
+			data.out->invalidate_checkpoints();
+			ret = true;
+		}
+
+		assert(buffered >= size(room.out));
+		buffered -= size(room.out);
+		rooms.pop_front();
+	}};
+
+	const auto wait{[&dock, &rooms, &buffered, &concurrency]
+	(const bool &all)
+	{
+		const bool block
+		{
+			all ||
+			rooms.size() >= concurrency ||
+			buffered >= size_t(polylog_budget)
+		};
+
+		if(!block || rooms.empty())
+			return false;
+
+		dock.wait([&rooms]
+		{
+			return rooms.front().done;
+		});
+
+		return true;
+	}};
+
+	data.user_rooms.for_each(membership, user::rooms::closure_bool{[&]
+	(const m::room &room, const string_view &)
+	{
+		while(!rooms.empty() && rooms.front().done)
+			splice();
+
+		while(wait(false))
+			while(!rooms.empty() && rooms.front().done)
+				splice();
+
+		auto &slot
+		{
+			rooms.emplace_back()
+		};
+
+		slot.room_id = room.room_id;
+
+		// The room's buffer counts against the budget while it's composed.
+		buffered += size_t(polylog_buffer_size);
+		const auto compose{[&data, &dock, &slot, &running, &buffered, &canceled]
+		{
+			const unwind done{[&dock, &slot, &running, &buffered]
+			{
+				buffered -= size_t(polylog_buffer_size);
+				slot.worker = nullptr;
+				slot.done = true;
+				--running;
+				dock.notify_all();
+			}};
+
+			if(canceled)
+				return;
+
+			slot.worker = ctx::current; try
+			{
+				_rooms_polylog_concurrent_room(data, slot, buffered);
+			}
+			catch(...)
+			{
+				slot.eptr = std::current_exception();
+			}
+		}};
+
+		// When no context of the pool is free the room would only wait in
+		// its queue behind the rooms of other syncs; this one composes it
+		// instead. Its exceptions propagate from the splice as for the rest.
+		++running;
+		if(polylog_pool.avail() <= polylog_pool.queued())
+		{
+			compose();
+			return true;
+		}
+
+		polylog_pool(compose);
+		return true;
+	}});
+
+	while(wait(true))
+		while(!rooms.empty() && rooms.front().done)
+			splice();
 
 	return ret;
 }
 
+/// Composes the room into the slot. The output is counted into buffered as
+/// it's flushed out of the stack buffer.
+void
+ircd::m::sync::_rooms_polylog_concurrent_room(data &parent,
+                                              polylog_room &slot,
+                                              size_t &buffered)
+{
+	const unique_mutable_buffer buf
+	{
+		polylog_buffer_size
+	};
+
+	json::stack out
+	{
+		buf, [&slot, &buffered](const const_buffer &buf)
+		{
+			slot.out.append(string_view{buf});
+			buffered += size(buf);
+			return buf;
+		}
+	};
+
+	sync::data data
+	{
+		parent, out
+	};
+
+	const m::room room
+	{
+		slot.room_id
+	};
+
+	const scope_restore theirs
+	{
+		data.room, &room
+	};
+
+	if(should_ignore(data))
+		return;
+
+	{
+		json::stack::object object
+		{
+			out
+		};
+
+		slot.ret = _rooms_polylog_room_items(data, room);
+	}
+
+	out.flush(true);
+	if(slot.ret)
+		return;
+
+	assert(buffered >= size(slot.out));
+	buffered -= size(slot.out);
+	slot.out.clear();
+}
+
 bool
 ircd::m::sync::should_ignore(const data &data)
 {
@@ -10,8 +10,6 @@
 
 namespace ircd::m::sync
 {
-	static long _notification_count(const room &, const event::idx &a, const event::idx &b);
-	static long _highlight_count(const room &, const user &u, const event::idx &a, const event::idx &b);
 	static bool room_unread_notifications_polylog(data &);
 	static bool room_unread_notifications_linear(data &);
 
@@ -107,15 +105,6 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 		if(!m::receipt::get(last_read, room.room_id, data.user))
 			return false;
 
-	const auto start_idx
-	{
-		last_read?
-			index(last_read):
-		!is_self_read?
-			index(room):
-			0UL
-	};
-
 	json::stack::object rooms
 	{
 		*data.out, "rooms"
@@ -136,16 +125,11 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 		*data.out, "unread_notifications"
 	};
 
-	const event::idx upper_bound
+	const auto &[notification_count, highlight_count]
 	{
-		std::max(data.range.second, data.event_idx + 1)
-	};
-
-	const auto notification_count
-	{
-		start_idx && !is_self_read?
-			_notification_count(room, start_idx, upper_bound):
-			0L
+		!is_self_read?
+			user::notifications{data.user}.unread(room.room_id):
+			std::pair<long, long>{0L, 0L}
 	};
 
 	json::stack::member
@@ -160,9 +144,7 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, upper_bound):
-				0L
+			highlight_count
 		}
 	};
 
@@ -199,9 +181,9 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 	if(!apropos(data, start_idx))
 		return false;
 
-	const auto notification_count
+	const auto &[notification_count, highlight_count]
 	{
-		_notification_count(room, start_idx, data.range.second)
+		user::notifications{data.user}.unread(room.room_id)
 	};
 
 	json::stack::member
@@ -216,53 +198,9 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, data.range.second):
-				0L
+			highlight_count
 		}
 	};
 
 	return true;
 }
-
-long
-ircd::m::sync::_notification_count(const room &room,
-                                   const event::idx &a,
-                                   const event::idx &b)
-{
-	const event::idx_range range
-	{
-		std::minmax(a, b)
-	};
-
-	return room::events::count(room, range);
-}
-
-long
-ircd::m::sync::_highlight_count(const room &room,
-                                const user &user,
-                                const event::idx &a,
-                                const event::idx &b)
-{
-	const event::idx_range range
-	{
-		std::minmax(a, b)
-	};
-
-	const user::notifications notifications
-	{
-		user
-	};
-
-	user::notifications::opts opts;
-	opts.room_id = room.room_id;
-	opts.only = "highlight";
-	opts.from = range.second;
-	opts.to = range.first;
-	const auto ret
-	{
-		notifications.count(opts)
-	};
-
-	return ret;
-}
@@ -2339,6 +2339,169 @@ console_cmd__ctx__prof(opt &out, const string_view &line)
 	return true;
 }
 
+static ctx::prof::counter
+_ctx_prof_counter(const string_view &name)
+{
+	for(size_t i(0); i < num_of<ctx::prof::counter>(); ++i)
+		if(iequals(name, reflect(ctx::prof::counter(i))))
+			return ctx::prof::counter(i);
+
+	throw error
+	{
+		"Unknown counter '%s'", name
+	};
+}
+
+bool
+console_cmd__ctx__prof__tree(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"prefix",
+	}};
+
+	const auto prefix
+	{
+		param["prefix"]
+	};
+
+	out << std::right
+	    << std::setw(10) << "SLICES" << " "
+	    << std::setw(16) << "TSC" << " "
+	    << std::setw(16) << "CYCLES" << " "
+	    << std::setw(16) << "INSTRUCTIONS" << " "
+	    << std::setw(12) << "CACHE MISS" << " "
+	    << std::setw(5) << "IPC" << " "
+	    << std::left
+	    << ":PATH"
+	    << std::endl;
+
+	ctx::prof::node::root.for_each([&out, &prefix]
+	(const ctx::prof::node &node)
+	{
+		char buf[1024];
+		const auto path
+		{
+			ctx::prof::path(buf, node)
+		};
+
+		if(prefix && !startswith(path, prefix))
+			return true;
+
+		const auto &c(node.count);
+		const auto &cyc(c[size_t(ctx::prof::counter::CYCLES)]);
+		const auto &ins(c[size_t(ctx::prof::counter::INSTRUCTIONS)]);
+		out << std::right
+		    << std::setw(10) << c[size_t(ctx::prof::counter::SLICES)] << " "
+		    << std::setw(16) << c[size_t(ctx::prof::counter::TSC)] << " "
+		    << std::setw(16) << cyc << " "
+		    << std::setw(16) << ins << " "
+		    << std::setw(12) << c[size_t(ctx::prof::counter::CACHE_MISSES)] << " "
+		    << std::setw(5) << std::fixed << std::setprecision(2)
+		    << (cyc? double(ins) / double(cyc) : 0.0) << " "
+		    << std::left
+		    << path
+		    << std::endl;
+
+		return true;
+	});
+
+	return true;
+}
+
+/// Output in the folded-stack format consumed by flamegraph.pl. Each node
+/// reports only its own (exclusive) count; children are not included.
+bool
+console_cmd__ctx__prof__folded(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"counter", "filename",
+	}};
+
+	const auto counter
+	{
+		_ctx_prof_counter(param["counter"]? param["counter"] : "TSC"_sv)
+	};
+
+	const auto filename
+	{
+		param["filename"]
+	};
+
+	std::stringstream folded;
+	ctx::prof::node::root.for_each([&folded, &counter]
+	(const ctx::prof::node &node)
+	{
+		const auto &val
+		{
+			node.count[size_t(counter)]
+		};
+
+		if(!val)
+			return true;
+
+		char buf[1024];
+		folded << ctx::prof::path(buf, node) << ' ' << val << '\n';
+		return true;
+	});
+
+	if(!filename)
+	{
+		out << folded.str();
+		return true;
+	}
+
+	const fs::fd file
+	{
+		filename, std::ios::out | std::ios::trunc
+	};
+
+	const auto str
+	{
+		folded.str()
+	};
+
+	fs::write(file, const_buffer{str});
+	out << "Wrote " << size(str) << " bytes to " << filename << std::endl;
+	return true;
+}
+
+bool
+console_cmd__ctx__ole(opt &out, const string_view &line)
+{
+	out << std::left << std::setw(32) << "NAME"
+	    << " " << std::right << std::setw(10) << "BATCHES"
+	    << " " << std::right << std::setw(10) << "TASKS"
+	    << " " << std::right << std::setw(8) << "ERRORS"
+	    << " " << std::right << std::setw(8) << "STEALS"
+	    << " " << std::right << std::setw(14) << "QUEUED AVG"
+	    << " " << std::right << std::setw(14) << "BUSY AVG"
+	    << " " << std::right << std::setw(14) << "BUSY TOTAL"
+	    << std::endl;
+
+	for(const auto &[name, tally] : ctx::ole::tallies)
+	{
+		const auto tasks
+		{
+			std::max(tally.tasks, 1UL)
+		};
+
+		char pbuf[3][48];
+		out << std::left << std::setw(32) << name
+		    << " " << std::right << std::setw(10) << tally.batches
+		    << " " << std::right << std::setw(10) << tally.tasks
+		    << " " << std::right << std::setw(8) << tally.errors
+		    << " " << std::right << std::setw(8) << tally.steals
+		    << " " << std::right << std::setw(14) << pretty(pbuf[0], tally.queued / tasks, 1)
+		    << " " << std::right << std::setw(14) << pretty(pbuf[1], tally.busy / tasks, 1)
+		    << " " << std::right << std::setw(14) << pretty(pbuf[2], tally.busy, 1)
+		    << std::endl;
+	}
+
+	return true;
+}
+
 bool
 console_cmd__ctx__term(opt &out, const string_view &line)
 {
@@ -2398,6 +2561,9 @@ console_cmd__ctx__list(opt &out, const string_view &line)
 	    << "STACK"
 	    << " "
 	    << std::setw(25)
+	    << "RESIDENT"
+	    << " "
+	    << std::setw(25)
 	    << "LIMIT"
 	    << " "
 	    << std::setw(6)
@@ -2448,6 +2614,9 @@ console_cmd__ctx__list(opt &out, const string_view &line)
 		out << " "
 		    << std::setw(25) << std::right << pretty(pbuf, iec(stack_at(ctx)));
 
+		out << " "
+		    << std::setw(25) << std::right << pretty(pbuf, iec(ctx::prof::stack_committed(ctx)));
+
 		out << " "
 		    << std::setw(25) << std::right << pretty(pbuf, iec(stack_max(ctx)));
 
@@ -5898,6 +6067,46 @@ console_cmd__net__listen__crt(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// http2
+//
+
+/// Decode HPACK header blocks given in hex. Each block is decoded with the
+/// dynamic table left by those before it, so the request and response
+/// sequences of RFC 7541 Appendix C can be checked against the decoder.
+bool
+console_cmd__http2__hpack(opt &out, const string_view &line)
+{
+	http2::hpack::decoder decoder;
+	size_t i(0);
+	tokens(line, ' ', [&out, &decoder, &i]
+	(const string_view &hex)
+	{
+		const unique_buffer<mutable_buffer> buf
+		{
+			size(hex) / 2
+		};
+
+		const const_buffer block
+		{
+			a2u(buf, hex)
+		};
+
+		out << "block " << i++ << " (" << size(block) << " bytes)" << std::endl;
+		decoder(block, [&out]
+		(const string_view &name, const string_view &value)
+		{
+			out << "  " << name << ": " << value << std::endl;
+		});
+
+		out << "table " << decoder.table.size() << " entries "
+		    << decoder.table_size << " of " << decoder.table_max << " bytes"
+		    << std::endl;
+	});
+
+	return true;
+}
+
 //
 // client
 //
@@ -6118,6 +6327,120 @@ console_cmd__resource(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// replay
+//
+
+bool
+console_cmd__replay__capture__start(opt &out, const string_view &line)
+{
+	using prototype = bool (const string_view &);
+
+	static mods::import<prototype> replay_capture
+	{
+		"replay", "replay_capture"
+	};
+
+	const params param{line, " ",
+	{
+		"path",
+	}};
+
+	if(replay_capture(param.at("path")))
+		out << "capturing requests to " << param.at("path") << std::endl;
+	else
+		out << "a capture is already running" << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__replay__capture__stop(opt &out, const string_view &line)
+{
+	using prototype = bool (const string_view &);
+
+	static mods::import<prototype> replay_capture
+	{
+		"replay", "replay_capture"
+	};
+
+	if(replay_capture(string_view{}))
+		out << "capture stopped" << std::endl;
+	else
+		out << "no capture is running" << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__replay__start(opt &out, const string_view &line)
+{
+	using prototype = bool (const string_view &,
+	                        const string_view &,
+	                        const double &,
+	                        const size_t &,
+	                        const string_view &);
+
+	static mods::import<prototype> replay_run
+	{
+		"replay", "replay_run"
+	};
+
+	const params param{line, " ",
+	{
+		"path", "remote", "speed", "concurrency", "token"
+	}};
+
+	const auto speed
+	{
+		param.at<double>("speed", 1.0)
+	};
+
+	const auto concurrency
+	{
+		param.at<size_t>("concurrency", 32UL)
+	};
+
+	if(replay_run(param.at("path"), param.at("remote"), speed, concurrency, param["token"]))
+		out << "replaying " << param.at("path")
+		    << " to " << param.at("remote")
+		    << " at " << speed << "x"
+		    << " with " << concurrency << " concurrent"
+		    << std::endl;
+	else
+		out << "a replay is already running" << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__replay__stop(opt &out, const string_view &line)
+{
+	using prototype = void ();
+
+	static mods::import<prototype> replay_stop
+	{
+		"replay", "replay_stop"
+	};
+
+	replay_stop();
+	return true;
+}
+
+bool
+console_cmd__replay__report(opt &out, const string_view &line)
+{
+	using prototype = void (std::ostream &);
+
+	static mods::import<prototype> replay_report
+	{
+		"replay", "replay_report"
+	};
+
+	replay_report(out);
+	return true;
+}
+
 //
 // me
 //
@@ -7110,6 +7433,30 @@ console_cmd__events__dump(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__events__ingest(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"filename"
+	}};
+
+	const auto filename
+	{
+		param.at(0)
+	};
+
+	const auto count
+	{
+		m::events::ingest__file(filename)
+	};
+
+	out << "Ingested " << count << " events from " << filename << "." << std::endl
+	    << "Run `event refs rebuild` to generate state references." << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__events__rebuild(opt &out, const string_view &line)
 {
@@ -11544,6 +11891,45 @@ console_cmd__user__mitsein(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__user__mitsein__rebuild(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"user_id"
+	}};
+
+	if(param.at("user_id") == "*")
+	{
+		m::users::opts opts;
+		opts.hostpart = my_host();
+		m::users::for_each(opts, [](const m::user &user)
+		{
+			m::user::mitsein::rebuild
+			{
+				user
+			};
+
+			return true;
+		});
+
+		return true;
+	}
+
+	const m::user user
+	{
+		m::user(param.at("user_id"))
+	};
+
+	m::user::mitsein::rebuild
+	{
+		user
+	};
+
+	out << "done" << std::endl;
+	return true;
+}
+
 bool
 console_cmd__user__tokens(opt &out, const string_view &line)
 {
@@ -51,24 +51,12 @@ m::resource::response
 handle_get(client &client,
            const m::resource::request &request)
 {
-	char sincebuf[m::room::id::buf::SIZE];
+	char sincebuf[m::event::STATE_KEY_MAX_SIZE + 32];
 	const string_view &since
 	{
 		url::decode(sincebuf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
-		throw m::BAD_REQUEST
-		{
-			"Invalid since token for this server."
-		};
-
-	if(since && m::room::id(since).host() != my_host())
-		throw m::BAD_REQUEST
-		{
-			"Invalid since token for this server."
-		};
-
 	const uint8_t limit
 	{
 		request.has("limit")?
@@ -95,12 +83,11 @@ handle_get(client &client,
 	opts.summary = true;
 	opts.join_rule = "public";
 	opts.server = my_host();
-	opts.lower_bound = true;
-	opts.room_id = since;
+	opts.since = since;
 
 	size_t count{0};
-	m::room::id::buf prev_batch_buf;
-	m::room::id::buf next_batch_buf;
+	char next_batch_buf[m::event::STATE_KEY_MAX_SIZE + 32];
+	string_view next_batch;
 	json::stack::object top{out};
 	{
 		json::stack::array chunk
@@ -108,8 +95,8 @@ handle_get(client &client,
 			top, "chunk"
 		};
 
-		m::rooms::for_each(opts, [&]
-		(const m::room::id &room_id)
+		m::rooms::for_each(opts, m::rooms::origin_closure_bool{[&]
+		(const m::room::id &room_id, const string_view &origin)
 		{
 			json::stack::object obj
 			{
@@ -117,11 +104,14 @@ handle_get(client &client,
 			};
 
 			m::rooms::summary::get(obj, room_id);
-			next_batch_buf = room_id;
+			next_batch = m::rooms::summary::index::cursor(next_batch_buf, room_id, origin);
 			return ++count < limit;
-		});
+		}});
 	}
 
+	// To count the total we clear the since token, otherwise the count
+	// will be the remainder.
+	opts.since = {};
 	json::stack::member
 	{
 		top, "total_room_count_estimate", json::value
@@ -130,16 +120,10 @@ handle_get(client &client,
 		}
 	};
 
-	if(prev_batch_buf)
-		json::stack::member
-		{
-			top, "prev_batch", prev_batch_buf
-		};
-
-	if(count >= limit)
+	if(count >= limit && next_batch)
 		json::stack::member
 		{
-			top, "next_batch", next_batch_buf
+			top, "next_batch", next_batch
 		};
 
 	return std::move(response);
@@ -8,19 +8,289 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
-ircd::mapi::header
-IRCD_MODULE
-{
-	"Bridges (Application Services)"
-};
+#include <RB_INC_REGEX
 
 namespace ircd::m::bridge
 {
+	struct matcher;
+	struct subject;
+	struct queue;
+	struct txn;
+
+	static bool matches(const std::regex &, const string_view &);
+	template<class M> static bool matches(const M &, subject &);
+	static std::string compile(const json::array &namespaces);
+	static net::hostport remote(const rfc3986::uri &);
+	static void rebuild();
+
+	static event::idx notified();
+	static void enqueue(queue &, const event::idx &);
+	static void scan(queue &);
+	static void persist(queue &);
+	static bool start(queue &);
+	static bool handle(txn &);
+	static void recv();
+	static void recv_timeouts();
+	static void worker();
+
+	static void handle_config(const m::event &, vm::eval &);
 	static void handle_event(const m::event &, vm::eval &);
+	static void init();
+	static void fini();
 
+	extern conf::item<size_t> txn_events_max;
+	extern conf::item<size_t> queue_max;
+	extern conf::item<seconds> txn_timeout;
+	extern conf::item<seconds> backoff_min;
+	extern conf::item<seconds> backoff_max;
+
+	extern const m::room::id::buf bridge_room_id;
+	extern const db::descriptor cursor_descriptor;
+	extern const db::description description;
+	extern std::shared_ptr<db::database> database;
+	extern db::column cursor;
+	extern std::shared_ptr<const matcher> matchers;
+	extern std::map<std::string, queue, std::less<>> queues;
+	extern std::list<txn> txns;
+	extern bool reload;
+	extern ctx::dock dock;
+	extern ctx::context sender;
+	extern hookfn<vm::eval &> config_hook;
 	extern hookfn<vm::eval &> notify_hook;
 }
 
+/// Compiled namespaces of every bridge. The combined patterns alternate the
+/// patterns of all bridges so an event which interests no bridge, the usual
+/// case, is rejected by one evaluation of each; only a hit is then resolved
+/// against the individual bridges.
+struct ircd::m::bridge::matcher
+{
+	struct bridge
+	{
+		std::string id;
+		std::regex users;                     // includes the sender_localpart
+		std::regex aliases;
+		std::regex rooms;
+		bool has_aliases {false};
+	};
+
+	std::regex users;
+	std::regex aliases;
+	std::regex rooms;
+	bool has_aliases {false};
+	std::vector<bridge> bridges;
+};
+
+/// The strings of an event tested against namespaces. Aliases of the room
+/// are only looked up once some bridge has an alias namespace.
+struct ircd::m::bridge::subject
+{
+	const m::event &event;
+	string_view sender;
+	string_view target;                       // state_key of m.room.member
+	string_view room_id;
+	std::vector<std::string> aliases;
+	bool aliases_loaded {false};
+
+	const std::vector<std::string> &get_aliases();
+
+	subject(const m::event &);
+};
+
+/// Delivery state of one bridge. Matched events wait in memory in order of
+/// their index; the last delivered event is persisted under the bridge's key
+/// in the cursor column so delivery resumes after a restart by rescanning the
+/// events since it. Events which don't fit in memory are likewise left to a
+/// rescan.
+struct ircd::m::bridge::queue
+{
+	std::string id;
+	std::deque<event::idx> events;            // matched; not yet in a txn
+	event::idx cursor {0};                    // last delivered (persisted)
+	event::idx scanned {0};                   // all up to here considered
+	std::string txn_id;                       // current txn; resent verbatim
+	std::string content;                      // current txn body
+	event::idx txn_last {0};                  // last event in current txn
+	size_t txn_count {0};
+	size_t attempts {0};                      // failures of current txn
+	steady_point retry;                       // backoff of current txn
+	bool gap {false};                         // events remain to scan
+	bool scanning {false};
+	bool inflight {false};
+};
+
+/// One attempt to deliver a queue's transaction.
+struct ircd::m::bridge::txn
+{
+	struct queue *queue;
+	steady_point started;
+	unique_mutable_buffer buf;
+	string_view uri;
+	window_buffer wb;
+	http::request hypertext;
+	server::request request;
+
+	txn(struct queue &, const config &);
+};
+
+ircd::mapi::header
+IRCD_MODULE
+{
+	"Bridges (Application Services)",
+	ircd::m::bridge::init,
+	ircd::m::bridge::fini,
+};
+
+decltype(ircd::m::bridge::txn_events_max)
+ircd::m::bridge::txn_events_max
+{
+	{ "name",     "ircd.m.bridge.txn.events_max" },
+	{ "default",  100L                           },
+	{ "description",
+
+	R"(
+	Maximum number of events in one transaction to an application service.
+	)"}
+};
+
+decltype(ircd::m::bridge::queue_max)
+ircd::m::bridge::queue_max
+{
+	{ "name",     "ircd.m.bridge.queue_max" },
+	{ "default",  16384L                    },
+	{ "description",
+
+	R"(
+	Maximum number of undelivered events held in memory for each application
+	service. Beyond this they are found again by scanning the database once
+	the application service catches up.
+	)"}
+};
+
+decltype(ircd::m::bridge::txn_timeout)
+ircd::m::bridge::txn_timeout
+{
+	{ "name",     "ircd.m.bridge.txn.timeout" },
+	{ "default",  30L                         },
+};
+
+decltype(ircd::m::bridge::backoff_min)
+ircd::m::bridge::backoff_min
+{
+	{ "name",     "ircd.m.bridge.txn.backoff.min" },
+	{ "default",  2L                              },
+	{ "description",
+
+	R"(
+	Seconds before retrying a failed transaction. This doubles with each
+	consecutive failure up to ircd.m.bridge.txn.backoff.max.
+	)"}
+};
+
+decltype(ircd::m::bridge::backoff_max)
+ircd::m::bridge::backoff_max
+{
+	{ "name",     "ircd.m.bridge.txn.backoff.max" },
+	{ "default",  900L                            },
+};
+
+decltype(ircd::m::bridge::bridge_room_id)
+ircd::m::bridge::bridge_room_id
+{
+	"bridge", m::my_host()
+};
+
+// Cursor column
+decltype(ircd::m::bridge::cursor_descriptor)
+ircd::m::bridge::cursor_descriptor
+{
+	// name
+	"cursor",
+
+	// explain
+	R"(
+	Delivery position of each application service. The key is the id of the
+	bridge. The value is a JSON object with the "event_id" of the last event
+	delivered and the "txn_id" of the transaction which delivered it.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+	0,       // cache size
+	0,       // cache size for compressed assets
+
+	// bloom_bits
+	0,
+
+	// expect hit
+	true,
+
+	// block_size
+	512,
+
+	// meta block size
+	512,
+
+	// compression
+	{}, // no compression
+};
+
+decltype(ircd::m::bridge::description)
+ircd::m::bridge::description
+{
+	{ "default" }, // requirement of RocksDB
+
+	cursor_descriptor,
+};
+
+decltype(ircd::m::bridge::database)
+ircd::m::bridge::database;
+
+decltype(ircd::m::bridge::cursor)
+ircd::m::bridge::cursor;
+
+decltype(ircd::m::bridge::matchers)
+ircd::m::bridge::matchers;
+
+decltype(ircd::m::bridge::queues)
+ircd::m::bridge::queues;
+
+decltype(ircd::m::bridge::txns)
+ircd::m::bridge::txns;
+
+decltype(ircd::m::bridge::reload)
+ircd::m::bridge::reload
+{
+	true
+};
+
+decltype(ircd::m::bridge::dock)
+ircd::m::bridge::dock;
+
+decltype(ircd::m::bridge::sender)
+ircd::m::bridge::sender
+{
+	"m.bridge", 512_KiB, &worker, context::POST,
+};
+
+decltype(ircd::m::bridge::config_hook)
+ircd::m::bridge::config_hook
+{
+	handle_config,
+	{
+		{ "_site",    "vm.effect"                  },
+		{ "room_id",  string_view{bridge_room_id}  },
+		{ "type",     "ircd.bridge"                },
+	}
+};
+
 decltype(ircd::m::bridge::notify_hook)
 ircd::m::bridge::notify_hook
 {
@@ -30,6 +300,40 @@ ircd::m::bridge::notify_hook
 	}
 };
 
+void
+ircd::m::bridge::init()
+{
+	static const std::string dbopts;
+	database = std::make_shared<db::database>("bridge", dbopts, description);
+	cursor = db::column{*database, "cursor"};
+}
+
+void
+ircd::m::bridge::fini()
+{
+	sender.terminate();
+	sender.join();
+	for(auto &txn : txns)
+		server::cancel(txn.request);
+
+	txns.clear();
+
+	// The database close contains pthread_join()'s within RocksDB which
+	// deadlock under certain conditions when called during a dlclose()
+	// (i.e static destruction of this module). Therefor we must manually
+	// close the db here first.
+	cursor = {};
+	database = std::shared_ptr<db::database>{};
+}
+
+void
+ircd::m::bridge::handle_config(const m::event &event,
+                               vm::eval &eval)
+{
+	reload = true;
+	dock.notify_all();
+}
+
 void
 ircd::m::bridge::handle_event(const m::event &event,
                               vm::eval &eval)
@@ -43,13 +347,874 @@ try
 	if(!event.event_id)
 		return;
 
+	// Every event up to here has passed through this hook, so it's covered
+	// for a queue which has missed none.
+	const auto covered
+	{
+		notified()
+	};
+
+	for(auto &[id, queue] : queues)
+		if(!queue.gap && !queue.scanning)
+			queue.scanned = std::max(queue.scanned, covered);
+
+	const auto matchers
+	{
+		bridge::matchers
+	};
+
+	if(!matchers || matchers->bridges.empty())
+		return;
+
+	subject subject
+	{
+		event
+	};
+
+	if(!matches(*matchers, subject))
+		return;
+
+	const auto &event_idx
+	{
+		eval.sequence
+	};
+
+	for(const auto &bridge : matchers->bridges)
+	{
+		const auto it
+		{
+			queues.find(bridge.id)
+		};
+
+		if(it == end(queues))
+			continue;
+
+		auto &queue{it->second};
+		if(event_idx <= queue.scanned)
+			continue;
+
+		if(!matches(bridge, subject))
+			continue;
+
+		// The scanner finds it instead.
+		if(queue.gap || queue.scanning || queue.events.size() >= size_t(queue_max))
+		{
+			queue.gap = true;
+			continue;
+		}
 
+		enqueue(queue, event_idx);
+	}
+
+	dock.notify_all();
+}
+catch(const ctx::interrupted &)
+{
+	throw;
 }
 catch(const std::exception &e)
 {
 	log::error
 	{
-		log, "Failed to handle for bridgelication services :%s",
+		log, "Failed to handle for application services :%s",
 		e.what(),
 	};
 }
+
+void
+ircd::m::bridge::worker()
+{
+	const auto ready{[]
+	{
+		return reload || std::any_of(begin(queues), end(queues), []
+		(const auto &p)
+		{
+			const auto &queue{p.second};
+			const bool scannable
+			{
+				queue.gap && queue.events.size() < size_t(queue_max) / 2
+			};
+
+			const bool sendable
+			{
+				(!queue.events.empty() || !queue.txn_id.empty()) && queue.retry <= now<steady_point>()
+			};
+
+			return scannable || sendable;
+		});
+	}};
+
+	while(1) try
+	{
+		if(reload)
+			rebuild();
+
+		steady_point next{steady_point::max()};
+		for(auto &[id, queue] : queues)
+		{
+			if(queue.gap && queue.events.size() < size_t(queue_max) / 2)
+				scan(queue);
+
+			if(queue.inflight || (queue.events.empty() && queue.txn_id.empty()))
+				continue;
+
+			if(queue.retry > now<steady_point>())
+			{
+				next = std::min(next, queue.retry);
+				continue;
+			}
+
+			start(queue);
+		}
+
+		if(!txns.empty())
+		{
+			recv();
+			recv_timeouts();
+			continue;
+		}
+
+		if(next != steady_point::max())
+			dock.wait_for(duration_cast<milliseconds>(next - now<steady_point>()), ready);
+		else
+			dock.wait(ready);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::critical
+		{
+			log, "Application service delivery worker :%s",
+			e.what(),
+		};
+
+		ctx::sleep(seconds(backoff_min));
+	}
+}
+
+/// Compose the next transaction unless one awaits retry, then send it.
+bool
+ircd::m::bridge::start(queue &queue)
+try
+{
+	assert(!queue.inflight);
+	if(queue.txn_id.empty())
+	{
+		std::vector<std::string> strung;
+		strung.reserve(std::min(queue.events.size(), size_t(txn_events_max)));
+		while(!queue.events.empty() && strung.size() < size_t(txn_events_max))
+		{
+			const auto event_idx
+			{
+				queue.events.front()
+			};
+
+			queue.events.pop_front();
+			const m::event::fetch event
+			{
+				std::nothrow, event_idx
+			};
+
+			queue.txn_last = event_idx;
+			if(likely(event.valid))
+				strung.emplace_back(json::strung{event});
+		}
+
+		const std::vector<json::value> events
+		(
+			begin(strung), end(strung)
+		);
+
+		queue.content = json::strung{json::members
+		{
+			{ "events", { events.data(), events.size() } },
+		}};
+
+		char txnidbuf[64];
+		queue.txn_id = m::txn::create_id(txnidbuf, queue.content);
+		queue.txn_count = events.size();
+		queue.attempts = 0;
+	}
+
+	bool ret(false);
+	config::get(std::nothrow, queue.id, [&queue, &ret]
+	(const auto &event_idx, const config &config)
+	{
+		if(!json::get<"url"_>(config))
+			return;
+
+		txns.emplace_back(queue, config);
+		queue.inflight = true;
+		ret = true;
+	});
+
+	// Without a url there is nowhere to deliver until reconfigured.
+	if(!ret)
+	{
+		queue.retry = now<steady_point>() + seconds(backoff_max);
+		return ret;
+	}
+
+	log::debug
+	{
+		log, "%s txn %s events:%zu last:%lu attempt:%zu",
+		queue.id,
+		queue.txn_id,
+		queue.txn_count,
+		queue.txn_last,
+		queue.attempts,
+	};
+
+	return ret;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "%s txn %s :%s",
+		queue.id,
+		queue.txn_id,
+		e.what(),
+	};
+
+	queue.retry = now<steady_point>() + seconds(backoff_max);
+	return false;
+}
+
+void
+ircd::m::bridge::recv()
+{
+	auto next
+	{
+		ctx::when_any(begin(txns), end(txns), []
+		(auto &it) -> server::request &
+		{
+			return it->request;
+		})
+	};
+
+	if(!next.wait(milliseconds(500), std::nothrow))
+		return;
+
+	const auto it
+	{
+		next.get()
+	};
+
+	assert(it != end(txns));
+	auto &txn{*it};
+	auto &queue{*txn.queue};
+	const bool ok
+	{
+		handle(txn)
+	};
+
+	queue.inflight = false;
+	txns.erase(it);
+	if(!ok)
+	{
+		const seconds backoff
+		{
+			std::min(seconds(backoff_min) * (1L << std::min(queue.attempts, 16UL)), seconds(backoff_max))
+		};
+
+		++queue.attempts;
+		queue.retry = now<steady_point>() + backoff;
+		return;
+	}
+
+	persist(queue);
+	queue.cursor = queue.txn_last;
+	queue.txn_id.clear();
+	queue.content.clear();
+	queue.txn_count = 0;
+	queue.attempts = 0;
+}
+
+bool
+ircd::m::bridge::handle(txn &txn)
+try
+{
+	const auto code
+	{
+		txn.request.get()
+	};
+
+	return true;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s txn %s attempt:%zu :%s",
+		txn.queue->id,
+		txn.queue->txn_id,
+		txn.queue->attempts,
+		e.what(),
+	};
+
+	return false;
+}
+
+void
+ircd::m::bridge::recv_timeouts()
+{
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	for(auto &txn : txns)
+		if(txn.started + seconds(txn_timeout) < now)
+			server::cancel(txn.request);
+}
+
+/// Record the last delivered event under the bridge's key; a failure here
+/// only means a restart delivers the transaction again under the same id.
+void
+ircd::m::bridge::persist(queue &queue)
+try
+{
+	const auto event_id
+	{
+		m::event_id(std::nothrow, queue.txn_last)
+	};
+
+	if(!event_id)
+		return;
+
+	const json::strung value
+	{
+		json::members
+		{
+			{ "event_id",  event_id      },
+			{ "txn_id",    queue.txn_id  },
+		}
+	};
+
+	db::write(cursor, queue.id, string_view{value});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "%s persisting txn %s :%s",
+		queue.id,
+		queue.txn_id,
+		e.what(),
+	};
+}
+
+/// Find matching events past what the queue has considered, in index order,
+/// until the queue is full or the present is reached.
+void
+ircd::m::bridge::scan(queue &queue)
+{
+	const auto matchers
+	{
+		bridge::matchers
+	};
+
+	if(!matchers)
+		return;
+
+	const auto it
+	{
+		std::find_if(begin(matchers->bridges), end(matchers->bridges), [&queue]
+		(const auto &bridge)
+		{
+			return bridge.id == queue.id;
+		})
+	};
+
+	if(it == end(matchers->bridges))
+		return;
+
+	const auto &bridge{*it};
+	const scope_restore scanning
+	{
+		queue.scanning, true
+	};
+
+	queue.gap = false;
+	const m::events::range range
+	{
+		queue.scanned + 1, vm::sequence::retired + 1
+	};
+
+	const bool done
+	{
+		m::events::for_each(range, [&queue, &bridge]
+		(const event::idx &event_idx, const m::event &event)
+		{
+			if(queue.events.size() >= size_t(queue_max))
+				return false;
+
+			queue.scanned = event_idx;
+			if(!event.event_id || !json::get<"room_id"_>(event))
+				return true;
+
+			subject subject
+			{
+				event
+			};
+
+			// Events the hook queued before the gap are found again here.
+			if(matches(bridge, subject) && !m::internal(m::room::id(subject.room_id)))
+				enqueue(queue, event_idx);
+
+			return true;
+		})
+	};
+
+	queue.gap |= !done;
+}
+
+/// The index below which every event has been through the notify hook:
+/// concurrent evals notify out of order, so an event with a greater index
+/// than one being evaluated may already have been seen.
+ircd::m::event::idx
+ircd::m::bridge::notified()
+{
+	const auto *const eval
+	{
+		vm::eval::seqmin()
+	};
+
+	return eval?
+		vm::sequence::get(*eval) - 1:
+		uint64_t(vm::sequence::retired);
+}
+
+/// Insert in order of index, unless already queued.
+void
+ircd::m::bridge::enqueue(queue &queue,
+                         const event::idx &event_idx)
+{
+	const auto pos
+	{
+		std::lower_bound(begin(queue.events), end(queue.events), event_idx)
+	};
+
+	if(pos != end(queue.events) && *pos == event_idx)
+		return;
+
+	queue.events.emplace(pos, event_idx);
+}
+
+/// Recompile the namespaces of every configured bridge and reconcile the
+/// queues with them; a new queue resumes from its persisted position, or
+/// from the present for a bridge never delivered to.
+void
+ircd::m::bridge::rebuild()
+{
+	reload = false;
+	auto ret
+	{
+		std::make_shared<matcher>()
+	};
+
+	std::string users, aliases, rooms;
+	const auto append{[](std::string &all, const std::string &one)
+	{
+		if(one.empty())
+			return;
+
+		all += all.empty()? "" : "|";
+		all += one;
+	}};
+
+	const auto regex{[](const std::string &pattern)
+	{
+		// An empty alternation would match everything; this matches nothing.
+		return std::regex
+		{
+			!pattern.empty()? pattern : std::string{"$^"},
+			std::regex::ECMAScript | std::regex::optimize | std::regex::nosubs
+		};
+	}};
+
+	config::for_each([&](const event::idx &event_idx, const config &config)
+	{
+		const json::string &id
+		{
+			json::get<"id"_>(config)
+		};
+
+		if(!id || !json::get<"url"_>(config))
+			return true;
+
+		const rfc3986::uri url
+		{
+			json::get<"url"_>(config)
+		};
+
+		if(!iequals(url.scheme, "https") && !iequals(url.scheme, "http"))
+		{
+			log::error
+			{
+				log, "%s url `%s' is not http or https.",
+				string_view{id},
+				json::get<"url"_>(config),
+			};
+
+			return true;
+		}
+
+		const net::hostport hostport
+		{
+			url.remote
+		};
+
+		const bool loopback
+		{
+			host(hostport) == "localhost"
+			|| (rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host(hostport))
+			    && net::is_loop(net::ipaddr{host(hostport)}))
+		};
+
+		if(iequals(url.scheme, "http") && !loopback)
+			log::warning
+			{
+				log, "%s url `%s' is plaintext to a host which is not local; the hs_token and every event are sent unencrypted.",
+				string_view{id},
+				json::get<"url"_>(config),
+			};
+
+		const namespaces &ns
+		{
+			json::get<"namespaces"_>(config)
+		};
+
+		const m::user::id::buf sender
+		{
+			json::get<"sender_localpart"_>(config), my_host()
+		};
+
+		// The bridge's own user is implicitly in its namespace.
+		static const std::regex special
+		{
+			R"([.^$|()\[\]{}*+?\\])"
+		};
+
+		const std::string sender_re
+		{
+			std::regex_replace(std::string{string_view{sender}}, special, R"(\$&)")
+		};
+
+		std::string users_re
+		{
+			compile(json::get<"users"_>(ns))
+		};
+
+		users_re = users_re.empty()? sender_re : users_re + "|" + sender_re;
+		const std::string aliases_re
+		{
+			compile(json::get<"aliases"_>(ns))
+		};
+
+		const std::string rooms_re
+		{
+			compile(json::get<"rooms"_>(ns))
+		};
+
+		try
+		{
+			ret->bridges.emplace_back(matcher::bridge
+			{
+				std::string{id},
+				regex(users_re),
+				regex(aliases_re),
+				regex(rooms_re),
+				!aliases_re.empty(),
+			});
+		}
+		catch(const std::regex_error &e)
+		{
+			log::error
+			{
+				log, "%s namespace regex :%s",
+				string_view{id},
+				e.what(),
+			};
+
+			return true;
+		}
+
+		append(users, users_re);
+		append(aliases, aliases_re);
+		append(rooms, rooms_re);
+		return true;
+	});
+
+	ret->users = regex(users);
+	ret->aliases = regex(aliases);
+	ret->rooms = regex(rooms);
+	ret->has_aliases = !aliases.empty();
+
+	// Reconcile the queues with the configured bridges.
+	for(auto it(begin(queues)); it != end(queues); )
+	{
+		const bool configured
+		{
+			std::any_of(begin(ret->bridges), end(ret->bridges), [&it]
+			(const auto &bridge)
+			{
+				return bridge.id == it->first;
+			})
+		};
+
+		if(!configured && !it->second.inflight && !it->second.scanning)
+			it = queues.erase(it);
+		else
+			++it;
+	}
+
+	const m::room::state state
+	{
+		bridge_room_id
+	};
+
+	for(const auto &bridge : ret->bridges)
+	{
+		auto it(queues.lower_bound(bridge.id));
+		if(it != end(queues) && it->first == bridge.id)
+			continue;
+
+		it = queues.emplace_hint(it, bridge.id, queue{});
+		auto &queue{it->second};
+		queue.id = bridge.id;
+		queue.cursor = vm::sequence::retired;
+		const auto resume{[&queue]
+		(const json::object &content)
+		{
+			const json::string &event_id
+			{
+				content["event_id"]
+			};
+
+			const auto event_idx
+			{
+				event_id?
+					m::index(std::nothrow, m::event::id(event_id)):
+					0UL
+			};
+
+			if(event_idx)
+				queue.cursor = event_idx;
+		}};
+
+		// Positions were once recorded as state in the bridge room; those
+		// are still honored until the first delivery writes the column.
+		if(!cursor(bridge.id, std::nothrow, resume))
+			m::get(std::nothrow, state.get(std::nothrow, "ircd.bridge.txn", bridge.id), "content", resume);
+
+		queue.scanned = queue.cursor;
+		queue.gap = queue.cursor < vm::sequence::retired;
+		log::info
+		{
+			log, "%s delivering from event_idx:%lu of %lu",
+			queue.id,
+			queue.cursor,
+			vm::sequence::retired,
+		};
+	}
+
+	matchers = std::move(ret);
+}
+
+std::string
+ircd::m::bridge::compile(const json::array &namespaces)
+{
+	std::string ret;
+	for(const json::object ns : namespaces)
+	{
+		const json::string &regex
+		{
+			ns["regex"]
+		};
+
+		if(!regex)
+			continue;
+
+		ret += ret.empty()? "(?:" : "|(?:";
+		ret += regex;
+		ret += ")";
+	}
+
+	return ret;
+}
+
+/// Either the combined patterns of all bridges or those of one bridge.
+template<class M>
+bool
+ircd::m::bridge::matches(const M &matcher,
+                         subject &subject)
+{
+	if(matches(matcher.users, subject.sender))
+		return true;
+
+	if(matches(matcher.users, subject.target))
+		return true;
+
+	if(matches(matcher.rooms, subject.room_id))
+		return true;
+
+	if(!matcher.has_aliases)
+		return false;
+
+	for(const auto &alias : subject.get_aliases())
+		if(matches(matcher.aliases, alias))
+			return true;
+
+	return false;
+}
+
+/// Namespace regexes are anchored at the start of the value only.
+bool
+ircd::m::bridge::matches(const std::regex &regex,
+                         const string_view &value)
+{
+	if(!value)
+		return false;
+
+	return std::regex_search(begin(value), end(value), regex, std::regex_constants::match_continuous);
+}
+
+//
+// subject
+//
+
+ircd::m::bridge::subject::subject(const m::event &event)
+:event
+{
+	event
+}
+,sender
+{
+	json::get<"sender"_>(event)
+}
+,target
+{
+	json::get<"type"_>(event) == "m.room.member"?
+		json::get<"state_key"_>(event):
+		json::string{}
+}
+,room_id
+{
+	json::get<"room_id"_>(event)
+}
+{
+}
+
+const std::vector<std::string> &
+ircd::m::bridge::subject::get_aliases()
+{
+	if(aliases_loaded || !room_id)
+		return aliases;
+
+	aliases_loaded = true;
+	const m::room::aliases room_aliases
+	{
+		m::room::id(room_id)
+	};
+
+	room_aliases.for_each([this](const auto &alias)
+	{
+		aliases.emplace_back(alias);
+		return true;
+	});
+
+	return aliases;
+}
+
+//
+// txn
+//
+
+/// Links made by server:: do the TLS handshake unless the peer's options
+/// say otherwise; a bridge at an http URL has its peer told not to before
+/// each transaction, as the peer may have been collected since the last.
+ircd::net::hostport
+ircd::m::bridge::remote(const rfc3986::uri &url)
+{
+	const net::hostport ret
+	{
+		url.remote
+	};
+
+	if(iequals(url.scheme, "http"))
+		server::get(ret).open_opts.handshake = false;
+
+	return ret;
+}
+
+ircd::m::bridge::txn::txn(struct queue &queue,
+                          const config &config)
+:queue
+{
+	&queue
+}
+,started
+{
+	now<steady_point>()
+}
+,buf
+{
+	16_KiB
+}
+,uri
+{
+	[&queue, &config, this]() -> string_view
+	{
+		const rfc3986::uri base_url
+		{
+			json::get<"url"_>(config)
+		};
+
+		// The path is a prefix for the API; a trailing slash is not doubled.
+		return fmt::sprintf
+		{
+			buf, "%s/_matrix/app/v1/transactions/%s?access_token=%s",
+			rstrip(base_url.path, '/'),
+			queue.txn_id,
+			json::get<"hs_token"_>(config),
+		};
+	}()
+}
+,wb
+{
+	buf + size(uri)
+}
+,hypertext
+{
+	wb,
+	rfc3986::uri(json::get<"url"_>(config)).remote,
+	"PUT",
+	uri,
+	size(queue.content),
+	"application/json; charset=utf-8",
+}
+,request
+{
+	remote(rfc3986::uri(json::get<"url"_>(config))),
+	server::out    { wb.completed(),  string_view{queue.content}     },
+	server::in     { wb.remains(),    wb.remains()                   },
+}
+{
+}
@@ -10,6 +10,39 @@
 
 namespace ircd::m::push
 {
+	struct note;
+	struct queue;
+	struct notify;
+	using queue_key = std::pair<std::string, std::string>; // user_id, pushkey
+
+	static string_view make_key(const mutable_buffer &, const queue_key &);
+	static void persist(const queue_key &, queue &);
+	static void load();
+	static long unread(const user::id &);
+	static void resolve(const note &);
+	static bool start(const queue_key &, queue &);
+	static bool handle(notify &);
+	static void recv();
+	static void recv_timeouts();
+	static void worker();
+	static void init();
+	static void fini();
+
+	extern conf::item<size_t> queue_max;
+	extern conf::item<size_t> attempts_max;
+	extern conf::item<seconds> notify_timeout;
+	extern conf::item<seconds> backoff_min;
+	extern conf::item<seconds> backoff_max;
+	extern const db::descriptor queue_descriptor;
+	extern const db::description description;
+	extern std::shared_ptr<db::database> database;
+	extern db::column queue_column;
+	extern std::deque<note> notified;
+	extern std::map<queue_key, queue> queues;
+	extern std::list<notify> notifies;
+	extern ctx::dock dock;
+	extern ctx::context sender;
+
 	static void execute(const event &, vm::eval &, const user::id &, const path &, const rule &, const event::idx &);
 	static bool matching(const event &, vm::eval &, const user::id &, const path &, const rule &);
 	static bool handle_kind(const event &, vm::eval &, const user::id &, const path &);
@@ -18,10 +51,174 @@ namespace ircd::m::push
 	extern hookfn<vm::eval &> hook_event;
 }
 
+/// A notifying rule matched an event for a user. This is all the eval does
+/// toward delivery; the sender resolves it to the user's pushers later.
+struct ircd::m::push::note
+{
+	std::string user_id;
+	event::idx event_idx {0};
+	event::idx rule_idx {0};
+	std::string room_id;                       // resolved by the sender
+	size_t count {1};                          // notes coalesced into this one
+};
+
+/// Undelivered notifications for one pusher. A burst in a room coalesces
+/// into its latest note, so a gateway is sent one request per room rather
+/// than per event. The queue is written to the queue column whenever it
+/// changes and is reloaded from there at startup.
+struct ircd::m::push::queue
+{
+	std::deque<note> notes;
+	size_t attempts {0};                       // failures of the front note
+	steady_point retry;                        // backoff of the front note
+	bool inflight {false};
+	bool persisted {false};                    // queue column has the key
+};
+
+/// One request to a push gateway for the front note of a queue.
+struct ircd::m::push::notify
+{
+	queue_key key;
+	unique_mutable_buffer buf;
+	std::string content;
+	steady_point started;
+	server::request request;
+
+	notify(const queue_key &, const note &, const json::object &pusher);
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
 	"Matrix 13.13 :Push Notifications",
+	ircd::m::push::init,
+	ircd::m::push::fini,
+};
+
+decltype(ircd::m::push::queue_max)
+ircd::m::push::queue_max
+{
+	{ "name",     "ircd.m.push.queue_max" },
+	{ "default",  64L                     },
+	{ "description",
+
+	R"(
+	Maximum number of rooms with undelivered notifications for one pusher;
+	the oldest are dropped beyond this.
+	)"}
+};
+
+decltype(ircd::m::push::attempts_max)
+ircd::m::push::attempts_max
+{
+	{ "name",     "ircd.m.push.attempts_max" },
+	{ "default",  8L                         },
+	{ "description",
+
+	R"(
+	Number of failed attempts after which a notification is dropped.
+	)"}
+};
+
+decltype(ircd::m::push::notify_timeout)
+ircd::m::push::notify_timeout
+{
+	{ "name",     "ircd.m.push.notify.timeout" },
+	{ "default",  20L                          },
+};
+
+decltype(ircd::m::push::backoff_min)
+ircd::m::push::backoff_min
+{
+	{ "name",     "ircd.m.push.backoff.min" },
+	{ "default",  1L                        },
+	{ "description",
+
+	R"(
+	Seconds before retrying a failed notification to a pusher. This doubles
+	with each consecutive failure up to ircd.m.push.backoff.max.
+	)"}
+};
+
+decltype(ircd::m::push::backoff_max)
+ircd::m::push::backoff_max
+{
+	{ "name",     "ircd.m.push.backoff.max" },
+	{ "default",  600L                      },
+};
+
+decltype(ircd::m::push::notified)
+ircd::m::push::notified;
+
+// Queue column
+decltype(ircd::m::push::queue_descriptor)
+ircd::m::push::queue_descriptor
+{
+	// name
+	"queue",
+
+	// explain
+	R"(
+	Undelivered notifications of each pusher. The key is the user_id and the
+	pushkey separated by a space. The value is a JSON object with the
+	"user_id", the "pushkey" and the array of queued "notes".
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+	0,       // cache size
+	0,       // cache size for compressed assets
+
+	// bloom_bits
+	0,
+
+	// expect hit
+	false,
+
+	// block_size
+	4_KiB,
+
+	// meta block size
+	512,
+
+	// compression
+	"kLZ4Compression;kSnappyCompression"s,
+};
+
+decltype(ircd::m::push::description)
+ircd::m::push::description
+{
+	{ "default" }, // requirement of RocksDB
+
+	queue_descriptor,
+};
+
+decltype(ircd::m::push::database)
+ircd::m::push::database;
+
+decltype(ircd::m::push::queue_column)
+ircd::m::push::queue_column;
+
+decltype(ircd::m::push::queues)
+ircd::m::push::queues;
+
+decltype(ircd::m::push::notifies)
+ircd::m::push::notifies;
+
+decltype(ircd::m::push::dock)
+ircd::m::push::dock;
+
+decltype(ircd::m::push::sender)
+ircd::m::push::sender
+{
+	"m.push", 512_KiB, &worker, context::POST,
 };
 
 decltype(ircd::m::push::hook_event)
@@ -222,8 +419,20 @@ try
 	if(!notifying(rule))
 		return;
 
+	const bool highlight
+	{
+		highlighting(rule)
+	};
+
+	const user::notifications notifications
+	{
+		user_id
+	};
+
+	notifications.notified(eval.room_id, highlight);
+
 	// We send highlight notifications through the user's room
-	if(highlighting(rule))
+	if(highlight)
 	{
 		char type_buf[event::TYPE_MAX_SIZE];
 		user::notifications::opts opts;
@@ -241,6 +450,14 @@ try
 			{ "rule_idx",   long(rule_idx)       },
 		});
 	}
+
+	// Delivery to the user's pushers happens in the sender.
+	notified.emplace_back(note
+	{
+		std::string{user_id}, eval.sequence, rule_idx
+	});
+
+	dock.notify_one();
 }
 catch(const ctx::interrupted &)
 {
@@ -264,3 +481,743 @@ catch(const std::exception &e)
 		e.what(),
 	};
 }
+
+//
+// delivery
+//
+
+void
+ircd::m::push::init()
+{
+	static const std::string dbopts;
+	database = std::make_shared<db::database>("push", dbopts, description);
+	queue_column = db::column{*database, "queue"};
+}
+
+void
+ircd::m::push::fini()
+{
+	sender.terminate();
+	sender.join();
+	for(auto &notify : notifies)
+		server::cancel(notify.request);
+
+	notifies.clear();
+
+	// The database close contains pthread_join()'s within RocksDB which
+	// deadlock under certain conditions when called during a dlclose()
+	// (i.e static destruction of this module). Therefor we must manually
+	// close the db here first.
+	queue_column = {};
+	database = std::shared_ptr<db::database>{};
+}
+
+void
+ircd::m::push::worker()
+{
+	load();
+	while(1) try
+	{
+		while(!notified.empty())
+		{
+			const unwind pop{[]
+			{
+				notified.pop_front();
+			}};
+
+			resolve(notified.front());
+		}
+
+		const auto now
+		{
+			ircd::now<steady_point>()
+		};
+
+		steady_point next{steady_point::max()};
+		for(auto it(begin(queues)); it != end(queues); )
+		{
+			auto &[key, queue] {*it};
+			if(!queue.inflight && !queue.notes.empty() && queue.retry > now)
+				next = std::min(next, queue.retry);
+			else if(!queue.inflight && !queue.notes.empty())
+				start(key, queue);
+
+			if(!queue.inflight && queue.notes.empty())
+			{
+				if(queue.persisted)
+					persist(key, queue);
+
+				it = queues.erase(it);
+				continue;
+			}
+
+			++it;
+		}
+
+		if(!notifies.empty())
+		{
+			recv();
+			recv_timeouts();
+			continue;
+		}
+
+		const auto ready{[]
+		{
+			return !notified.empty();
+		}};
+
+		if(next != steady_point::max())
+			dock.wait_for(duration_cast<milliseconds>(next - ircd::now<steady_point>()), ready);
+		else
+			dock.wait(ready);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::critical
+		{
+			log, "Push delivery worker :%s",
+			e.what(),
+		};
+
+		ctx::sleep(seconds(backoff_min));
+	}
+}
+
+/// Add the note to the queue of each of the user's http pushers, coalescing
+/// with a note already waiting for the same room.
+void
+ircd::m::push::resolve(const note &note)
+try
+{
+	char room_id_buf[m::id::MAX_SIZE];
+	const string_view room_id
+	{
+		m::get(std::nothrow, note.event_idx, "room_id", room_id_buf)
+	};
+
+	if(!room_id)
+		return;
+
+	const m::user::pushers pushers
+	{
+		m::user::id(note.user_id)
+	};
+
+	pushers.for_each([&note, &room_id]
+	(const event::idx &pusher_idx, const string_view &pushkey, const json::object &content)
+	{
+		const push::pusher pusher
+		{
+			content
+		};
+
+		if(json::get<"kind"_>(pusher) != "http")
+			return true;
+
+		if(!json::get<"data"_>(pusher).has("url"))
+			return true;
+
+		auto &queue
+		{
+			queues[queue_key{note.user_id, pushkey}]
+		};
+
+		// The inflight front is left alone; it's removed once it completes.
+		const auto it
+		{
+			std::find_if(begin(queue.notes) + queue.inflight, end(queue.notes), [&room_id]
+			(const auto &queued)
+			{
+				return queued.room_id == room_id;
+			})
+		};
+
+		if(it != end(queue.notes))
+		{
+			it->event_idx = note.event_idx;
+			it->rule_idx = note.rule_idx;
+			it->count += note.count;
+		}
+		else
+		{
+			if(queue.notes.size() >= size_t(queue_max) && queue.notes.size() > queue.inflight)
+				queue.notes.erase(begin(queue.notes) + queue.inflight);
+
+			queue.notes.emplace_back(note);
+			queue.notes.back().room_id = room_id;
+		}
+
+		persist(queue_key{note.user_id, pushkey}, queue);
+		return true;
+	});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Resolving pushers of %s for event_idx:%lu :%s",
+		note.user_id,
+		note.event_idx,
+		e.what(),
+	};
+}
+
+bool
+ircd::m::push::start(const queue_key &key,
+                     queue &queue)
+try
+{
+	assert(!queue.inflight);
+	assert(!queue.notes.empty());
+	const auto &[user_id, pushkey]
+	{
+		key
+	};
+
+	const m::user::pushers pushers
+	{
+		m::user::id(user_id)
+	};
+
+	bool ret(false);
+	pushers.get(std::nothrow, pushkey, [&key, &queue, &ret]
+	(const event::idx &, const string_view &, const json::object &pusher)
+	{
+		notifies.emplace_back(key, queue.notes.front(), pusher);
+		queue.inflight = true;
+		ret = true;
+	});
+
+	// The pusher was removed; so is its queue.
+	if(!ret)
+	{
+		queue.notes.clear();
+		persist(key, queue);
+	}
+
+	return ret;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	const auto &[user_id, pushkey]
+	{
+		key
+	};
+
+	log::derror
+	{
+		log, "Notify %s pushkey '%s' :%s",
+		user_id,
+		pushkey,
+		e.what(),
+	};
+
+	queue.notes.pop_front();
+	persist(key, queue);
+	return false;
+}
+
+void
+ircd::m::push::recv()
+{
+	auto next
+	{
+		ctx::when_any(begin(notifies), end(notifies), []
+		(auto &it) -> server::request &
+		{
+			return it->request;
+		})
+	};
+
+	if(!next.wait(milliseconds(500), std::nothrow))
+		return;
+
+	const auto it
+	{
+		next.get()
+	};
+
+	assert(it != end(notifies));
+	const auto key
+	{
+		it->key
+	};
+
+	const bool ok
+	{
+		handle(*it)
+	};
+
+	notifies.erase(it);
+	const auto qit
+	{
+		queues.find(key)
+	};
+
+	if(qit == end(queues))
+		return;
+
+	auto &queue{qit->second};
+	queue.inflight = false;
+	if(!ok && ++queue.attempts < size_t(attempts_max))
+	{
+		const seconds backoff
+		{
+			std::min(seconds(backoff_min) * (1L << std::min(queue.attempts, 16UL)), seconds(backoff_max))
+		};
+
+		queue.retry = now<steady_point>() + backoff;
+		return;
+	}
+
+	assert(!queue.notes.empty());
+	queue.notes.pop_front();
+	queue.attempts = 0;
+	persist(key, queue);
+	if(!queue.notes.empty())
+		return;
+
+	queues.erase(qit);
+}
+
+bool
+ircd::m::push::handle(notify &notify)
+try
+{
+	// Throws for a non-2xx response.
+	notify.request.get();
+	const json::object response
+	{
+		notify.request.in.content
+	};
+
+	const auto &[user_id, pushkey]
+	{
+		notify.key
+	};
+
+	// The gateway no longer accepts this pushkey; the pusher is removed.
+	const json::array rejected
+	{
+		response["rejected"]
+	};
+
+	for(const json::string rejected_key : rejected)
+		if(rejected_key == pushkey)
+		{
+			log::dwarning
+			{
+				log, "Removing pusher '%s' of %s rejected by its gateway.",
+				pushkey,
+				user_id,
+			};
+
+			m::user::pushers{m::user::id(user_id)}.del(pushkey);
+			break;
+		}
+
+	return true;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	const auto &[user_id, pushkey]
+	{
+		notify.key
+	};
+
+	log::derror
+	{
+		log, "Notify %s pushkey '%s' :%s",
+		user_id,
+		pushkey,
+		e.what(),
+	};
+
+	return false;
+}
+
+void
+ircd::m::push::recv_timeouts()
+{
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	for(auto &notify : notifies)
+		if(notify.started + seconds(notify_timeout) < now)
+			server::cancel(notify.request);
+}
+
+/// Write the queue under its key; an empty queue deletes the key.
+void
+ircd::m::push::persist(const queue_key &key,
+                       queue &queue)
+try
+{
+	const auto &[user_id, pushkey]
+	{
+		key
+	};
+
+	char key_buf[512];
+	const string_view column_key
+	{
+		make_key(key_buf, key)
+	};
+
+	if(queue.notes.empty())
+	{
+		if(queue.persisted)
+			db::del(queue_column, column_key);
+
+		queue.persisted = false;
+		return;
+	}
+
+	std::vector<json::value> notes(queue.notes.size());
+	std::vector<std::string> strung(queue.notes.size());
+	for(size_t i(0); i < queue.notes.size(); ++i)
+	{
+		const auto &note{queue.notes[i]};
+		strung[i] = json::strung{json::members
+		{
+			{ "event_idx",  long(note.event_idx)  },
+			{ "rule_idx",   long(note.rule_idx)   },
+			{ "room_id",    note.room_id          },
+			{ "count",      long(note.count)      },
+		}};
+
+		notes[i] = string_view{strung[i]};
+	}
+
+	const json::strung value
+	{
+		json::members
+		{
+			{ "user_id",  user_id                            },
+			{ "pushkey",  pushkey                            },
+			{ "notes",    { notes.data(), notes.size() }     },
+		}
+	};
+
+	db::write(queue_column, column_key, string_view{value});
+	queue.persisted = true;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Persisting push queue of %s :%s",
+		key.first,
+		e.what(),
+	};
+}
+
+/// The user_id can't contain a space, which separates it from the pushkey.
+ircd::string_view
+ircd::m::push::make_key(const mutable_buffer &buf,
+                        const queue_key &key)
+{
+	return fmt::sprintf
+	{
+		buf, "%s %s",
+		key.first,
+		key.second,
+	};
+}
+
+/// Restore the queues which were undelivered at the last shutdown.
+void
+ircd::m::push::load()
+{
+	size_t loaded(0);
+	for(auto it(queue_column.begin()); it; ++it)
+	{
+		const json::object content
+		{
+			it->second
+		};
+
+		const json::string &user_id
+		{
+			content["user_id"]
+		};
+
+		const json::string &pushkey
+		{
+			content["pushkey"]
+		};
+
+		const json::array &notes
+		{
+			content["notes"]
+		};
+
+		if(!user_id || empty(notes))
+			continue;
+
+		auto &queue
+		{
+			queues[queue_key{user_id, pushkey}]
+		};
+
+		queue.persisted = true;
+		for(const json::object note : notes)
+		{
+			queue.notes.emplace_back(push::note
+			{
+				std::string{user_id},
+				note.get<event::idx>("event_idx"),
+				note.get<event::idx>("rule_idx"),
+				json::string{note["room_id"]},
+				note.get<size_t>("count", 1UL),
+			});
+
+			++loaded;
+		}
+	}
+
+	if(loaded)
+		log::info
+		{
+			log, "Restored %zu undelivered notifications for %zu pushers.",
+			loaded,
+			queues.size(),
+		};
+}
+
+/// The badge count of the spec: notifications since the read receipt in
+/// every room the user is joined to.
+long
+ircd::m::push::unread(const user::id &user_id)
+{
+	const m::user::notifications notifications
+	{
+		user_id
+	};
+
+	long ret(0);
+	const m::user::rooms rooms
+	{
+		user_id
+	};
+
+	rooms.for_each("join", m::user::rooms::closure{[&notifications, &ret]
+	(const m::room &room, const string_view &membership)
+	{
+		ret += notifications.unread(room.room_id).first;
+	}});
+
+	return ret;
+}
+
+//
+// notify
+//
+
+ircd::m::push::notify::notify(const queue_key &key,
+                              const note &note,
+                              const json::object &pusher_)
+:key
+{
+	key
+}
+,buf
+{
+	16_KiB
+}
+,content{[&note, &pusher_]
+{
+	const push::pusher pusher
+	{
+		pusher_
+	};
+
+	const json::object &data
+	{
+		json::get<"data"_>(pusher)
+	};
+
+	const bool event_id_only
+	{
+		json::string(data["format"]) == "event_id_only"
+	};
+
+	// The gateway receives the pusher's data less the url.
+	std::vector<json::member> data_members;
+	for(const auto &[key, val] : data)
+		if(key != "url")
+			data_members.emplace_back(key, val);
+
+	// Tweaks are the set_tweak actions of the rule which matched.
+	bool highlight {false};
+	std::vector<json::member> tweaks;
+	m::get(std::nothrow, note.rule_idx, "content", [&tweaks, &highlight]
+	(const json::object &content)
+	{
+		const push::rule rule
+		{
+			content
+		};
+
+		highlight = highlighting(rule);
+		for(const json::object action : json::array(json::get<"actions"_>(rule)))
+		{
+			const json::string &tweak
+			{
+				action["set_tweak"]
+			};
+
+			if(!tweak)
+				continue;
+
+			tweaks.emplace_back(json::member
+			{
+				string_view{tweak}, action.has("value")?
+					json::value{action["value"]}:
+					json::value{true}
+			});
+		}
+	});
+
+	const json::members device
+	{
+		{ "app_id",     json::get<"app_id"_>(pusher)                      },
+		{ "pushkey",    json::get<"pushkey"_>(pusher)                     },
+		{ "data",       { data_members.data(), data_members.size() }      },
+		{ "tweaks",     { tweaks.data(), tweaks.size() }                  },
+	};
+
+	const json::value devices[]
+	{
+		json::value{device}
+	};
+
+	const m::event::fetch event
+	{
+		std::nothrow, note.event_idx
+	};
+
+	json::iov notification;
+	const json::iov::push push[]
+	{
+		{ notification, { "room_id",    note.room_id                      } },
+		{ notification, { "prio",       highlight? "high" : "low"         } },
+		{ notification, { "devices",    { devices, 1 }                    } },
+		{ notification, { "counts",     json::members
+		{
+			{ "unread", unread(m::user::id(note.user_id)) },
+		}}},
+	};
+
+	const json::iov::add event_id
+	{
+		notification, event.valid,
+		{
+			"event_id", [&event]
+			{
+				return json::value{event.event_id};
+			}
+		}
+	};
+
+	const json::iov::add type
+	{
+		notification, event.valid && !event_id_only,
+		{
+			"type", [&event]
+			{
+				return json::get<"type"_>(event);
+			}
+		}
+	};
+
+	const json::iov::add sender
+	{
+		notification, event.valid && !event_id_only,
+		{
+			"sender", [&event]
+			{
+				return json::get<"sender"_>(event);
+			}
+		}
+	};
+
+	const json::iov::add content
+	{
+		notification, event.valid && !event_id_only,
+		{
+			"content", [&event]
+			{
+				return json::get<"content"_>(event);
+			}
+		}
+	};
+
+	const json::strung object
+	{
+		notification
+	};
+
+	return json::strung{json::members
+	{
+		{ "notification", json::object{object} },
+	}};
+}()}
+,started
+{
+	now<steady_point>()
+}
+,request{[this, &pusher_]
+{
+	const push::pusher pusher
+	{
+		pusher_
+	};
+
+	const rfc3986::uri url
+	{
+		json::string(json::get<"data"_>(pusher)["url"])
+	};
+
+	window_buffer wb{buf};
+	http::request
+	{
+		wb, url.remote, "POST", url.path, size(content), "application/json; charset=utf-8"
+	};
+
+	const auto head
+	{
+		wb.completed()
+	};
+
+	return server::request
+	{
+		net::hostport  { url.remote                     },
+		server::out    { head,  string_view{content}    },
+		server::in     { wb.remains(),  wb.remains()    },
+	};
+}()}
+{
+}
@@ -40,6 +40,7 @@ namespace ircd::magick
 	extern conf::item<uint64_t> limit_cycles;
 	extern conf::item<uint64_t> yield_threshold;
 	extern conf::item<uint64_t> yield_interval;
+	extern conf::item<bool> offload_enable;
 	extern log::log log;
 }
 
@@ -55,6 +56,8 @@ struct ircd::magick::transform
 	using output = std::function<void (const const_buffer &)>;
 	using transformer = std::function<Image *(const input &)>;
 
+	static void execute(const const_buffer &, const output &, const transformer &);
+
 	transform(const const_buffer &, const output &, const transformer &);
 };
 
@@ -100,6 +103,13 @@ ircd::magick::yield_interval
 	{ "default", 768L                         },
 };
 
+decltype(ircd::magick::offload_enable)
+ircd::magick::offload_enable
+{
+	{ "name",    "ircd.magick.offload.enable" },
+	{ "default", true                         },
+};
+
 // It is likely that we can't have two contexts enter libmagick
 // simultaneously. This race is possible if the progress callback yields
 // and another context starts an operation. It is highly unlikely the lib
@@ -433,6 +443,54 @@ IRCD_MODULE_EXPORT
 ircd::magick::transform::transform(const const_buffer &input,
                                    const output &output,
                                    const transformer &transformer)
+{
+	if(!offload_enable || !ctx::current)
+	{
+		execute(input, output, transformer);
+		return;
+	}
+
+	// The job is conducted on an ircd::ctx::ole thread so the main thread
+	// is not held up by large images. This context holds the call_mutex on
+	// behalf of the offload thread for the duration of the job; the calls
+	// made over there observe no ctx::current and do not lock it again.
+	unique_buffer<mutable_buffer> result;
+	const auto copy_result{[&result]
+	(const const_buffer &buf)
+	{
+		result = unique_buffer<mutable_buffer>{buf};
+	}};
+
+	{
+		const std::lock_guard lock
+		{
+			call_mutex
+		};
+
+		static const ctx::ole::opts opts
+		{
+			"magick.transform"
+		};
+
+		ctx::offload
+		{
+			opts, [&input, &copy_result, &transformer]
+			{
+				execute(input, copy_result, transformer);
+			}
+		};
+	}
+
+	// The output closure may be doing anything (i.e. writing to a client or
+	// starting another transform) so it is invoked back on this context
+	// after the lock is released.
+	output(result);
+}
+
+void
+ircd::magick::transform::execute(const const_buffer &input,
+                                 const output &output,
+                                 const transformer &transformer)
 {
 	const custom_ptr<ImageInfo> input_info
 	{
@@ -521,11 +579,16 @@ ircd::magick::callex(function&& f,
 			"Graphics library not ready."
 		};
 
-	const std::lock_guard lock
+	// Calls from an offload thread are covered by the lock the offloading
+	// context already holds; see transform().
+	std::unique_lock<ctx::mutex> lock
 	{
-		call_mutex
+		call_mutex, std::defer_lock
 	};
 
+	if(likely(ctx::current))
+		lock.lock();
+
 	ExceptionInfo ei;
 	GetExceptionInfo(&ei); // initializer
 	const unwind destroy{[&ei]
@@ -578,11 +641,14 @@ ircd::magick::call(function&& f,
 			"Graphics library not ready."
 		};
 
-	const std::lock_guard lock
+	std::unique_lock<ctx::mutex> lock
 	{
-		call_mutex
+		call_mutex, std::defer_lock
 	};
 
+	if(likely(ctx::current))
+		lock.lock();
+
 	assert(call_ready);
 	return f(std::forward<args>(a)...);
 }
@@ -627,7 +693,9 @@ noexcept try
 	// and monotonically increases across jobs as well.
 	const auto cycles_sample
 	{
-		ctx::this_ctx::cycles()
+		ctx::current?
+			ctx::this_ctx::cycles():
+			prof::cycles()
 	};
 
 	// Detect if this is a new job. Tick is usually zero for a new job, but for
@@ -747,6 +815,10 @@ ircd::magick::check_yield(job &job)
 	if(likely(job.ticks < yield_threshold))
 		return false;
 
+	// This job is running on an offload thread; there's nothing to yield.
+	if(!ctx::current)
+		return false;
+
 	const uint64_t &yield_interval
 	{
 		magick::yield_interval
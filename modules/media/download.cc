@@ -39,6 +39,11 @@ get__download_local(client &client,
                     const string_view &file,
                     const m::room &room);
 
+static m::media::file::range
+get__download_range(const m::resource::request &request,
+                    const string_view &etag,
+                    const size_t &file_size);
+
 static m::resource::response
 get__download(client &client,
               const m::resource::request &request)
@@ -127,39 +132,200 @@ get__download_local(client &client,
 		};
 	});
 
+	// The content of an mxc never changes so the file's room localpart,
+	// which is a hash of the mxc, serves as a strong entity-tag.
+	char etag_buf[64];
+	const string_view etag
+	{
+		fmt::sprintf
+		{
+			etag_buf, "\"%s\"", room.room_id.localname()
+		}
+	};
+
+	const auto range
+	{
+		get__download_range(request, etag, file_size)
+	};
+
+	const bool partial
+	{
+		range.first != 0 || range.second != file_size
+	};
+
+	char content_range_buf[64];
+	const string_view content_range
+	{
+		partial?
+			fmt::sprintf
+			{
+				content_range_buf, "bytes %zu-%zu/%zu",
+				range.first,
+				range.second - 1,
+				file_size,
+			}:
+			string_view{}
+	};
+
+	const http::header headers[]
+	{
+		{ "Accept-Ranges",   "bytes"        },
+		{ "ETag",            etag           },
+		{ "Content-Range",   content_range  },
+	};
+
+	char headers_buf[512];
+	window_buffer sb{headers_buf};
+	http::write(sb, vector_view<const http::header>
+	{
+		headers, partial? 3UL : 2UL
+	});
+
+	const size_t content_length
+	{
+		range.second - range.first
+	};
+
 	// Send HTTP head to client
 	m::resource::response
 	{
-		client, http::OK, content_type, file_size
+		client,
+		partial? http::PARTIAL_CONTENT : http::OK,
+		content_type,
+		content_length,
+		string_view{sb.completed()}
 	};
 
+	// Only the blocks covering the range are read from the database.
 	size_t sent{0}, read
 	{
-		m::media::file::read(room, [&client, &sent]
+		m::media::file::read(room, range, [&client, &sent]
 		(const string_view &block)
 		{
 			sent += write_all(*client.sock, block);
 		})
 	};
 
-	if(unlikely(read != file_size))
+	if(unlikely(read != content_length))
 		log::error
 		{
-			m::media::log, "File %s/%s [%s] size mismatch: expected %zu got %zu",
+			m::media::log, "File %s/%s [%s] size mismatch: expected %zu got %zu (range %zu-%zu of %zu)",
 			server,
 			file,
 			string_view{room.room_id},
+			content_length,
+			read,
+			range.first,
+			range.second,
 			file_size,
-			read
 		};
 
 	// Have to kill client here after failing content length expectation.
-	if(unlikely(read != file_size))
+	if(unlikely(read != content_length))
 		client.close(net::dc::RST, net::close_ignore);
 
 	return {};
 }
 
+/// Determine the byte range [start, stop) of the file to send to the client
+/// from the Range and If-Range headers. Only a single range is supported;
+/// requests for multiple ranges receive the whole file, which is permitted
+/// by RFC 7233. An unsatisfiable range throws 416 with the Content-Range
+/// of the whole file.
+static m::media::file::range
+get__download_range(const m::resource::request &request,
+                    const string_view &etag,
+                    const size_t &file_size)
+{
+	const m::media::file::range whole
+	{
+		0, file_size
+	};
+
+	const string_view &range_spec
+	{
+		request.head.range
+	};
+
+	if(!startswith(range_spec, "bytes="))
+		return whole;
+
+	// If-Range with an entity-tag which doesn't match ours (or with a date,
+	// which we never issue) means the client's partial copy is stale.
+	if(request.head.if_range && request.head.if_range != etag)
+		return whole;
+
+	const string_view spec
+	{
+		strip(lstrip(range_spec, "bytes="))
+	};
+
+	if(has(spec, ','))
+		return whole;
+
+	const auto &[first, last]
+	{
+		split(spec, '-')
+	};
+
+	const auto unsatisfiable{[&file_size]
+	{
+		char buf[64];
+		const http::header headers[]
+		{
+			{ "Content-Range", fmt::sprintf
+			{
+				buf, "bytes */%zu", file_size
+			}},
+		};
+
+		return http::error
+		{
+			http::RANGE_NOT_SATISFIABLE, {}, headers
+		};
+	}};
+
+	if(!lex_castable<size_t>(strip(first)) && !lex_castable<size_t>(strip(last)))
+		return whole;
+
+	// Suffix range; the last N bytes of the file.
+	if(!strip(first))
+	{
+		const size_t suffix
+		{
+			lex_cast<size_t>(strip(last))
+		};
+
+		if(!suffix || !file_size)
+			throw unsatisfiable();
+
+		return
+		{
+			file_size - std::min(suffix, file_size), file_size
+		};
+	}
+
+	const size_t start
+	{
+		lex_cast<size_t>(strip(first))
+	};
+
+	const size_t stop
+	{
+		strip(last)?
+			std::min(lex_cast<size_t>(strip(last)) + 1, file_size):
+			file_size
+	};
+
+	if(start >= file_size || start >= stop)
+		throw unsatisfiable();
+
+	return
+	{
+		start, stop
+	};
+}
+
 static m::resource::method
 method_get
 {
@@ -10,6 +10,11 @@
 
 #include "media.h"
 
+namespace ircd::m::media::file
+{
+	static size_t seek(const room &, room::events &, const size_t &offset);
+}
+
 struct ircd::m::media::magick
 {
 	module modules
@@ -99,12 +104,67 @@ ircd::m::media::blocks_descriptor
 	"kOldestSmallestSeqFirst"s,
 };
 
+// Thumbnails column
+decltype(ircd::m::media::thumbnails_descriptor)
+ircd::m::media::thumbnails_descriptor
+{
+	// name
+	"thumbnails",
+
+	// explain
+	R"(
+	Key-value store of generated thumbnails. The key is the plaintext
+	"server/mediaid/WxH/method" of the request after dimensions have been
+	clamped to the configured limits. The value is a JSON object with the
+	"type", "size" and an array of the "blocks" constituting the thumbnail.
+	The blocks themselves are stored in the blocks column like any other
+	file's blocks; they are content-addressed by their sha256-b58 hash.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+
+	bool(blocks_cache_enable)? -1 : 0,
+
+	bool(blocks_cache_comp_enable)? -1 : 0,
+
+	// bloom_bits
+	10,
+
+	// expect hit
+	false,
+
+	// block_size
+	512,
+
+	// meta block size
+	512,
+
+	// compression
+	"kLZ4Compression;kSnappyCompression"s,
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
 decltype(ircd::m::media::description)
 ircd::m::media::description
 {
 	{ "default" }, // requirement of RocksDB
 
 	blocks_descriptor,
+
+	thumbnails_descriptor,
 };
 
 decltype(ircd::m::media::blocks_cache_size)
@@ -159,6 +219,9 @@ ircd::m::media::database;
 decltype(ircd::m::media::blocks)
 ircd::m::media::blocks;
 
+decltype(ircd::m::media::thumbnails)
+ircd::m::media::thumbnails;
+
 decltype(ircd::m::media::downloading)
 ircd::m::media::downloading;
 
@@ -175,6 +238,7 @@ ircd::m::media::init()
 	static const std::string dbopts;
 	database = std::make_shared<db::database>("media", dbopts, description);
 	blocks = db::column{*database, "blocks"};
+	thumbnails = db::column{*database, "thumbnails"};
 
 	// The conf setter callbacks must be manually executed after
 	// the database was just loaded to set the cache size.
@@ -430,7 +494,7 @@ ircd::m::media::file::write(const m::room &room,
 	{
 		const size_t blksz
 		{
-			std::min(size(content) - off, size_t(32_KiB))
+			std::min(size(content) - off, block_size_max)
 		};
 
 		const const_buffer &block
@@ -452,6 +516,15 @@ size_t
 IRCD_MODULE_EXPORT
 ircd::m::media::file::read(const m::room &room,
                            const closure &closure)
+{
+	return read(room, range{0, -1UL}, closure);
+}
+
+size_t
+IRCD_MODULE_EXPORT
+ircd::m::media::file::read(const m::room &room,
+                           const range &range,
+                           const closure &closure)
 {
 	static const event::fetch::opts fopts
 	{
@@ -464,25 +537,38 @@ ircd::m::media::file::read(const m::room &room,
 		room, 1, &fopts
 	};
 
+	if(!it)
+		return ret;
+
+	// Byte offset in the file of the block at the iterator; all blocks
+	// preceding the requested range are skipped without being read.
+	size_t pos
+	{
+		seek(room, it, range.first)
+	};
+
 	if(!it)
 		return ret;
 
 	size_t events_fetched(0), events_prefetched(0);
 	room::events epf
 	{
-		room, 1, &fopts
+		room, it.depth(), &fopts
 	};
 
-	size_t blocks_fetched(0), blocks_prefetched(0);
+	size_t blocks_fetched(0), blocks_prefetched(0), blocks_prefetched_pos(pos);
 	room::events bpf
 	{
-		room, 1, &fopts
+		room, it.depth(), &fopts
 	};
 
-	for(; it; ++it)
+	for(; it && pos < range.second; ++it)
 	{
 		for(; bpf && blocks_prefetched < blocks_fetched + blocks_prefetch; ++bpf)
 		{
+			if(blocks_prefetched_pos >= range.second)
+				break;
+
 			for(; epf && events_prefetched < events_fetched + events_prefetch; ++epf)
 				events_prefetched += epf.prefetch();
 
@@ -500,6 +586,16 @@ ircd::m::media::file::read(const m::room &room,
 				at<"content"_>(event).at("hash")
 			};
 
+			const auto &block_size
+			{
+				at<"content"_>(event).get<size_t>("size")
+			};
+
+			// Blocks before the range are skipped by the reader too.
+			blocks_prefetched_pos += block_size;
+			if(blocks_prefetched_pos <= range.first)
+				continue;
+
 			blocks_prefetched += block::prefetch(hash);
 		}
 
@@ -525,6 +621,26 @@ ircd::m::media::file::read(const m::room &room,
 			at<"content"_>(event).get<size_t>("size")
 		};
 
+		// Blocks entirely before the range are passed without being read;
+		// seek() leaves the iterator at the first block when it can't
+		// position it.
+		if(pos + block_size <= range.first)
+		{
+			pos += block_size;
+			continue;
+		}
+
+		// Portion of this block falling within the range.
+		const size_t slice_start
+		{
+			range.first > pos? range.first - pos : 0UL
+		};
+
+		const size_t slice_stop
+		{
+			std::min(block_size, range.second - pos)
+		};
+
 		const auto handle{[&](const const_buffer &block)
 		{
 			if(unlikely(size(block) != block_size))
@@ -540,7 +656,13 @@ ircd::m::media::file::read(const m::room &room,
 				};
 
 			assert(size(block) == block_size);
-			ret += size(block);
+			assert(slice_start <= slice_stop);
+			const const_buffer slice
+			{
+				data(block) + slice_start, slice_stop - slice_start
+			};
+
+			ret += size(slice);
 
 			#if 0
 			log::debug
@@ -557,7 +679,7 @@ ircd::m::media::file::read(const m::room &room,
 			};
 			#endif
 
-			closure(block);
+			closure(slice);
 		}};
 
 		if(unlikely(!block::get(hash, handle)))
@@ -569,11 +691,101 @@ ircd::m::media::file::read(const m::room &room,
 				string_view{event.event_id},
 				it.event_idx(),
 			};
+
+		pos += block_size;
 	}
 
 	return ret;
 }
 
+/// Positions the iterator at the block containing the byte offset and
+/// returns the offset of the start of that block in the file. The blocks
+/// are written contiguously by file::write() with a fixed size (except the
+/// last) so the target block is found by its depth relative to the first
+/// block without reading any of the blocks preceding it. If the file does
+/// not appear to follow that layout the iterator is left at the first block
+/// and zero is returned; the caller must then pass over the blocks preceding
+/// the offset itself.
+size_t
+ircd::m::media::file::seek(const room &room,
+                           room::events &it,
+                           const size_t &offset)
+{
+	const auto is_block{[&it]
+	{
+		return json::get<"type"_>(*it) == "ircd.file.block";
+	}};
+
+	for(; it; ++it)
+		if(is_block())
+			break;
+
+	if(!it || !offset)
+		return 0;
+
+	const auto first_depth
+	{
+		it.depth()
+	};
+
+	const auto block_size
+	{
+		at<"content"_>(*it).get<size_t>("size")
+	};
+
+	if(block_size != block_size_max || offset < block_size)
+		return 0;
+
+	// Any other event interleaved with the blocks would offset the depth
+	// of every block after it. That is ruled out when the span from the
+	// first block to the head of the room holds exactly as many events as
+	// the file has blocks.
+	size_t file_size{0};
+	const m::room::state state{room};
+	state.get(std::nothrow, "ircd.file.stat", "size", [&file_size]
+	(const m::event &event)
+	{
+		file_size = at<"content"_>(event).get<size_t>("value");
+	});
+
+	const size_t blocks
+	{
+		(file_size + block_size - 1) / block_size
+	};
+
+	const int64_t head_depth
+	{
+		m::depth(std::nothrow, room.room_id)
+	};
+
+	const bool contiguous
+	{
+		head_depth >= int64_t(first_depth) &&
+		size_t(head_depth - first_depth + 1) == blocks
+	};
+
+	if(!contiguous)
+		return 0;
+
+	const size_t index
+	{
+		offset / block_size
+	};
+
+	const auto target_depth
+	{
+		first_depth + index
+	};
+
+	if(likely(it.seek(target_depth) && it.depth() == target_depth && is_block()))
+		if(likely(at<"content"_>(*it).get<size_t>("size") <= block_size))
+			return index * block_size;
+
+	it.seek(first_depth);
+	assert(is_block());
+	return 0;
+}
+
 //
 // media::file
 //
@@ -28,6 +28,8 @@ namespace ircd::m::media
 	extern const db::description description;
 	extern std::shared_ptr<db::database> database;
 	extern db::column blocks;
+	extern const db::descriptor thumbnails_descriptor;
+	extern db::column thumbnails;
 
 	extern conf::item<seconds> download_timeout;
 	extern std::set<m::room::id> downloading;
@@ -44,4 +46,7 @@ namespace ircd::m::media::thumbnail
 	extern conf::item<size_t> height_max;
 	extern conf::item<std::string> mime_whitelist;
 	extern conf::item<std::string> mime_blacklist;
+	extern conf::item<bool> cache_enable;
+	extern std::set<std::string, std::less<>> generating;
+	extern ctx::dock generating_dock;
 }
@@ -69,6 +69,19 @@ ircd::m::media::thumbnail::mime_blacklist
 	{ "default",  ""                                      },
 };
 
+decltype(ircd::m::media::thumbnail::cache_enable)
+ircd::m::media::thumbnail::cache_enable
+{
+	{ "name",     "ircd.m.media.thumbnail.cache.enable" },
+	{ "default",  true                                  },
+};
+
+decltype(ircd::m::media::thumbnail::generating)
+ircd::m::media::thumbnail::generating;
+
+decltype(ircd::m::media::thumbnail::generating_dock)
+ircd::m::media::thumbnail::generating_dock;
+
 m::resource
 thumbnail_resource__legacy
 {
@@ -95,6 +108,38 @@ get__thumbnail_local(client &client,
                      const m::media::mxc &,
                      const m::room &room);
 
+static m::resource::response
+generate__thumbnail(client &client,
+                    const m::media::mxc &,
+                    const m::room &room,
+                    const string_view &key,
+                    const m::event::idx &source,
+                    const const_buffer &file,
+                    const string_view &content_type,
+                    const string_view &method,
+                    const std::pair<size_t, size_t> &dimension);
+
+static bool
+get__thumbnail_cached(client &client,
+                      const m::media::mxc &,
+                      const string_view &key,
+                      const m::event::idx &source);
+
+static void
+set__thumbnail_cached(const string_view &key,
+                      const m::event::idx &source,
+                      const const_buffer &thumbnail,
+                      const string_view &content_type);
+
+static size_t
+del__thumbnail_cached(const m::media::mxc &);
+
+static string_view
+thumbnail_key(const mutable_buffer &out,
+              const m::media::mxc &,
+              const std::pair<size_t, size_t> &dimension,
+              const string_view &method);
+
 m::resource::response
 get__thumbnail(client &client,
                const m::resource::request &request)
@@ -206,6 +251,13 @@ get__thumbnail_local(client &client,
 		file_size = at<"content"_>(event).get<size_t>("value");
 	});
 
+	// The cache is only valid for the same instance of the source file; if
+	// the file is purged and stored again this index differs.
+	const m::event::idx source
+	{
+		state.get(std::nothrow, "ircd.file.stat", "size")
+	};
+
 	// Get the MIME type
 	char type_buf[64];
 	string_view content_type
@@ -227,35 +279,6 @@ get__thumbnail_local(client &client,
 		};
 	});
 
-	const unique_buffer<mutable_buffer> buf
-	{
-		file_size
-	};
-
-	size_t copied(0);
-	const auto sink{[&buf, &copied]
-	(const const_buffer &block)
-	{
-		copied += copy(buf + copied, block);
-	}};
-
-	const size_t read_size
-	{
-		m::media::file::read(room, sink)
-	};
-
-	if(unlikely(read_size != file_size || file_size != copied))
-		throw ircd::error
-		{
-			"File %s/%s [%s] size mismatch: expected %zu got %zu copied %zu",
-			mxc.server,
-			mxc.mediaid,
-			string_view{room.room_id},
-			file_size,
-			read_size,
-			copied
-		};
-
 	const bool available
 	{
 		m::media::magick_support
@@ -315,15 +338,106 @@ get__thumbnail_local(client &client,
 				"Unknown reason",
 		};
 
+	char keybuf[512];
+	const string_view key
+	{
+		!fallback && cache_enable?
+			thumbnail_key(keybuf, mxc, dimension, method):
+			string_view{}
+	};
+
+	// When another context is already generating this same thumbnail we
+	// wait for it to finish and then serve its result out of the cache
+	// rather than generating it again. The cache lookup yields, so another
+	// context may have claimed the key meanwhile; the claim is only made
+	// after a check which has no yield between it and the emplace below.
+	while(key)
+	{
+		generating_dock.wait([&key]
+		{
+			return !generating.count(key);
+		});
+
+		if(get__thumbnail_cached(client, mxc, key, source))
+			return {};
+
+		if(!generating.count(key))
+			break;
+	}
+
+	const auto iit
+	{
+		key?
+			generating.emplace(key):
+			std::make_pair(end(generating), false)
+	};
+
+	const unwind uw{[&iit]
+	{
+		if(!iit.second)
+			return;
+
+		generating.erase(iit.first);
+		generating_dock.notify_all();
+	}};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		file_size
+	};
+
+	size_t copied(0);
+	const auto sink{[&buf, &copied]
+	(const const_buffer &block)
+	{
+		copied += copy(buf + copied, block);
+	}};
+
+	const size_t read_size
+	{
+		m::media::file::read(room, sink)
+	};
+
+	if(unlikely(read_size != file_size || file_size != copied))
+		throw ircd::error
+		{
+			"File %s/%s [%s] size mismatch: expected %zu got %zu copied %zu",
+			mxc.server,
+			mxc.mediaid,
+			string_view{room.room_id},
+			file_size,
+			read_size,
+			copied
+		};
+
 	if(fallback)
 		return m::resource::response
 		{
 			client, buf, content_type
 		};
 
-	const auto closure{[&client, &content_type]
+	return generate__thumbnail(client, mxc, room, key, source, buf, content_type, method, dimension);
+}
+
+static m::resource::response
+generate__thumbnail(client &client,
+                    const m::media::mxc &mxc,
+                    const m::room &room,
+                    const string_view &key,
+                    const m::event::idx &source,
+                    const const_buffer &file,
+                    const string_view &content_type,
+                    const string_view &method,
+                    const std::pair<size_t, size_t> &dimension)
+{
+	// The thumbnailer conducts its work on an offload thread; the result
+	// is delivered back to this context in the closure.
+	const auto closure{[&client, &content_type, &key, &source]
 	(const const_buffer &buf)
 	{
+		if(key)
+			set__thumbnail_cached(key, source, buf, content_type);
+
 		m::resource::response
 		{
 			client, buf, content_type
@@ -333,13 +447,234 @@ get__thumbnail_local(client &client,
 	if(method == "crop")
 		magick::thumbcrop
 		{
-			buf, dimension, closure
+			file, dimension, closure
 		};
 	else
 		magick::thumbnail
 		{
-			buf, dimension, closure
+			file, dimension, closure
 		};
 
 	return {}; // responded from closure.
 }
+
+/// Respond to the client with a previously generated thumbnail. Returns
+/// false if the cache has no thumbnail for the key, in which case nothing
+/// was sent to the client.
+static bool
+get__thumbnail_cached(client &client,
+                      const m::media::mxc &mxc,
+                      const string_view &key,
+                      const m::event::idx &source)
+{
+	bool found;
+	const std::string info_buf
+	{
+		db::read(m::media::thumbnails, key, found)
+	};
+
+	if(!found)
+		return false;
+
+	const json::object info
+	{
+		info_buf
+	};
+
+	// The source file was deleted or replaced since this was generated;
+	// every thumbnail of the file is stale.
+	if(info.get<m::event::idx>("source") != source)
+	{
+		del__thumbnail_cached(mxc);
+		return false;
+	}
+
+	const json::string &content_type
+	{
+		info.at("type")
+	};
+
+	const auto &file_size
+	{
+		info.at<size_t>("size")
+	};
+
+	const json::array blocks
+	{
+		info.at("blocks")
+	};
+
+	// A block missing here would mean the cache entry outlived its data;
+	// treat it as a miss and let the caller regenerate it.
+	for(const json::string hash : blocks)
+		if(unlikely(!db::has(m::media::blocks, hash)))
+			return false;
+
+	for(const json::string hash : blocks)
+		m::media::block::prefetch(hash);
+
+	m::resource::response
+	{
+		client, http::OK, content_type, file_size
+	};
+
+	size_t sent(0);
+	for(const json::string hash : blocks)
+		m::media::block::get(hash, [&client, &sent]
+		(const const_buffer &block)
+		{
+			sent += write_all(*client.sock, block);
+		});
+
+	// Have to kill client here after failing content length expectation.
+	if(unlikely(sent != file_size))
+	{
+		log::error
+		{
+			m::media::log, "Thumbnail %s size mismatch: expected %zu sent %zu",
+			key,
+			file_size,
+			sent,
+		};
+
+		client.close(net::dc::RST, net::close_ignore);
+	}
+
+	return true;
+}
+
+/// Store a generated thumbnail. The thumbnail is split into blocks which
+/// are written to the blocks column content-addressed, just like the
+/// blocks of any file; the thumbnails column maps the key to the list.
+static void
+set__thumbnail_cached(const string_view &key,
+                      const m::event::idx &source,
+                      const const_buffer &thumbnail,
+                      const string_view &content_type)
+try
+{
+	static constexpr const auto hash_size
+	{
+		b58encode_size(sha256::digest_size)
+	};
+
+	const size_t &block_max
+	{
+		m::media::file::block_size_max
+	};
+
+	const size_t blocks_count
+	{
+		(size(thumbnail) + block_max - 1) / block_max
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		512 + blocks_count * (hash_size + 4)
+	};
+
+	json::stack out{buf};
+	{
+		json::stack::object top{out};
+		json::stack::member
+		{
+			top, "type", json::value{content_type}
+		};
+
+		json::stack::member
+		{
+			top, "size", json::value{long(size(thumbnail))}
+		};
+
+		json::stack::member
+		{
+			top, "source", json::value{long(source)}
+		};
+
+		json::stack::array blocks
+		{
+			top, "blocks"
+		};
+
+		for(size_t off(0); off < size(thumbnail); off += block_max)
+		{
+			const const_buffer block
+			{
+				data(thumbnail) + off, std::min(size(thumbnail) - off, block_max)
+			};
+
+			char b58buf[hash_size];
+			blocks.append(m::media::block::set(mutable_buffer{b58buf}, block));
+		}
+	}
+
+	db::write(m::media::thumbnails, key, out.completed());
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::media::log, "Failed to cache thumbnail %s :%s",
+		key,
+		e.what(),
+	};
+}
+
+/// Remove every cached thumbnail of the file. The blocks are left to the
+/// blocks column; they are content-addressed and may be shared.
+static size_t
+del__thumbnail_cached(const m::media::mxc &mxc)
+try
+{
+	char buf[512];
+	const string_view prefix
+	{
+		fmt::sprintf
+		{
+			buf, "%s/%s/", mxc.server, mxc.mediaid
+		}
+	};
+
+	std::vector<std::string> keys;
+	for(auto it(m::media::thumbnails.lower_bound(prefix)); bool(it); ++it)
+	{
+		if(!startswith(it->first, prefix))
+			break;
+
+		keys.emplace_back(it->first);
+	}
+
+	for(const auto &key : keys)
+		db::del(m::media::thumbnails, key);
+
+	return keys.size();
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::media::log, "Failed to invalidate thumbnails of %s/%s :%s",
+		mxc.server,
+		mxc.mediaid,
+		e.what(),
+	};
+
+	return 0;
+}
+
+static string_view
+thumbnail_key(const mutable_buffer &out,
+              const m::media::mxc &mxc,
+              const std::pair<size_t, size_t> &dimension,
+              const string_view &method)
+{
+	return fmt::sprintf
+	{
+		out, "%s/%s/%zux%zu/%s",
+		mxc.server,
+		mxc.mediaid,
+		dimension.first,
+		dimension.second,
+		method,
+	};
+}
@@ -10,6 +10,18 @@
 
 namespace ircd::net::dns::cache
 {
+	struct entry;
+
+	static std::string make_key(const string_view &type, const string_view &state_key);
+	static time_t expiry(const json::array &rrs, const time_t &ts);
+	static entry *find(const string_view &type, const string_view &state_key);
+	static entry *load(const string_view &type, const string_view &state_key);
+	static entry &store(const string_view &type, const string_view &state_key, const json::object &content, const time_t &ts);
+	static void refresh(const hostport &, const opts &, entry &);
+	static void evict();
+	static size_t persist(const size_t &max);
+	static void persist_worker();
+
 	static bool call_waiter(const string_view &, const string_view &, const json::array &, waiter &);
 	static size_t call_waiters(const string_view &, const string_view &, const json::array &);
 	static void handle(const m::event &, m::vm::eval &);
@@ -19,10 +31,31 @@ namespace ircd::net::dns::cache
 
 	extern const m::room::id::buf dns_room_id;
 	extern m::hookfn<m::vm::eval &> hook;
+	extern std::unordered_map<std::string, entry> entries;
+	extern std::deque<std::string> dirty;
+	extern ctx::dock persist_dock;
+	extern ctx::context persister;
+	extern stats::item hits;
+	extern stats::item misses;
+	extern stats::item stale_hits;
+	extern stats::item prefetches;
 
 	static void init(), fini();
 }
 
+/// In-memory cache entry. The room remains the durable store; entries are
+/// loaded from it on a miss and written back to it lazily.
+struct ircd::net::dns::cache::entry
+{
+	std::string content;              // ircd.dns.rrs.* event content
+	time_t ts {0};                    // when the answer was received
+	time_t expires {0};               // when no record remains valid
+	time_t retry {0};                 // no refresh attempted before this
+	uint64_t hits {0};
+	bool refreshing {false};
+	bool dirty {false};               // not yet written to the room
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
@@ -60,6 +93,9 @@ ircd::net::dns::cache::init()
 void
 ircd::net::dns::cache::fini()
 {
+	while(!dirty.empty())
+		persist(-1UL);
+
 	if(!waiting.empty())
 		log::warning
 		{
@@ -168,15 +204,40 @@ try
 	rr0.~object();
 	array.~array();
 	content.~object();
-	const m::room room
+
+	// A failed refresh does not replace a good answer which can still be
+	// served stale; the waiters receive that answer instead. NXDOMAIN is
+	// authoritative and always replaces the entry.
+	auto *const entry
 	{
-		dns_room_id
+		code != 3? find(type, state_key) : nullptr
 	};
 
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
+	const auto now
+	{
+		ircd::time()
+	};
+
+	if(entry && entry->refreshing && now < entry->expires + seconds(stale_ttl).count())
+	{
+		const std::string content(entry->content);
+		const json::array rrs(json::object(content).get(""));
+		if(!is_error(rrs))
+		{
+			entry->refreshing = false;
+			entry->retry = now + seconds(error_ttl).count();
+			call_waiters(type, state_key, rrs);
+			return true;
+		}
+	}
+
+	const json::object result
+	{
+		out.completed()
+	};
 
-	send(room, m::me(), type, state_key, json::object(out.completed()));
+	store(type, state_key, result, now);
+	call_waiters(type, state_key, result.get(""));
 	return true;
 }
 catch(const http::error &e)
@@ -296,15 +357,13 @@ try
 
 	array.~array();
 	content.~object();
-	const m::room room
+	const json::object result
 	{
-		dns_room_id
+		out.completed()
 	};
 
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
-
-	send(room, m::me(), type, state_key, json::object{out.completed()});
+	store(type, state_key, result, ircd::time());
+	call_waiters(type, state_key, result.get(""));
 	return true;
 }
 catch(const http::error &e)
@@ -374,46 +433,70 @@ ircd::net::dns::cache::get(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
+	auto *entry
 	{
-		dns_room_id
+		find(type, state_key)?: load(type, state_key)
 	};
 
-	const m::event::idx &event_idx
+	if(!entry)
 	{
-		state.get(std::nothrow, type, state_key)
-	};
-
-	if(!event_idx)
+		++misses;
 		return false;
+	}
 
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
-		return false;
+	const auto now
+	{
+		ircd::time()
+	};
 
-	bool ret{false};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&hp, &closure, &ret, &ts]
-	(const json::object &content)
+	const bool stale
 	{
-		const json::array &rrs
-		{
-			content.get("")
-		};
+		now > entry->expires
+	};
 
-		// If all records are expired then skip; otherwise since this closure
-		// expects a single array we reveal both expired and valid records.
-		ret = !std::all_of(begin(rrs), end(rrs), [&ts]
-		(const json::object &rr)
+	// The entry is a miss once all records are expired, unless it can be
+	// served stale. Otherwise since this closure expects a single array we
+	// reveal both expired and valid records.
+	if(stale)
+	{
+		const json::array rrs(json::object(entry->content).get(""));
+		if(is_error(rrs) || now > entry->expires + seconds(stale_ttl).count())
 		{
-			return expired(rr, ts);
-		});
+			++misses;
+			return false;
+		}
+	}
 
-		if(ret && closure)
-			closure(hp, rrs);
-	});
+	const auto lifetime
+	{
+		std::max(entry->expires - entry->ts, time_t(1))
+	};
 
-	return ret;
+	const bool prefetch
+	{
+		!stale
+		&& entry->hits >= size_t(prefetch_hits)
+		&& size_t(entry->expires - now) * 100 < size_t(lifetime) * size_t(prefetch_pct)
+	};
+
+	++entry->hits;
+	++hits;
+	stale_hits += stale;
+	prefetches += prefetch && !entry->refreshing;
+	if(stale || prefetch)
+		refresh(hp, opts, *entry);
+
+	// The callback may conduct further queries which modify the cache so
+	// the content is copied off the entry first.
+	const std::string content
+	{
+		entry->content
+	};
+
+	if(closure)
+		closure(hp, json::object(content).get(""));
+
+	return true;
 }
 
 bool
@@ -436,39 +519,26 @@ ircd::net::dns::cache::for_each(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
-	{
-		dns_room_id
-	};
-
-	const m::event::idx &event_idx
+	const auto *const entry
 	{
-		state.get(std::nothrow, type, state_key)
+		find(type, state_key)?: load(type, state_key)
 	};
 
-	if(!event_idx)
-		return false;
-
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
+	if(!entry)
 		return false;
 
-	bool ret{true};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&state_key, &closure, &ret, &ts]
-	(const json::object &content)
+	const time_t ts{entry->ts};
+	const std::string content{entry->content};
+	for(const json::object &rr : json::array(json::object(content).get("")))
 	{
-		for(const json::object &rr : json::array(content.get("")))
-		{
-			if(expired(rr, ts))
-				continue;
+		if(expired(rr, ts))
+			continue;
 
-			if(!(ret = closure(state_key, rr)))
-				break;
-		}
-	});
+		if(!closure(state_key, rr))
+			return false;
+	}
 
-	return ret;
+	return true;
 }
 
 bool
@@ -531,12 +601,22 @@ try
 		json::get<"state_key"_>(event)
 	};
 
-	const json::array &rrs
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	// Events written by persist() match the entry already in memory; any
+	// other write to the room replaces it.
+	const auto *const entry
 	{
-		json::get<"content"_>(event).get("")
+		find(type, state_key)
 	};
 
-	call_waiters(type, state_key, rrs);
+	if(!entry || (!entry->dirty && string_view(entry->content) != string_view(content)))
+		store(type, state_key, content, json::get<"origin_server_ts"_>(event) / 1000L).dirty = false;
+
+	call_waiters(type, state_key, content.get(""));
 }
 catch(const std::exception &e)
 {
@@ -622,6 +702,344 @@ catch(const std::exception &e)
 	return true;
 }
 
+//
+// memory cache
+//
+
+decltype(ircd::net::dns::cache::entries)
+ircd::net::dns::cache::entries;
+
+decltype(ircd::net::dns::cache::dirty)
+ircd::net::dns::cache::dirty;
+
+decltype(ircd::net::dns::cache::persist_dock)
+ircd::net::dns::cache::persist_dock;
+
+decltype(ircd::net::dns::cache::hits)
+ircd::net::dns::cache::hits
+{
+	{ "name", "ircd.net.dns.cache.hits" },
+	{ "desc", "Number of queries answered from the cache" },
+};
+
+decltype(ircd::net::dns::cache::misses)
+ircd::net::dns::cache::misses
+{
+	{ "name", "ircd.net.dns.cache.misses" },
+	{ "desc", "Number of queries the cache could not answer" },
+};
+
+decltype(ircd::net::dns::cache::stale_hits)
+ircd::net::dns::cache::stale_hits
+{
+	{ "name", "ircd.net.dns.cache.stale" },
+	{ "desc", "Number of queries answered with an expired entry while it was refreshed" },
+};
+
+decltype(ircd::net::dns::cache::prefetches)
+ircd::net::dns::cache::prefetches
+{
+	{ "name", "ircd.net.dns.cache.prefetches" },
+	{ "desc", "Number of popular entries refreshed before their expiration" },
+};
+
+decltype(ircd::net::dns::cache::persister)
+ircd::net::dns::cache::persister
+{
+	"dns.cache", 256_KiB, ctx::context::POST, persist_worker
+};
+
+/// The key is the event type and state_key separated by a space, which
+/// appears in neither.
+std::string
+ircd::net::dns::cache::make_key(const string_view &type,
+                                const string_view &state_key)
+{
+	std::string ret;
+	ret.reserve(size(type) + 1 + size(state_key));
+	ret.append(data(type), size(type));
+	ret.push_back(' ');
+	ret.append(data(state_key), size(state_key));
+	return ret;
+}
+
+ircd::net::dns::cache::entry *
+ircd::net::dns::cache::find(const string_view &type,
+                            const string_view &state_key)
+{
+	const auto it
+	{
+		entries.find(make_key(type, state_key))
+	};
+
+	return it != end(entries)? &it->second : nullptr;
+}
+
+/// Reads the answer from the cache room into memory on a miss.
+ircd::net::dns::cache::entry *
+ircd::net::dns::cache::load(const string_view &type,
+                            const string_view &state_key)
+{
+	const m::room::state state
+	{
+		dns_room_id
+	};
+
+	const m::event::idx &event_idx
+	{
+		state.get(std::nothrow, type, state_key)
+	};
+
+	if(!event_idx)
+		return nullptr;
+
+	time_t origin_server_ts;
+	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
+		return nullptr;
+
+	entry *ret {nullptr};
+	m::get(std::nothrow, event_idx, "content", [&]
+	(const json::object &content)
+	{
+		ret = &store(type, state_key, content, origin_server_ts / 1000L);
+		ret->dirty = false;
+	});
+
+	return ret;
+}
+
+/// Replaces the entry with a new answer; the answer is queued for the room.
+ircd::net::dns::cache::entry &
+ircd::net::dns::cache::store(const string_view &type,
+                             const string_view &state_key,
+                             const json::object &content,
+                             const time_t &ts)
+{
+	evict();
+	auto key
+	{
+		make_key(type, state_key)
+	};
+
+	auto &entry
+	{
+		entries[key]
+	};
+
+	const bool was_dirty
+	{
+		entry.dirty
+	};
+
+	entry = cache::entry
+	{
+		std::string{content},
+		ts,
+		expiry(content.get(""), ts),
+		0,
+		entry.hits,
+		false,
+		true,
+	};
+
+	if(!was_dirty)
+	{
+		dirty.emplace_back(std::move(key));
+		persist_dock.notify_one();
+	}
+
+	return entry;
+}
+
+/// The entry expires when the last of its records expires, consistent
+/// with the per-record test in dns::expired().
+time_t
+ircd::net::dns::cache::expiry(const json::array &rrs,
+                              const time_t &ts)
+{
+	time_t ret(ts);
+	for(const json::object &rr : rrs)
+	{
+		const seconds &min
+		{
+			is_error(rr)? seconds(error_ttl) : seconds(min_ttl)
+		};
+
+		ret = std::max(ret, ts + std::max(get_ttl(rr), time_t(min.count())));
+	}
+
+	return ret;
+}
+
+/// Resubmits the query to the resolver without waiting; the answer arrives
+/// through put() like any other.
+void
+ircd::net::dns::cache::refresh(const hostport &hp,
+                               const opts &opts,
+                               entry &entry)
+try
+{
+	if(entry.refreshing || ircd::time() < entry.retry)
+		return;
+
+	auto _opts(opts);
+	_opts.cache_check = false;
+	entry.refreshing = true;
+	resolve(hp, _opts, callback{[]
+	(const hostport &, const json::array &)
+	{
+		// Nothing to do here; put() has already updated the entry.
+	}});
+}
+catch(const std::exception &e)
+{
+	entry.refreshing = false;
+	entry.retry = ircd::time() + seconds(error_ttl).count();
+	log::derror
+	{
+		log, "cache refresh '%s' :%s",
+		host(hp),
+		e.what(),
+	};
+}
+
+/// Trims the map back below the configured maximum. Anything no longer
+/// servable goes first, then the least used entries. Entries not yet
+/// written to the room are kept.
+void
+ircd::net::dns::cache::evict()
+{
+	const size_t max
+	{
+		std::max(size_t(mem_max), 1UL)
+	};
+
+	if(likely(entries.size() < max))
+		return;
+
+	const auto now
+	{
+		ircd::time()
+	};
+
+	const auto stale_max
+	{
+		seconds(stale_ttl).count()
+	};
+
+	for(auto it(begin(entries)); it != end(entries); )
+		if(!it->second.dirty && it->second.expires + stale_max < now)
+			it = entries.erase(it);
+		else
+			++it;
+
+	if(entries.size() < max)
+		return;
+
+	std::vector<decltype(entries)::iterator> victims;
+	victims.reserve(entries.size());
+	for(auto it(begin(entries)); it != end(entries); ++it)
+		if(!it->second.dirty)
+			victims.emplace_back(it);
+
+	const size_t count
+	{
+		std::min(victims.size(), entries.size() - max * 9 / 10)
+	};
+
+	std::nth_element(begin(victims), begin(victims) + count, end(victims), []
+	(const auto &a, const auto &b)
+	{
+		return a->second.hits < b->second.hits;
+	});
+
+	for(size_t i(0); i < count; ++i)
+		entries.erase(victims[i]);
+}
+
+void
+ircd::net::dns::cache::persist_worker()
+{
+	while(1)
+	{
+		persist_dock.wait([]
+		{
+			return !dirty.empty();
+		});
+
+		// Let answers accumulate so a burst of lookups becomes one pass.
+		ctx::sleep(milliseconds(persist_interval));
+		while(!dirty.empty())
+			persist(persist_batch);
+	}
+}
+
+/// Writes up to max queued entries to the cache room. The entry can change
+/// or vanish while this yields for each write, so the content is copied
+/// out first.
+size_t
+ircd::net::dns::cache::persist(const size_t &max)
+{
+	const m::room room
+	{
+		dns_room_id
+	};
+
+	if(unlikely(!exists(room)))
+		create(room, m::me(), "internal");
+
+	size_t ret(0);
+	while(!dirty.empty() && ret < max)
+	{
+		const std::string key
+		{
+			std::move(dirty.front())
+		};
+
+		dirty.pop_front();
+		const auto it
+		{
+			entries.find(key)
+		};
+
+		if(it == end(entries) || !it->second.dirty)
+			continue;
+
+		const std::string content
+		{
+			it->second.content
+		};
+
+		it->second.dirty = false;
+		const auto &[type, state_key]
+		{
+			split(key, ' ')
+		};
+
+		try
+		{
+			send(room, m::me(), type, state_key, json::object{content});
+			++ret;
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "cache persist (%s, %s) :%s",
+				type,
+				state_key,
+				e.what(),
+			};
+		}
+	}
+
+	return ret;
+}
+
 //
 // cache room creation
 //
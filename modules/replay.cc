@@ -0,0 +1,914 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+using namespace ircd;
+
+namespace ircd::replay
+{
+	struct endpoint;
+
+	static sha256::buf salted(const string_view &);
+	static string_view hash_id(const mutable_buffer &, const string_view &id);
+	static string_view hash_segment(const mutable_buffer &, const string_view &);
+	static std::string redact_path(const string_view &path, const string_view &prefix);
+	static std::string redact_query(const string_view &query);
+	static std::string redact(const string_view &value, const bool &keep = false);
+	static void capture_tap(const resource::method &, const client &, const resource::request &);
+	static void capture_worker();
+	static void send(const json::object &record);
+	static void worker();
+	static void on_unload();
+
+	extern conf::item<size_t> capture_flush;
+	extern conf::item<bool> capture_hash_ids;
+	extern conf::item<seconds> timeout;
+	extern log::log log;
+
+	// capture
+	std::unique_ptr<resource::method::tap> tap;
+	std::unique_ptr<context> capture_context;
+	std::string capture_path, capture_buf, capture_salt;
+	steady_point capture_started;
+	size_t captured, skipped;
+	bool capture_stopping;
+	ctx::dock capture_dock;
+
+	// replay
+	std::unique_ptr<context> replay_context;
+	std::string replay_path, replay_remote, replay_token;
+	double replay_speed;
+	size_t replay_concurrency, inflight;
+	bool replay_stopping;
+	ctx::dock replay_dock;
+	std::map<std::string, endpoint, std::less<>> endpoints;
+}
+
+extern "C" bool replay_capture(const string_view &path);
+extern "C" bool replay_run(const string_view &path, const string_view &remote, const double &speed, const size_t &concurrency, const string_view &token);
+extern "C" void replay_stop();
+extern "C" void replay_report(std::ostream &);
+
+mapi::header
+IRCD_MODULE
+{
+	"Traffic capture and replay", nullptr, ircd::replay::on_unload
+};
+
+/// Latencies and response statuses of the replayed requests which were
+/// captured for one route. Any response other than 2xx is an error; status
+/// class zero counts requests which received no response at all.
+struct ircd::replay::endpoint
+{
+	size_t count {0};
+	size_t errors {0};
+	std::array<size_t, 6> status {0}; // by class (code / 100)
+	std::vector<uint32_t> latency;    // microseconds
+};
+
+decltype(ircd::replay::log)
+ircd::replay::log
+{
+	"replay"
+};
+
+decltype(ircd::replay::capture_flush)
+ircd::replay::capture_flush
+{
+	{ "name",     "ircd.replay.capture.flush" },
+	{ "default",  long(64_KiB)                },
+};
+
+decltype(ircd::replay::capture_hash_ids)
+ircd::replay::capture_hash_ids
+{
+	{ "name",     "ircd.replay.capture.hash_ids" },
+	{ "default",  false                          },
+	{ "description",
+
+	R"(
+	Replace room, user and event identifiers in the capture with salted hashes.
+	The hashes correlate within one capture but name nothing on the replay
+	target, so such a capture is only useful against a target seeded with
+	those identifiers. By default identifiers are recorded as received so the
+	replay addresses the same rooms and users.
+	)"}
+};
+
+decltype(ircd::replay::timeout)
+ircd::replay::timeout
+{
+	{ "name",     "ircd.replay.timeout" },
+	{ "default",  60L                   },
+};
+
+void
+ircd::replay::on_unload()
+{
+	replay_stop();
+	replay_capture(string_view{});
+}
+
+//
+// capture
+//
+
+/// Starts recording every request received by this server to the file at
+/// path, or stops recording when path is empty. Each request is one line of
+/// JSON with its offset in milliseconds from the start of the capture, the
+/// method, the route it was dispatched to, the path and query, and the
+/// content. Headers and the address of the client are not recorded. The
+/// content is reduced to the structure of the request: only the members
+/// named in the allowlist below keep their values. Identifiers are kept so
+/// the replay addresses the same rooms and users; with hash_ids they are
+/// instead replaced with hashes salted for the capture, so requests for the
+/// same room or user still correlate within one file.
+bool
+replay_capture(const string_view &path)
+{
+	using namespace ircd::replay;
+
+	if(!path)
+	{
+		if(!capture_context)
+			return false;
+
+		tap.reset(nullptr);
+		capture_stopping = true;
+		capture_dock.notify_all();
+		capture_context->join();
+		capture_context.reset(nullptr);
+		log::info
+		{
+			replay::log, "Captured %zu requests (%zu skipped) to `%s'",
+			captured,
+			skipped,
+			capture_path,
+		};
+
+		return true;
+	}
+
+	if(capture_context)
+		return false;
+
+	capture_path = std::string{path};
+	capture_buf.clear();
+	capture_salt = rand::string(rand::dict::alnum, 32);
+	capture_started = now<steady_point>();
+	captured = 0;
+	skipped = 0;
+	capture_stopping = false;
+	capture_context = std::make_unique<context>
+	(
+		"replay.capture", 256_KiB, context::POST, capture_worker
+	);
+
+	tap = std::make_unique<resource::method::tap>(capture_tap);
+	log::info
+	{
+		replay::log, "Capturing requests to `%s'",
+		capture_path,
+	};
+
+	return true;
+}
+
+/// The tap is called on the request's context and must not yield; the line
+/// is composed into the buffer and the writing is left to the worker. A
+/// failure here must never fail the request being observed.
+void
+ircd::replay::capture_tap(const resource::method &method,
+                          const client &client,
+                          const resource::request &request)
+try
+{
+	const auto &head
+	{
+		request.head
+	};
+
+	// Bodies which are not JSON (i.e media uploads) are not captured.
+	if(request.content && !json::valid(request.content, std::nothrow))
+	{
+		++skipped;
+		return;
+	}
+
+	const auto ts
+	{
+		duration_cast<milliseconds>(now<steady_point>() - capture_started)
+	};
+
+	thread_local char endpoint_buf[256];
+	const string_view endpoint
+	{
+		fmt::sprintf
+		{
+			endpoint_buf, "%s %s",
+			method.name,
+			method.resource->path,
+		}
+	};
+
+	const std::string uri
+	{
+		redact_path(head.path, method.resource->path) + redact_query(head.query)
+	};
+
+	const std::string content
+	{
+		request.content?
+			redact(request.content):
+			std::string{}
+	};
+
+	std::vector<json::member> record
+	{
+		{ "ts",        ts.count()  },
+		{ "method",    head.method },
+		{ "endpoint",  endpoint    },
+		{ "uri",       uri         },
+	};
+
+	if(request.content)
+		record.emplace_back("content", json::value{content, json::type(content)});
+
+	capture_buf += json::strung
+	{
+		record.data(), record.data() + record.size()
+	};
+
+	capture_buf += '\n';
+	++captured;
+	if(capture_buf.size() >= size_t(capture_flush))
+		capture_dock.notify();
+}
+catch(const std::exception &e)
+{
+	++skipped;
+	log::derror
+	{
+		log, "Failed to capture %s request :%s",
+		method.name,
+		e.what(),
+	};
+}
+
+/// Reduces a JSON value to its structure. Members of objects are dropped
+/// unless their key is in the allowlist, or the key is an identifier (maps
+/// keyed by room or user) in which case the key passes through hash_id().
+/// Strings keep their value only under an allowlisted key; identifiers pass
+/// through hash_id() wherever they are found and every other string is
+/// emptied. Numbers and literals are
+/// kept so limits, timeouts and flags replay as they were received.
+std::string
+ircd::replay::redact(const string_view &value,
+                     const bool &keep)
+{
+	static const std::set<string_view> allow
+	{
+		"account_data", "algorithm", "auth_events", "contains_url", "dir",
+		"edu_type", "edus", "ephemeral", "event_fields", "event_format",
+		"event_id", "events", "filter", "full_state", "guest_access",
+		"history_visibility", "include_all_networks", "include_leave",
+		"include_redundant_members", "is_direct", "join_rule", "kind",
+		"lazy_load_members", "limit", "m.relates_to", "membership",
+		"messages", "msgtype", "not_rooms", "not_senders", "not_types",
+		"pdus", "preset", "presence", "prev_events", "rel_type", "room",
+		"room_id", "rooms", "sender", "senders", "set_presence", "state",
+		"timeline", "timeout", "type", "types", "user_id", "visibility",
+	};
+
+	switch(json::type(value, std::nothrow))
+	{
+		case json::OBJECT:
+		{
+			std::vector<std::pair<std::string, std::string>> kept;
+			for(const auto &[key_, val] : json::object{value})
+			{
+				const json::string key{key_};
+				if(allow.count(key))
+				{
+					kept.emplace_back(key, redact(val, true));
+					continue;
+				}
+
+				if(!m::has_sigil(key))
+					continue;
+
+				char buf[512];
+				std::string hashed
+				{
+					hash_id(buf, key)
+				};
+
+				kept.emplace_back(std::move(hashed), redact(val, false));
+			}
+
+			std::vector<json::member> members;
+			members.reserve(kept.size());
+			for(const auto &[key, val] : kept)
+				members.emplace_back(key, json::value{val, json::type(val)});
+
+			return json::strung
+			{
+				members.data(), members.data() + members.size()
+			};
+		}
+
+		case json::ARRAY:
+		{
+			std::vector<std::string> kept;
+			for(const auto &val : json::array{value})
+				kept.emplace_back(redact(val, keep));
+
+			std::vector<json::value> values;
+			values.reserve(kept.size());
+			for(const auto &val : kept)
+				values.emplace_back(val, json::type(val));
+
+			return json::strung
+			{
+				json::value{values.data(), values.size()}
+			};
+		}
+
+		case json::STRING:
+		{
+			const json::string string{value};
+			char buf[512];
+			if(m::has_sigil(string))
+				return json::strung{json::value{hash_id(buf, string), json::STRING}};
+
+			return keep?
+				std::string{value}:
+				std::string{"\"\""};
+		}
+
+		case json::NUMBER:
+		case json::LITERAL:
+			return std::string{value};
+	}
+
+	return std::string{"null"};
+}
+
+/// The route's own path is kept; each parameter after it is kept only if it
+/// is a plain lowercase word (sub-routes and event types) or an identifier,
+/// otherwise it is hashed.
+std::string
+ircd::replay::redact_path(const string_view &path,
+                          const string_view &prefix)
+{
+	const size_t prefix_len
+	{
+		startswith(path, prefix)? size(prefix) : 0UL
+	};
+
+	std::string ret
+	{
+		path.substr(0, prefix_len)
+	};
+
+	tokens(path.substr(prefix_len), '/', [&ret](const string_view &segment)
+	{
+		thread_local char dec[1024], hash[512], buf[1024];
+		const string_view decoded
+		{
+			url::decode(dec, segment)
+		};
+
+		if(!ret.empty() && ret.back() != '/')
+			ret += '/';
+
+		ret += url::encode(buf, hash_segment(hash, decoded));
+	});
+
+	if(endswith(path, '/') && !endswith(ret, '/'))
+		ret += '/';
+
+	return ret;
+}
+
+/// Query parameters keep their names; their values are kept only for the
+/// structural parameters in the allowlist. The access_token is dropped.
+std::string
+ircd::replay::redact_query(const string_view &query)
+{
+	static const std::set<string_view> allow
+	{
+		"dir", "from", "full_state", "limit", "set_presence", "since", "to",
+		"timeout",
+	};
+
+	std::string ret;
+	http::query::string{query}.for_each([&ret]
+	(const auto &param)
+	{
+		const auto &[key, val]
+		{
+			param
+		};
+
+		if(key == "access_token")
+			return true;
+
+		thread_local char dec[2048], hash[512], buf[2048];
+		const string_view decoded
+		{
+			url::decode(dec, val)
+		};
+
+		ret += ret.empty()? "?" : "&";
+		ret += key;
+		ret += "=";
+		if(allow.count(key))
+			ret += val;
+		else if(key == "filter" && json::type(decoded, std::nothrow) == json::OBJECT)
+			ret += url::encode(buf, redact(decoded));
+		else
+			ret += url::encode(buf, hash_segment(hash, decoded));
+
+		return true;
+	});
+
+	return ret;
+}
+
+/// Plain lowercase words and empty segments are returned as-is; identifiers
+/// go through hash_id(); anything else is hashed entirely.
+ircd::string_view
+ircd::replay::hash_segment(const mutable_buffer &buf,
+                           const string_view &segment)
+{
+	const bool word
+	{
+		!empty(segment) && size(segment) <= 64
+		&& std::all_of(begin(segment), end(segment), [](const char &c)
+		{
+			return (c >= 'a' && c <= 'z') || c == '.' || c == '_';
+		})
+	};
+
+	if(word || empty(segment))
+		return segment;
+
+	if(m::has_sigil(segment))
+		return hash_id(buf, segment);
+
+	char b58buf[64];
+	const string_view hash
+	{
+		trunc(b58encode(b58buf, salted(segment)), 16)
+	};
+
+	return string_view
+	{
+		data(buf), copy(buf, hash)
+	};
+}
+
+/// Identifiers are kept unless hash_ids is configured, in which case the
+/// localpart and the server are replaced with truncated salted hashes,
+/// keeping the sigil and the shape of the identifier.
+ircd::string_view
+ircd::replay::hash_id(const mutable_buffer &buf,
+                      const string_view &id)
+{
+	if(!capture_hash_ids)
+		return string_view
+		{
+			data(buf), copy(buf, id)
+		};
+
+	const auto &[local, host]
+	{
+		split(id.substr(1), ':')
+	};
+
+	char lbuf[64], hbuf[64];
+	const string_view lstr
+	{
+		trunc(b58encode(lbuf, salted(local)), 16)
+	};
+
+	const string_view hstr
+	{
+		trunc(b58encode(hbuf, salted(host)), 8)
+	};
+
+	return host?
+		fmt::sprintf{buf, "%c%s:%s", id.at(0), lstr, hstr}:
+		fmt::sprintf{buf, "%c%s", id.at(0), lstr};
+}
+
+ircd::sha256::buf
+ircd::replay::salted(const string_view &input)
+{
+	return sha256::buf{[&input](const mutable_buffer &out)
+	{
+		sha256 hash;
+		hash.update(string_view{capture_salt});
+		hash.update(input);
+		hash.finalize(out);
+	}};
+}
+
+void
+ircd::replay::capture_worker()
+{
+	while(!capture_stopping || !capture_buf.empty())
+	{
+		capture_dock.wait_for(seconds(5), []
+		{
+			return capture_stopping || capture_buf.size() >= size_t(capture_flush);
+		});
+
+		std::string buf;
+		std::swap(buf, capture_buf);
+		if(!buf.empty()) try
+		{
+			fs::append(capture_path, const_buffer{buf});
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "Failed to write %zu bytes of capture to `%s' :%s",
+				buf.size(),
+				capture_path,
+				e.what(),
+			};
+		}
+	}
+}
+
+//
+// replay
+//
+
+/// Replays a capture against remote. The requests are sent with the pacing
+/// they were received at divided by speed; a speed of zero sends them as fast
+/// as the concurrency allows. Client requests are authorized with token;
+/// federation requests are signed by this server.
+bool
+replay_run(const string_view &path,
+           const string_view &remote,
+           const double &speed,
+           const size_t &concurrency,
+           const string_view &token)
+{
+	using namespace ircd::replay;
+
+	if(replay_context && !replay_context->joined())
+		return false;
+
+	replay_path = std::string{path};
+	replay_remote = std::string{remote};
+	replay_token = std::string{token};
+	replay_speed = speed;
+	replay_concurrency = std::max(concurrency, 1UL);
+	replay_stopping = false;
+	endpoints.clear();
+	replay_context = std::make_unique<context>
+	(
+		"replay", 512_KiB, context::POST, worker
+	);
+
+	return true;
+}
+
+void
+replay_stop()
+{
+	using namespace ircd::replay;
+
+	if(!replay_context)
+		return;
+
+	replay_stopping = true;
+	if(!replay_context->joined())
+	{
+		replay_context->interrupt();
+		replay_context->join();
+	}
+
+	replay_context.reset(nullptr);
+}
+
+/// Latency distribution of each route in the last replay, in milliseconds,
+/// and the number of responses in each status class. ERRORS counts every
+/// request which did not receive a 2xx; NONE those which received nothing.
+void
+replay_report(std::ostream &out)
+{
+	using namespace ircd::replay;
+
+	out
+	<< std::left << std::setw(56) << "ENDPOINT" << " "
+	<< std::right << std::setw(8) << "COUNT" << " "
+	<< std::right << std::setw(7) << "ERRORS" << " "
+	<< std::right << std::setw(7) << "2XX" << " "
+	<< std::right << std::setw(7) << "3XX" << " "
+	<< std::right << std::setw(7) << "4XX" << " "
+	<< std::right << std::setw(7) << "5XX" << " "
+	<< std::right << std::setw(7) << "NONE" << " "
+	<< std::right << std::setw(9) << "MEAN" << " "
+	<< std::right << std::setw(9) << "P50" << " "
+	<< std::right << std::setw(9) << "P90" << " "
+	<< std::right << std::setw(9) << "P99" << " "
+	<< std::right << std::setw(9) << "MAX" << " "
+	<< std::endl;
+
+	for(const auto &[name, endpoint] : endpoints)
+	{
+		auto latency(endpoint.latency);
+		std::sort(begin(latency), end(latency));
+		const auto pct{[&latency](const double &p) -> double
+		{
+			if(latency.empty())
+				return 0.0;
+
+			const auto i(std::min(size_t(p * latency.size()), latency.size() - 1));
+			return latency.at(i) / 1000.0;
+		}};
+
+		const double mean
+		{
+			latency.empty()? 0.0:
+			std::accumulate(begin(latency), end(latency), 0.0) / latency.size() / 1000.0
+		};
+
+		out
+		<< std::left << std::setw(56) << trunc(name, 56) << " "
+		<< std::right << std::setw(8) << endpoint.count << " "
+		<< std::right << std::setw(7) << endpoint.errors << " "
+		<< std::right << std::setw(7) << endpoint.status[2] << " "
+		<< std::right << std::setw(7) << endpoint.status[3] << " "
+		<< std::right << std::setw(7) << endpoint.status[4] << " "
+		<< std::right << std::setw(7) << endpoint.status[5] << " "
+		<< std::right << std::setw(7) << endpoint.status[0] + endpoint.status[1] << " "
+		<< std::right << std::setw(9) << std::fixed << std::setprecision(2) << mean << " "
+		<< std::right << std::setw(9) << pct(0.50) << " "
+		<< std::right << std::setw(9) << pct(0.90) << " "
+		<< std::right << std::setw(9) << pct(0.99) << " "
+		<< std::right << std::setw(9) << pct(1.00) << " "
+		<< std::endl;
+	}
+}
+
+void
+ircd::replay::worker()
+try
+{
+	const std::string file
+	{
+		fs::read(replay_path)
+	};
+
+	log::info
+	{
+		log, "Replaying `%s' (%zu bytes) to %s at %lfx with %zu concurrent",
+		replay_path,
+		file.size(),
+		replay_remote,
+		replay_speed,
+		replay_concurrency,
+	};
+
+	const ctx::pool::opts pool_opts
+	{
+		512_KiB,                 // stack_size
+		replay_concurrency,      // initial_ctxs
+		-1,                      // queue_max_hard
+		0,                       // queue_max_soft
+		true,                    // queue_max_blocking
+		false,                   // queue_max_dwarning
+	};
+
+	ctx::pool pool
+	{
+		"replay", pool_opts
+	};
+
+	const unwind join{[&pool]
+	{
+		if(replay_stopping)
+			pool.interrupt();
+
+		replay_dock.wait([]
+		{
+			return inflight == 0;
+		});
+
+		pool.join();
+	}};
+
+	const auto started
+	{
+		now<system_point>()
+	};
+
+	size_t count(0);
+	tokens(file, '\n', token_view_bool{[&](const string_view &line)
+	{
+		if(replay_stopping)
+			return false;
+
+		if(!line)
+			return true;
+
+		const json::object record
+		{
+			line
+		};
+
+		if(replay_speed > 0.0)
+		{
+			const milliseconds ts
+			{
+				long(record.get<long>("ts") / replay_speed)
+			};
+
+			ctx::sleep_until(started + ts);
+		}
+
+		++inflight;
+		pool([record(std::string{line})]
+		{
+			const unwind dec{[]
+			{
+				--inflight;
+				replay_dock.notify_all();
+			}};
+
+			send(json::object{record});
+		});
+
+		++count;
+		return true;
+	}});
+
+	log::info
+	{
+		log, "Replayed %zu requests from `%s'",
+		count,
+		replay_path,
+	};
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Replay of `%s' :%s",
+		replay_path,
+		e.what(),
+	};
+}
+
+void
+ircd::replay::send(const json::object &record)
+try
+{
+	const json::string method
+	{
+		record.at("method")
+	};
+
+	const json::string uri
+	{
+		record.at("uri")
+	};
+
+	const json::string endpoint
+	{
+		record.at("endpoint")
+	};
+
+	const json::object content
+	{
+		record["content"]
+	};
+
+	const net::hostport remote
+	{
+		string_view{replay_remote}
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	window_buffer wb
+	{
+		buf
+	};
+
+	const bool federation
+	{
+		startswith(uri, "/_matrix/federation") || startswith(uri, "/_matrix/key")
+	};
+
+	if(federation)
+	{
+		const m::request request
+		{
+			my_host(), host(remote), method, uri, content
+		};
+
+		wb([&request](const mutable_buffer &buf)
+		{
+			return request(buf);
+		});
+	}
+	else
+	{
+		thread_local char authorization_buf[512];
+		const http::header headers[]
+		{
+			{
+				"Authorization", fmt::sprintf
+				{
+					authorization_buf, "Bearer %s", replay_token
+				}
+			},
+		};
+
+		http::request
+		{
+			wb, host(remote), method, uri, size(string_view(content)), "application/json; charset=utf-8",
+			{
+				headers, replay_token.empty()? 0UL : 1UL
+			}
+		};
+	}
+
+	const const_buffer out_head
+	{
+		wb.completed()
+	};
+
+	const mutable_buffer in_head
+	{
+		buf + size(out_head)
+	};
+
+	server::request::opts sopts;
+	sopts.http_exceptions = false;
+	const auto started
+	{
+		now<steady_point>()
+	};
+
+	server::request req
+	{
+		remote, { out_head, string_view(content) }, { in_head, mutable_buffer{} }, &sopts
+	};
+
+	uint code(0);
+	const unwind record_latency{[&]
+	{
+		const auto elapsed
+		{
+			duration_cast<microseconds>(now<steady_point>() - started)
+		};
+
+		auto it(endpoints.lower_bound(endpoint));
+		if(it == end(endpoints) || it->first != endpoint)
+			it = endpoints.emplace_hint(it, std::string{endpoint}, replay::endpoint{});
+
+		auto &stats(it->second);
+		stats.count += 1;
+		stats.errors += code < 200 || code >= 300;
+		stats.status.at(std::min(code / 100, uint(stats.status.size() - 1))) += 1;
+		stats.latency.emplace_back(std::min(elapsed.count(), long(UINT32_MAX)));
+	}};
+
+	req.wait(seconds(timeout));
+	code = uint(req.get());
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s :%s",
+		string_view{record},
+		e.what(),
+	};
+}
@@ -35,41 +35,93 @@ stats_get
 	stats_resource, "GET", get__stats
 };
 
+static void
+write_stats(std::ostream &out,
+            const time_t &ts)
+{
+	out << "aio_requests_total"
+	    << ' ' << fs::aio::stats.requests
+	    << ' ' << ts
+	    << '\n';
+
+	out << "aio_requests_bytes_total"
+	    << ' ' << fs::aio::stats.bytes_requests
+	    << ' ' << ts
+	    << '\n';
+
+	ctx::prof::node::root.for_each([&out, &ts]
+	(const ctx::prof::node &node)
+	{
+		char buf[512];
+		const auto path
+		{
+			ctx::prof::path(buf, node)
+		};
+
+		for(size_t i(0); i < num_of<ctx::prof::counter>(); ++i)
+		{
+			char name[32];
+			out << "ctx_prof_" << tolower(name, reflect(ctx::prof::counter(i)))
+			    << "_total{path=\"" << path << "\"}"
+			    << ' ' << node.count[i]
+			    << ' ' << ts
+			    << '\n';
+		}
+
+		return true;
+	});
+}
+
 resource::response
 get__stats(client &client,
            const resource::request &request)
 {
-	static const size_t buf_max
+	static const size_t buf_min
 	{
-		4096
+		512_KiB
 	};
 
-	char buf[buf_max];
-	std::stringstream out;
-	pubsetbuf(out, buf);
+	static const size_t buf_max
+	{
+		32_MiB
+	};
 
 	const time_t ts
 	{
 		ircd::time<milliseconds>()
 	};
 
-	out << "aio_requests_total"
-	    << ' ' << fs::aio::stats.requests
-	    << ' ' << ts
-	    << '\n';
+	// The output is rendered again into a larger buffer when it didn't fit;
+	// the profiling tree grows with the number of contexts and scopes.
+	for(size_t buf_size(buf_min); buf_size <= buf_max; buf_size *= 2)
+	{
+		const unique_buffer<mutable_buffer> buf
+		{
+			buf_size
+		};
 
-	out << "aio_requests_bytes_total"
-	    << ' ' << fs::aio::stats.bytes_requests
-	    << ' ' << ts
-	    << '\n';
+		std::stringstream out;
+		pubsetbuf(out, buf);
+		write_stats(out, ts);
 
-	const string_view output
-	{
-		view(out, buf)
-	};
+		const string_view output
+		{
+			view(out, buf)
+		};
+
+		if(!out.good() || size(output) >= size(buf))
+			continue;
+
+		return resource::response
+		{
+			client, output, "text/plain", http::OK
+		};
+	}
 
-	return resource::response
+	throw http::error
 	{
-		client, output, "text/plain", http::OK
+		"Statistics exceed the output limit of %zu bytes.",
+		http::INTERNAL_SERVER_ERROR,
+		buf_max,
 	};
 }